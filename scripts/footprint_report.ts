@@ -0,0 +1,600 @@
+#!/usr/bin/env bun
+/**
+ * RS41ng Footprint Report
+ *
+ * Builds the firmware for every configuration variant in scripts/footprint-matrix.yaml and reports flash and RAM
+ * use per variant and target: .text/.data/.bss from the ELF sections and the worst-case stack depth from the
+ * per-function stack usage and call graph emitted by GCC (-fstack-usage -fcallgraph-info=su). The stack depth
+ * is the deepest call chain from main() plus the deepest interrupt handlers that can be nested on top of it.
+ *
+ * Results are written as footprint.json and footprint.csv into the output directory and printed as a table.
+ *
+ * Usage:
+ *   bun run scripts/footprint_report.ts [--matrix <file>] [--output <dir>] [--only <variant>]...
+ *                                       [--toolchain-prefix <prefix>] [--no-build]
+ *
+ * --no-build analyzes existing build directories in the output directory again.
+ * Needs the ARM toolchain of the Docker build image (arm-none-eabi-gcc 10 or later for -fcallgraph-info).
+ *
+ * Exit codes: 0 = all variants within budget, 1 = usage/build error, 2 = budget exceeded
+ */
+
+import { existsSync, mkdirSync, readdirSync, readFileSync, statSync, writeFileSync } from "fs";
+import { resolve, dirname, join } from "path";
+import { spawnSync } from "child_process";
+import { load as yamlLoad } from "js-yaml";
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+interface TargetSpec {
+  cmake: string;
+  linker_script: string;
+}
+
+interface IndirectCallRule {
+  callers: string;
+  targets: string;
+}
+
+interface VariantSpec {
+  name: string;
+  targets: string[];
+  baseline?: boolean;
+  settings?: Record<string, string | number | boolean>;
+  budget?: { flash?: number; ram?: number };
+}
+
+interface Matrix {
+  targets: Record<string, TargetSpec>;
+  isr_nesting_levels: number;
+  indirect_calls: IndirectCallRule[];
+  baseline: Record<string, string | number | boolean>;
+  variants: VariantSpec[];
+}
+
+interface MemoryRegion {
+  origin: number;
+  length: number;
+}
+
+interface FunctionNode {
+  name: string;
+  location: string;
+  stack: number | null;
+  dynamic: boolean;
+  callees: Set<string>;
+  indirect: boolean;
+}
+
+interface StackResult {
+  depth: number;
+  path: string[];
+  exact: boolean;
+}
+
+interface Footprint {
+  variant: string;
+  target: string;
+  status: "ok" | "over-budget" | "build-failed";
+  text: number;
+  data: number;
+  bss: number;
+  flash: number;
+  flash_budget: number;
+  stack_main: number;
+  stack_isr: number;
+  stack: number;
+  ram: number;
+  ram_budget: number;
+  stack_exact: boolean;
+  flash_delta: number | null;
+  ram_delta: number | null;
+  main_path: string[];
+  isr_handlers: { name: string; depth: number }[];
+  unknown_functions: string[];
+}
+
+// Registers stacked on exception entry (no FPU context: the firmware is built with soft float)
+const EXCEPTION_FRAME_BYTES = 32;
+
+const ISR_PATTERN = /(_IRQHandler|^SysTick_Handler|^PendSV_Handler|^SVC_Handler|^NMI_Handler|^HardFault_Handler)$/;
+
+// ─── Helpers ──────────────────────────────────────────────────────────────────
+
+function die(message: string, code: number = 1): never {
+  console.error(`ERROR: ${message}`);
+  process.exit(code);
+  throw new Error(message); // unreachable; satisfies TypeScript never return
+}
+
+function run(command: string, args: string[], cwd: string): { ok: boolean; output: string } {
+  const result = spawnSync(command, args, { cwd, encoding: "utf8", maxBuffer: 64 * 1024 * 1024 });
+  return {
+    ok: result.status === 0,
+    output: `${result.stdout ?? ""}${result.stderr ?? ""}${result.error ? result.error.message : ""}`,
+  };
+}
+
+function findFiles(dir: string, extension: string, found: string[] = []): string[] {
+  for (const entry of readdirSync(dir)) {
+    const path = join(dir, entry);
+    if (statSync(path).isDirectory()) {
+      // Skip the compiler identification builds of CMake
+      if (!/^\d+\.\d+\.\d+$/.test(entry)) {
+        findFiles(path, extension, found);
+      }
+    } else if (entry.endsWith(extension)) {
+      found.push(path);
+    }
+  }
+  return found;
+}
+
+function settingValue(value: string | number | boolean): string {
+  return typeof value === "string" ? value : String(value);
+}
+
+/**
+ * The override header is included at the end of the settings in src/config.h (RS41NG_CONFIG_OVERRIDE)
+ */
+function generateOverrideHeader(matrix: Matrix, variant: VariantSpec): string {
+  const settings = {
+    ...(variant.baseline === false ? {} : matrix.baseline),
+    ...(variant.settings ?? {}),
+  };
+
+  const lines = [`// Generated by scripts/footprint_report.ts for variant "${variant.name}"`];
+  for (const [name, value] of Object.entries(settings)) {
+    lines.push(`#undef ${name}`);
+    lines.push(`#define ${name} ${settingValue(value)}`);
+  }
+  return lines.join("\n") + "\n";
+}
+
+// ─── Sizes and budgets ────────────────────────────────────────────────────────
+
+function parseSize(value: string): number {
+  const match = /^(0x[0-9a-fA-F]+|\d+)\s*([KM]?)$/.exec(value.trim());
+  if (!match) {
+    die(`Cannot parse linker script size "${value}"`);
+  }
+  const multiplier = match[2] === "K" ? 1024 : match[2] === "M" ? 1024 * 1024 : 1;
+  return Number(match[1]) * multiplier;
+}
+
+function parseMemoryRegions(linkerScriptPath: string): Record<string, MemoryRegion> {
+  const regions: Record<string, MemoryRegion> = {};
+  const pattern = /^\s*(\w+)\s*\([\w!]+\)\s*:\s*ORIGIN\s*=\s*([^,]+),\s*LENGTH\s*=\s*(\S+)/gm;
+  const script = readFileSync(linkerScriptPath, "utf8");
+  for (const match of script.matchAll(pattern)) {
+    regions[match[1]] = { origin: parseSize(match[2]), length: parseSize(match[3]) };
+  }
+  if (!regions.FLASH || !regions.RAM) {
+    die(`No FLASH and RAM memory regions in ${linkerScriptPath}`);
+  }
+  return regions;
+}
+
+function inRegion(address: number, region: MemoryRegion): boolean {
+  return address >= region.origin && address < region.origin + region.length;
+}
+
+/**
+ * Sections are classified by address: everything placed in FLASH is .text, .data is loaded from flash into RAM,
+ * and the other RAM sections are .bss. The stack reservation of the linker script is left out, the stack is
+ * accounted for by the call graph analysis.
+ */
+function readSections(sizeTool: string, elfPath: string, regions: Record<string, MemoryRegion>) {
+  const result = run(sizeTool, ["-A", "-d", elfPath], dirname(elfPath));
+  if (!result.ok) {
+    die(`${sizeTool} failed: ${result.output}`);
+  }
+
+  let text = 0;
+  let data = 0;
+  let bss = 0;
+  for (const line of result.output.split("\n")) {
+    const match = /^(\S+)\s+(\d+)\s+(\d+)\s*$/.exec(line);
+    if (!match) {
+      continue;
+    }
+    const [, name, size, address] = match;
+    if (name === "._user_heap_stack") {
+      continue;
+    }
+    if (name === ".data") {
+      data += Number(size);
+    } else if (inRegion(Number(address), regions.FLASH)) {
+      text += Number(size);
+    } else if (inRegion(Number(address), regions.RAM)) {
+      bss += Number(size);
+    }
+  }
+  return { text, data, bss };
+}
+
+// ─── Call graph ───────────────────────────────────────────────────────────────
+
+/**
+ * Reads the VCG call graph files (.ci) written by -fcallgraph-info=su. Functions defined in a translation unit
+ * carry their stack usage in the node label, external declarations have none.
+ */
+function readCallGraph(buildDir: string): Map<string, FunctionNode> {
+  const functions = new Map<string, FunctionNode>();
+  const nodePattern = /^node: \{ title: "([^"]+)" label: "([^"]*)"/;
+  const edgePattern = /^edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"/;
+
+  const getNode = (title: string): FunctionNode => {
+    let node = functions.get(title);
+    if (!node) {
+      node = { name: title, location: "", stack: null, dynamic: false, callees: new Set(), indirect: false };
+      functions.set(title, node);
+    }
+    return node;
+  };
+
+  for (const file of findFiles(buildDir, ".ci")) {
+    for (const line of readFileSync(file, "utf8").split("\n")) {
+      const nodeMatch = nodePattern.exec(line);
+      if (nodeMatch) {
+        const [name, location, usage] = nodeMatch[2].split("\\n");
+        const stackMatch = /^(\d+) bytes \(([\w,]+)\)$/.exec(usage ?? "");
+        const node = getNode(nodeMatch[1]);
+        node.name = name;
+        if (stackMatch) {
+          node.location = location;
+          node.stack = Number(stackMatch[1]);
+          node.dynamic = stackMatch[2] === "dynamic";
+        }
+        continue;
+      }
+
+      const edgeMatch = edgePattern.exec(line);
+      if (edgeMatch) {
+        if (edgeMatch[2] === "__indirect_call") {
+          getNode(edgeMatch[1]).indirect = true;
+        } else {
+          getNode(edgeMatch[1]).callees.add(edgeMatch[2]);
+        }
+      }
+    }
+  }
+
+  functions.delete("__indirect_call");
+  return functions;
+}
+
+function resolveIndirectCalls(functions: Map<string, FunctionNode>, rules: IndirectCallRule[]): string[] {
+  const unresolved: string[] = [];
+  const compiled = rules.map((rule) => ({ callers: new RegExp(rule.callers), targets: new RegExp(rule.targets) }));
+
+  for (const node of functions.values()) {
+    if (!node.indirect) {
+      continue;
+    }
+    const rule = compiled.find((r) => r.callers.test(node.name));
+    if (!rule) {
+      unresolved.push(node.name);
+      continue;
+    }
+    for (const [title, candidate] of functions) {
+      if (candidate.stack !== null && rule.targets.test(candidate.name)) {
+        node.callees.add(title);
+      }
+    }
+    node.indirect = false;
+  }
+
+  return unresolved;
+}
+
+/**
+ * Deepest call chain from a function. Recursion and functions without stack usage information (libc, assembly)
+ * are counted once with their known usage, and make the result inexact.
+ */
+function stackDepth(
+  functions: Map<string, FunctionNode>,
+  title: string,
+  memo: Map<string, StackResult>,
+  active: Set<string>,
+  unknown: Set<string>
+): StackResult {
+  const cached = memo.get(title);
+  if (cached) {
+    return cached;
+  }
+
+  const node = functions.get(title);
+  if (!node || node.stack === null) {
+    unknown.add(node ? node.name : title);
+    return { depth: 0, path: [node ? node.name : title], exact: false };
+  }
+  if (active.has(title)) {
+    return { depth: 0, path: [`${node.name} (recursion)`], exact: false };
+  }
+
+  active.add(title);
+  let deepest: StackResult = { depth: 0, path: [], exact: true };
+  let exact = !node.dynamic && !node.indirect;
+  for (const callee of node.callees) {
+    const result = stackDepth(functions, callee, memo, active, unknown);
+    exact = exact && result.exact;
+    if (result.depth > deepest.depth || deepest.path.length === 0) {
+      deepest = result;
+    }
+  }
+  active.delete(title);
+
+  const result = { depth: node.stack + deepest.depth, path: [node.name, ...deepest.path], exact };
+  memo.set(title, result);
+  return result;
+}
+
+// ─── Report ───────────────────────────────────────────────────────────────────
+
+function analyze(
+  matrix: Matrix,
+  variant: VariantSpec,
+  targetName: string,
+  buildDir: string,
+  sizeTool: string,
+  repoRoot: string
+): Footprint {
+  const target = matrix.targets[targetName];
+  const regions = parseMemoryRegions(resolve(repoRoot, target.linker_script));
+  const sections = readSections(sizeTool, join(buildDir, "RS41ng.elf"), regions);
+
+  const functions = readCallGraph(buildDir);
+  const unresolved = resolveIndirectCalls(functions, matrix.indirect_calls ?? []);
+  const memo = new Map<string, StackResult>();
+  const unknown = new Set<string>();
+
+  const main = stackDepth(functions, "main", memo, new Set(), unknown);
+
+  // Handlers called by other handlers (HAL callbacks such as User_TIM2_IRQHandler) are part of their depth
+  const called = new Set<string>();
+  for (const node of functions.values()) {
+    node.callees.forEach((callee) => called.add(callee));
+  }
+
+  const handlers: { name: string; depth: number; exact: boolean }[] = [];
+  for (const [title, node] of functions) {
+    if (node.stack !== null && ISR_PATTERN.test(node.name) && !called.has(title)) {
+      const result = stackDepth(functions, title, memo, new Set(), unknown);
+      handlers.push({ name: node.name, depth: result.depth + EXCEPTION_FRAME_BYTES, exact: result.exact });
+    }
+  }
+  handlers.sort((a, b) => b.depth - a.depth);
+  const nested = handlers.slice(0, matrix.isr_nesting_levels ?? 1);
+  const stackIsr = nested.reduce((sum, handler) => sum + handler.depth, 0);
+
+  const flash = sections.text + sections.data;
+  const stack = main.depth + stackIsr;
+  const ram = sections.data + sections.bss + stack;
+  const flashBudget = variant.budget?.flash ?? regions.FLASH.length;
+  const ramBudget = variant.budget?.ram ?? regions.RAM.length;
+
+  return {
+    variant: variant.name,
+    target: targetName,
+    status: flash > flashBudget || ram > ramBudget ? "over-budget" : "ok",
+    text: sections.text,
+    data: sections.data,
+    bss: sections.bss,
+    flash,
+    flash_budget: flashBudget,
+    stack_main: main.depth,
+    stack_isr: stackIsr,
+    stack,
+    ram,
+    ram_budget: ramBudget,
+    stack_exact: main.exact && nested.every((handler) => handler.exact) && unresolved.length === 0,
+    flash_delta: null,
+    ram_delta: null,
+    main_path: main.path,
+    isr_handlers: nested.map(({ name, depth }) => ({ name, depth })),
+    unknown_functions: [...unknown, ...unresolved.map((name) => `${name} (unresolved indirect call)`)].sort(),
+  };
+}
+
+function failedFootprint(variant: VariantSpec, targetName: string): Footprint {
+  return {
+    variant: variant.name,
+    target: targetName,
+    status: "build-failed",
+    text: 0,
+    data: 0,
+    bss: 0,
+    flash: 0,
+    flash_budget: 0,
+    stack_main: 0,
+    stack_isr: 0,
+    stack: 0,
+    ram: 0,
+    ram_budget: 0,
+    stack_exact: false,
+    flash_delta: null,
+    ram_delta: null,
+    main_path: [],
+    isr_handlers: [],
+    unknown_functions: [],
+  };
+}
+
+const CSV_COLUMNS: (keyof Footprint)[] = [
+  "variant",
+  "target",
+  "status",
+  "text",
+  "data",
+  "bss",
+  "flash",
+  "flash_budget",
+  "flash_delta",
+  "stack_main",
+  "stack_isr",
+  "stack",
+  "stack_exact",
+  "ram",
+  "ram_budget",
+  "ram_delta",
+];
+
+function formatCsv(results: Footprint[]): string {
+  const rows = results.map((result) => CSV_COLUMNS.map((column) => String(result[column] ?? "")).join(","));
+  return [CSV_COLUMNS.join(","), ...rows].join("\n") + "\n";
+}
+
+function printTable(results: Footprint[]) {
+  const delta = (value: number | null) => (value === null ? "" : value >= 0 ? `+${value}` : `${value}`);
+  const header = ["variant", "target", "flash", "(delta)", "data+bss", "stack", "ram", "(delta)", "ram budget", "status"];
+  const rows = results.map((r) => [
+    r.variant,
+    r.target,
+    String(r.flash),
+    delta(r.flash_delta),
+    String(r.data + r.bss),
+    `${r.stack}${r.stack_exact ? "" : "+"}`,
+    String(r.ram),
+    delta(r.ram_delta),
+    String(r.ram_budget),
+    r.status,
+  ]);
+  const widths = header.map((title, i) => Math.max(title.length, ...rows.map((row) => row[i].length)));
+  for (const row of [header, ...rows]) {
+    console.log(row.map((cell, i) => (i < 2 ? cell.padEnd(widths[i]) : cell.padStart(widths[i]))).join("  "));
+  }
+  console.log("A stack depth marked with + is a lower bound, see unknown_functions in footprint.json.");
+}
+
+// ─── Main ─────────────────────────────────────────────────────────────────────
+
+function main() {
+  const scriptDir = dirname(new URL(import.meta.url).pathname);
+  const repoRoot = resolve(scriptDir, "..");
+
+  let matrixPath = resolve(scriptDir, "footprint-matrix.yaml");
+  let outputDir = resolve(repoRoot, "build-footprint");
+  let toolchainPrefix = "arm-none-eabi-";
+  let build = true;
+  const only: string[] = [];
+
+  const args = process.argv.slice(2);
+  for (let i = 0; i < args.length; i++) {
+    const value = () => args[++i] ?? die(`Missing value for ${args[i - 1]}`);
+    switch (args[i]) {
+      case "--matrix":
+        matrixPath = resolve(value());
+        break;
+      case "--output":
+        outputDir = resolve(value());
+        break;
+      case "--only":
+        only.push(value());
+        break;
+      case "--toolchain-prefix":
+        toolchainPrefix = value();
+        break;
+      case "--no-build":
+        build = false;
+        break;
+      default:
+        console.error(
+          "Usage: bun run scripts/footprint_report.ts [--matrix <file>] [--output <dir>] [--only <variant>]...\n" +
+            "                                           [--toolchain-prefix <prefix>] [--no-build]"
+        );
+        process.exit(1);
+    }
+  }
+
+  if (existsSync(resolve(repoRoot, "src", "config_generated.h"))) {
+    die("src/config_generated.h exists: the footprint variants are based on the built-in configuration (src/config.h)");
+  }
+
+  let matrix: Matrix;
+  try {
+    matrix = yamlLoad(readFileSync(matrixPath, "utf8")) as Matrix;
+  } catch (e: any) {
+    die(`Failed to load footprint matrix from ${matrixPath}: ${e.message}`);
+  }
+
+  for (const name of only) {
+    if (!matrix.variants.some((variant) => variant.name === name)) {
+      die(`Unknown variant "${name}"`);
+    }
+  }
+
+  mkdirSync(outputDir, { recursive: true });
+  const results: Footprint[] = [];
+
+  for (const variant of matrix.variants) {
+    if (only.length > 0 && !only.includes(variant.name)) {
+      continue;
+    }
+
+    for (const targetName of variant.targets) {
+      const target = matrix.targets[targetName] ?? die(`Unknown target "${targetName}" in variant "${variant.name}"`);
+      const buildDir = join(outputDir, `${variant.name}-${targetName}`);
+
+      if (build) {
+        console.log(`Building ${variant.name} for ${targetName}...`);
+        mkdirSync(buildDir, { recursive: true });
+        const overridePath = join(buildDir, "config_override.h");
+        writeFileSync(overridePath, generateOverrideHeader(matrix, variant), "utf8");
+
+        const configure = run(
+          "cmake",
+          [
+            "-S",
+            repoRoot,
+            "-B",
+            buildDir,
+            `-DCMAKE_TOOLCHAIN_FILE=${resolve(repoRoot, "cmake", "arm-none-eabi-gcc.cmake")}`,
+            ...target.cmake.split(/\s+/),
+            `-DRS41NG_CONFIG_OVERRIDE=${overridePath}`,
+            "-DRS41NG_STACK_USAGE=1",
+          ],
+          repoRoot
+        );
+        const compile = configure.ok ? run("cmake", ["--build", buildDir, "--parallel"], repoRoot) : configure;
+        if (!compile.ok) {
+          console.error(compile.output.split("\n").slice(-30).join("\n"));
+          console.error(`ERROR: build of ${variant.name} for ${targetName} failed`);
+          results.push(failedFootprint(variant, targetName));
+          continue;
+        }
+      }
+
+      results.push(analyze(matrix, variant, targetName, buildDir, `${toolchainPrefix}size`, repoRoot));
+    }
+  }
+
+  for (const result of results) {
+    const baseline = results.find((r) => r.variant === "baseline" && r.target === result.target);
+    if (baseline && baseline.status !== "build-failed" && result.status !== "build-failed") {
+      result.flash_delta = result.flash - baseline.flash;
+      result.ram_delta = result.ram - baseline.ram;
+    }
+  }
+
+  writeFileSync(join(outputDir, "footprint.json"), JSON.stringify(results, null, 2) + "\n", "utf8");
+  writeFileSync(join(outputDir, "footprint.csv"), formatCsv(results), "utf8");
+
+  printTable(results);
+  console.log(`Wrote ${join(outputDir, "footprint.json")} and ${join(outputDir, "footprint.csv")}`);
+
+  if (results.some((result) => result.status === "build-failed")) {
+    process.exit(1);
+  }
+  if (results.some((result) => result.status === "over-budget")) {
+    for (const result of results.filter((r) => r.status === "over-budget")) {
+      console.error(
+        `Over budget: ${result.variant} (${result.target}): flash ${result.flash}/${result.flash_budget}, ` +
+          `RAM ${result.ram}/${result.ram_budget}`
+      );
+    }
+    process.exit(2);
+  }
+}
+
+main();
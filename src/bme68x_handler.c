@@ -4,6 +4,7 @@
 #include "telemetry.h"
 #include "log.h"
 #include "hal/i2c.h"
+#include "hal/i2c_queue.h"
 #include "hal/delay.h"
 
 /**
@@ -24,6 +25,16 @@ static struct bme68x_conf conf;
 static struct bme68x_heatr_conf heatr_conf;
 static bool bme680_initialization_required = true;
 
+// Forced-mode measurement started by bme68x_trigger_measurement() and not read yet
+static bool bme68x_measurement_triggered = false;
+static uint32_t bme68x_measurement_ready_tick_ms = 0;
+
+#if I2C_QUEUE_ENABLE
+static uint8_t bme68x_request_buffer[BME68X_LEN_FIELD];
+static i2c_request bme68x_request;
+static telemetry_request_callback bme68x_request_callback;
+#endif
+
 BME68X_INTF_RET_TYPE bme68x_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
 {
     if (i2c_read_bytes(&DEFAULT_I2C_PORT, SENSOR_BME68X_I2C_ADDRESS, reg_addr, (uint8_t)len, reg_data) != HAL_OK) {
@@ -116,6 +127,9 @@ bool bme68x_handler_init(void)
 
     rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, &bme);
 
+    // Initialization starts a measurement of its own, the next read starts a fresh one
+    bme68x_measurement_triggered = false;
+
     if(rslt == BME68X_OK) {
         bme680_initialization_required = false;
         return true;
@@ -123,17 +137,58 @@ bool bme68x_handler_init(void)
     return false;
 }
 
+static void bme68x_start_measurement()
+{
+    bme68x_set_op_mode(BME68X_FORCED_MODE, &bme);
+
+    /* Calculate delay period in microseconds */
+    uint32_t del_period = bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, &bme) + (heatr_conf.heatr_dur * 1000);
+
+    // Round up and add a tick, as the current one may be about to end
+    bme68x_measurement_ready_tick_ms = HAL_GetTick() + (del_period + 999) / 1000 + 1;
+    bme68x_measurement_triggered = true;
+}
+
+static uint32_t bme68x_measurement_remaining_ms()
+{
+    int32_t remaining_ms = (int32_t) (bme68x_measurement_ready_tick_ms - HAL_GetTick());
+    return remaining_ms > 0 ? (uint32_t) remaining_ms : 0;
+}
+
+/**
+ * Start a forced-mode measurement that the next bme68x_read_telemetry() call reads, so that the conversion
+ * and heater time pass before it instead of blocking it. A measurement that has not been read yet is kept.
+ * Returns the time in milliseconds until the data is ready, or 0 if the sensor needs to be re-initialized first,
+ * which bme68x_read_telemetry() does.
+ */
+uint32_t bme68x_trigger_measurement()
+{
+    if (bme680_initialization_required) {
+        return 0;
+    }
+
+    if (!bme68x_measurement_triggered) {
+        bme68x_start_measurement();
+    }
+
+    return bme68x_measurement_remaining_ms();
+}
+
 bool bme68x_read(int32_t *temperature_celsius_100, uint32_t *pressure_mbar_100, uint32_t *humidity_percentage_100, uint32_t *bme680_gas_r) {
     int8_t rslt;
-    uint32_t del_period;
     struct bme68x_data data;
     uint8_t n_fields;
 
-    bme68x_set_op_mode(BME68X_FORCED_MODE, &bme);
+    if (!bme68x_measurement_triggered) {
+        bme68x_start_measurement();
+    }
 
-    /* Calculate delay period in microseconds */
-    del_period = bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, &bme) + (heatr_conf.heatr_dur * 1000);
-    bme.delay_us(del_period, bme.intf_ptr);
+    // Wait only for the part of the measurement that has not passed since it was triggered
+    uint32_t remaining_ms = bme68x_measurement_remaining_ms();
+    if (remaining_ms > 0) {
+        delay_ms(remaining_ms);
+    }
+    bme68x_measurement_triggered = false;
 
     rslt = bme68x_get_data(BME68X_FORCED_MODE, &data, &n_fields, &bme);
 
@@ -211,4 +266,79 @@ bool bme68x_read_telemetry(telemetry_data *data)
     bme680_initialization_required = !success;
 
     return success;
-}
\ No newline at end of file
+}
+
+#if I2C_QUEUE_ENABLE
+static void bme68x_request_complete(i2c_request *request)
+{
+    telemetry_data *data = (telemetry_data *) request->context;
+    struct bme68x_data field;
+
+    if (request->status != HAL_OK) {
+        log_error("BME68X read failed\n");
+        // Re-initialized with blocking transfers on the next read
+        bme680_initialization_required = true;
+        bme68x_request_callback();
+        return;
+    }
+
+    if (bme68x_compensate_field_data(request->data, &field, &bme) != BME68X_OK) {
+        // The measurement has not ended: keep the previous values
+        log_error("BME68X: no new data\n");
+        bme68x_request_callback();
+        return;
+    }
+
+    log_info("BME68X: Temperature %d, Pressure %lu, Humidity %lu, Gas R %lu, Status 0x%x\n",
+            (field.temperature / 100),
+            (long unsigned int)field.pressure,
+            (long unsigned int)(field.humidity / 1000),
+            (long unsigned int)field.gas_resistance,
+            field.status);
+
+    data->temperature_celsius_100 = field.temperature;
+    data->pressure_mbar_100 = field.pressure;
+    data->humidity_percentage_100 = field.humidity / 10;
+    data->bme6xx_gas_r = field.gas_resistance;
+    data->ext_sensor_type = SENSOR_BME68X;
+
+    bme68x_request_callback();
+}
+
+/**
+ * Queue a read of the data field of a triggered measurement whose conversion and heater time have passed.
+ * The Bosch compensation runs and the telemetry data is updated when the transfer completes, after which
+ * the callback is called. Falls back to bme68x_read_telemetry(), which waits for the measurement, while the sensor
+ * needs to be re-initialized or no finished measurement is waiting to be read, calling the callback before
+ * returning, as it does when the read cannot be queued.
+ */
+bool bme68x_request_telemetry(telemetry_data *data, telemetry_request_callback callback)
+{
+    if (bme680_initialization_required || !bme68x_measurement_triggered || bme68x_measurement_remaining_ms() > 0) {
+        bool success = bme68x_read_telemetry(data);
+        callback();
+        return success;
+    }
+
+    // Still in flight from an earlier call
+    if (bme68x_request.state != I2C_REQUEST_STATE_IDLE) {
+        callback();
+        return false;
+    }
+
+    bme68x_measurement_triggered = false;
+
+    bme68x_request.port = &DEFAULT_I2C_PORT;
+    bme68x_request.address = SENSOR_BME68X_I2C_ADDRESS;
+    bme68x_request.reg = BME68X_REG_FIELD0;
+    bme68x_request.size = BME68X_LEN_FIELD;
+    bme68x_request.data = bme68x_request_buffer;
+    bme68x_request.write = false;
+    bme68x_request.timeout_ms = I2C_QUEUE_REQUEST_TIMEOUT_MS;
+    bme68x_request.callback = bme68x_request_complete;
+    bme68x_request.context = data;
+    bme68x_request_callback = callback;
+
+    return i2c_queue_submit(&bme68x_request);
+}
+#endif
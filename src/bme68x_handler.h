@@ -6,6 +6,8 @@
 
 bool bme68x_handler_init();
 bool bme68x_read(int32_t *temperature_celsius_100, uint32_t *pressure_mbar_100, uint32_t *humidity_percentage_100, uint16_t *air_quality_index);
+uint32_t bme68x_trigger_measurement();
 bool bme68x_read_telemetry(telemetry_data *data);
+bool bme68x_request_telemetry(telemetry_data *data, telemetry_request_callback callback);
 
 #endif
@@ -4,6 +4,7 @@
 #include "telemetry.h"
 #include "log.h"
 #include "hal/i2c.h"
+#include "hal/i2c_queue.h"
 #include "hal/delay.h"
 
 /**
@@ -23,6 +24,16 @@ static struct bme69x_dev bme;
 static struct bme69x_conf conf;
 static struct bme69x_heatr_conf heatr_conf;
 static bool bme690_initialization_required = true;
+
+// Forced-mode measurement started by bme690_trigger_measurement() and not read yet
+static bool bme690_measurement_triggered = false;
+static uint32_t bme690_measurement_ready_tick_ms = 0;
+
+#if I2C_QUEUE_ENABLE
+static uint8_t bme690_request_buffer[BME69X_LEN_FIELD];
+static i2c_request bme690_request;
+static telemetry_request_callback bme690_request_callback;
+#endif
  
  BME69X_INTF_RET_TYPE bme69x_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
  {
@@ -112,6 +123,9 @@ bool bme690_handler_init(void)
 
     rslt = bme69x_set_op_mode(BME69X_FORCED_MODE, &bme);
 
+    // Initialization starts a measurement of its own, the next read starts a fresh one
+    bme690_measurement_triggered = false;
+
     if(rslt == BME69X_OK) {
         bme690_initialization_required = false;
         return true;
@@ -119,16 +133,57 @@ bool bme690_handler_init(void)
     return false;
 }
 
+static void bme690_start_measurement()
+{
+    bme69x_set_op_mode(BME69X_FORCED_MODE, &bme);
+
+    /* Calculate delay period in microseconds */
+    uint32_t del_period = bme69x_get_meas_dur(BME69X_FORCED_MODE, &conf, &bme) + (heatr_conf.heatr_dur * 1000);
+
+    // Round up and add a tick, as the current one may be about to end
+    bme690_measurement_ready_tick_ms = HAL_GetTick() + (del_period + 999) / 1000 + 1;
+    bme690_measurement_triggered = true;
+}
+
+static uint32_t bme690_measurement_remaining_ms()
+{
+    int32_t remaining_ms = (int32_t) (bme690_measurement_ready_tick_ms - HAL_GetTick());
+    return remaining_ms > 0 ? (uint32_t) remaining_ms : 0;
+}
+
+/**
+ * Start a forced-mode measurement that the next bme690_read_telemetry() call reads, so that the conversion
+ * and heater time pass before it instead of blocking it. A measurement that has not been read yet is kept.
+ * Returns the time in milliseconds until the data is ready, or 0 if the sensor needs to be re-initialized first,
+ * which bme690_read_telemetry() does.
+ */
+uint32_t bme690_trigger_measurement()
+{
+    if (bme690_initialization_required) {
+        return 0;
+    }
+
+    if (!bme690_measurement_triggered) {
+        bme690_start_measurement();
+    }
+
+    return bme690_measurement_remaining_ms();
+}
+
 bool bme690_read(int32_t *temperature_celsius_100, uint32_t *pressure_mbar_100, uint32_t *humidity_percentage_100, uint32_t *bme690_gas_r) {
-    uint32_t del_period;
     struct bme69x_data data;
     uint8_t n_fields;
 
-    bme69x_set_op_mode(BME69X_FORCED_MODE, &bme);
+    if (!bme690_measurement_triggered) {
+        bme690_start_measurement();
+    }
 
-    /* Calculate delay period in microseconds */
-    del_period = bme69x_get_meas_dur(BME69X_FORCED_MODE, &conf, &bme) + (heatr_conf.heatr_dur * 1000);
-    bme.delay_us(del_period, bme.intf_ptr);
+    // Wait only for the part of the measurement that has not passed since it was triggered
+    uint32_t remaining_ms = bme690_measurement_remaining_ms();
+    if (remaining_ms > 0) {
+        delay_ms(remaining_ms);
+    }
+    bme690_measurement_triggered = false;
 
     bme69x_get_data(BME69X_FORCED_MODE, &data, &n_fields, &bme);
 
@@ -202,4 +257,79 @@ bool bme690_read_telemetry(telemetry_data *data)
     bme690_initialization_required = !success;
 
     return success;
-}
\ No newline at end of file
+}
+
+#if I2C_QUEUE_ENABLE
+static void bme690_request_complete(i2c_request *request)
+{
+    telemetry_data *data = (telemetry_data *) request->context;
+    struct bme69x_data field;
+
+    if (request->status != HAL_OK) {
+        log_error("BME69X read failed\n");
+        // Re-initialized with blocking transfers on the next read
+        bme690_initialization_required = true;
+        bme690_request_callback();
+        return;
+    }
+
+    if (bme69x_compensate_field_data(request->data, &field, &bme) != BME69X_OK) {
+        // The measurement has not ended: keep the previous values
+        log_error("BME69X: no new data\n");
+        bme690_request_callback();
+        return;
+    }
+
+    log_info("BME69X: Temperature %d, Pressure %lu, Humidity %lu, Gas R %lu, Status 0x%x\n",
+            (field.temperature / 100),
+            (long unsigned int)field.pressure,
+            (long unsigned int)(field.humidity / 1000),
+            (long unsigned int)field.gas_resistance,
+            field.status);
+
+    data->temperature_celsius_100 = field.temperature;
+    data->pressure_mbar_100 = field.pressure;
+    data->humidity_percentage_100 = field.humidity / 10;
+    data->bme6xx_gas_r = field.gas_resistance;
+    data->ext_sensor_type = SENSOR_BME690;
+
+    bme690_request_callback();
+}
+
+/**
+ * Queue a read of the data field of a triggered measurement whose conversion and heater time have passed.
+ * The Bosch compensation runs and the telemetry data is updated when the transfer completes, after which
+ * the callback is called. Falls back to bme690_read_telemetry(), which waits for the measurement, while the sensor
+ * needs to be re-initialized or no finished measurement is waiting to be read, calling the callback before
+ * returning, as it does when the read cannot be queued.
+ */
+bool bme690_request_telemetry(telemetry_data *data, telemetry_request_callback callback)
+{
+    if (bme690_initialization_required || !bme690_measurement_triggered || bme690_measurement_remaining_ms() > 0) {
+        bool success = bme690_read_telemetry(data);
+        callback();
+        return success;
+    }
+
+    // Still in flight from an earlier call
+    if (bme690_request.state != I2C_REQUEST_STATE_IDLE) {
+        callback();
+        return false;
+    }
+
+    bme690_measurement_triggered = false;
+
+    bme690_request.port = &DEFAULT_I2C_PORT;
+    bme690_request.address = SENSOR_BME690_I2C_ADDRESS;
+    bme690_request.reg = BME69X_REG_FIELD0;
+    bme690_request.size = BME69X_LEN_FIELD;
+    bme690_request.data = bme690_request_buffer;
+    bme690_request.write = false;
+    bme690_request.timeout_ms = I2C_QUEUE_REQUEST_TIMEOUT_MS;
+    bme690_request.callback = bme690_request_complete;
+    bme690_request.context = data;
+    bme690_request_callback = callback;
+
+    return i2c_queue_submit(&bme690_request);
+}
+#endif
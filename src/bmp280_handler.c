@@ -1,4 +1,5 @@
 #include "drivers/bmp280/bmp280.h"
+#include "drivers/hal/i2c_queue.h"
 #include "bmp280_handler.h"
 #include "log.h"
 
@@ -6,6 +7,12 @@ bmp280 bmp280_dev;
 
 static bool bmp280_initialization_required = true;
 
+#if I2C_QUEUE_ENABLE
+static uint8_t bmp280_request_buffer[8];
+static i2c_request bmp280_request;
+static telemetry_request_callback bmp280_request_callback;
+#endif
+
 bool bmp280_handler_init()
 {
     bmp280_dev.port = &DEFAULT_I2C_PORT;
@@ -25,18 +32,9 @@ bool bmp280_handler_init()
     return success;
 }
 
-bool bmp280_read(int32_t *temperature_celsius_100, uint32_t *pressure_mbar_100, uint32_t *humidity_percentage_100)
+static void bmp280_convert(int32_t temperature_raw, uint32_t pressure_raw, uint32_t humidity_raw,
+        int32_t *temperature_celsius_100, uint32_t *pressure_mbar_100, uint32_t *humidity_percentage_100)
 {
-    int32_t temperature_raw;
-    uint32_t pressure_raw;
-    uint32_t humidity_raw;
-
-    bool success = bmp280_read_fixed(&bmp280_dev, &temperature_raw, &pressure_raw, &humidity_raw);
-    if (!success) {
-        log_error("BMP280 read failed\n");
-        return false;
-    }
-
     if (temperature_celsius_100) {
         *temperature_celsius_100 = temperature_raw;
     }
@@ -48,10 +46,35 @@ bool bmp280_read(int32_t *temperature_celsius_100, uint32_t *pressure_mbar_100,
     if (humidity_percentage_100) {
         *humidity_percentage_100 = (uint32_t) (((float) humidity_raw) * 100.0f / 1024.0f);
     }
+}
+
+bool bmp280_read(int32_t *temperature_celsius_100, uint32_t *pressure_mbar_100, uint32_t *humidity_percentage_100)
+{
+    int32_t temperature_raw;
+    uint32_t pressure_raw;
+    uint32_t humidity_raw;
+
+    bool success = bmp280_read_fixed(&bmp280_dev, &temperature_raw, &pressure_raw, &humidity_raw);
+    if (!success) {
+        log_error("BMP280 read failed\n");
+        return false;
+    }
+
+    bmp280_convert(temperature_raw, pressure_raw, humidity_raw,
+            temperature_celsius_100, pressure_mbar_100, humidity_percentage_100);
 
     return true;
 }
 
+/**
+ * The sensor measures continuously in normal mode, so the registers always hold a recent measurement.
+ * Nothing to start: returns 0, as the data is ready for bmp280_read_telemetry() right away.
+ */
+uint32_t bmp280_trigger_measurement()
+{
+    return 0;
+}
+
 bool bmp280_read_telemetry(telemetry_data *data)
 {
     bool success;
@@ -106,3 +129,62 @@ bool bmp280_read_telemetry(telemetry_data *data)
 
     return success;
 }
+
+#if I2C_QUEUE_ENABLE
+static void bmp280_request_complete(i2c_request *request)
+{
+    telemetry_data *data = (telemetry_data *) request->context;
+
+    if (request->status != HAL_OK) {
+        log_error("BMP280 read failed\n");
+        // Re-initialized with blocking transfers on the next read
+        bmp280_initialization_required = true;
+        bmp280_request_callback();
+        return;
+    }
+
+    int32_t temperature_raw;
+    uint32_t pressure_raw;
+    uint32_t humidity_raw;
+    bmp280_compensate_fixed(&bmp280_dev, request->data, &temperature_raw, &pressure_raw, &humidity_raw);
+
+    bmp280_convert(temperature_raw, pressure_raw, humidity_raw,
+            &data->temperature_celsius_100, &data->pressure_mbar_100, &data->humidity_percentage_100);
+    data->ext_sensor_type = (bmp280_dev.id == BMP280_CHIP_ID) ? SENSOR_BMP280 : SENSOR_BME280;
+
+    bmp280_request_callback();
+}
+
+/**
+ * Queue a read of the sensor data registers. The telemetry data is updated when the transfer completes, after which
+ * the callback is called. Falls back to bmp280_read_telemetry() while the sensor needs to be re-initialized,
+ * calling the callback before returning, as it does when the read cannot be queued.
+ */
+bool bmp280_request_telemetry(telemetry_data *data, telemetry_request_callback callback)
+{
+    if (bmp280_initialization_required) {
+        bool success = bmp280_read_telemetry(data);
+        callback();
+        return success;
+    }
+
+    // Still in flight from an earlier call
+    if (bmp280_request.state != I2C_REQUEST_STATE_IDLE) {
+        callback();
+        return false;
+    }
+
+    bmp280_request.port = bmp280_dev.port;
+    bmp280_request.address = bmp280_dev.addr;
+    bmp280_request.reg = BMP280_REG_DATA;
+    bmp280_request.size = bmp280_data_size(&bmp280_dev);
+    bmp280_request.data = bmp280_request_buffer;
+    bmp280_request.write = false;
+    bmp280_request.timeout_ms = I2C_QUEUE_REQUEST_TIMEOUT_MS;
+    bmp280_request.callback = bmp280_request_complete;
+    bmp280_request.context = data;
+    bmp280_request_callback = callback;
+
+    return i2c_queue_submit(&bmp280_request);
+}
+#endif
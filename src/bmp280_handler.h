@@ -6,6 +6,8 @@
 
 bool bmp280_handler_init();
 bool bmp280_read(int32_t *temperature_celsius_100, uint32_t *pressure_mbar_100, uint32_t *humidity_percentage_100);
+uint32_t bmp280_trigger_measurement();
 bool bmp280_read_telemetry(telemetry_data *data);
+bool bmp280_request_telemetry(telemetry_data *data, telemetry_request_callback callback);
 
 #endif
@@ -0,0 +1,81 @@
+#include <string.h>
+
+#include "afsk.h"
+
+static void afsk_generator_next_symbol(afsk_generator *generator)
+{
+    int8_t tone_index = generator->finished ? -1 : generator->next_tone();
+
+    if (tone_index < 0 || tone_index >= AFSK_TONE_COUNT_MAX) {
+        generator->finished = true;
+        tone_index = generator->idle_tone_index;
+        generator->symbol_remaining_q8 = UINT32_MAX;
+    } else {
+        // Distribute the fractional part of the symbol period evenly over the symbols
+        generator->symbol_remaining_q8 = generator->symbol_period_q8;
+        generator->symbol_period_remainder_sum += generator->symbol_period_remainder;
+        if (generator->symbol_period_remainder_sum >= generator->symbol_rate) {
+            generator->symbol_period_remainder_sum -= generator->symbol_rate;
+            generator->symbol_remaining_q8++;
+        }
+    }
+
+    if (tone_index != generator->current_tone_index) {
+        // Keep the phase: the rest of the half cycle in progress is completed at the new tone
+        generator->toggle_remaining_q8 = (uint32_t) (((uint64_t) generator->toggle_remaining_q8
+                * generator->half_period_q8[tone_index]) / generator->half_period_q8[generator->current_tone_index]);
+        generator->current_tone_index = tone_index;
+    }
+}
+
+void afsk_generator_init(afsk_generator *generator, uint32_t timer_clock_hz, uint32_t symbol_rate,
+        fsk_tone *tones, int8_t idle_tone_index, int8_t (*next_tone)())
+{
+    memset(generator, 0, sizeof(afsk_generator));
+
+    generator->next_tone = next_tone;
+    generator->symbol_rate = symbol_rate;
+    generator->symbol_period_q8 = (uint32_t) (((uint64_t) timer_clock_hz << 8U) / symbol_rate);
+    generator->symbol_period_remainder = (uint32_t) (((uint64_t) timer_clock_hz << 8U) % symbol_rate);
+    generator->idle_tone_index = idle_tone_index;
+
+    for (int8_t i = 0; i < AFSK_TONE_COUNT_MAX; i++) {
+        generator->half_period_q8[i] = (uint32_t) (((uint64_t) timer_clock_hz * 100U << 8U)
+                / (2U * tones[i].frequency_hz_100));
+    }
+
+    generator->current_tone_index = idle_tone_index;
+    generator->toggle_remaining_q8 = generator->half_period_q8[idle_tone_index];
+    afsk_generator_next_symbol(generator);
+}
+
+uint16_t afsk_generator_fill(afsk_generator *generator, uint16_t length, uint16_t *periods)
+{
+    uint16_t symbol_period_count = 0;
+
+    for (uint16_t i = 0; i < length; i++) {
+        uint32_t interval_q8 = 0;
+
+        if (!generator->finished) {
+            symbol_period_count = i + 1;
+        }
+
+        while (generator->toggle_remaining_q8 > generator->symbol_remaining_q8) {
+            // The symbol ends before the next toggle
+            interval_q8 += generator->symbol_remaining_q8;
+            generator->toggle_remaining_q8 -= generator->symbol_remaining_q8;
+            afsk_generator_next_symbol(generator);
+        }
+
+        interval_q8 += generator->toggle_remaining_q8;
+        generator->symbol_remaining_q8 -= generator->toggle_remaining_q8;
+        generator->toggle_remaining_q8 = generator->half_period_q8[generator->current_tone_index];
+
+        // Carry the sub-tick part over to the next period so that rounding does not accumulate
+        interval_q8 += generator->tick_remainder_q8;
+        generator->tick_remainder_q8 = interval_q8 & 0xFFU;
+        periods[i] = (uint16_t) ((interval_q8 >> 8U) - 1U);
+    }
+
+    return symbol_period_count;
+}
@@ -0,0 +1,54 @@
+#ifndef __AFSK_H
+#define __AFSK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "codecs/fsk/fsk.h"
+
+#define AFSK_TONE_COUNT_MAX 2
+
+/**
+ * Phase-continuous AFSK synthesis for a square wave generated by a timer in output compare toggle mode.
+ *
+ * Produces the length of every half cycle of the waveform as a timer period (ticks - 1, as written to ARR).
+ * Tones switch exactly at symbol boundaries: the half cycle in progress at a boundary is completed at the
+ * new tone without resetting the phase, so no timing error accumulates between symbols.
+ * All times are kept in 1/256 timer ticks.
+ */
+typedef struct _afsk_generator {
+    int8_t (*next_tone)();
+
+    uint32_t half_period_q8[AFSK_TONE_COUNT_MAX];
+    uint32_t symbol_rate;
+    uint32_t symbol_period_q8;
+    uint32_t symbol_period_remainder;
+    int8_t idle_tone_index;
+
+    bool finished;
+    int8_t current_tone_index;
+    uint32_t symbol_period_remainder_sum;
+    uint32_t symbol_remaining_q8;
+    uint32_t toggle_remaining_q8;
+    uint32_t tick_remainder_q8;
+} afsk_generator;
+
+/**
+ * @param generator
+ * @param timer_clock_hz Tick rate of the timer generating the waveform
+ * @param symbol_rate Symbols per second
+ * @param tones Tone frequencies for tone indexes 0 ... AFSK_TONE_COUNT_MAX - 1
+ * @param idle_tone_index Tone sent after the last symbol
+ * @param next_tone Source of tone indexes, returns a negative value after the last symbol
+ */
+void afsk_generator_init(afsk_generator *generator, uint32_t timer_clock_hz, uint32_t symbol_rate,
+        fsk_tone *tones, int8_t idle_tone_index, int8_t (*next_tone)());
+
+/**
+ * Fills the buffer with timer periods. After the last symbol, the idle tone is used as padding.
+ *
+ * @return Number of periods that still contain symbols: less than length once the last symbol has been generated
+ */
+uint16_t afsk_generator_fill(afsk_generator *generator, uint16_t length, uint16_t *periods);
+
+#endif
@@ -1,62 +1,86 @@
-#include <string.h>
 #include <stdbool.h>
 
 #include "aprs_9600.h"
 #include "codecs/ax25/ax25.h"
 
-#define G3RUH_PREAMBLE_FLAGS 64
-
+/**
+ * Bits are collected in transmission order (oldest bit in the most significant position) and
+ * scrambled a byte at a time.
+ */
 typedef struct {
     uint8_t *output;
     uint16_t max_length;
-    uint16_t byte_index;
-    uint8_t bit_index;
+    uint16_t length;
+    uint32_t pending_bits;
+    uint8_t pending_bit_count;
     uint32_t scrambler_state;
     uint8_t nrzi_state;
 } g3ruh_state;
 
 static void g3ruh_init(g3ruh_state *state, uint8_t *output, uint16_t max_length)
 {
-    memset(state, 0, sizeof(g3ruh_state));
     state->output = output;
     state->max_length = max_length;
-    state->bit_index = 7;
-    memset(output, 0, max_length);
+    state->length = 0;
+    state->pending_bits = 0;
+    state->pending_bit_count = 0;
+    state->scrambler_state = 0;
+    state->nrzi_state = 0;
+}
+
+static inline uint8_t g3ruh_reverse_bits(uint8_t byte)
+{
+    byte = (uint8_t) ((byte & 0xF0U) >> 4U | (byte & 0x0FU) << 4U);
+    byte = (uint8_t) ((byte & 0xCCU) >> 2U | (byte & 0x33U) << 2U);
+    byte = (uint8_t) ((byte & 0xAAU) >> 1U | (byte & 0x55U) << 1U);
+    return byte;
 }
 
 /**
- * Emit one bit through the G3RUH scrambler into the output buffer.
+ * Scramble and NRZI encode up to 8 bits in transmission order, MSB first, and store them in the output buffer.
  *
  * G3RUH uses a self-synchronizing scrambler with polynomial x^17 + x^12 + 1:
  *   out[n] = in[n] XOR out[n-12] XOR out[n-17]
+ * Both taps are further back than 8 bits, so a whole byte only depends on earlier output bits
+ * and is scrambled with two shifts of the output history (newest bit in bit 0).
+ *
+ * NRZI: a 0 bit toggles the line, so each output level is the running parity of the zero bits,
+ * computed for the whole byte with a prefix XOR.
  *
  * Output bits are packed MSB-first into bytes for the SI4032 FIFO.
  */
-static void g3ruh_emit_bit(g3ruh_state *state, uint8_t bit)
+static void g3ruh_emit_scrambled(g3ruh_state *state, uint8_t bits, uint8_t bit_count)
 {
-    if (state->byte_index >= state->max_length) {
+    if (state->length >= state->max_length) {
         return;
     }
 
-    uint8_t tap12 = (state->scrambler_state >> 11) & 1;
-    uint8_t tap17 = (state->scrambler_state >> 16) & 1;
-    uint8_t scrambled = (bit ^ tap12 ^ tap17) & 1;
-    state->scrambler_state = (state->scrambler_state << 1) | scrambled;
+    uint8_t mask = (uint8_t) (0xFFU << (8U - bit_count));
+    uint8_t scrambled = (uint8_t) ((bits ^ (state->scrambler_state >> 4U) ^ (state->scrambler_state >> 9U)) & mask);
+    state->scrambler_state = (state->scrambler_state << bit_count) | (scrambled >> (8U - bit_count));
 
-    // NRZI encode: 0 bit = toggle, 1 bit = no change
-    if (!scrambled) {
-        state->nrzi_state ^= 1;
-    }
+    uint8_t toggles = (uint8_t) (~scrambled & mask);
+    toggles ^= toggles >> 1U;
+    toggles ^= toggles >> 2U;
+    toggles ^= toggles >> 4U;
 
-    if (state->nrzi_state) {
-        state->output[state->byte_index] |= (1U << state->bit_index);
-    }
+    uint8_t levels = (uint8_t) ((state->nrzi_state ? ~toggles : toggles) & mask);
+    state->nrzi_state = (levels >> (8U - bit_count)) & 1U;
+
+    state->output[state->length++] = levels;
+}
 
-    if (state->bit_index == 0) {
-        state->bit_index = 7;
-        state->byte_index++;
-    } else {
-        state->bit_index--;
+/**
+ * Append bits (at most 24) in transmission order, the oldest bit being the most significant one
+ */
+static inline void g3ruh_push_bits(g3ruh_state *state, uint32_t bits, uint8_t bit_count)
+{
+    state->pending_bits = (state->pending_bits << bit_count) | bits;
+    state->pending_bit_count += bit_count;
+
+    while (state->pending_bit_count >= 8) {
+        state->pending_bit_count -= 8;
+        g3ruh_emit_scrambled(state, (uint8_t) (state->pending_bits >> state->pending_bit_count), 8);
     }
 }
 
@@ -66,9 +90,7 @@ static void g3ruh_emit_bit(g3ruh_state *state, uint8_t bit)
  */
 static void g3ruh_emit_byte_raw(g3ruh_state *state, uint8_t byte)
 {
-    for (uint8_t i = 0; i < 8; i++) {
-        g3ruh_emit_bit(state, (byte >> i) & 1);
-    }
+    g3ruh_push_bits(state, g3ruh_reverse_bits(byte), 8);
 }
 
 /**
@@ -78,30 +100,55 @@ static void g3ruh_emit_byte_raw(g3ruh_state *state, uint8_t byte)
  */
 static uint8_t g3ruh_emit_byte_stuffed(g3ruh_state *state, uint8_t byte, uint8_t ones_count)
 {
+    // The byte in transmission order (LSB first) after the run of ones carried over from the previous bytes
+    uint16_t run = (uint16_t) ((byte << ones_count) | ((1U << ones_count) - 1U));
+
+    if ((run & (run >> 1U) & (run >> 2U) & (run >> 3U) & (run >> 4U)) == 0) {
+        // No run of five ones: nothing to stuff, and the byte contains at least one zero bit
+        g3ruh_push_bits(state, g3ruh_reverse_bits(byte), 8);
+
+        uint8_t trailing_ones = 0;
+        for (uint8_t top = byte; top & 0x80U; top <<= 1U) {
+            trailing_ones++;
+        }
+
+        return trailing_ones;
+    }
+
+    uint32_t bits = 0;
+    uint8_t bit_count = 0;
+
     for (uint8_t i = 0; i < 8; i++) {
-        uint8_t bit = (byte >> i) & 1;
-        g3ruh_emit_bit(state, bit);
+        uint8_t bit = (byte >> i) & 1U;
+        bits = (bits << 1U) | bit;
+        bit_count++;
 
         if (bit) {
             ones_count++;
             if (ones_count == 5) {
-                g3ruh_emit_bit(state, 0);
+                bits <<= 1U;
+                bit_count++;
                 ones_count = 0;
             }
         } else {
             ones_count = 0;
         }
     }
+
+    g3ruh_push_bits(state, bits, bit_count);
+
     return ones_count;
 }
 
-static uint16_t g3ruh_get_output_length(g3ruh_state *state)
+static uint16_t g3ruh_finish(g3ruh_state *state)
 {
-    uint16_t total = state->byte_index;
-    if (state->bit_index < 7) {
-        total++;
+    if (state->pending_bit_count > 0) {
+        uint8_t bits = (uint8_t) (state->pending_bits << (8U - state->pending_bit_count));
+        g3ruh_emit_scrambled(state, bits, state->pending_bit_count);
+        state->pending_bit_count = 0;
     }
-    return total;
+
+    return state->length;
 }
 
 /**
@@ -114,6 +161,7 @@ static uint16_t g3ruh_get_output_length(g3ruh_state *state)
  *   3. Bit-stuffed frame data (addresses, control, PID, info, FCS)
  *   4. Closing flag
  *   All bits are passed through the G3RUH scrambler.
+ * Any unused bits of the last byte are zero.
  */
 uint16_t g3ruh_encode(uint8_t *ax25_frame, uint16_t ax25_length, uint8_t *output, uint16_t max_output_length)
 {
@@ -137,5 +185,5 @@ uint16_t g3ruh_encode(uint8_t *ax25_frame, uint16_t ax25_length, uint8_t *output
     // Closing flag
     g3ruh_emit_byte_raw(&state, AX25_PACKET_FLAG);
 
-    return g3ruh_get_output_length(&state);
+    return g3ruh_finish(&state);
 }
@@ -3,6 +3,15 @@
 
 #include <stdint.h>
 
+#define G3RUH_PREAMBLE_FLAGS 64
+
+/**
+ * Upper bound of the g3ruh_encode() output length for an AX.25 frame of the given length, flags included:
+ * the preamble and the frame, plus a stuffed bit for every 5 bits of the frame between its flags.
+ */
+#define G3RUH_ENCODED_MAX_LENGTH(ax25_length) \
+    (G3RUH_PREAMBLE_FLAGS + (ax25_length) + ((ax25_length) - 2 + 4) / 5)
+
 uint16_t g3ruh_encode(uint8_t *ax25_frame, uint16_t ax25_length, uint8_t *output, uint16_t max_output_length);
 
 #endif
@@ -1,47 +1,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include "ax25.h"
-
-static inline uint16_t ax25_calculate_crc_for_bit(uint16_t crc, bool bit)
-{
-    uint16_t result = crc;
-    uint16_t temp;
-
-    // XOR lsb of CRC with the latest bit
-    temp = crc ^ (bit ? 1U : 0U);
-    // Shift 16-bit CRC one bit to the right
-    result >>= 1U;
-
-    // If XOR result from above has lsb set
-    if (temp & 0x0001U) {
-        result ^= 0x8408U;
-    }
-
-    return result;
-}
-
-static inline uint16_t ax25_calculate_crc_for_byte(uint16_t crc, uint8_t byte)
-{
-    uint8_t temp = byte;
-    for (uint16_t i = 0; i < 8; i++, temp >>= 1U) {
-        bool bit = ((temp & 1U) == 1U) ? true : false;
-        crc = ax25_calculate_crc_for_bit(crc, bit);
-    }
-
-    return crc;
-}
-
-static uint16_t ax25_calculate_crc(uint16_t length, uint8_t *data)
-{
-    uint16_t crc = 0xFFFF;
-
-    for (uint16_t i = 0; i < length; i++) {
-        uint8_t byte = data[i];
-        crc = ax25_calculate_crc_for_byte(crc, byte);
-    }
-
-    return crc;
-}
+#include "codecs/crc/crc16.h"
 
 static uint16_t ax25_encode_digipeater_path(char *input, char *packet_data)
 {
@@ -111,7 +71,7 @@ uint16_t ax25_encode_packet_aprs(char *source, uint8_t source_ssid, char *destin
     strcpy(header_end->information_field, information_field);
 
     uint16_t crc_length = 14 + digipeater_addresses_length + 2 + info_length;
-    uint16_t crc = ax25_calculate_crc(crc_length, actual_data_start);
+    uint16_t crc = crc16_x25_update(CRC16_INIT, actual_data_start, crc_length);
 
     ax25_packet_footer *footer = (ax25_packet_footer *) (((uint8_t *) header_end->information_field) + info_length);
 
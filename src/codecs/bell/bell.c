@@ -4,9 +4,6 @@
 #include "codecs/ax25/ax25.h"
 #include "bell.h"
 
-#define FSK_TONE_INDEX_BELL_SPACE 0
-#define FSK_TONE_INDEX_BELL_MARK 1
-
 #define BELL_TONE_COUNT 2
 
 typedef struct _bell_encoder {
@@ -92,6 +89,7 @@ void bell_encoder_get_tones(fsk_encoder *encoder, int8_t *tone_count, fsk_tone *
 
 uint32_t bell_encoder_get_tone_spacing(fsk_encoder *encoder)
 {
+    (void) encoder;
     return 0;
 }
 
@@ -103,6 +101,7 @@ uint32_t bell_encoder_get_symbol_rate(fsk_encoder *encoder)
 
 uint32_t bell_encoder_get_symbol_delay(fsk_encoder *encoder)
 {
+    (void) encoder;
     return 0;
 }
 
@@ -162,6 +161,18 @@ int8_t bell_encoder_next_tone(fsk_encoder *encoder)
     return bell->current_tone_index;
 }
 
+bool bell_encoder_render(fsk_encoder *encoder, fsk_symbol_stream *stream)
+{
+    bell_encoder *bell = (bell_encoder *) encoder->priv;
+
+    bell_encoder_set_data(encoder, bell->data_length, bell->data);
+    bool success = fsk_symbol_stream_render(stream, 1, encoder, bell_encoder_next_tone);
+
+    bell_encoder_set_data(encoder, bell->data_length, bell->data);
+
+    return success;
+}
+
 fsk_encoder_api bell_fsk_encoder_api = {
         .get_tones = bell_encoder_get_tones,
         .get_tone_spacing = bell_encoder_get_tone_spacing,
@@ -169,4 +180,5 @@ fsk_encoder_api bell_fsk_encoder_api = {
         .get_symbol_delay = bell_encoder_get_symbol_delay,
         .set_data = bell_encoder_set_data,
         .next_tone = bell_encoder_next_tone,
+        .render = bell_encoder_render,
 };
@@ -6,6 +6,9 @@
 
 #include "codecs/fsk/fsk.h"
 
+#define FSK_TONE_INDEX_BELL_SPACE 0
+#define FSK_TONE_INDEX_BELL_MARK 1
+
 #define BELL_FLAG_FIELD_COUNT_1200 45
 #define BELL_FLAG_FIELD_COUNT_300 45
 
@@ -15,6 +18,7 @@ void bell_encoder_set_data(fsk_encoder *encoder, uint16_t data_length, uint8_t *
 void bell_encoder_get_tones(fsk_encoder *encoder, int8_t *tone_count, fsk_tone **tones);
 uint32_t bell_encoder_get_symbol_rate(fsk_encoder *encoder);
 int8_t bell_encoder_next_tone(fsk_encoder *encoder);
+bool bell_encoder_render(fsk_encoder *encoder, fsk_symbol_stream *stream);
 
 extern fsk_tone bell202_tones[];
 extern fsk_tone bell103_tones[];
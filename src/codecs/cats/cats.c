@@ -12,6 +12,14 @@ cats_packet cats_create(uint8_t *data)
     return c;
 }
 
+// The length of the output of cats_fully_encode().
+// CRC, whitening and LDPC run in place: packet->data needs room for this many bytes, minus the 2 length bytes.
+size_t cats_fully_encoded_length(cats_packet *packet)
+{
+    return cats_ldpc_encoded_length(packet->len + 2) + 2;
+}
+
+// The interleaver reads packet->data while writing out, so the two must not overlap.
 // This makes changes to packet->data.
 // Don't call it more than once, and don't use
 // the packet after calling!
@@ -10,6 +10,7 @@ typedef struct _cats_packet {
 } cats_packet;
 
 cats_packet cats_create(uint8_t *payload);
+size_t cats_fully_encoded_length(cats_packet *packet);
 size_t cats_fully_encode(cats_packet packet, uint8_t *out);
 
 #endif
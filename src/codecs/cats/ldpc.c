@@ -22,9 +22,18 @@ cats_ldpc_code_t *cats_ldpc_pick_code(size_t len)
     }
 }
 
+// Parity of the largest code (tm2048) in 32-bit words
+#define CATS_LDPC_MAX_PARITY_WORDS (1024 / 32)
+
 // For more information on this, see the CATS standard
 // https://gitlab.scd31.com/cats/cats-standard
 // Section 5.2
+//
+// Parity is kept in 32-bit words, most significant bit first, the same bit order as the output bytes.
+// For every circulant offset, the generator rows of the set data bits are XORed in,
+// and then each parity block is rotated left by one bit.
+// Circulants of 32 bits or more span whole words and are rotated with a carry from word to word,
+// 16-bit circulants (tc128) are rotated as two halves of one word.
 // returns # of bytes written to parity_out
 size_t cats_ldpc_encode_chunk(uint8_t *data, cats_ldpc_code_t *code, uint8_t *parity_out)
 {
@@ -34,36 +43,67 @@ size_t cats_ldpc_encode_chunk(uint8_t *data, cats_ldpc_code_t *code, uint8_t *pa
     int circ_size = (int) code->circulant_size;
     const uint64_t* gc = code->matrix;
     int row_len = parity_length_bits / 64;
+    int parity_words = parity_length_bits / 32;
+    int circ_words = circ_size / 32;
+    int crows = data_length_bits / circ_size;
+
+    assert(parity_words <= CATS_LDPC_MAX_PARITY_WORDS);
 
-    memset(parity_out, 0x00, parity_length_bits / 8);
+    uint32_t parity[CATS_LDPC_MAX_PARITY_WORDS];
+    memset(parity, 0x00, parity_words * sizeof(uint32_t));
 
     for (int offset = 0; offset < circ_size; offset++) {
-        for (int crow = 0; crow < data_length_bits / circ_size; crow++) {
+        for (int crow = 0; crow < crows; crow++) {
             int bit = crow * circ_size + offset;
             if (GET_BIT(data[bit / 8], bit % 8)) {
+                const uint64_t *row = &gc[crow * row_len];
                 for (int idx = 0; idx < row_len; idx++) {
-                    uint64_t circ = gc[(crow * row_len) + idx];
-                    for (int j = 0; j < 8; j++) {
-                        parity_out[idx * 8 + j] ^= (uint8_t)(circ >> ((7 - j) * 8));
-                    }
+                    parity[idx * 2] ^= (uint32_t) (row[idx] >> 32);
+                    parity[idx * 2 + 1] ^= (uint32_t) row[idx];
                 }
             }
         }
 
-        for (int block = 0; block < parity_length_bits / circ_size; block++) {
-            uint8_t* parityblock = &parity_out[block * circ_size / 8];
-            uint8_t carry = parityblock[0] >> 7;
-            for (int x = (circ_size / 8) - 1; x >= 0; x--) {
-                uint8_t c = parityblock[x] >> 7;
-                parityblock[x] = (parityblock[x] << 1) | carry;
-                carry = c;
+        if (circ_words == 0) {
+            for (int x = 0; x < parity_words; x++) {
+                uint32_t word = parity[x];
+                parity[x] = ((word << 1) & 0xFFFEFFFEUL) | ((word >> 15) & 0x00010001UL);
+            }
+        } else {
+            for (int block = 0; block < parity_words; block += circ_words) {
+                uint32_t *parityblock = &parity[block];
+                uint32_t carry = parityblock[0] >> 31;
+                for (int x = circ_words - 1; x >= 0; x--) {
+                    uint32_t c = parityblock[x] >> 31;
+                    parityblock[x] = (parityblock[x] << 1) | carry;
+                    carry = c;
+                }
             }
         }
     }
 
+    for (int x = 0; x < parity_words; x++) {
+        parity_out[x * 4] = (uint8_t) (parity[x] >> 24);
+        parity_out[x * 4 + 1] = (uint8_t) (parity[x] >> 16);
+        parity_out[x * 4 + 2] = (uint8_t) (parity[x] >> 8);
+        parity_out[x * 4 + 3] = (uint8_t) parity[x];
+    }
+
     return parity_length_bits / 8;
 }
 
+// The length of the data after cats_ldpc_encode(), including its parity and length bytes
+size_t cats_ldpc_encoded_length(size_t len)
+{
+    size_t i = 0;
+    while (i < len) {
+        cats_ldpc_code_t *code = cats_ldpc_pick_code(len - i);
+        i += (code->code_length_bits - code->data_length_bits) / 8;
+    }
+
+    return (len * 2) + (i - len) + 2;
+}
+
 size_t cats_ldpc_encode(uint8_t *data, size_t len)
 {
     // Didn't implement the 512-byte LDPC variant - unnecessary and uses a lot of space
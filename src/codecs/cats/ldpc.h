@@ -4,6 +4,11 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "ldpc_matrices.h"
+
+cats_ldpc_code_t *cats_ldpc_pick_code(size_t len);
+size_t cats_ldpc_encode_chunk(uint8_t *data, cats_ldpc_code_t *code, uint8_t *parity_out);
+size_t cats_ldpc_encoded_length(size_t len);
 size_t cats_ldpc_encode(uint8_t *data, size_t len);
 
 #endif
@@ -0,0 +1,45 @@
+#ifndef __CRC16_H
+#define __CRC16_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+
+#define CRC16_INIT 0xFFFF
+
+/**
+ * Table-driven CRC-16 with the CRC-CCITT polynomial.
+ *
+ * crc16_ccitt_*: MSB first, as used by Horus (CRC-16/CCITT-FALSE with CRC16_INIT).
+ * crc16_x25_*: LSB first, as used by the AX.25 FCS and CATS (CRC-16/X-25 with CRC16_INIT, result inverted).
+ *
+ * Each takes the CRC computed so far (CRC16_INIT to start) and returns the CRC updated with the data.
+ * The nibble variants use 16-entry tables (32 bytes of flash each), the byte variants 256-entry tables
+ * (512 bytes each) and are roughly twice as fast. CRC16_BYTE_TABLE_ENABLE selects which one the codecs use.
+ */
+
+uint16_t crc16_ccitt_update_nibble(uint16_t crc, const uint8_t *data, size_t length);
+uint16_t crc16_ccitt_update_byte(uint16_t crc, const uint8_t *data, size_t length);
+uint16_t crc16_x25_update_nibble(uint16_t crc, const uint8_t *data, size_t length);
+uint16_t crc16_x25_update_byte(uint16_t crc, const uint8_t *data, size_t length);
+
+static inline uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t *data, size_t length)
+{
+#if CRC16_BYTE_TABLE_ENABLE
+    return crc16_ccitt_update_byte(crc, data, length);
+#else
+    return crc16_ccitt_update_nibble(crc, data, length);
+#endif
+}
+
+static inline uint16_t crc16_x25_update(uint16_t crc, const uint8_t *data, size_t length)
+{
+#if CRC16_BYTE_TABLE_ENABLE
+    return crc16_x25_update_byte(crc, data, length);
+#else
+    return crc16_x25_update_nibble(crc, data, length);
+#endif
+}
+
+#endif
@@ -0,0 +1,30 @@
+#include <string.h>
+
+#include "fsk.h"
+
+bool fsk_symbol_stream_render(fsk_symbol_stream *stream, uint8_t bits_per_symbol,
+        fsk_encoder *encoder, int8_t (*next_tone)(fsk_encoder *encoder))
+{
+    uint32_t symbol_capacity = (uint32_t) stream->symbols_length * 8U / bits_per_symbol;
+    uint32_t symbol_count = 0;
+    int8_t tone_index;
+
+    memset(stream->symbols, 0, stream->symbols_length);
+    stream->bits_per_symbol = bits_per_symbol;
+    stream->symbol_count = 0;
+    stream->current_symbol_index = 0;
+
+    while ((tone_index = next_tone(encoder)) >= 0) {
+        if (symbol_count >= symbol_capacity) {
+            return false;
+        }
+
+        uint32_t bit_index = symbol_count * bits_per_symbol;
+        stream->symbols[bit_index >> 3U] |= (uint8_t) (tone_index << (bit_index & 7U));
+        symbol_count++;
+    }
+
+    stream->symbol_count = symbol_count;
+
+    return true;
+}
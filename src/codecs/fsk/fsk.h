@@ -1,6 +1,9 @@
 #ifndef __FSK_H
 #define __FSK_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #define FSK_TONE_COUNT_MAX 20
 
 typedef struct _fsk_tone {
@@ -12,6 +15,18 @@ typedef struct _fsk_encoder {
     void *priv;
 } fsk_encoder;
 
+/**
+ * Tone indexes of a whole packet, packed LSB first with bits_per_symbol (1, 2, 4 or 8) bits per symbol
+ */
+typedef struct _fsk_symbol_stream {
+    uint8_t *symbols;
+    uint16_t symbols_length;
+    uint8_t bits_per_symbol;
+
+    uint32_t symbol_count;
+    uint32_t current_symbol_index;
+} fsk_symbol_stream;
+
 typedef struct _fsk_encoder_api {
     /**
      * @param encoder
@@ -53,6 +68,32 @@ typedef struct _fsk_encoder_api {
     void (*set_data)(fsk_encoder *encoder, uint16_t data_length, uint8_t *data);
 
     int8_t (*next_tone)(fsk_encoder *encoder);
+
+    /**
+     * Optional: expands the whole packet set with set_data() into a symbol stream in thread mode, so that
+     * the data timer interrupt only needs fsk_symbol_stream_next_tone(). The encoder is rewound afterwards,
+     * so next_tone() can still be used if the stream does not fit.
+     *
+     * @param encoder
+     * @param stream Stream with the symbols buffer and its length set
+     * @return true if the whole packet fits in the stream, false otherwise or NULL if not supported
+     */
+    bool (*render)(fsk_encoder *encoder, fsk_symbol_stream *stream);
 } fsk_encoder_api;
 
+bool fsk_symbol_stream_render(fsk_symbol_stream *stream, uint8_t bits_per_symbol,
+        fsk_encoder *encoder, int8_t (*next_tone)(fsk_encoder *encoder));
+
+static inline int8_t fsk_symbol_stream_next_tone(fsk_symbol_stream *stream)
+{
+    if (stream->current_symbol_index >= stream->symbol_count) {
+        return -1;
+    }
+
+    uint32_t bit_index = stream->current_symbol_index * stream->bits_per_symbol;
+    stream->current_symbol_index++;
+
+    return (int8_t) ((stream->symbols[bit_index >> 3U] >> (bit_index & 7U)) & ((1U << stream->bits_per_symbol) - 1U));
+}
+
 #endif
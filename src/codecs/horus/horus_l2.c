@@ -55,7 +55,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include "config.h"
 #include "horus_l2.h"
+#include "codecs/crc/crc16.h"
 
 #ifdef HORUS_L2_UNITTEST
 #define HORUS_L2_RX
@@ -66,7 +68,7 @@
 #define INTERLEAVER
 #define SCRAMBLER
 
-static char uw[] = {'$', '$'};
+static char uw[HORUS_L2_TX_PAYLOAD_OFFSET] = {'$', '$'};
 
 /* Function Prototypes ------------------------------------------------*/
 
@@ -119,6 +121,132 @@ int horus_l2_get_num_tx_data_bytes(int num_payload_data_bytes)
   Takes an array of payload data bytes, prepends a unique word and appends
   parity bits.
 
+  HORUS_L2_GOLAY_TABLE_ENABLE selects horus_l2_encode_golay_table(),
+  otherwise the original bit-serial horus_l2_encode_golay_bitwise() is
+  used. Both produce identical output.
+ */
+
+int horus_l2_encode_tx_packet(unsigned char *output_tx_data,
+                              unsigned char *input_payload_data,
+        int num_payload_data_bytes)
+{
+#if HORUS_L2_GOLAY_TABLE_ENABLE
+    int num_tx_data_bytes = horus_l2_encode_golay_table(output_tx_data, input_payload_data, num_payload_data_bytes);
+#else
+    int num_tx_data_bytes = horus_l2_encode_golay_bitwise(output_tx_data, input_payload_data, num_payload_data_bytes);
+#endif
+
+    /* optional interleaver - we dont interleave UW */
+
+    #ifdef INTERLEAVER
+    interleave(&output_tx_data[sizeof(uw)], num_tx_data_bytes - 2, 0);
+    #endif
+
+    /* optional scrambler to prevent long strings of the same symbol
+       which upsets the modem - we dont scramble UW */
+
+    #ifdef SCRAMBLER
+    scramble(&output_tx_data[sizeof(uw)], num_tx_data_bytes - 2);
+    #endif
+
+    return num_tx_data_bytes;
+}
+
+/*
+  Golay parity is linear in the data bits, so the 11 parity bits of a 12-bit
+  group are the XOR of the parity of its upper and lower 6 bits: two 64-entry
+  tables (256 bytes of flash) instead of a 4096-entry one.
+  golay23_parity_high[i] = get_syndrome(i << 17), golay23_parity_low[i] = get_syndrome(i << 11).
+ */
+
+static const uint16_t golay23_parity_high[64] = {
+        0x000, 0x6cc, 0x1ed, 0x721, 0x3da, 0x516, 0x237, 0x4fb,
+        0x7b4, 0x178, 0x659, 0x095, 0x46e, 0x2a2, 0x583, 0x34f,
+        0x31d, 0x5d1, 0x2f0, 0x43c, 0x0c7, 0x60b, 0x12a, 0x7e6,
+        0x4a9, 0x265, 0x544, 0x388, 0x773, 0x1bf, 0x69e, 0x052,
+        0x63a, 0x0f6, 0x7d7, 0x11b, 0x5e0, 0x32c, 0x40d, 0x2c1,
+        0x18e, 0x742, 0x063, 0x6af, 0x254, 0x498, 0x3b9, 0x575,
+        0x527, 0x3eb, 0x4ca, 0x206, 0x6fd, 0x031, 0x710, 0x1dc,
+        0x293, 0x45f, 0x37e, 0x5b2, 0x149, 0x785, 0x0a4, 0x668,
+};
+
+static const uint16_t golay23_parity_low[64] = {
+        0x000, 0x475, 0x49f, 0x0ea, 0x54b, 0x13e, 0x1d4, 0x5a1,
+        0x6e3, 0x296, 0x27c, 0x609, 0x3a8, 0x7dd, 0x737, 0x342,
+        0x1b3, 0x5c6, 0x52c, 0x159, 0x4f8, 0x08d, 0x067, 0x412,
+        0x750, 0x325, 0x3cf, 0x7ba, 0x21b, 0x66e, 0x684, 0x2f1,
+        0x366, 0x713, 0x7f9, 0x38c, 0x62d, 0x258, 0x2b2, 0x6c7,
+        0x585, 0x1f0, 0x11a, 0x56f, 0x0ce, 0x4bb, 0x451, 0x024,
+        0x2d5, 0x6a0, 0x64a, 0x23f, 0x79e, 0x3eb, 0x301, 0x774,
+        0x436, 0x043, 0x0a9, 0x4dc, 0x17d, 0x508, 0x5e2, 0x197,
+};
+
+static inline uint16_t golay23_parity(uint16_t data)
+{
+    return golay23_parity_high[data >> 6] ^ golay23_parity_low[data & 0x3f];
+}
+
+static inline unsigned char *horus_l2_write_parity(unsigned char *pout, uint32_t *parity_bits, int *nparitybits,
+        uint16_t data)
+{
+    *parity_bits = (*parity_bits << 11) | golay23_parity(data);
+    *nparitybits += 11;
+
+    while (*nparitybits >= 8) {
+        *nparitybits -= 8;
+        *pout++ = (unsigned char) (*parity_bits >> *nparitybits);
+    }
+
+    return pout;
+}
+
+/*
+  Word-oriented encoder: takes the payload 24 bits (two Golay codewords) at a
+  time and writes the parity bits MSB first through a bit accumulator.
+ */
+
+int horus_l2_encode_golay_table(unsigned char *output_tx_data,
+                                unsigned char *input_payload_data,
+        int num_payload_data_bytes)
+{
+    int num_tx_data_bytes = horus_l2_get_num_tx_data_bytes(num_payload_data_bytes);
+    unsigned char *pout = output_tx_data;
+    unsigned char *pin = input_payload_data;
+    uint32_t parity_bits = 0;
+    int nparitybits = 0;
+    int remaining = num_payload_data_bytes;
+
+    memcpy(pout, uw, sizeof(uw));
+    pout += sizeof(uw);
+    if (pout != input_payload_data) {
+        memcpy(pout, input_payload_data, num_payload_data_bytes);
+    }
+    pout += num_payload_data_bytes;
+
+    for (; remaining >= 3; remaining -= 3, pin += 3) {
+        pout = horus_l2_write_parity(pout, &parity_bits, &nparitybits, (uint16_t) ((pin[0] << 4) | (pin[1] >> 4)));
+        pout = horus_l2_write_parity(pout, &parity_bits, &nparitybits, (uint16_t) (((pin[1] & 0x0f) << 8) | pin[2]));
+    }
+
+    /* The bitwise encoder shifts a partial last group by one bit only: 8 bits become data << 1, not data << 4 */
+
+    if (remaining == 2) {
+        pout = horus_l2_write_parity(pout, &parity_bits, &nparitybits, (uint16_t) ((pin[0] << 4) | (pin[1] >> 4)));
+        pout = horus_l2_write_parity(pout, &parity_bits, &nparitybits, (uint16_t) ((pin[1] & 0x0f) << 1));
+    } else if (remaining == 1) {
+        pout = horus_l2_write_parity(pout, &parity_bits, &nparitybits, (uint16_t) (pin[0] << 1));
+    }
+
+    if (nparitybits > 0) {
+        *pout++ = (unsigned char) (parity_bits << (8 - nparitybits));
+    }
+
+    assert(pout == (output_tx_data + num_tx_data_bytes));
+
+    return num_tx_data_bytes;
+}
+
+/*
   The encoder will run on the payload on a small 8-bit uC.  As we are
   memory constrained so we do a lot of burrowing for bits out of
   packed arrays, and don't use a LUT for Golay encoding.  Hopefully it
@@ -127,8 +255,8 @@ int horus_l2_get_num_tx_data_bytes(int num_payload_data_bytes)
   somewhere.
  */
 
-int horus_l2_encode_tx_packet(unsigned char *output_tx_data,
-                              unsigned char *input_payload_data,
+int horus_l2_encode_golay_bitwise(unsigned char *output_tx_data,
+                                  unsigned char *input_payload_data,
         int num_payload_data_bytes)
 {
     int num_tx_data_bytes, num_payload_data_bits;
@@ -140,7 +268,9 @@ int horus_l2_encode_tx_packet(unsigned char *output_tx_data,
     num_tx_data_bytes = horus_l2_get_num_tx_data_bytes(num_payload_data_bytes);
     memcpy(pout, uw, sizeof(uw));
     pout += sizeof(uw);
-    memcpy(pout, input_payload_data, num_payload_data_bytes);
+    if (pout != input_payload_data) {
+        memcpy(pout, input_payload_data, num_payload_data_bytes);
+    }
     pout += num_payload_data_bytes;
 
     /* Read input bits one at a time.  Fill input Golay codeword.  Find output Golay codeword.
@@ -266,19 +396,6 @@ int horus_l2_encode_tx_packet(unsigned char *output_tx_data,
     #endif
     assert(pout == (output_tx_data + num_tx_data_bytes));
 
-    /* optional interleaver - we dont interleave UW */
-
-    #ifdef INTERLEAVER
-    interleave(&output_tx_data[sizeof(uw)], num_tx_data_bytes - 2, 0);
-    #endif
-
-    /* optional scrambler to prevent long strings of the same symbol
-       which upsets the modem - we dont scramble UW */
-
-    #ifdef SCRAMBLER
-    scramble(&output_tx_data[sizeof(uw)], num_tx_data_bytes - 2);
-    #endif
-
     return num_tx_data_bytes;
 }
 
@@ -1186,17 +1303,9 @@ int golay23_count_errors(int recd_codeword, int corrected_codeword)
 
 #endif
 
-// from http://stackoverflow.com/questions/10564491/function-to-calculate-a-crc16-checksum
+// CRC-16/CCITT-FALSE, shared with the other codecs
 
 unsigned short gen_crc16(unsigned char *data_p, unsigned char length)
 {
-    unsigned char x;
-    unsigned short crc = 0xFFFF;
-
-    while (length--) {
-        x = crc >> 8 ^ *data_p++;
-        x ^= x >> 4;
-        crc = (crc << 8) ^ ((unsigned short) (x << 12)) ^ ((unsigned short) (x << 5)) ^ ((unsigned short) x);
-    }
-    return crc;
+    return crc16_ccitt_update(CRC16_INIT, data_p, length);
 }
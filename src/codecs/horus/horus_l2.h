@@ -11,11 +11,25 @@
 
 int horus_l2_get_num_tx_data_bytes(int num_payload_data_bytes);
 
+/* The payload data follows the unique word in the tx packet: with input_payload_data at
+   output_tx_data + HORUS_L2_TX_PAYLOAD_OFFSET, the packet is encoded in place */
+#define HORUS_L2_TX_PAYLOAD_OFFSET 2
+
 /* returns number of output bytes in output_tx_data */
 int horus_l2_encode_tx_packet(unsigned char *output_tx_data,
         unsigned char *input_payload_data,
         int num_payload_data_bytes);
 
+/* Unique word, payload and Golay parity bits only, before interleaving and scrambling */
+int horus_l2_encode_golay_table(unsigned char *output_tx_data,
+        unsigned char *input_payload_data,
+        int num_payload_data_bytes);
+
+/* The same with the original bit-serial encoder */
+int horus_l2_encode_golay_bitwise(unsigned char *output_tx_data,
+        unsigned char *input_payload_data,
+        int num_payload_data_bytes);
+
 void horus_l2_decode_rx_packet(unsigned char *output_payload_data,
         unsigned char *input_rx_data,
         int num_payload_data_bytes);
@@ -28,12 +28,18 @@
 #include "log.h"
 
 #define CLAMP(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+// For unsigned values, which cannot be below a lower bound of 0
+#define CLAMP_MAX(x, hi) ((x) > (hi) ? (hi) : (x))
 
 volatile uint16_t horus_v3_packet_counter = 0;
 static horusTelemetry asnMessage;
 static BitStream encodedMessage;
 
-size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data){
+static size_t horus_packet_v3_frame(uint8_t *payload, int encodedSize);
+static void horus_packet_v3_add_extra_sensors(horusAdditionalSensors *sensors, telemetry_data *data);
+
+size_t horus_packet_v3_create_asn1(uint8_t *payload, telemetry_data *data)
+{
     // Horus v3 packets are encoded using ASN1, and are encapsulated in packets
     // of sizes 32, 48, 64, 96 or 128 bytes (before coding)
     // The CRC16 for these packets is located at the *start* of the packet, still little-endian encoded
@@ -59,8 +65,8 @@ size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data){
         .latitude = CLAMP(lat, -9000000, 9000000),
         .longitude = CLAMP(lon, -18000000, 18000000),
         .altitudeMeters = CLAMP(alt, -1000, 50000),
-        .velocityHorizontalKilometersPerHour = CLAMP(velocity_horizontal, 0, 511),
-        .gnssSatellitesVisible = CLAMP(data->gps.satellites_visible, 0, 31),
+        .velocityHorizontalKilometersPerHour = CLAMP_MAX(velocity_horizontal, 511),
+        .gnssSatellitesVisible = CLAMP_MAX(data->gps.satellites_visible, 31),
         .ascentRateCentimetersPerSecond = CLAMP((int32_t)data->gps.climb_cm_per_second, -32767, 32767),
         .temperatureCelsius_x10 = {
             .internal = CLAMP((int16_t)(data->internal_temperature_celsius_100 / 10), -1023, 1023),
@@ -72,7 +78,7 @@ size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data){
             }
         },
         .milliVolts = {
-            .battery = CLAMP(data->battery_voltage_millivolts, 0, 16383),
+            .battery = CLAMP_MAX(data->battery_voltage_millivolts, 16383),
             .exist = {
                 .battery = true,
                 .solar = false,
@@ -115,22 +121,134 @@ size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data){
             asnMessage.temperatureCelsius_x10.exist.external = true;
         }
 
-        if (data->humidity_percentage_100 >= 0 && data->humidity_percentage_100 <= 10000 && data->ext_sensor_type != SENSOR_BMP280) {
-            asnMessage.humidityPercentage = CLAMP((uint8_t)(data->humidity_percentage_100 / 100), 0, 100);
+        if (data->humidity_percentage_100 <= 10000 && data->ext_sensor_type != SENSOR_BMP280) {
+            asnMessage.humidityPercentage = CLAMP_MAX((uint8_t)(data->humidity_percentage_100 / 100), 100);
             asnMessage.exist.humidityPercentage = true;
         }
 
         if (data->pressure_mbar_100 > 0 && data->pressure_mbar_100 <= 120000) {
-            asnMessage.pressurehPa_x10 = CLAMP((uint16_t)(data->pressure_mbar_100 / 10), 0, 12000);
+            asnMessage.pressurehPa_x10 = CLAMP_MAX((uint16_t)(data->pressure_mbar_100 / 10), 12000);
             asnMessage.exist.pressurehPa_x10 = true;
         }
     }
 
+    horus_packet_v3_add_extra_sensors(&asnMessage.extraSensors, data);
+    asnMessage.exist.extraSensors = asnMessage.extraSensors.nCount > 0;
+
+    memset(&encodedMessage, 0, sizeof(encodedMessage));
+
+    // The Encoder may fail and update an error code
+    int errCode;
+
+    // Initialization associates the buffer to the bit stream
+    // We want to write the uncoded message starting at 2 bytes into the message.
+    BitStream_Init (&encodedMessage,
+                    (unsigned char*)(payload+2),
+                    HORUS_UNCODED_BUFFER_SIZE-2);
+    
+    // Encode the message using uPER encoding rule
+
+    // We patch in assert functionality in assert_override.h
+    // Before running encode we set assert_value = 0
+    // Then check the value in assert_value
+    assert_value = 0;
+
+    if (!horusTelemetry_Encode(&asnMessage,
+                        &encodedMessage,
+                        &errCode,
+                        true) || assert_value != 0)
+    {  
+        // Not at this error helps that much in a flight, but it helps
+        // us when debugging!   
+        if(errCode > 0) {
+            log_error("[error]: HORUS v3 Encoding Failed: %i\n", errCode);
+        }
+        if(assert_value != 0){
+            log_error("[error]: HORUS v3 Assert Failure, maybe hit buffer size limit\n");
+        }
+        // Need to check what happens here.
+        return 0;
+    } else {
+        // Encoding was successful!
+        // Now we try to add extensions if we have any
+
+        #if HORUS_V3_EXTENSIONS 
+        horusExtensions asnExtensions = {
+            #if HORUS_V3_NOHUB
+            .via = Via_nohub, 
+            #endif
+            .exist = {
+                #if HORUS_V3_NOHUB
+                .via = true
+                #endif
+            }
+        };
+
+        if (!horusExtensions_Encode(&asnExtensions,
+                        &encodedMessage,
+                        &errCode,
+                        true) || assert_value != 0)
+        {  
+            // Not at this error helps that much in a flight, but it helps
+            // us when debugging!   
+            if(errCode > 0) {
+                log_error("[error]: HORUS v3 Extension Encoding Failed: %i\n", errCode);
+            }
+            if(assert_value != 0){
+                log_error("[error]: HORUS v3 Extension Assert Failure, maybe hit buffer size limit\n");
+            }
+            // Need to check what happens here.
+            return 0;
+        }
+
+        #endif
+
+        return horus_packet_v3_frame(payload, BitStream_GetLength(&encodedMessage));
+    }
+
+    return 0;
+}
+
+/**
+ * Pad the encoded message to the next frame size and add the CRC at the start of the packet.
+ */
+static size_t horus_packet_v3_frame(uint8_t *payload, int encodedSize)
+{
+    // Determine the required frame size.
+    // Probably should do this from a list of valid sizes in a neater manner
+    int frameSize = 128;
+    if (encodedSize <= 30){
+        frameSize = 32;
+    } else if (encodedSize <= 46){
+        frameSize = 48;
+    } else if (encodedSize <= 62){
+        frameSize = 64;
+    } else if (encodedSize <= 94){
+        frameSize = 96;
+    } else if (encodedSize <= 126){
+        frameSize = 128;
+    }
+
+    // Calculate CRC16 over the frame, starting at byte 2
+    uint16_t packetCrc = (uint16_t)gen_crc16((unsigned char *)(payload + 2),
+                                 frameSize - 2);
+    // Write CRC into bytes 0–1 of the packet
+    memcpy(payload, &packetCrc, sizeof(packetCrc));  // little‑endian on STM32
+
+    log_info("HORUS v3 ASN1: %i Frame: %i\n", encodedSize, frameSize);
+
+    return frameSize;
+}
+
+static void horus_packet_v3_add_extra_sensors(horusAdditionalSensors *sensors, telemetry_data *data)
+{
+    (void) sensors;
+    (void) data;
+
     // Add radsens data to packet if enabled
 #if SENSOR_RADSENS_ENABLE
-    if (asnMessage.extraSensors.nCount < 4) {
+    if (sensors->nCount < 4) {
         // Unit: µR/h
-        asnMessage.exist.extraSensors = true;
         horusAdditionalSensorType radsens_struct = {
             .name = "radsens",
             .exist = { 
@@ -147,16 +265,15 @@ size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data){
                 }
             }
         };
-        asnMessage.extraSensors.arr[asnMessage.extraSensors.nCount] = radsens_struct;
-        asnMessage.extraSensors.nCount += 1;
+        sensors->arr[sensors->nCount] = radsens_struct;
+        sensors->nCount += 1;
     }
 #endif
 
 #if PULSE_COUNTER_ENABLE
     // Add pulse count data to packet if enabled
-    if (asnMessage.extraSensors.nCount < 4) {
+    if (sensors->nCount < 4) {
         // Unit: pulse count
-        asnMessage.exist.extraSensors = true;
         horusAdditionalSensorType pulse_count_struct = {
             .name = "pulse",
             .exist = { 
@@ -173,16 +290,15 @@ size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data){
                 }
             }
         };
-        asnMessage.extraSensors.arr[asnMessage.extraSensors.nCount] = pulse_count_struct;
-        asnMessage.extraSensors.nCount += 1;
+        sensors->arr[sensors->nCount] = pulse_count_struct;
+        sensors->nCount += 1;
     }
 #endif
 
 // Add BME6XX gas data to packet if enabled
 #if SENSOR_BME_6XX_GAS_MEASUREMENT
-    if (asnMessage.extraSensors.nCount < 4) {
+    if (sensors->nCount < 4) {
         // Unit: µR/h
-        asnMessage.exist.extraSensors = true;
         horusAdditionalSensorType bme_gas_struct = {
             .name = "gas",
             .exist = { 
@@ -199,14 +315,13 @@ size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data){
                 }
             }
         };
-        asnMessage.extraSensors.arr[asnMessage.extraSensors.nCount] = bme_gas_struct;
-        asnMessage.extraSensors.nCount += 1;
+        sensors->arr[sensors->nCount] = bme_gas_struct;
+        sensors->nCount += 1;
     }
 #endif
 
 #if TX_DFM_ADDITIONAL_TELEM && defined(DFM17)
-    asnMessage.exist.extraSensors = true;
-    if (asnMessage.extraSensors.nCount < 4) {
+    if (sensors->nCount < 4) {
         // GPS-derived XO_TUNE signed offset (cap_trim_offset + 127 to make it unsigned).
         // Decode: gpsofs - 127 gives the signed correction applied on top of the 0x60 baseline.
         horusAdditionalSensorType gps_offset_struct = {
@@ -228,16 +343,15 @@ size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data){
                 }
             }
         };
-        asnMessage.extraSensors.arr[asnMessage.extraSensors.nCount] = gps_offset_struct;
-        asnMessage.extraSensors.nCount += 1;
+        sensors->arr[sensors->nCount] = gps_offset_struct;
+        sensors->nCount += 1;
     }
 #endif
 
 #if 0
 // Reevaluate this at a later time -- something isn't scaled right
 // #ifdef DFM17
-    if (asnMessage.extraSensors.nCount < 4 && data->current_milliamps > 0) {
-        asnMessage.exist.extraSensors = true;
+    if (sensors->nCount < 4 && data->current_milliamps > 0) {
         horusAdditionalSensorType current_struct = {
             .name = "cur",
             .exist = {
@@ -254,15 +368,14 @@ size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data){
                 }
             }
         };
-        asnMessage.extraSensors.arr[asnMessage.extraSensors.nCount] = current_struct;
-        asnMessage.extraSensors.nCount += 1;
+        sensors->arr[sensors->nCount] = current_struct;
+        sensors->nCount += 1;
     }
 #endif
 
 #ifdef DEBUG_TX_BUTTON_ADC
     // Unit: raw ADC
-    if (asnMessage.extraSensors.nCount < 4) {
-        asnMessage.exist.extraSensors = true;
+    if (sensors->nCount < 4) {
         horusAdditionalSensorType button_adc_struct = {
             .name = "adcbutton",
             .exist = {
@@ -279,107 +392,320 @@ size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data){
                 }
             }
         };
-        asnMessage.extraSensors.arr[asnMessage.extraSensors.nCount] = button_adc_struct;
-        asnMessage.extraSensors.nCount += 1;
+        sensors->arr[sensors->nCount] = button_adc_struct;
+        sensors->nCount += 1;
     }
 #endif
+}
 
-    memset(&encodedMessage, 0, sizeof(encodedMessage));
+/*
+ * Fast path: the same uPER bits as horusTelemetry_Encode() for the fields this firmware sends.
+ *
+ * The presence bitmap and the callsign are constant within a flight, so they are encoded once into
+ * horus_v3_prefix. Packets start from a copy of the prefix with the data-dependent presence bits patched in,
+ * and the constrained integers are appended by a writer that keeps the pending bits in a 64-bit word
+ * instead of going through the BitStream bit by bit. Extra sensors, if any, are still encoded by asn1scc.
+ */
 
-    // The Encoder may fail and update an error code
-    int errCode;
+// Presence bitmap of the Telemetry SEQUENCE, most significant bit first
+#define HORUS_V3_PRESENCE_BIT_COUNT 12
+#define HORUS_V3_PRESENCE_EXTRA_SENSORS 1
+#define HORUS_V3_PRESENCE_VELOCITY_HORIZONTAL 2
+#define HORUS_V3_PRESENCE_SATELLITES 3
+#define HORUS_V3_PRESENCE_ASCENT_RATE 4
+#define HORUS_V3_PRESENCE_PRESSURE 5
+#define HORUS_V3_PRESENCE_TEMPERATURE 6
+#define HORUS_V3_PRESENCE_HUMIDITY 7
+#define HORUS_V3_PRESENCE_MILLIVOLTS 8
+#define HORUS_V3_PRESENCE_GNSS_POWER_SAVE_STATE 10
+
+// Constrained whole numbers are encoded as (value - min) in the bits needed for (max - min)
+#define HORUS_V3_BITS_CALLSIGN_LENGTH 4
+#define HORUS_V3_BITS_CALLSIGN_CHAR 6
+#define HORUS_V3_BITS_SEQUENCE_NUMBER 16
+#define HORUS_V3_BITS_TIME_OF_DAY 17
+#define HORUS_V3_BITS_LATITUDE 25
+#define HORUS_V3_BITS_LONGITUDE 26
+#define HORUS_V3_BITS_ALTITUDE 16
+#define HORUS_V3_BITS_VELOCITY_HORIZONTAL 10
+#define HORUS_V3_BITS_SATELLITES 5
+#define HORUS_V3_BITS_ASCENT_RATE 16
+#define HORUS_V3_BITS_PRESSURE 14
+#define HORUS_V3_BITS_TEMPERATURE 11
+#define HORUS_V3_BITS_HUMIDITY 7
+#define HORUS_V3_BITS_MILLIVOLTS 14
+#define HORUS_V3_BITS_GNSS_POWER_SAVE_STATE 3
+#define HORUS_V3_BITS_FIELD_COUNT 7
+
+#define HORUS_V3_CALLSIGN HORUS_V3_PAYLOAD_CALLSIGN HORUS_V3_CALLSIGN_SUFFIX
+#define HORUS_V3_CALLSIGN_LENGTH_MAX 15
+#define HORUS_V3_PREFIX_BIT_COUNT_MAX \
+    (HORUS_V3_PRESENCE_BIT_COUNT + HORUS_V3_BITS_CALLSIGN_LENGTH + HORUS_V3_CALLSIGN_LENGTH_MAX * HORUS_V3_BITS_CALLSIGN_CHAR)
+
+// Uncoded packet bytes after the CRC
+#define HORUS_V3_MESSAGE_SIZE (HORUS_UNCODED_BUFFER_SIZE - 2)
+
+typedef struct _horus_v3_bit_writer {
+    uint8_t *buffer;
+    uint16_t position;
+    uint8_t bit_count;
+    bool overflow;
+    uint64_t bits;
+} horus_v3_bit_writer;
+
+static uint8_t horus_v3_prefix[(HORUS_V3_PREFIX_BIT_COUNT_MAX + 7) / 8];
+static uint16_t horus_v3_prefix_bit_count = 0;
+static bool horus_v3_prefix_valid = false;
+
+static inline void horus_v3_put_bits(horus_v3_bit_writer *writer, uint32_t value, uint8_t count)
+{
+    writer->bits = (writer->bits << count) | value;
+    writer->bit_count += count;
+
+    while (writer->bit_count >= 8) {
+        writer->bit_count -= 8;
+        if (writer->position >= HORUS_V3_MESSAGE_SIZE) {
+            writer->overflow = true;
+            return;
+        }
+        writer->buffer[writer->position++] = (uint8_t) (writer->bits >> writer->bit_count);
+    }
+}
 
-    // Initialization associates the buffer to the bit stream
-    // We want to write the uncoded message starting at 2 bytes into the message.
-    BitStream_Init (&encodedMessage,
-                    (unsigned char*)(payload+2),
-                    HORUS_UNCODED_BUFFER_SIZE-2);
-    
-    // Encode the message using uPER encoding rule
+/**
+ * Store the pending bits in the buffer, for BitStream encoders or as the final partial byte.
+ */
+static void horus_v3_flush_bits(horus_v3_bit_writer *writer)
+{
+    if (writer->bit_count > 0 && writer->position < HORUS_V3_MESSAGE_SIZE) {
+        writer->buffer[writer->position] = (uint8_t) (writer->bits << (8 - writer->bit_count));
+    }
+}
 
-    // We patch in assert functionality in assert_override.h
-    // Before running encode we set assert_value = 0
-    // Then check the value in assert_value
-    assert_value = 0;
+static void horus_v3_seek_bits(horus_v3_bit_writer *writer, uint16_t bit_position)
+{
+    writer->position = bit_position / 8;
+    writer->bit_count = bit_position % 8;
+    writer->bits = writer->bit_count > 0 ? writer->buffer[writer->position] >> (8 - writer->bit_count) : 0;
+}
 
-    if (!horusTelemetry_Encode(&asnMessage,
-                        &encodedMessage,
-                        &errCode,
-                        true) || assert_value != 0)
-    {  
-        // Not at this error helps that much in a flight, but it helps
-        // us when debugging!   
-        if(errCode > 0) {
-            log_error("[error]: HORUS v3 Encoding Failed: %i\n", errCode);
+static inline uint32_t horus_v3_presence_bit(uint8_t index)
+{
+    return 1UL << (HORUS_V3_PRESENCE_BIT_COUNT - 1 - index);
+}
+
+static bool horus_packet_v3_prepare_prefix()
+{
+    static const char callsign[] = HORUS_V3_CALLSIGN;
+    size_t callsign_length = strlen(callsign);
+
+    if (callsign_length < 1 || callsign_length > HORUS_V3_CALLSIGN_LENGTH_MAX) {
+        return false;
+    }
+
+    uint32_t presence = horus_v3_presence_bit(HORUS_V3_PRESENCE_VELOCITY_HORIZONTAL)
+            | horus_v3_presence_bit(HORUS_V3_PRESENCE_SATELLITES)
+            | horus_v3_presence_bit(HORUS_V3_PRESENCE_ASCENT_RATE)
+            | horus_v3_presence_bit(HORUS_V3_PRESENCE_TEMPERATURE)
+            | horus_v3_presence_bit(HORUS_V3_PRESENCE_MILLIVOLTS);
+#if GPS_POWER_SAVING_ENABLE
+    presence |= horus_v3_presence_bit(HORUS_V3_PRESENCE_GNSS_POWER_SAVE_STATE);
+#endif
+
+    memset(horus_v3_prefix, 0, sizeof(horus_v3_prefix));
+    horus_v3_bit_writer writer = {
+            .buffer = horus_v3_prefix,
+    };
+
+    horus_v3_put_bits(&writer, presence, HORUS_V3_PRESENCE_BIT_COUNT);
+    horus_v3_put_bits(&writer, callsign_length - 1, HORUS_V3_BITS_CALLSIGN_LENGTH);
+
+    for (size_t i = 0; i < callsign_length; i++) {
+        // Character set of payloadCallsign: "-/0-9A-Za-z", in ASCII order
+        char c = callsign[i];
+        uint8_t index;
+        if (c == '-') {
+            index = 0;
+        } else if (c == '/') {
+            index = 1;
+        } else if (c >= '0' && c <= '9') {
+            index = 2 + (c - '0');
+        } else if (c >= 'A' && c <= 'Z') {
+            index = 12 + (c - 'A');
+        } else if (c >= 'a' && c <= 'z') {
+            index = 38 + (c - 'a');
+        } else {
+            return false;
         }
-        if(assert_value != 0){
-            log_error("[error]: HORUS v3 Assert Failure, maybe hit buffer size limit\n");
+        horus_v3_put_bits(&writer, index, HORUS_V3_BITS_CALLSIGN_CHAR);
+    }
+
+    horus_v3_flush_bits(&writer);
+    horus_v3_prefix_bit_count = writer.position * 8 + writer.bit_count;
+
+    return true;
+}
+
+/**
+ * Produces the same packets as horus_packet_v3_create_asn1().
+ */
+size_t horus_packet_v3_create_fast(uint8_t *payload, telemetry_data *data)
+{
+    if (!horus_v3_prefix_valid) {
+        horus_v3_prefix_valid = horus_packet_v3_prepare_prefix();
+        if (!horus_v3_prefix_valid) {
+            log_error("[error]: HORUS v3 Encoding Failed: invalid callsign\n");
+            return 0;
         }
-        // Need to check what happens here.
+    }
+
+    horus_v3_packet_counter++;
+
+    uint32_t velocity_horizontal = (data->gps.ground_speed_cm_per_second * 36) / 1000;
+
+    int32_t time_of_day = data->gps.hours*3600 + data->gps.minutes*60 + data->gps.seconds;
+    int32_t lat = (int32_t)(data->gps.latitude_degrees_10000000 / 100);
+    int32_t lon = (int32_t)(data->gps.longitude_degrees_10000000 / 100);
+    int32_t alt = (int32_t)(data->gps.altitude_mm / 1000);
+
+    int16_t temperature_internal = CLAMP((int16_t)(data->internal_temperature_celsius_100 / 10), -1023, 1023);
+    bool temperature_external_exists = false;
+    int16_t temperature_external = 0;
+    bool humidity_exists = false;
+    uint8_t humidity = 0;
+    bool pressure_exists = false;
+    uint16_t pressure = 0;
+
+    if (data->ext_sensor_type != NO_EXT_SENSOR) {
+        if (data->temperature_celsius_100 >= -10230 && data->temperature_celsius_100 <= 10230) {
+            temperature_external = CLAMP((int16_t)(data->temperature_celsius_100 / 10), -1023, 1023);
+            temperature_external_exists = true;
+        }
+
+        if (data->humidity_percentage_100 <= 10000 && data->ext_sensor_type != SENSOR_BMP280) {
+            humidity = CLAMP_MAX((uint8_t)(data->humidity_percentage_100 / 100), 100);
+            humidity_exists = true;
+        }
+
+        if (data->pressure_mbar_100 > 0 && data->pressure_mbar_100 <= 120000) {
+            pressure = CLAMP_MAX((uint16_t)(data->pressure_mbar_100 / 10), 12000);
+            pressure_exists = true;
+        }
+    }
+
+#if GPS_POWER_SAVING_ENABLE
+    // Out of range for the GnssPowerSaveState enumeration, fails the constraint check of the asn1scc encoder
+    if (data->gps.power_safe_mode_state > horusinactive) {
+        log_error("[error]: HORUS v3 Encoding Failed: invalid GNSS power save state\n");
         return 0;
-    } else {
-        // Encoding was successful!
-        // Now we try to add extensions if we have any
+    }
+#endif
 
-        #if HORUS_V3_EXTENSIONS 
-        horusExtensions asnExtensions = {
-            #if HORUS_V3_NOHUB
-            .via = Via_nohub, 
-            #endif
-            .exist = {
-                #if HORUS_V3_NOHUB
-                .via = true
-                #endif
-            }
-        };
+    asnMessage.extraSensors.nCount = 0;
+    horus_packet_v3_add_extra_sensors(&asnMessage.extraSensors, data);
+    bool extra_sensors_exist = asnMessage.extraSensors.nCount > 0;
 
-        if (!horusExtensions_Encode(&asnExtensions,
-                        &encodedMessage,
-                        &errCode,
-                        true) || assert_value != 0)
-        {  
-            // Not at this error helps that much in a flight, but it helps
-            // us when debugging!   
-            if(errCode > 0) {
-                log_error("[error]: HORUS v3 Extension Encoding Failed: %i\n", errCode);
-            }
-            if(assert_value != 0){
-                log_error("[error]: HORUS v3 Extension Assert Failure, maybe hit buffer size limit\n");
-            }
-            // Need to check what happens here.
+    uint8_t *message = payload + 2;
+    memset(message, 0, HORUS_V3_MESSAGE_SIZE);
+    memcpy(message, horus_v3_prefix, sizeof(horus_v3_prefix));
+
+    // The data-dependent presence bits are all in the first byte
+    if (extra_sensors_exist) {
+        message[0] |= (uint8_t) (horus_v3_presence_bit(HORUS_V3_PRESENCE_EXTRA_SENSORS) >> (HORUS_V3_PRESENCE_BIT_COUNT - 8));
+    }
+    if (pressure_exists) {
+        message[0] |= (uint8_t) (horus_v3_presence_bit(HORUS_V3_PRESENCE_PRESSURE) >> (HORUS_V3_PRESENCE_BIT_COUNT - 8));
+    }
+    if (humidity_exists) {
+        message[0] |= (uint8_t) (horus_v3_presence_bit(HORUS_V3_PRESENCE_HUMIDITY) >> (HORUS_V3_PRESENCE_BIT_COUNT - 8));
+    }
+
+    horus_v3_bit_writer writer = {
+            .buffer = message,
+    };
+    horus_v3_seek_bits(&writer, horus_v3_prefix_bit_count);
+
+    horus_v3_put_bits(&writer, horus_v3_packet_counter, HORUS_V3_BITS_SEQUENCE_NUMBER);
+    horus_v3_put_bits(&writer, CLAMP(time_of_day, -1, 86400) + 1, HORUS_V3_BITS_TIME_OF_DAY);
+    horus_v3_put_bits(&writer, CLAMP(lat, -9000000, 9000000) + 9000000, HORUS_V3_BITS_LATITUDE);
+    horus_v3_put_bits(&writer, CLAMP(lon, -18000000, 18000000) + 18000000, HORUS_V3_BITS_LONGITUDE);
+    horus_v3_put_bits(&writer, CLAMP(alt, -1000, 50000) + 1000, HORUS_V3_BITS_ALTITUDE);
+
+    if (extra_sensors_exist) {
+        int errCode;
+
+        horus_v3_flush_bits(&writer);
+        BitStream_AttachBuffer(&encodedMessage, message, HORUS_V3_MESSAGE_SIZE);
+        encodedMessage.currentByte = writer.position;
+        encodedMessage.currentBit = writer.bit_count;
+
+        assert_value = 0;
+        if (!horusAdditionalSensors_IsConstraintValid(&asnMessage.extraSensors, &errCode)
+            || !horusAdditionalSensors_Encode(&asnMessage.extraSensors, &encodedMessage, &errCode, false)
+            || assert_value != 0) {
+            log_error("[error]: HORUS v3 Encoding Failed: %i\n", errCode);
             return 0;
         }
 
-        #endif
+        horus_v3_seek_bits(&writer, encodedMessage.currentByte * 8 + encodedMessage.currentBit);
+    }
 
-        // Now we need to figure out the required frame size, and add the CRC.
-        int encodedSize = BitStream_GetLength(&encodedMessage);
-
-        // Determine the required frame size.
-        // Probably should do this from a list of valid sizes in a neater manner
-        int frameSize = 128;
-        if (encodedSize <= 30){
-            frameSize = 32;
-        } else if (encodedSize <= 46){
-            frameSize = 48;
-        } else if (encodedSize <= 62){
-            frameSize = 64;
-        } else if (encodedSize <= 94){
-            frameSize = 96;
-        } else if (encodedSize <= 126){
-            frameSize = 128;
-        }
+    horus_v3_put_bits(&writer, CLAMP_MAX(velocity_horizontal, 511), HORUS_V3_BITS_VELOCITY_HORIZONTAL);
+    horus_v3_put_bits(&writer, CLAMP_MAX(data->gps.satellites_visible, 31), HORUS_V3_BITS_SATELLITES);
+    horus_v3_put_bits(&writer, CLAMP((int32_t)data->gps.climb_cm_per_second, -32767, 32767) + 32767,
+            HORUS_V3_BITS_ASCENT_RATE);
+    if (pressure_exists) {
+        horus_v3_put_bits(&writer, pressure, HORUS_V3_BITS_PRESSURE);
+    }
+
+    // TemperatureSensors: presence bits of internal, external, custom1 and custom2
+    horus_v3_put_bits(&writer, temperature_external_exists ? 0xC : 0x8, 4);
+    horus_v3_put_bits(&writer, temperature_internal + 1023, HORUS_V3_BITS_TEMPERATURE);
+    if (temperature_external_exists) {
+        horus_v3_put_bits(&writer, temperature_external + 1023, HORUS_V3_BITS_TEMPERATURE);
+    }
+
+    if (humidity_exists) {
+        horus_v3_put_bits(&writer, humidity, HORUS_V3_BITS_HUMIDITY);
+    }
 
-        // Calculate CRC16 over the frame, starting at byte 2
-        uint16_t packetCrc = (uint16_t)gen_crc16((unsigned char *)(payload + 2),
-                                     frameSize - 2);
-        // Write CRC into bytes 0–1 of the packet
-        memcpy(payload, &packetCrc, sizeof(packetCrc));  // little‑endian on STM32
+    // MilliVoltSensors: only the battery voltage is present
+    horus_v3_put_bits(&writer, 0x8, 4);
+    horus_v3_put_bits(&writer, CLAMP_MAX(data->battery_voltage_millivolts, 16383), HORUS_V3_BITS_MILLIVOLTS);
 
-        log_info("HORUS v3 ASN1: %i Frame: %i\n", encodedSize, frameSize);
+#if GPS_POWER_SAVING_ENABLE
+    horus_v3_put_bits(&writer, data->gps.power_safe_mode_state, HORUS_V3_BITS_GNSS_POWER_SAVE_STATE);
+#endif
+
+#if HORUS_V3_EXTENSIONS
+    horus_v3_put_bits(&writer, HORUS_V3_EXTRA_FIELD_COUNT, HORUS_V3_BITS_FIELD_COUNT);
+
+    // Extensions SEQUENCE: presence bit of via
+#if HORUS_V3_NOHUB
+    horus_v3_put_bits(&writer, 1, 1);
+    // Unconstrained whole number: length byte and the value in one byte
+    horus_v3_put_bits(&writer, 1, 8);
+    horus_v3_put_bits(&writer, (uint32_t) Via_nohub, 8);
+#else
+    horus_v3_put_bits(&writer, 0, 1);
+#endif
+#endif
 
-        return frameSize;
+    if (writer.overflow) {
+        log_error("[error]: HORUS v3 Assert Failure, maybe hit buffer size limit\n");
+        return 0;
     }
 
-    return 0;
+    horus_v3_flush_bits(&writer);
+
+    return horus_packet_v3_frame(payload, writer.position + (writer.bit_count > 0 ? 1 : 0));
+}
+
+size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data)
+{
+#if HORUS_V3_FAST_ENCODER_ENABLE
+    return horus_packet_v3_create_fast(payload, data);
+#else
+    return horus_packet_v3_create_asn1(payload, data);
+#endif
 }
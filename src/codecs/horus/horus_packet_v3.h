@@ -29,6 +29,8 @@
 #include "asn1/HorusBinaryV3.h"
 
 size_t horus_packet_v3_create(uint8_t *payload, telemetry_data *data);
+size_t horus_packet_v3_create_asn1(uint8_t *payload, telemetry_data *data);
+size_t horus_packet_v3_create_fast(uint8_t *payload, telemetry_data *data);
 
 // Currently only NOHUB feature will trigger extensions,
 #if HORUS_V3_NOHUB
@@ -51,15 +51,16 @@
 #define JTENCODE_TONE_SPACING_FT8        625          // ~6.25 Hz
 #define JTENCODE_TONE_SPACING_FSQ        879          // ~8.79 Hz
 
-#define JTENCODE_TONE_DELAY_JT9               576 * 100          // Delay value for JT9-1
-#define JTENCODE_TONE_DELAY_JT65              371 * 100          // Delay value for JT65A
-#define JTENCODE_TONE_DELAY_JT4               229 * 100          // Delay value for JT4A
-#define JTENCODE_TONE_DELAY_WSPR              683 * 100          // Delay value for WSPR
-#define JTENCODE_TONE_DELAY_FT8               159 * 100          // Delay value for FT8
-#define JTENCODE_TONE_DELAY_FSQ_2             500 * 100          // Delay value for 2 baud FSQ
-#define JTENCODE_TONE_DELAY_FSQ_3             333 * 100          // Delay value for 3 baud FSQ
-#define JTENCODE_TONE_DELAY_FSQ_4_5           222 * 100          // Delay value for 4.5 baud FSQ
-#define JTENCODE_TONE_DELAY_FSQ_6             167 * 100          // Delay value for 6 baud FSQ
+// Symbol periods in units of 10 us
+#define JTENCODE_TONE_DELAY_JT9               57600              // Delay value for JT9-1
+#define JTENCODE_TONE_DELAY_JT65              37152              // Delay value for JT65A
+#define JTENCODE_TONE_DELAY_JT4               22857              // Delay value for JT4A
+#define JTENCODE_TONE_DELAY_WSPR              68267              // Delay value for WSPR
+#define JTENCODE_TONE_DELAY_FT8               16000              // Delay value for FT8
+#define JTENCODE_TONE_DELAY_FSQ_2             50000              // Delay value for 2 baud FSQ
+#define JTENCODE_TONE_DELAY_FSQ_3             33333              // Delay value for 3 baud FSQ
+#define JTENCODE_TONE_DELAY_FSQ_4_5           22222              // Delay value for 4.5 baud FSQ
+#define JTENCODE_TONE_DELAY_FSQ_6             16667              // Delay value for 6 baud FSQ
 
 typedef struct _jtencode_mode {
     uint16_t symbol_count;
@@ -53,7 +53,7 @@ void mfsk_encoder_new(fsk_encoder *encoder, mfsk_type type, uint32_t symbol_rate
             break;
     }
 
-    for (int i = 0; i < type; i++) {
+    for (int i = 0; i < (int) type; i++) {
         mfsk->tones[i].index = (int8_t) i;
         mfsk->tones[i].frequency_hz_100 = i * tone_spacing_hz_100;
     }
@@ -105,6 +105,7 @@ uint32_t mfsk_encoder_get_symbol_rate(fsk_encoder *encoder)
 
 uint32_t mfsk_encoder_get_symbol_delay(fsk_encoder *encoder)
 {
+    (void) encoder;
     return 0;
 }
 
@@ -164,6 +165,21 @@ int8_t mfsk_encoder_next_tone(fsk_encoder *encoder)
     return symbol;
 }
 
+bool mfsk_encoder_render(fsk_encoder *encoder, fsk_symbol_stream *stream)
+{
+    mfsk_encoder *mfsk = (mfsk_encoder *) encoder->priv;
+
+    // MFSK_2 uses tone indexes 0 and 2
+    uint8_t bits_per_symbol = mfsk->type == MFSK_16 ? 4 : 2;
+
+    mfsk_encoder_set_data(encoder, mfsk->data_length, mfsk->data);
+    bool success = fsk_symbol_stream_render(stream, bits_per_symbol, encoder, mfsk_encoder_next_tone);
+
+    mfsk_encoder_set_data(encoder, mfsk->data_length, mfsk->data);
+
+    return success;
+}
+
 fsk_encoder_api mfsk_fsk_encoder_api = {
         .get_tones = mfsk_encoder_get_tones,
         .get_tone_spacing = mfsk_encoder_get_tone_spacing,
@@ -171,6 +187,7 @@ fsk_encoder_api mfsk_fsk_encoder_api = {
         .get_symbol_delay = mfsk_encoder_get_symbol_delay,
         .set_data = mfsk_encoder_set_data,
         .next_tone = mfsk_encoder_next_tone,
+        .render = mfsk_encoder_render,
 };
 
 #ifdef TEST
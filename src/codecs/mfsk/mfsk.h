@@ -20,6 +20,7 @@ uint32_t mfsk_encoder_get_tone_spacing(fsk_encoder *encoder);
 uint32_t mfsk_encoder_get_symbol_rate(fsk_encoder *encoder);
 uint32_t mfsk_encoder_get_symbol_delay(fsk_encoder *encoder);
 int8_t mfsk_encoder_next_tone(fsk_encoder *encoder);
+bool mfsk_encoder_render(fsk_encoder *encoder, fsk_symbol_stream *stream);
 
 extern fsk_encoder_api mfsk_fsk_encoder_api;
 
@@ -584,6 +584,11 @@ Setting, measured RF output power, relative DC power draw
 #define GPS_POSITION_MESSAGE_RATE 1
 #define GPS_TIME_MESSAGE_RATE 1
 
+// Configuration variants built by scripts/footprint_report.ts redefine settings above in an override header
+#ifdef RS41NG_CONFIG_OVERRIDE
+#include RS41NG_CONFIG_OVERRIDE
+#endif
+
 #if (PULSE_COUNTER_ENABLE) && ((GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE) || (RADIO_SI5351_ENABLE) || (SENSOR_BMP280_ENABLE) || (SENSOR_BME690_ENABLE))
 #error Pulse counter cannot be enabled simultaneously with GPS NMEA output or I2C bus sensors.
 #endif
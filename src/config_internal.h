@@ -7,6 +7,8 @@
 #define EXTERNAL_SERIAL_PORT_BAUD_RATE 115200
 
 #define RADIO_PAYLOAD_MAX_LENGTH 512
+// Symbols of the jtencode modes, or the packed tone indexes rendered before TX for the other modes: fits a full
+// Horus coded buffer (2 bits per symbol). Longer packets are sent with the tones generated in the interrupt.
 #define RADIO_SYMBOL_DATA_MAX_LENGTH 256
 #define RADIO_PAYLOAD_MESSAGE_MAX_LENGTH 64
 
@@ -18,9 +20,87 @@
 // PARIS: 50 dot durations, 20 WPM -> 60ms per unit
 #define MORSE_WPM_TO_SYMBOL_RATE(wpm) (1000 / (60 * 20 / wpm))
 
+// CRC-16 (AX.25 FCS, Horus, CATS) with 256-entry lookup tables, or false for 16-entry tables: ~1 kB less flash, slower
+#define CRC16_BYTE_TABLE_ENABLE true
+
+// Horus Golay (23,12) parity from two 64-entry lookup tables instead of the bit-serial encoder
+#define HORUS_L2_GOLAY_TABLE_ENABLE true
+
+// Horus v3 packets from a precomputed presence bitmap and callsign prefix and a word-level bit writer,
+// or false for the generic asn1scc horusTelemetry_Encode(). Both produce identical packets.
+#define HORUS_V3_FAST_ENCODER_ENABLE true
+
+// Message templates parsed once in radio_init() and rendered in a single pass,
+// or false to substitute every placeholder with template_replace() on each transmission
+#define TEMPLATE_COMPILE_ENABLE true
+
+// Radio chip temperature and I2C sensors are read in the background between transmissions and copied at TX start,
+// or false to read every source at TX start. A source not refreshed for TELEMETRY_CACHE_STALE_FACTOR intervals
+// is read at TX start.
+#define TELEMETRY_CACHE_ENABLE true
+#define TELEMETRY_CACHE_RADIO_TEMPERATURE_INTERVAL_MS 10000
+#define TELEMETRY_CACHE_SENSOR_INTERVAL_MS 5000
+#define TELEMETRY_CACHE_STALE_FACTOR 3
+
+// Start the forced-mode measurements of the BME68x and BME690 sensors this long before the next scheduled
+// transmission, so that their conversion and heater time pass while the radio is idle instead of delaying TX start.
+// Set to 0 to start them at TX start.
+#define TELEMETRY_SENSOR_TRIGGER_LEAD_MS 2500
+
+// Read the BMP280, BME68x, BME690 and RadSens sensors through the interrupt-driven I2C request queue instead of
+// blocking the main loop for every transfer: in the background for the telemetry cache, and at TX start.
+// BME68x/BME690 data is read this way once a triggered measurement is ready, and their setup stays blocking.
+#define I2C_QUEUE_ENABLE true
+#define I2C_QUEUE_REQUEST_TIMEOUT_MS 20
+
+// While no transmission is due, sleep until the next deadline (GPS solution, end of the post-transmit delay,
+// sensor trigger lead time) with a single scheduler timer interrupt and SysTick suspended, instead of polling.
+// WFI (Sleep mode) only, not STOP mode: the clocks and peripherals keep running, see the README.
+#define SYSTEM_IDLE_SLEEP_ENABLE true
+
 // Experimental fast frequency change routine for Si5351, not tested
 #define SI5351_FAST_ENABLE false
 
+// Si5351 MFSK (Horus) tones switch by writing only the precalculated multisynth register bytes that differ,
+// or false to call si5351_set_frequency() for every symbol. Not used with SI5351_FAST_ENABLE.
+// With I2C_QUEUE_ENABLE, the data timer interrupt submits these writes to the I²C request queue.
+#define SI5351_TONE_TABLE_ENABLE true
+
+// DMA1 channels by number. STM32F1 wires each peripheral request to a fixed channel, and a channel serves one
+// request at a time: the simulator fails if two drivers claim the same channel. RSM4x4 (STM32L4) selects the
+// requests with CSELR, but keeps the same channels.
+#define DMA_CHANNEL_ADC 1
+#if defined(DFM17)
+#define DMA_CHANNEL_SPI_TX 3
+#define DMA_CHANNEL_GPS_USART_RX 6
+#else
+#define DMA_CHANNEL_PWM_TIMER 2
+#define DMA_CHANNEL_SPI_TX 5
+#define DMA_CHANNEL_GPS_USART_RX 5
+#endif
+
+// Bell 202 tones for APRS-1200 on the Si4032 are fed to the PWM timer by DMA, see pwm_dma_start().
+// The timer trigger routing is specific to STM32F100: RSM4x4 keeps the bit-banged symbol loop.
+#if defined(RS41) && !defined(RS41_RSM4x4)
+#define PWM_TIMER_DMA_ENABLE true
+#else
+#define PWM_TIMER_DMA_ENABLE false
+#endif
+
+// SPI bursts that only write at least SPI_DMA_TRANSFER_LENGTH_MIN bytes (radio FIFO fills, filter and property
+// blocks) are sent by DMA, see spi_transfer(). Reads and shorter bursts use polled transfers.
+// DFM17 only: SPI2_TX of the RS41 is wired to the channel of USART1_RX, which the GPS ring keeps running.
+#if defined(DFM17)
+#define SPI_DMA_ENABLE true
+#else
+#define SPI_DMA_ENABLE false
+#endif
+#define SPI_DMA_TRANSFER_LENGTH_MIN 8
+
+#if SPI_DMA_ENABLE && (DMA_CHANNEL_SPI_TX == DMA_CHANNEL_GPS_USART_RX)
+#error "SPI DMA needs a DMA channel that the GPS USART RX ring does not use"
+#endif
+
 // Bench test: auto-enter STABILIZING after this many seconds of uptime,
 // bypassing the altitude arm and descent checks.  Set to 0 for flight mode.
 #define LANDED_MODE_TEST_SECONDS 0
@@ -627,6 +627,65 @@ int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_dat
     return rslt;
 }
 
+/*
+ * @brief This API compensates a forced mode data field that has already been read
+ * from the sensor, without any bus transfers
+ */
+int8_t bme68x_compensate_field_data(const uint8_t *buff, struct bme68x_data *data, struct bme68x_dev *dev)
+{
+    uint8_t gas_range_l, gas_range_h;
+    uint32_t adc_temp;
+    uint32_t adc_pres;
+    uint16_t adc_hum;
+    uint16_t adc_gas_res_low, adc_gas_res_high;
+
+    if ((buff == NULL) || (data == NULL) || (dev == NULL))
+    {
+        return BME68X_E_NULL_PTR;
+    }
+
+    data->status = buff[0] & BME68X_NEW_DATA_MSK;
+    data->gas_index = buff[0] & BME68X_GAS_INDEX_MSK;
+    data->meas_index = buff[1];
+
+    adc_pres = (uint32_t)(((uint32_t)buff[2] * 4096) | ((uint32_t)buff[3] * 16) | ((uint32_t)buff[4] / 16));
+    adc_temp = (uint32_t)(((uint32_t)buff[5] * 4096) | ((uint32_t)buff[6] * 16) | ((uint32_t)buff[7] / 16));
+    adc_hum = (uint16_t)(((uint32_t)buff[8] * 256) | (uint32_t)buff[9]);
+    adc_gas_res_low = (uint16_t)((uint32_t)buff[13] * 4 | (((uint32_t)buff[14]) / 64));
+    adc_gas_res_high = (uint16_t)((uint32_t)buff[15] * 4 | (((uint32_t)buff[16]) / 64));
+    gas_range_l = buff[14] & BME68X_GAS_RANGE_MSK;
+    gas_range_h = buff[16] & BME68X_GAS_RANGE_MSK;
+    if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+    {
+        data->status |= buff[16] & BME68X_GASM_VALID_MSK;
+        data->status |= buff[16] & BME68X_HEAT_STAB_MSK;
+    }
+    else
+    {
+        data->status |= buff[14] & BME68X_GASM_VALID_MSK;
+        data->status |= buff[14] & BME68X_HEAT_STAB_MSK;
+    }
+
+    if (!(data->status & BME68X_NEW_DATA_MSK))
+    {
+        return BME68X_W_NO_NEW_DATA;
+    }
+
+    data->temperature = calc_temperature(adc_temp, dev);
+    data->pressure = calc_pressure(adc_pres, dev);
+    data->humidity = calc_humidity(adc_hum, dev);
+    if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+    {
+        data->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
+    }
+    else
+    {
+        data->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
+    }
+
+    return BME68X_OK;
+}
+
 /*
  * @brief This API is used to set the gas configuration of the sensor.
  */
@@ -225,6 +225,27 @@ uint32_t bme68x_get_meas_dur(const uint8_t op_mode, struct bme68x_conf *conf, st
  */
 int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev);
 
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_compensate_field_data bme68x_compensate_field_data
+ * \code
+ * int8_t bme68x_compensate_field_data(const uint8_t *buff, struct bme68x_data *data, struct bme68x_dev *dev);
+ * \endcode
+ * @details Compensates a forced mode data field of BME68X_LEN_FIELD bytes read from BME68X_REG_FIELD0
+ * without a bus transfer, for reads done through the I2C request queue. Unlike bme68x_get_data(),
+ * the heater set-point registers (res_heat, idac, gas_wait) are not read.
+ *
+ * @param[in]  buff    : Field registers read from the sensor.
+ * @param[out] data    : Structure instance to hold the data.
+ * @param[in,out] dev  : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval > 0 -> Warning: no new data
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_compensate_field_data(const uint8_t *buff, struct bme68x_data *data, struct bme68x_dev *dev);
+
 /**
  * \ingroup bme68x
  * \defgroup bme68xApiConfig Configuration
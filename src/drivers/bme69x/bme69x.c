@@ -578,6 +578,55 @@ int8_t bme69x_get_data(uint8_t op_mode, struct bme69x_data *data, uint8_t *n_dat
     return rslt;
 }
 
+/*
+ * @brief This API compensates a forced mode data field that has already been read
+ * from the sensor, without any bus transfers
+ */
+int8_t bme69x_compensate_field_data(const uint8_t *buff, struct bme69x_data *data, struct bme69x_dev *dev)
+{
+    uint8_t gas_range;
+    uint32_t adc_temp;
+    uint32_t adc_pres;
+    uint16_t adc_hum;
+    uint16_t adc_gas_res;
+
+    if ((buff == NULL) || (data == NULL) || (dev == NULL))
+    {
+        return BME69X_E_NULL_PTR;
+    }
+
+    data->status = buff[0] & BME69X_NEW_DATA_MSK;
+    data->gas_index = buff[0] & BME69X_GAS_INDEX_MSK;
+    data->meas_index = buff[1];
+
+    adc_pres = (uint32_t)(((uint32_t)buff[2] << 16) | ((uint32_t)buff[3] << 8) | ((uint32_t)buff[4]));
+    adc_temp = (uint32_t)(((uint32_t)buff[5] << 16) | ((uint32_t)buff[6] << 8) | ((uint32_t)buff[7]));
+    adc_hum = (uint16_t)(((uint32_t)buff[8] << 8) | (uint32_t)buff[9]);
+    adc_gas_res = ((uint16_t)buff[15] << 2) | ((uint16_t)buff[16] >> 6);
+
+    gas_range = buff[16] & BME69X_GAS_RANGE_MSK;
+
+    data->status |= buff[16] & BME69X_GASM_VALID_MSK;
+    data->status |= buff[16] & BME69X_HEAT_STAB_MSK;
+
+    if (!(data->status & BME69X_NEW_DATA_MSK))
+    {
+        return BME69X_W_NO_NEW_DATA;
+    }
+
+#ifndef BME69X_USE_FPU
+    data->temperature = calc_temperature(adc_temp, dev, &data->t_lin);
+    data->pressure = calc_pressure(adc_pres, data->t_lin, dev);
+#else
+    data->temperature = calc_temperature(adc_temp, dev);
+    data->pressure = calc_pressure(adc_pres, data->temperature, dev);
+#endif
+    data->humidity = calc_humidity(adc_hum, data->temperature, dev);
+    data->gas_resistance = calc_gas_resistance(adc_gas_res, gas_range);
+
+    return BME69X_OK;
+}
+
 /*
  * @brief This API is used to set the gas configuration of the sensor.
  */
@@ -219,6 +219,27 @@ uint32_t bme69x_get_meas_dur(const uint8_t op_mode, struct bme69x_conf *conf, st
  */
 int8_t bme69x_get_data(uint8_t op_mode, struct bme69x_data *data, uint8_t *n_data, struct bme69x_dev *dev);
 
+/*!
+ * \ingroup bme69xApiData
+ * \page bme69x_api_bme69x_compensate_field_data bme69x_compensate_field_data
+ * \code
+ * int8_t bme69x_compensate_field_data(const uint8_t *buff, struct bme69x_data *data, struct bme69x_dev *dev);
+ * \endcode
+ * @details Compensates a forced mode data field of BME69X_LEN_FIELD bytes read from BME69X_REG_FIELD0
+ * without a bus transfer, for reads done through the I2C request queue. Unlike bme69x_get_data(),
+ * the heater set-point registers (res_heat, idac, gas_wait) are not read.
+ *
+ * @param[in]  buff    : Field registers read from the sensor.
+ * @param[out] data    : Structure instance to hold the data.
+ * @param[in,out] dev  : Structure instance of bme69x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval > 0 -> Warning: no new data
+ * @retval < 0 -> Fail
+ */
+int8_t bme69x_compensate_field_data(const uint8_t *buff, struct bme69x_data *data, struct bme69x_dev *dev);
+
 /**
  * \ingroup bme69x
  * \defgroup bme69xApiConfig Configuration
@@ -305,37 +305,43 @@ static inline uint32_t compensate_humidity(bmp280 *dev, int32_t adc_hum, int32_t
     return v_x1_u32r >> 12;
 }
 
-bool bmp280_read_fixed(bmp280 *dev, int32_t *temperature, uint32_t *pressure, uint32_t *humidity)
+uint8_t bmp280_data_size(bmp280 *dev)
 {
-    int32_t adc_pressure;
-    int32_t adc_temp;
-    uint8_t data[8];
-
     // Only the BME280 supports reading the humidity.
-    if (dev->id != BME280_CHIP_ID) {
-        if (humidity) {
-            *humidity = 0;
-        }
-        humidity = NULL;
-    }
-
-    // Need to read in one sequence to ensure they match.
-    uint8_t size = humidity ? 8 : 6;
-    if (!read_data(dev, 0xf7, data, size)) {
-        return false;
-    }
+    return dev->id == BME280_CHIP_ID ? 8 : 6;
+}
 
-    adc_pressure = data[0] << 12 | data[1] << 4 | data[2] >> 4;
-    adc_temp = data[3] << 12 | data[4] << 4 | data[5] >> 4;
+void bmp280_compensate_fixed(bmp280 *dev, const uint8_t *data, int32_t *temperature, uint32_t *pressure,
+        uint32_t *humidity)
+{
+    int32_t adc_pressure = data[0] << 12 | data[1] << 4 | data[2] >> 4;
+    int32_t adc_temp = data[3] << 12 | data[4] << 4 | data[5] >> 4;
 
     int32_t fine_temp;
     *temperature = compensate_temperature(dev, adc_temp, &fine_temp);
     *pressure = compensate_pressure(dev, adc_pressure, fine_temp);
 
     if (humidity) {
+        if (dev->id != BME280_CHIP_ID) {
+            *humidity = 0;
+            return;
+        }
         int32_t adc_humidity = data[6] << 8 | data[7];
         *humidity = compensate_humidity(dev, adc_humidity, fine_temp);
     }
+}
+
+bool bmp280_read_fixed(bmp280 *dev, int32_t *temperature, uint32_t *pressure, uint32_t *humidity)
+{
+    uint8_t data[8];
+
+    // Need to read in one sequence to ensure they match.
+    uint8_t size = humidity ? bmp280_data_size(dev) : 6;
+    if (!read_data(dev, BMP280_REG_DATA, data, size)) {
+        return false;
+    }
+
+    bmp280_compensate_fixed(dev, data, temperature, pressure, humidity);
 
     return true;
 }
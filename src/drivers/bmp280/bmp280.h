@@ -21,6 +21,9 @@
 #define BMP280_CHIP_ID  0x58 /* BMP280 has chip-id 0x58 */
 #define BME280_CHIP_ID  0x60 /* BME280 has chip-id 0x60 */
 
+// Start of the pressure, temperature and humidity data registers
+#define BMP280_REG_DATA 0xF7
+
 /**
  * Mode of BMP280 module operation.
  * Forced - Measurement is initiated by user.
@@ -160,6 +163,18 @@ bool bmp280_is_measuring(bmp280 *dev);
  */
 bool bmp280_read_fixed(bmp280 *dev, int32_t *temperature, uint32_t *pressure, uint32_t *humidity);
 
+/**
+ * Number of bytes to read from BMP280_REG_DATA for bmp280_compensate_fixed(): 8 for the BME280, 6 otherwise.
+ */
+uint8_t bmp280_data_size(bmp280 *dev);
+
+/**
+ * Compensate data registers read from BMP280_REG_DATA without a bus transfer, for reads done through the
+ * I2C request queue. Units are the same as for bmp280_read_fixed().
+ */
+void bmp280_compensate_fixed(bmp280 *dev, const uint8_t *data, int32_t *temperature, uint32_t *pressure,
+        uint32_t *humidity);
+
 /**
  * Read compensated temperature and pressure data:
  *  Temperature in degrees Celsius.
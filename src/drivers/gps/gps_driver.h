@@ -20,8 +20,15 @@
  *   gps_driver_request_gpstime()
  *   gps_driver_get_current_gps_data(data)
  *   gps_driver_peek_current_gps_data(data)
- *   gps_driver_handle_incoming_byte(byte)
+ *   gps_driver_get_gps_data_since(sequence, data)
+ *   gps_driver_get_gps_data_sequence()
+ *   gps_driver_handle_incoming_data(ring, ring_size, start, end, reset)
  *   gps_driver_reset_parser()
+ *   gps_driver_clear_data()
+ *
+ * Parsing, ACK handling, NMEA forwarding and the current GPS data are
+ * shared by both drivers in the UBX core (drivers/gps/ubx_core.h), so the
+ * data access and parser macros are the same for every driver.
  */
 
 #include "config.h"
@@ -45,11 +52,6 @@
 #define gps_driver_enable_power_save_mode()     ubxg6010_enable_power_save_mode()
 #define gps_driver_sleep()                      ubxg6010_sleep()
 #define gps_driver_request_gpstime()            ubxg6010_request_gpstime()
-#define gps_driver_get_current_gps_data(data)   ubxg6010_get_current_gps_data(data)
-#define gps_driver_peek_current_gps_data(data)  ubxg6010_peek_current_gps_data(data)
-#define gps_driver_handle_incoming_byte         ubxg6010_handle_incoming_byte
-#define gps_driver_reset_parser()               ubxg6010_reset_parser()
-#define gps_driver_clear_data()                 ubxg6010_clear_data()
 
 #endif /* GPS_DRIVER_UBXG6010 */
 
@@ -65,12 +67,21 @@
 #define gps_driver_enable_power_save_mode()     ubxm10050_enable_power_save_mode()
 #define gps_driver_sleep()                      ubxm10050_sleep()
 #define gps_driver_request_gpstime()            ubxm10050_request_gpstime()
-#define gps_driver_get_current_gps_data(data)   ubxm10050_get_current_gps_data(data)
-#define gps_driver_peek_current_gps_data(data)  ubxm10050_peek_current_gps_data(data)
-#define gps_driver_handle_incoming_byte         ubxm10050_handle_incoming_byte
-#define gps_driver_reset_parser()               ubxm10050_reset_parser()
-#define gps_driver_clear_data()                 ubxm10050_clear_data()
 
 #endif /* GPS_DRIVER_UBXM10050 */
 
+/* -------------------------------------------------------------------------
+ * UBX core shared by all drivers
+ * ------------------------------------------------------------------------- */
+
+#include "drivers/gps/ubx_core.h"
+
+#define gps_driver_get_current_gps_data(data)   ubx_core_get_current_gps_data(data)
+#define gps_driver_peek_current_gps_data(data)  ubx_core_peek_current_gps_data(data)
+#define gps_driver_get_gps_data_since(sequence, data) ubx_core_get_gps_data_since(sequence, data)
+#define gps_driver_get_gps_data_sequence()      ubx_core_get_gps_data_sequence()
+#define gps_driver_handle_incoming_data         ubx_core_handle_incoming_data
+#define gps_driver_reset_parser()               ubx_core_reset_parser()
+#define gps_driver_clear_data()                 ubx_core_clear_data()
+
 #endif /* __GPS_DRIVER_H */
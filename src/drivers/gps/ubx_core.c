@@ -0,0 +1,387 @@
+#include <string.h>
+
+#include "drivers/hal/system.h"
+#include "drivers/hal/usart_gps.h"
+#include "drivers/hal/delay.h"
+#include "config.h"
+
+#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
+#include "drivers/hal/usart_ext.h"
+#endif
+
+#include "ubx_core.h"
+#include "log.h"
+
+static const ubx_chip *ubx_core_chip = NULL;
+
+// Compiler barrier: the readers and the writer of the published GPS data run on the same core
+#define ubx_core_barrier() __asm__ volatile ("" ::: "memory")
+
+/**
+ * GPS data being decoded. Only written from ubx_core_handle_incoming_data(), which runs in the USART DMA drain,
+ * or with interrupts disabled.
+ */
+static gps_data ubx_core_gps_data;
+
+/**
+ * Published GPS data, double-buffered so that readers never need to disable interrupts. The decoded data is copied
+ * into the buffer readers are not using and the publish count then switches them over to it. A reader retries
+ * if the publish count changed while it was copying. The drain runs either in the main loop or in the timer
+ * interrupt, so the copy is complete whenever a reader gets to check the count again, and a reader interrupting
+ * the writer reads the other, complete buffer.
+ */
+static gps_data ubx_core_published_gps_data[2];
+static volatile uint32_t ubx_core_publish_count = 0;
+static volatile uint32_t ubx_core_published_sequence = 0;
+
+// Sequence number of the GPS data last returned by ubx_core_get_current_gps_data()
+static uint32_t ubx_core_consumed_sequence = 0;
+
+// Time of week of the navigation epoch the current sequence number was given to
+static uint32_t ubx_core_epoch_time_of_week_millis = 0;
+static bool ubx_core_epoch_known = false;
+
+static volatile bool ack_received = false;
+static volatile bool nack_received = false;
+
+static uint16_t raw_capture_length = 0;
+
+static void ubx_core_handle_frame(const ubx_frame *frame);
+static void ubx_core_publish_gps_data();
+
+#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
+static bool ubx_core_handle_nmea(uint8_t data);
+
+/**
+ * NMEA forwarding state:
+ *   0: waiting for '$'
+ *   1: waiting for 'G'
+ *   2: waiting for the talker ID letter
+ *   3: forwarding the sentence, until CR LF
+ */
+static volatile uint8_t nmea_sync = 0;
+#endif
+
+static ubx_stream ubx_core_stream = {
+        .frame_handler = ubx_core_handle_frame,
+#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
+        .passthrough_handler = ubx_core_handle_nmea,
+#endif
+};
+
+/**
+ * Activates the chip and starts from a clean parser, ACK state and GPS data
+ */
+void ubx_core_init(const ubx_chip *chip)
+{
+    system_disable_irq();
+    ubx_core_chip = chip;
+    ubx_core_stream.max_payload_length = chip->max_payload_length;
+    ubx_core_reset_parser();
+    // The sequence number keeps counting, so that nobody takes the cleared data for a new solution
+    uint32_t sequence = ubx_core_gps_data.sequence;
+    memset(&ubx_core_gps_data, 0, sizeof(gps_data));
+    ubx_core_gps_data.sequence = sequence;
+    ubx_core_epoch_known = false;
+    ubx_core_publish_gps_data();
+    ack_received = false;
+    nack_received = false;
+    raw_capture_length = 0;
+    system_enable_irq();
+}
+
+static void ubx_core_handle_frame(const ubx_frame *frame)
+{
+    if (frame->msg_class == UBX_CLASS_ACK) {
+        if (frame->msg_id == UBX_ACK_ACK) {
+            ack_received = true;
+            return;
+        }
+        if (frame->msg_id == UBX_ACK_NAK) {
+            nack_received = true;
+            return;
+        }
+    }
+
+    const ubx_core_message *message = ubx_core_chip->messages;
+    const ubx_core_message *messages_end = message + ubx_core_chip->message_count;
+
+    for (; message < messages_end; message++) {
+        if (message->msg_class == frame->msg_class && message->msg_id == frame->msg_id) {
+            if (frame->length >= message->min_length) {
+                message->handler(frame, &ubx_core_gps_data);
+            }
+            return;
+        }
+    }
+
+#ifdef GPS_LOGGING_ENABLE
+    log_info("GPS %s: unhandled message class=0x%02X id=0x%02X length=%u\n", ubx_core_chip->name,
+            frame->msg_class, frame->msg_id, frame->length);
+#endif
+}
+
+#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
+static void ubx_core_handle_nmea_sentence_start(uint8_t data)
+{
+    if (nmea_sync == 0 && data == '$') {
+        nmea_sync = 1;
+    } else if (nmea_sync == 1) {
+        if (data == 'G') {
+            nmea_sync = 2;
+        } else {
+            nmea_sync = 0;
+        }
+    } else if (nmea_sync == 2) {
+        if (data >= 'A' && data <= 'Z') {
+            usart_ext_send_byte('$');
+            usart_ext_send_byte('G');
+            usart_ext_send_byte(data);
+            nmea_sync = 3;
+        } else {
+            nmea_sync = 0;
+        }
+    }
+}
+
+static void ubx_core_handle_nmea_output(uint8_t data)
+{
+    usart_ext_send_byte(data);
+    if (data == '\r') {
+        nmea_sync = 3;
+    } else if (nmea_sync == 3 && data == '\n') {
+        nmea_sync = 0;
+    }
+}
+
+/**
+ * Bytes outside UBX frames: keeps all bytes while forwarding a sentence
+ */
+static bool ubx_core_handle_nmea(uint8_t data)
+{
+    if (nmea_sync >= 3) {
+        ubx_core_handle_nmea_output(data);
+    } else {
+        ubx_core_handle_nmea_sentence_start(data);
+    }
+    return nmea_sync >= 3;
+}
+#endif
+
+/**
+ * Handles the bytes received into the USART DMA ring since the last call, see ubx_stream_parse()
+ */
+void ubx_core_handle_incoming_data(const uint8_t *ring, uint16_t ring_size, uint16_t start, uint16_t end,
+        uint8_t reset)
+{
+    if (ubx_core_chip == NULL) {
+        return;
+    }
+
+    if (reset) {
+        ubx_core_reset_parser();
+    }
+
+    if (raw_capture_length < ubx_core_chip->raw_capture_size) {
+        for (uint16_t pos = start; pos != end && raw_capture_length < ubx_core_chip->raw_capture_size;
+                pos = (pos + 1) % ring_size) {
+            ubx_core_chip->raw_capture_buffer[raw_capture_length++] = ring[pos];
+        }
+    }
+
+    uint16_t bad_packets = ubx_stream_parse(&ubx_core_stream, ring, ring_size, start, end);
+    ubx_core_gps_data.bad_packets += bad_packets;
+
+    // The message handlers flag new data as updated: publish it, as the next solution once per navigation epoch.
+    // The messages of an epoch share its time of week and may arrive over several drains.
+    if (ubx_core_gps_data.updated) {
+        ubx_core_gps_data.updated = false;
+        if (!ubx_core_epoch_known || ubx_core_gps_data.time_of_week_millis != ubx_core_epoch_time_of_week_millis) {
+            ubx_core_epoch_time_of_week_millis = ubx_core_gps_data.time_of_week_millis;
+            ubx_core_epoch_known = true;
+            ubx_core_gps_data.sequence++;
+        }
+        ubx_core_publish_gps_data();
+    } else if (bad_packets > 0) {
+        ubx_core_publish_gps_data();
+    }
+}
+
+/**
+ * Drops the frame being parsed and any NMEA sentence being forwarded
+ */
+void ubx_core_reset_parser()
+{
+    ubx_stream_reset(&ubx_core_stream);
+    ubx_core_stream.passthrough_active = false;
+#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
+    nmea_sync = 0;
+#endif
+}
+
+/**
+ * Drops the frame being parsed, so that a partial frame cannot swallow the response to the next command
+ */
+void ubx_core_resync()
+{
+    ubx_stream_reset(&ubx_core_stream);
+}
+
+void ubx_core_send_command(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t payload_length)
+{
+    uint8_t header[4] = {msg_class, msg_id, (uint8_t) (payload_length & 0xFFU), (uint8_t) (payload_length >> 8U)};
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+
+    ack_received = false;
+    nack_received = false;
+
+    usart_gps_send_byte(UBX_SYNC_CHAR_1);
+    usart_gps_send_byte(UBX_SYNC_CHAR_2);
+
+    for (uint8_t i = 0; i < sizeof(header); i++) {
+        ck_a += header[i];
+        ck_b += ck_a;
+        usart_gps_send_byte(header[i]);
+    }
+
+    for (uint16_t i = 0; i < payload_length; i++) {
+        ck_a += payload[i];
+        ck_b += ck_a;
+        usart_gps_send_byte(payload[i]);
+    }
+
+    usart_gps_send_byte(ck_a);
+    usart_gps_send_byte(ck_b);
+}
+
+/**
+ * Waits for the ACK or NAK of the last command sent. Returns true on ACK.
+ */
+bool ubx_core_wait_for_ack()
+{
+    if (ubx_core_chip->ack_wait_drains_dma) {
+        uint32_t start = HAL_GetTick();
+        while ((HAL_GetTick() - start) < ubx_core_chip->ack_timeout_ms) {
+            usart_gps_drain_dma();
+            if (ack_received || nack_received) {
+                return ack_received;
+            }
+        }
+    } else {
+        uint16_t timeout = ubx_core_chip->ack_timeout_ms;
+        while (!ack_received && !nack_received && timeout-- > 0) {
+            delay_ms(1);
+        }
+        if (ack_received || nack_received) {
+            return ack_received;
+        }
+    }
+
+    log_info("GPS %s: ACK timeout (ok=%u bad=%u)\n", ubx_core_chip->name, ubx_core_gps_data.ok_packets,
+            ubx_core_gps_data.bad_packets);
+    return false;
+}
+
+bool ubx_core_send_command_and_wait_for_ack(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload,
+        uint16_t payload_length)
+{
+    ubx_core_send_command(msg_class, msg_id, payload, payload_length);
+    return ubx_core_wait_for_ack();
+}
+
+static void ubx_core_publish_gps_data()
+{
+    uint32_t count = ubx_core_publish_count + 1;
+    memcpy(&ubx_core_published_gps_data[count & 1U], &ubx_core_gps_data, sizeof(gps_data));
+    ubx_core_barrier();
+    ubx_core_publish_count = count;
+    ubx_core_published_sequence = ubx_core_gps_data.sequence;
+}
+
+static void ubx_core_read_gps_data(gps_data *data)
+{
+    uint32_t count;
+    do {
+        count = ubx_core_publish_count;
+        ubx_core_barrier();
+        memcpy(data, &ubx_core_published_gps_data[count & 1U], sizeof(gps_data));
+        ubx_core_barrier();
+    } while (count != ubx_core_publish_count);
+}
+
+/**
+ * Reads the current GPS data, flagged as updated if it is a new solution since the last call. The flag is shared
+ * by all callers: use ubx_core_get_gps_data_since() to follow the solutions independently of other readers.
+ */
+bool ubx_core_get_current_gps_data(gps_data *data)
+{
+    ubx_core_read_gps_data(data);
+    data->updated = data->sequence != ubx_core_consumed_sequence;
+    ubx_core_consumed_sequence = data->sequence;
+
+    return data->updated;
+}
+
+// Non-consuming read: leaves the updated flag of ubx_core_get_current_gps_data() intact
+bool ubx_core_peek_current_gps_data(gps_data *data)
+{
+    ubx_core_read_gps_data(data);
+    data->updated = data->sequence != ubx_core_consumed_sequence;
+
+    return data->updated;
+}
+
+/**
+ * Reads the current GPS data. Returns true, and flags the data as updated, if it is a newer solution than the one
+ * with the given sequence number. Keep data->sequence to ask for the solution after this one.
+ */
+bool ubx_core_get_gps_data_since(uint32_t sequence, gps_data *data)
+{
+    ubx_core_read_gps_data(data);
+    data->updated = data->sequence != sequence;
+
+    return data->updated;
+}
+
+/**
+ * Sequence number of the current GPS solution, to wait for the next one without copying the data
+ */
+uint32_t ubx_core_get_gps_data_sequence()
+{
+    return ubx_core_published_sequence;
+}
+
+/**
+ * Clears the GPS data. The cleared data is not a new solution.
+ */
+void ubx_core_clear_data()
+{
+    system_disable_irq();
+    uint16_t ok_packets = ubx_core_gps_data.ok_packets;
+    uint16_t bad_packets = ubx_core_gps_data.bad_packets;
+    uint32_t sequence = ubx_core_gps_data.sequence;
+    memset(&ubx_core_gps_data, 0, sizeof(gps_data));
+    ubx_core_gps_data.sequence = sequence;
+    ubx_core_epoch_known = false;
+    if (ubx_core_chip != NULL && ubx_core_chip->preserve_packet_counters_on_clear) {
+        ubx_core_gps_data.ok_packets = ok_packets;
+        ubx_core_gps_data.bad_packets = bad_packets;
+    }
+    ubx_core_publish_gps_data();
+    ubx_core_consumed_sequence = sequence;
+    system_enable_irq();
+}
+
+void ubx_core_set_power_safe_mode_state(uint8_t state)
+{
+    system_disable_irq();
+    ubx_core_gps_data.power_safe_mode_state = state;
+    ubx_core_publish_gps_data();
+    system_enable_irq();
+}
+
+uint16_t ubx_core_get_raw_capture_length()
+{
+    return raw_capture_length;
+}
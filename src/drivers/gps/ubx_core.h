@@ -0,0 +1,89 @@
+#ifndef __UBX_CORE_H
+#define __UBX_CORE_H
+
+/**
+ * UBX transport core shared by the u-blox GPS drivers.
+ *
+ * The core owns everything that does not depend on the receiver generation: the streaming frame parser on the
+ * USART DMA ring (drivers/gps/ubx_stream.h), dispatch of the received messages, ACK/NAK handling, NMEA forwarding,
+ * sending commands and the current GPS data. A driver describes its chip with a ubx_chip: the messages it decodes
+ * and the quirks of the chip and its driver. The driver activates its chip with ubx_core_init() before talking
+ * to the receiver and keeps only the configuration sequences of its generation.
+ *
+ * The GPS data is published after every drain of the DMA ring that decoded a message. The first message of a new
+ * navigation epoch (time of week) makes it the next solution with the next sequence number, the rest of the epoch
+ * updates that solution. Readers get a consistent copy without disabling interrupts, and can follow the solutions
+ * by their sequence number independently of each other.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "src/gps.h"
+#include "drivers/gps/ubx_stream.h"
+
+#define UBX_CLASS_NAV 0x01
+#define UBX_CLASS_RXM 0x02
+#define UBX_CLASS_ACK 0x05
+#define UBX_CLASS_CFG 0x06
+#define UBX_CLASS_MON 0x0A
+
+#define UBX_ACK_NAK 0x00
+#define UBX_ACK_ACK 0x01
+
+/**
+ * Decodes a message into the GPS data. The frame has at least the minimum length of its message table entry.
+ */
+typedef void (*ubx_core_message_handler)(const ubx_frame *frame, gps_data *data);
+
+typedef struct _ubx_core_message {
+    uint8_t msg_class;
+    uint8_t msg_id;
+    uint16_t min_length;
+    ubx_core_message_handler handler;
+} ubx_core_message;
+
+typedef struct _ubx_chip {
+    const char *name;
+
+    // Messages decoded into the GPS data. ACK and NAK are handled by the core.
+    const ubx_core_message *messages;
+    uint8_t message_count;
+
+    // Longer frames are counted as bad packets
+    uint16_t max_payload_length;
+
+    uint16_t ack_timeout_ms;
+    // Drain the USART DMA ring while waiting for an ACK instead of waiting for the timer interrupt to do it
+    bool ack_wait_drains_dma;
+
+    // Keep the packet counters when the GPS data is cleared, to tell whether the receiver talks after a wake-up
+    bool preserve_packet_counters_on_clear;
+
+    // Optional capture of the first bytes received after ubx_core_init(), for diagnostics
+    uint8_t *raw_capture_buffer;
+    uint16_t raw_capture_size;
+} ubx_chip;
+
+void ubx_core_init(const ubx_chip *chip);
+
+void ubx_core_handle_incoming_data(const uint8_t *ring, uint16_t ring_size, uint16_t start, uint16_t end,
+        uint8_t reset);
+void ubx_core_reset_parser();
+void ubx_core_resync();
+
+void ubx_core_send_command(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t payload_length);
+bool ubx_core_wait_for_ack();
+bool ubx_core_send_command_and_wait_for_ack(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload,
+        uint16_t payload_length);
+
+bool ubx_core_get_current_gps_data(gps_data *data);
+bool ubx_core_peek_current_gps_data(gps_data *data);
+bool ubx_core_get_gps_data_since(uint32_t sequence, gps_data *data);
+uint32_t ubx_core_get_gps_data_sequence();
+void ubx_core_clear_data();
+void ubx_core_set_power_safe_mode_state(uint8_t state);
+
+uint16_t ubx_core_get_raw_capture_length();
+
+#endif
@@ -0,0 +1,179 @@
+#include <string.h>
+
+#include "ubx_stream.h"
+
+void ubx_stream_reset(ubx_stream *stream)
+{
+    stream->state = UBX_STREAM_STATE_SYNC_1;
+    stream->header_count = 0;
+}
+
+static inline uint16_t ubx_stream_distance(uint16_t from, uint16_t to, uint16_t ring_size)
+{
+    return to >= from ? to - from : to + ring_size - from;
+}
+
+/**
+ * Handle the frame whose last checksum byte has just been read. The frame is handed over only if the DMA cannot have
+ * overwritten it yet: the ring has to hold the frame, the bytes received after it and the margin for the DMA.
+ */
+static uint16_t ubx_stream_complete_frame(ubx_stream *stream, const uint8_t *ring, uint16_t ring_size,
+        uint8_t ck_b, uint16_t pos, uint16_t end)
+{
+    stream->state = UBX_STREAM_STATE_SYNC_1;
+
+    if (stream->checksum_a != stream->ck_a || ck_b != stream->ck_b) {
+        return 1;
+    }
+
+    uint16_t length = (uint16_t) (stream->header[2] | (stream->header[3] << 8));
+    uint32_t used = (uint32_t) length + UBX_FRAME_OVERHEAD + ubx_stream_distance(pos, end, ring_size)
+            + UBX_STREAM_DMA_MARGIN;
+
+    if (used <= ring_size && stream->frame_handler != NULL) {
+        ubx_frame frame = {
+                .ring = ring,
+                .ring_size = ring_size,
+                .payload_pos = stream->payload_pos,
+                .length = length,
+                .msg_class = stream->header[0],
+                .msg_id = stream->header[1],
+        };
+        stream->frame_handler(&frame);
+    }
+
+    return 0;
+}
+
+/**
+ * Parse the contiguous bytes ring[pos] .. ring[segment_end - 1]. The end of the received data is at end,
+ * which is segment_end for the last segment of a call. Returns the number of bad frames.
+ */
+static uint16_t ubx_stream_parse_segment(ubx_stream *stream, const uint8_t *ring, uint16_t ring_size,
+        uint16_t pos, uint16_t segment_end, uint16_t end)
+{
+    uint16_t bad_frames = 0;
+
+    while (pos < segment_end) {
+        switch (stream->state) {
+            case UBX_STREAM_STATE_SYNC_1:
+                if (stream->passthrough_handler == NULL) {
+                    // Nothing to do with the bytes in between: skip straight to the next sync character
+                    const uint8_t *sync = memchr(&ring[pos], UBX_SYNC_CHAR_1, segment_end - pos);
+                    if (sync == NULL) {
+                        return bad_frames;
+                    }
+                    pos = (uint16_t) (sync - ring) + 1;
+                    stream->state = UBX_STREAM_STATE_SYNC_2;
+                    break;
+                }
+                for (; pos < segment_end; pos++) {
+                    uint8_t data = ring[pos];
+                    if (stream->passthrough_active) {
+                        stream->passthrough_active = stream->passthrough_handler(data);
+                    } else if (data == UBX_SYNC_CHAR_1) {
+                        stream->state = UBX_STREAM_STATE_SYNC_2;
+                        pos++;
+                        break;
+                    } else {
+                        stream->passthrough_active = stream->passthrough_handler(data);
+                    }
+                }
+                break;
+            case UBX_STREAM_STATE_SYNC_2: {
+                uint8_t data = ring[pos++];
+                if (data == UBX_SYNC_CHAR_2) {
+                    stream->state = UBX_STREAM_STATE_HEADER;
+                    stream->header_count = 0;
+                    stream->ck_a = 0;
+                    stream->ck_b = 0;
+                } else {
+                    // A false start: the byte is not checked for the first sync character again
+                    stream->state = UBX_STREAM_STATE_SYNC_1;
+                    if (stream->passthrough_handler != NULL) {
+                        stream->passthrough_active = stream->passthrough_handler(data);
+                    }
+                }
+                break;
+            }
+            case UBX_STREAM_STATE_HEADER: {
+                uint8_t data = ring[pos++];
+                stream->header[stream->header_count++] = data;
+                stream->ck_a += data;
+                stream->ck_b += stream->ck_a;
+                if (stream->header_count < sizeof(stream->header)) {
+                    break;
+                }
+
+                uint16_t length = (uint16_t) (stream->header[2] | (stream->header[3] << 8));
+                if (length > stream->max_payload_length) {
+                    stream->state = UBX_STREAM_STATE_SYNC_1;
+                    bad_frames++;
+                    break;
+                }
+
+                stream->payload_pos = pos < ring_size ? pos : 0;
+                stream->payload_remaining = length;
+                stream->header_count = 0;
+                stream->state = length > 0 ? UBX_STREAM_STATE_PAYLOAD : UBX_STREAM_STATE_CHECKSUM;
+                break;
+            }
+            case UBX_STREAM_STATE_PAYLOAD: {
+                uint16_t count = segment_end - pos;
+                if (count > stream->payload_remaining) {
+                    count = stream->payload_remaining;
+                }
+
+                // Fletcher checksum over the payload in place, with the running sums kept in registers
+                uint8_t ck_a = stream->ck_a;
+                uint8_t ck_b = stream->ck_b;
+                const uint8_t *data = &ring[pos];
+                const uint8_t *data_end = data + count;
+                while (data < data_end) {
+                    ck_a += *data++;
+                    ck_b += ck_a;
+                }
+                stream->ck_a = ck_a;
+                stream->ck_b = ck_b;
+
+                pos += count;
+                stream->payload_remaining -= count;
+                if (stream->payload_remaining == 0) {
+                    stream->state = UBX_STREAM_STATE_CHECKSUM;
+                }
+                break;
+            }
+            case UBX_STREAM_STATE_CHECKSUM: {
+                uint8_t data = ring[pos++];
+                if (stream->header_count == 0) {
+                    stream->checksum_a = data;
+                    stream->header_count = 1;
+                    break;
+                }
+                bad_frames += ubx_stream_complete_frame(stream, ring, ring_size, data, pos < ring_size ? pos : 0, end);
+                break;
+            }
+        }
+    }
+
+    return bad_frames;
+}
+
+/**
+ * Parse the bytes received into the ring from position start up to, but not including, position end.
+ * The range wraps around the end of the ring if end is before start. Complete frames are handed to the frame
+ * handler during the call. Returns the number of frames with a bad checksum or length.
+ */
+uint16_t ubx_stream_parse(ubx_stream *stream, const uint8_t *ring, uint16_t ring_size, uint16_t start, uint16_t end)
+{
+    if (start == end) {
+        return 0;
+    }
+
+    if (end > start) {
+        return ubx_stream_parse_segment(stream, ring, ring_size, start, end, end);
+    }
+
+    uint16_t bad_frames = ubx_stream_parse_segment(stream, ring, ring_size, start, ring_size, end);
+    return bad_frames + ubx_stream_parse_segment(stream, ring, ring_size, 0, end, end);
+}
@@ -0,0 +1,96 @@
+#ifndef __UBX_STREAM_H
+#define __UBX_STREAM_H
+
+/**
+ * Streaming UBX frame parser working in place on the GPS USART receive DMA ring.
+ *
+ * The parser is fed ranges of the ring as the DMA fills it. It scans for the sync characters, reads the header and
+ * runs the Fletcher checksum over the ring segments as they arrive, without copying the frame anywhere. A frame
+ * with a valid checksum is handed over while it is still in the ring, and its payload is read from there with the
+ * ubx_frame_*() accessors.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UBX_SYNC_CHAR_1 0xB5
+#define UBX_SYNC_CHAR_2 0x62
+
+// Sync characters, class, ID, payload length and checksum
+#define UBX_FRAME_OVERHEAD 8
+
+// Bytes the DMA may write into the ring while a frame is being handled. Frames that do not fit in the ring
+// together with this margin and the bytes received after them would be overwritten, and are not handed over.
+#define UBX_STREAM_DMA_MARGIN 16
+
+/**
+ * A complete UBX frame with a valid checksum in the receive ring.
+ * The payload may wrap around the end of the ring: read it with the ubx_frame_*() accessors.
+ */
+typedef struct _ubx_frame {
+    const uint8_t *ring;
+    uint16_t ring_size;
+    // Position of the first payload byte in the ring
+    uint16_t payload_pos;
+    uint16_t length;
+    uint8_t msg_class;
+    uint8_t msg_id;
+} ubx_frame;
+
+typedef void (*ubx_stream_frame_handler)(const ubx_frame *frame);
+
+/**
+ * Gets the bytes outside of UBX frames, for example NMEA sentences. Returns true while all following bytes belong
+ * to it as well, in which case they are not checked for UBX sync characters.
+ */
+typedef bool (*ubx_stream_passthrough_handler)(uint8_t data);
+
+typedef enum _ubx_stream_state {
+    UBX_STREAM_STATE_SYNC_1 = 0,
+    UBX_STREAM_STATE_SYNC_2,
+    UBX_STREAM_STATE_HEADER,
+    UBX_STREAM_STATE_PAYLOAD,
+    UBX_STREAM_STATE_CHECKSUM,
+} ubx_stream_state;
+
+typedef struct _ubx_stream {
+    ubx_stream_frame_handler frame_handler;
+    ubx_stream_passthrough_handler passthrough_handler;
+    // Frames with a longer payload are counted as bad without waiting for their end
+    uint16_t max_payload_length;
+
+    ubx_stream_state state;
+    bool passthrough_active;
+    // Class, ID and payload length, then the two checksum bytes
+    uint8_t header[4];
+    uint8_t header_count;
+    uint8_t checksum_a;
+    uint16_t payload_pos;
+    uint16_t payload_remaining;
+    uint8_t ck_a;
+    uint8_t ck_b;
+} ubx_stream;
+
+void ubx_stream_reset(ubx_stream *stream);
+uint16_t ubx_stream_parse(ubx_stream *stream, const uint8_t *ring, uint16_t ring_size, uint16_t start, uint16_t end);
+
+static inline uint8_t ubx_frame_u1(const ubx_frame *frame, uint16_t offset)
+{
+    uint16_t pos = frame->payload_pos + offset;
+    if (pos >= frame->ring_size) {
+        pos -= frame->ring_size;
+    }
+    return frame->ring[pos];
+}
+
+static inline uint16_t ubx_frame_u2(const ubx_frame *frame, uint16_t offset)
+{
+    return (uint16_t) (ubx_frame_u1(frame, offset) | (ubx_frame_u1(frame, offset + 1) << 8));
+}
+
+static inline uint32_t ubx_frame_u4(const ubx_frame *frame, uint16_t offset)
+{
+    return (uint32_t) ubx_frame_u2(frame, offset) | ((uint32_t) ubx_frame_u2(frame, offset + 2) << 16);
+}
+
+#endif
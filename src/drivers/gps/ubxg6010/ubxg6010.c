@@ -1,11 +1,11 @@
 #include <string.h>
+#include <stddef.h>
 
 #include "drivers/hal/system.h"
 #include "drivers/hal/usart_gps.h"
-#include "drivers/hal/usart_ext.h"
 #include "drivers/hal/delay.h"
 
-
+#include "drivers/gps/ubx_core.h"
 #include "ubxg6010.h"
 #include "log.h"
 #include "config.h"
@@ -24,11 +24,6 @@ typedef struct __attribute__((packed)) {
     uint16_t payloadSize;
 } uBloxHeader;
 
-typedef struct {
-    uint8_t ck_a;
-    uint8_t ck_b;
-} uBloxChecksum;
-
 typedef struct {
     uint32_t iTOW;        //GPS time of week of the navigation epoch. [- ms]
     uint16_t year;        //Year (UTC) [- y]
@@ -244,79 +239,13 @@ typedef struct __attribute__((packed)) {
     ubloxPacketData data;
 } uBloxPacket;
 
-gps_data ubxg6010_current_gps_data;
+#define UBXG6010_ACK_TIMEOUT_MS 1500
 
 volatile bool gps_initialized = false;
-volatile bool ack_received = false;
-volatile bool nack_received = false;
-
-volatile static uint8_t sync_ubx = 0;
-volatile static uint8_t sync_nmea = 0;
-
-static uBloxChecksum
-ubxg6010_calculate_checksum(const uint8_t msgClass, const uint8_t msgId, const uint8_t *message, uint16_t size)
-{
-    uBloxChecksum ck = {0, 0};
-
-    ck.ck_a += msgClass;
-    ck.ck_b += ck.ck_a;
-    ck.ck_a += msgId;
-    ck.ck_b += ck.ck_a;
-
-    ck.ck_a += size & 0xffU;
-    ck.ck_b += ck.ck_a;
-    ck.ck_a += size >> 8U;
-    ck.ck_b += ck.ck_a;
-
-    for (uint16_t i = 0; i < size; i++) {
-        ck.ck_a += message[i];
-        ck.ck_b += ck.ck_a;
-    }
-
-    return ck;
-}
-
-static void ubxg6010_clear_ack()
-{
-    ack_received = false;
-    nack_received = false;
-}
-
-static bool ubxg6010_wait_for_ack()
-{
-    uint16_t timeout = 1500;
-
-    while (!ack_received && !nack_received && timeout-- > 0) {
-        delay_ms(1);
-    }
-
-    return ack_received;
-}
-
-void ubxg6010_send_command(uint8_t msgClass, uint8_t msgId, const uint8_t *payload, uint16_t payloadSize)
-{
-    ubxg6010_clear_ack();
-
-    uBloxChecksum chksum = ubxg6010_calculate_checksum(msgClass, msgId, payload, payloadSize);
-
-    usart_gps_send_byte(0xB5);
-    usart_gps_send_byte(0x62);
-    usart_gps_send_byte(msgClass);
-    usart_gps_send_byte(msgId);
-    usart_gps_send_byte((uint8_t) (payloadSize & 0xFFU));
-    usart_gps_send_byte((uint8_t) (payloadSize >> 8U));
-
-    uint16_t i;
-    for (i = 0; i < payloadSize; ++i) {
-        usart_gps_send_byte(payload[i]);
-    }
-    usart_gps_send_byte(chksum.ck_a);
-    usart_gps_send_byte(chksum.ck_b);
-}
 
 void ubxg6010_send_packet(const uBloxPacket *packet)
 {
-    ubxg6010_send_command(packet->header.messageClass, packet->header.messageId, (const uint8_t *) &packet->data,
+    ubx_core_send_command(packet->header.messageClass, packet->header.messageId, (const uint8_t *) &packet->data,
             packet->header.payloadSize);
 }
 
@@ -327,33 +256,12 @@ bool ubxg6010_send_packet_and_wait_for_ack(const uBloxPacket *packet)
 
     do {
         ubxg6010_send_packet(packet);
-        success = ubxg6010_wait_for_ack();
+        success = ubx_core_wait_for_ack();
     } while (!success && retries-- > 0);
 
     return success;
 }
 
-bool ubxg6010_get_current_gps_data(gps_data *data)
-{
-    system_disable_irq();
-    memcpy(data, &ubxg6010_current_gps_data, sizeof(gps_data));
-    ubxg6010_current_gps_data.updated = false;
-    system_enable_irq();
-
-    return data->updated;
-}
-
-// Non-consuming read: leaves the updated flag intact so the transmit
-// scheduler, which is the sole consumer of the flag, still sees it.
-bool ubxg6010_peek_current_gps_data(gps_data *data)
-{
-    system_disable_irq();
-    memcpy(data, &ubxg6010_current_gps_data, sizeof(gps_data));
-    system_enable_irq();
-
-    return data->updated;
-}
-
 const uBloxPacket msgcfgrst = {
         .header = {
                 0xb5,
@@ -519,8 +427,8 @@ bool ubxg6010_enable_power_save_mode()
     packet.data.cfgrxm.lpMode = 1;
 
     log_info("GPS: Entering power-saving mode\n");
-    ubxg6010_send_packet(&packet);
-    success = ubxg6010_wait_for_ack();
+    success = ubx_core_send_command_and_wait_for_ack(packet.header.messageClass, packet.header.messageId,
+            (const uint8_t *) &packet.data, packet.header.payloadSize);
     if (!success) {
         log_error("GPS: Entering power-saving mode failed\n");
     }
@@ -539,14 +447,14 @@ void ubxg6010_sleep(void)
     pmreq[4] = 0x02;  /* flags bit1 = backup */
 
     log_info("GPS: Entering backup (sleep) mode\n");
-    ubxg6010_send_command(0x02, 0x41, pmreq, sizeof(pmreq));
+    ubx_core_send_command(UBX_CLASS_RXM, 0x41, pmreq, sizeof(pmreq));
 
-    ubxg6010_current_gps_data.power_safe_mode_state = POWER_SAFE_MODE_STATE_INACTIVE;
+    ubx_core_set_power_safe_mode_state(POWER_SAFE_MODE_STATE_INACTIVE);
 }
 
 void ubxg6010_init_and_sleep(void)
 {
-    memset(&ubxg6010_current_gps_data, 0, sizeof(gps_data));
+    ubx_core_init(&ubxg6010_chip);
 
     // Init USART at the GPS chip's default power-on baud rate
     log_info("GPS: Initializing USART at %d baud for sleep\n", GPS_INITIAL_BAUD_RATE);
@@ -560,7 +468,7 @@ bool ubxg6010_init()
 {
     bool success;
 
-    memset(&ubxg6010_current_gps_data, 0, sizeof(gps_data));
+    ubx_core_init(&ubxg6010_chip);
 
     gps_initialized = false;
 
@@ -716,204 +624,135 @@ void ubxg6010_request_gpstime()
     ubxg6010_send_packet(&msgnavgpstime);
 }
 
-static void ubxg6010_handle_packet(uBloxPacket *pkt)
-{
-    // log_info("Handling GPS packet\n");
-    uBloxChecksum cksum = ubxg6010_calculate_checksum(pkt->header.messageClass, pkt->header.messageId,
-            (const uint8_t *) &pkt->data, pkt->header.payloadSize);
-    uBloxChecksum *checksum = (uBloxChecksum *) (((uint8_t *) &pkt->data) + pkt->header.payloadSize);
-
-    if (cksum.ck_a != checksum->ck_a || cksum.ck_b != checksum->ck_b) {
-        ubxg6010_current_gps_data.bad_packets += 1;
-#ifdef GPS_LOGGING_ENABLE
-        log_info("GPS checksum FAIL (bad=%i) class=0x%02X id=0x%02X payloadSize=%u\n",
-                 ubxg6010_current_gps_data.bad_packets,
-                 pkt->header.messageClass, pkt->header.messageId,
-                 pkt->header.payloadSize);
-#endif
-        return;
-    }
+/*
+ * Message handlers, called from the UBX core for the messages in the table below. The payload is still in the USART
+ * DMA ring and may wrap around its end, so the fields are read with the ubx_frame_*() accessors at their offsets in
+ * the payload structures above.
+ */
 
-#ifdef GPS_LOGGING_ENABLE
-    log_info("GPS message: class=0x%02X id=0x%02X\n", pkt->header.messageClass, pkt->header.messageId);
-#endif
+#define FIELD_U1(type, field) ubx_frame_u1(frame, offsetof(type, field))
+#define FIELD_U2(type, field) ubx_frame_u2(frame, offsetof(type, field))
+#define FIELD_U4(type, field) ubx_frame_u4(frame, offsetof(type, field))
 
-    if (pkt->header.messageClass == 0x01 && pkt->header.messageId == 0x07) {
-        // NOTE: NAV-PVT message is not supported by the older UBX-G6010 chip, but only the newer UBX-M10050
-        ubxg6010_current_gps_data.ok_packets += 1;
-        ubxg6010_current_gps_data.time_of_week_millis = pkt->data.navpvt.iTOW;
-        ubxg6010_current_gps_data.year = pkt->data.navpvt.year;
-        ubxg6010_current_gps_data.month = pkt->data.navpvt.month;
-        ubxg6010_current_gps_data.day = pkt->data.navpvt.day;
-        ubxg6010_current_gps_data.hours = pkt->data.navpvt.hour;
-        ubxg6010_current_gps_data.minutes = pkt->data.navpvt.min;
-        ubxg6010_current_gps_data.seconds = pkt->data.navpvt.sec;
-
-        ubxg6010_current_gps_data.fix = pkt->data.navpvt.fixType;
-        ubxg6010_current_gps_data.latitude_degrees_10000000 = pkt->data.navpvt.lat;
-        ubxg6010_current_gps_data.longitude_degrees_10000000 = pkt->data.navpvt.lon;
-        ubxg6010_current_gps_data.altitude_mm = pkt->data.navpvt.hMSL;
-        ubxg6010_current_gps_data.satellites_visible = pkt->data.navpvt.numSV;
-        ubxg6010_current_gps_data.ground_speed_cm_per_second = pkt->data.navpvt.gSpeed;
-        ubxg6010_current_gps_data.heading_degrees_100000 = pkt->data.navpvt.headMot;
-        ubxg6010_current_gps_data.climb_cm_per_second = -pkt->data.navpvt.velD;
-
-        ubxg6010_current_gps_data.updated = true;
-    } else if (pkt->header.messageClass == 0x01 && pkt->header.messageId == 0x12) {
-        ubxg6010_current_gps_data.ok_packets += 1;
-        ubxg6010_current_gps_data.time_of_week_millis = pkt->data.navvelned.iTOW;
-        ubxg6010_current_gps_data.ground_speed_cm_per_second = pkt->data.navvelned.gSpeed;
-        ubxg6010_current_gps_data.heading_degrees_100000 = pkt->data.navvelned.headMot;
-        ubxg6010_current_gps_data.climb_cm_per_second = -pkt->data.navvelned.velD;
-
-        ubxg6010_current_gps_data.updated = true;
-    } else if (pkt->header.messageClass == 0x01 && pkt->header.messageId == 0x02) {
-        ubxg6010_current_gps_data.ok_packets += 1;
-        ubxg6010_current_gps_data.time_of_week_millis = pkt->data.navposllh.iTOW;
-        ubxg6010_current_gps_data.latitude_degrees_10000000 = pkt->data.navposllh.lat;
-        ubxg6010_current_gps_data.longitude_degrees_10000000 = pkt->data.navposllh.lon;
-        ubxg6010_current_gps_data.altitude_mm = pkt->data.navposllh.hMSL;
-
-        ubxg6010_current_gps_data.updated = true;
-    } else if (pkt->header.messageClass == 0x01 && pkt->header.messageId == 0x03) {
-        ubxg6010_current_gps_data.ok_packets += 1;
-        ubxg6010_current_gps_data.fix_ok = pkt->data.navstatus.flags & 0x01;
-        /* NAV-STATUS flags2 bits [1:0] psmState uses a 2-bit scheme:
-         * 0=acquisition, 1=tracking, 2=POT, 3=inactive.
-         * Map to gps.h constants (which follow the NAV-PVT / Horus v3 scheme). */
-        {
-            static const uint8_t navstatus_psm_map[] = {
-                POWER_SAFE_MODE_STATE_ACQUISITION,
-                POWER_SAFE_MODE_STATE_TRACKING,
-                POWER_SAFE_MODE_STATE_OPTIMISED,
-                POWER_SAFE_MODE_STATE_INACTIVE,
-            };
-            ubxg6010_current_gps_data.power_safe_mode_state =
-                navstatus_psm_map[pkt->data.navstatus.flags2 & 0x03];
-        }
+static void ubxg6010_handle_nav_pvt(const ubx_frame *frame, gps_data *data)
+{
+    // NOTE: NAV-PVT message is not supported by the older UBX-G6010 chip, but only the newer UBX-M10050
+    data->ok_packets += 1;
+    data->time_of_week_millis = FIELD_U4(uBloxNAVPVTPayload, iTOW);
+    data->year = FIELD_U2(uBloxNAVPVTPayload, year);
+    data->month = FIELD_U1(uBloxNAVPVTPayload, month);
+    data->day = FIELD_U1(uBloxNAVPVTPayload, day);
+    data->hours = FIELD_U1(uBloxNAVPVTPayload, hour);
+    data->minutes = FIELD_U1(uBloxNAVPVTPayload, min);
+    data->seconds = FIELD_U1(uBloxNAVPVTPayload, sec);
+
+    data->fix = FIELD_U1(uBloxNAVPVTPayload, fixType);
+    data->latitude_degrees_10000000 = (int32_t) FIELD_U4(uBloxNAVPVTPayload, lat);
+    data->longitude_degrees_10000000 = (int32_t) FIELD_U4(uBloxNAVPVTPayload, lon);
+    data->altitude_mm = (int32_t) FIELD_U4(uBloxNAVPVTPayload, hMSL);
+    data->satellites_visible = FIELD_U1(uBloxNAVPVTPayload, numSV);
+    data->ground_speed_cm_per_second = FIELD_U4(uBloxNAVPVTPayload, gSpeed);
+    data->heading_degrees_100000 = (int32_t) FIELD_U4(uBloxNAVPVTPayload, headMot);
+    data->climb_cm_per_second = -(int32_t) FIELD_U4(uBloxNAVPVTPayload, velD);
+
+    data->updated = true;
+}
 
-        ubxg6010_current_gps_data.updated = true;
-    } else if (pkt->header.messageClass == 0x01 && pkt->header.messageId == 0x06) {
-        ubxg6010_current_gps_data.time_of_week_millis = pkt->data.navsol.iTOW;
-        ubxg6010_current_gps_data.week = pkt->data.navsol.week;
-        ubxg6010_current_gps_data.fix = pkt->data.navsol.gpsFix;
-        ubxg6010_current_gps_data.fix_ok = pkt->data.navsol.flags & 0x01;
-        ubxg6010_current_gps_data.satellites_visible = pkt->data.navsol.numSV;
-        ubxg6010_current_gps_data.position_dilution_of_precision = pkt->data.navsol.pDOP;
-
-        ubxg6010_current_gps_data.updated = true;
-    } else if (pkt->header.messageClass == 0x01 && pkt->header.messageId == 0x20) {
-        ubxg6010_current_gps_data.time_of_week_millis = pkt->data.navtimegps.iTOW;
-        ubxg6010_current_gps_data.week = pkt->data.navtimegps.week;
-
-        if (pkt->data.navtimegps.valid & 0x04) {
-            // Flag set if leap seconds are valid
-            ubxg6010_current_gps_data.leap_seconds = pkt->data.navtimegps.leapS;
-        }
+static void ubxg6010_handle_nav_velned(const ubx_frame *frame, gps_data *data)
+{
+    data->ok_packets += 1;
+    data->time_of_week_millis = FIELD_U4(uBloxNAVVELNEDPayload, iTOW);
+    data->ground_speed_cm_per_second = FIELD_U4(uBloxNAVVELNEDPayload, gSpeed);
+    data->heading_degrees_100000 = (int32_t) FIELD_U4(uBloxNAVVELNEDPayload, headMot);
+    data->climb_cm_per_second = -(int32_t) FIELD_U4(uBloxNAVVELNEDPayload, velD);
 
-        ubxg6010_current_gps_data.updated = true;
-    } else if (pkt->header.messageClass == 0x01 && pkt->header.messageId == 0x21) {
-        ubxg6010_current_gps_data.year = pkt->data.navtimeutc.year;
-        ubxg6010_current_gps_data.month = pkt->data.navtimeutc.month;
-        ubxg6010_current_gps_data.day = pkt->data.navtimeutc.day;
-        ubxg6010_current_gps_data.hours = pkt->data.navtimeutc.hour;
-        ubxg6010_current_gps_data.minutes = pkt->data.navtimeutc.min;
-        ubxg6010_current_gps_data.seconds = pkt->data.navtimeutc.sec;
-
-        ubxg6010_current_gps_data.updated = true;
-    } else if (pkt->header.messageClass == 0x05 && pkt->header.messageId == 0x01) {
-        ack_received = true;
-    } else if (pkt->header.messageClass == 0x05 && pkt->header.messageId == 0x00) {
-        nack_received = true;
-    }
+    data->updated = true;
 }
 
-void ubxg6010_reset_parser()
+static void ubxg6010_handle_nav_posllh(const ubx_frame *frame, gps_data *data)
 {
-    sync_ubx = 0;
-    sync_nmea = 0;
+    data->ok_packets += 1;
+    data->time_of_week_millis = FIELD_U4(uBloxNAVPOSLLHPayload, iTOW);
+    data->latitude_degrees_10000000 = (int32_t) FIELD_U4(uBloxNAVPOSLLHPayload, lat);
+    data->longitude_degrees_10000000 = (int32_t) FIELD_U4(uBloxNAVPOSLLHPayload, lon);
+    data->altitude_mm = (int32_t) FIELD_U4(uBloxNAVPOSLLHPayload, hMSL);
+
+    data->updated = true;
 }
 
-void ubxg6010_clear_data()
+static void ubxg6010_handle_nav_status(const ubx_frame *frame, gps_data *data)
 {
-    memset(&ubxg6010_current_gps_data, 0, sizeof(gps_data));
+    /* NAV-STATUS flags2 bits [1:0] psmState uses a 2-bit scheme:
+     * 0=acquisition, 1=tracking, 2=POT, 3=inactive.
+     * Map to gps.h constants (which follow the NAV-PVT / Horus v3 scheme). */
+    static const uint8_t navstatus_psm_map[] = {
+        POWER_SAFE_MODE_STATE_ACQUISITION,
+        POWER_SAFE_MODE_STATE_TRACKING,
+        POWER_SAFE_MODE_STATE_OPTIMISED,
+        POWER_SAFE_MODE_STATE_INACTIVE,
+    };
+
+    data->ok_packets += 1;
+    data->fix_ok = FIELD_U1(uBloxNAVSTATUSPayload, flags) & 0x01;
+    data->power_safe_mode_state = navstatus_psm_map[FIELD_U1(uBloxNAVSTATUSPayload, flags2) & 0x03];
+
+    data->updated = true;
 }
 
-#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
-static void ubxg6010_handle_nmea_sentence_start(uint8_t data)
+static void ubxg6010_handle_nav_sol(const ubx_frame *frame, gps_data *data)
 {
-    if (sync_nmea == 0 && data == '$') {
-        sync_nmea = 1;
-    } else if (sync_nmea == 1) {
-        if (data == 'G') {
-            sync_nmea = 2;
-        } else {
-            sync_nmea = 0;
-        }
-    } else if (sync_nmea == 2) {
-        if (data >= 'A' && data <= 'Z') {
-            usart_ext_send_byte('$');
-            usart_ext_send_byte('G');
-            usart_ext_send_byte(data);
-            sync_nmea = 3;
-        } else {
-            sync_nmea = 0;
-        }
-    }
+    data->time_of_week_millis = FIELD_U4(uBloxNAVSOLPayload, iTOW);
+    data->week = (int16_t) FIELD_U2(uBloxNAVSOLPayload, week);
+    data->fix = FIELD_U1(uBloxNAVSOLPayload, gpsFix);
+    data->fix_ok = FIELD_U1(uBloxNAVSOLPayload, flags) & 0x01;
+    data->satellites_visible = FIELD_U1(uBloxNAVSOLPayload, numSV);
+    data->position_dilution_of_precision = FIELD_U2(uBloxNAVSOLPayload, pDOP);
+
+    data->updated = true;
 }
 
-static void ubxg6010_handle_nmea_output(uint8_t data)
+static void ubxg6010_handle_nav_timegps(const ubx_frame *frame, gps_data *data)
 {
-    usart_ext_send_byte(data);
-    if (data == '\r') {
-        sync_nmea = 3;
-    } else if (sync_nmea == 3 && data == '\n') {
-        sync_nmea = 0;
+    data->time_of_week_millis = FIELD_U4(uBloxNAVTIMEGPSPayload, iTOW);
+    data->week = (int16_t) FIELD_U2(uBloxNAVTIMEGPSPayload, week);
+
+    if (FIELD_U1(uBloxNAVTIMEGPSPayload, valid) & 0x04) {
+        // Flag set if leap seconds are valid
+        data->leap_seconds = (int8_t) FIELD_U1(uBloxNAVTIMEGPSPayload, leapS);
     }
+
+    data->updated = true;
 }
-#endif
 
-void ubxg6010_handle_incoming_byte(uint8_t data, uint8_t reset)
+static void ubxg6010_handle_nav_timeutc(const ubx_frame *frame, gps_data *data)
 {
-    static uint8_t buffer_pos = 0;
-    static uint8_t incoming_packet_buffer[sizeof(uBloxPacket) + sizeof(uBloxChecksum)];
-    static uBloxPacket *incoming_packet = (uBloxPacket *) incoming_packet_buffer;
-
-    if (reset) {
-       sync_ubx = 0;
-       buffer_pos = 0;
-    }
-    if (!sync_ubx && (sync_nmea < 3)) {
-        if (!buffer_pos && data == 0xB5) {
-            buffer_pos = 1;
-            incoming_packet->header.sc1 = data;
-        } else if (buffer_pos == 1 && data == 0x62) {
-            sync_ubx = 1;
-            buffer_pos = 2;
-            incoming_packet->header.sc2 = data;
-        }
-#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
-        else
-        {
-            ubxg6010_handle_nmea_sentence_start(data);
-            buffer_pos = 0;
-        }
-    } else if (sync_nmea >= 3) {
-        ubxg6010_handle_nmea_output(data);
-#endif
-    } else {
-        ((uint8_t *) incoming_packet)[buffer_pos] = data;
-        if ((buffer_pos >= sizeof(uBloxHeader) - 1) &&
-            (buffer_pos - 1 == (incoming_packet->header.payloadSize + sizeof(uBloxHeader) + sizeof(uBloxChecksum)))) {
-            ubxg6010_handle_packet((uBloxPacket *) incoming_packet);
-            buffer_pos = 0;
-            sync_ubx = 0;
-        } else {
-            buffer_pos++;
-            if (buffer_pos >= sizeof(uBloxPacket) + sizeof(uBloxChecksum)) {
-                buffer_pos = 0;
-                sync_ubx = 0;
-            }
-        }
-    }
+    data->year = FIELD_U2(uBloxNAVTIMEUTCPayload, year);
+    data->month = FIELD_U1(uBloxNAVTIMEUTCPayload, month);
+    data->day = FIELD_U1(uBloxNAVTIMEUTCPayload, day);
+    data->hours = FIELD_U1(uBloxNAVTIMEUTCPayload, hour);
+    data->minutes = FIELD_U1(uBloxNAVTIMEUTCPayload, min);
+    data->seconds = FIELD_U1(uBloxNAVTIMEUTCPayload, sec);
+
+    data->updated = true;
 }
+
+static const ubx_core_message ubxg6010_messages[] = {
+        {UBX_CLASS_NAV, 0x07, sizeof(uBloxNAVPVTPayload), ubxg6010_handle_nav_pvt},
+        {UBX_CLASS_NAV, 0x12, sizeof(uBloxNAVVELNEDPayload), ubxg6010_handle_nav_velned},
+        {UBX_CLASS_NAV, 0x02, sizeof(uBloxNAVPOSLLHPayload), ubxg6010_handle_nav_posllh},
+        {UBX_CLASS_NAV, 0x03, sizeof(uBloxNAVSTATUSPayload), ubxg6010_handle_nav_status},
+        {UBX_CLASS_NAV, 0x06, sizeof(uBloxNAVSOLPayload), ubxg6010_handle_nav_sol},
+        {UBX_CLASS_NAV, 0x20, sizeof(uBloxNAVTIMEGPSPayload), ubxg6010_handle_nav_timegps},
+        {UBX_CLASS_NAV, 0x21, sizeof(uBloxNAVTIMEUTCPayload), ubxg6010_handle_nav_timeutc},
+};
+
+const ubx_chip ubxg6010_chip = {
+        .name = "G6010",
+        .messages = ubxg6010_messages,
+        .message_count = sizeof(ubxg6010_messages) / sizeof(ubxg6010_messages[0]),
+        .max_payload_length = 256,
+        .ack_timeout_ms = UBXG6010_ACK_TIMEOUT_MS,
+        // The timer interrupt drains the USART DMA ring while waiting for an ACK
+        .ack_wait_drains_dma = false,
+        .preserve_packet_counters_on_clear = false,
+};
@@ -4,6 +4,9 @@
 #include <stdint.h>
 
 #include "src/gps.h"
+#include "drivers/gps/ubx_core.h"
+
+extern const ubx_chip ubxg6010_chip;
 
 bool ubxg6010_init();
 
@@ -15,14 +18,4 @@ void ubxg6010_sleep(void);
 
 void ubxg6010_request_gpstime();
 
-bool ubxg6010_get_current_gps_data(gps_data *data);
-
-bool ubxg6010_peek_current_gps_data(gps_data *data);
-
-void ubxg6010_handle_incoming_byte(uint8_t data, uint8_t reset);
-
-void ubxg6010_reset_parser();
-
-void ubxg6010_clear_data();
-
 #endif
@@ -9,19 +9,22 @@
  *   - Power save via CFG-PM-OPERATEMODE set to PSMCT (cyclic tracking).
  *   - NAV-PVT (0x01 0x07) provides position + velocity + time in one message.
  *   - UBX frame format and checksum algorithm are unchanged.
+ *
+ * Parsing, ACK/NAK handling, NMEA forwarding and the current GPS data are
+ * shared with the ubxg6010 driver in drivers/gps/ubx_core.c. This driver
+ * has the configuration sequences and the decoders of its messages.
  */
 
 #include <string.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
 #include "drivers/hal/system.h"
 #include "drivers/hal/usart_gps.h"
 #include "drivers/hal/delay.h"
-#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
-#include "drivers/hal/usart_ext.h"
-#endif
 
+#include "drivers/gps/ubx_core.h"
 #include "ubxm10050.h"
 #include "log.h"
 #include "config.h"
@@ -30,15 +33,7 @@
  * Protocol constants
  * ------------------------------------------------------------------------- */
 
-#define UBX_SYNC1               0xB5
-#define UBX_SYNC2               0x62
-
-/* Message classes */
-#define UBX_CLASS_NAV           0x01
-#define UBX_CLASS_RXM           0x02
-#define UBX_CLASS_CFG           0x06
-#define UBX_CLASS_MON           0x0A
-#define UBX_CLASS_ACK           0x05
+/* Message classes and the ACK/NAK IDs are defined in drivers/gps/ubx_core.h */
 
 /* Message IDs */
 #define UBX_NAV_PVT             0x07    /* Position, Velocity, Time */
@@ -48,8 +43,6 @@
 #define UBX_CFG_VALSET          0x8A    /* Set configuration items */
 #define UBX_CFG_VALDEL          0x8C    /* Delete configuration items (revert to defaults) */
 #define UBX_CFG_RST             0x04    /* Reset receiver */
-#define UBX_ACK_ACK             0x01
-#define UBX_ACK_NAK             0x00
 
 /* CFG-VALSET layers bitmask */
 #define VALSET_LAYER_RAM        0x01    /* Volatile RAM - lost on power cycle */
@@ -120,19 +113,6 @@
  * Packet structures
  * ------------------------------------------------------------------------- */
 
-typedef struct __attribute__((packed)) {
-    uint8_t  sync1;         /* 0xB5 */
-    uint8_t  sync2;         /* 0x62 */
-    uint8_t  msgClass;
-    uint8_t  msgId;
-    uint16_t payloadLen;
-} UbxHeader;
-
-typedef struct __attribute__((packed)) {
-    uint8_t ck_a;
-    uint8_t ck_b;
-} UbxChecksum;
-
 /* CFG-RST payload */
 typedef struct __attribute__((packed)) {
     uint16_t navBbrMask;    /* BBR sections to clear, 0xFFFF = cold start */
@@ -207,99 +187,16 @@ typedef struct __attribute__((packed)) {
  * Module state
  * ------------------------------------------------------------------------- */
 
-static gps_data m10_current_gps_data;
 static bool     m10_initialized = false;
-static volatile bool ack_received  = false;
-static volatile bool nack_received = false;
-
-/* Parser state */
-static uint8_t  parse_sync     = 0;
-static uint8_t  parse_buf[256 + sizeof(UbxHeader) + sizeof(UbxChecksum)];
-static uint16_t parse_pos      = 0;
 
-#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
-/* NMEA forwarding state:
- *   0 = idle, waiting for '$'
- *   1 = got '$', waiting for 'G'
- *   2 = got '$G', waiting for talker ID letter
- *   3 = forwarding sentence body until \n
- */
-static volatile uint8_t nmea_sync = 0;
-#endif
-
-/* Raw-byte capture: filled by ubxm10050_handle_incoming_byte before
- * the parser runs, so we can log exactly what the GPS chip sends us. */
+/* Raw-byte capture: filled by the UBX core before the parser runs,
+ * so we can log exactly what the GPS chip sends us after the reset. */
 #define RAW_CAPTURE_SIZE 80
 static uint8_t  raw_capture_buf[RAW_CAPTURE_SIZE];
-static volatile uint16_t raw_capture_pos = 0;
 
 /* Count of NAV-PVT packets received (reset on init) */
 static uint16_t pvt_packet_count = 0;
 
-/* -------------------------------------------------------------------------
- * Checksum
- * ------------------------------------------------------------------------- */
-
-static UbxChecksum ubxm10050_checksum(uint8_t msgClass, uint8_t msgId,
-                                       const uint8_t *payload, uint16_t len)
-{
-    UbxChecksum cs = {0, 0};
-    cs.ck_a += msgClass;  cs.ck_b += cs.ck_a;
-    cs.ck_a += msgId;     cs.ck_b += cs.ck_a;
-    cs.ck_a += (uint8_t)(len & 0xFF);        cs.ck_b += cs.ck_a;
-    cs.ck_a += (uint8_t)((len >> 8) & 0xFF); cs.ck_b += cs.ck_a;
-    for (uint16_t i = 0; i < len; i++) {
-        cs.ck_a += payload[i];
-        cs.ck_b += cs.ck_a;
-    }
-    return cs;
-}
-
-/* -------------------------------------------------------------------------
- * Send raw UBX packet
- * ------------------------------------------------------------------------- */
-
-static void ubxm10050_send_raw(uint8_t msgClass, uint8_t msgId,
-                                const uint8_t *payload, uint16_t payloadLen)
-{
-    UbxChecksum cs = ubxm10050_checksum(msgClass, msgId, payload, payloadLen);
-
-    usart_gps_send_byte(UBX_SYNC1);
-    usart_gps_send_byte(UBX_SYNC2);
-    usart_gps_send_byte(msgClass);
-    usart_gps_send_byte(msgId);
-    usart_gps_send_byte((uint8_t)(payloadLen & 0xFF));
-    usart_gps_send_byte((uint8_t)((payloadLen >> 8) & 0xFF));
-    for (uint16_t i = 0; i < payloadLen; i++) {
-        usart_gps_send_byte(payload[i]);
-    }
-    usart_gps_send_byte(cs.ck_a);
-    usart_gps_send_byte(cs.ck_b);
-}
-
-/* -------------------------------------------------------------------------
- * Wait for ACK/NAK with timeout
- * ------------------------------------------------------------------------- */
-
-static bool ubxm10050_wait_for_ack(void)
-{
-    uint32_t start = HAL_GetTick();
-    ack_received  = false;
-    nack_received = false;
-
-    while ((HAL_GetTick() - start) < UBX_ACK_TIMEOUT_MS) {
-        usart_gps_drain_dma();
-        if (ack_received)  return true;
-        if (nack_received) return false;
-    }
-
-    log_info("GPS M10: ACK timeout (gps_ints=%lu ok=%u bad=%u)\n",
-             gps_ints,
-             m10_current_gps_data.ok_packets,
-             m10_current_gps_data.bad_packets);
-    return false;
-}
-
 /* -------------------------------------------------------------------------
  * CFG-VALSET helpers
  *
@@ -352,11 +249,9 @@ static bool ubxm10050_valset_u1_multi(uint8_t layers,
     /* Drain any pending bytes and reset parser to avoid stale state
      * from NMEA or partial UBX packets consuming our ACK sync bytes. */
     usart_gps_drain_dma();
-    parse_sync = 0;
-    parse_pos  = 0;
+    ubx_core_resync();
 
-    ubxm10050_send_raw(UBX_CLASS_CFG, UBX_CFG_VALSET, buf, sizeof(buf));
-    return ubxm10050_wait_for_ack();
+    return ubx_core_send_command_and_wait_for_ack(UBX_CLASS_CFG, UBX_CFG_VALSET, buf, sizeof(buf));
 }
 
 /* Send a single CFG-VALSET with one U4 item */
@@ -381,11 +276,9 @@ static bool ubxm10050_valset_u4(uint8_t layers, uint32_t key, uint32_t val)
     /* Drain any pending bytes and reset parser to avoid stale state
      * from NMEA or partial UBX packets consuming our ACK sync bytes. */
     usart_gps_drain_dma();
-    parse_sync = 0;
-    parse_pos  = 0;
+    ubx_core_resync();
 
-    ubxm10050_send_raw(UBX_CLASS_CFG, UBX_CFG_VALSET, buf, sizeof(buf));
-    return ubxm10050_wait_for_ack();
+    return ubx_core_send_command_and_wait_for_ack(UBX_CLASS_CFG, UBX_CFG_VALSET, buf, sizeof(buf));
 }
 
 /* Send a single CFG-VALSET with one U2 item */
@@ -406,11 +299,9 @@ static bool ubxm10050_valset_u2(uint8_t layers, uint32_t key, uint16_t val)
     buf[9] = (uint8_t)((val >> 8) & 0xFF);
 
     usart_gps_drain_dma();
-    parse_sync = 0;
-    parse_pos  = 0;
+    ubx_core_resync();
 
-    ubxm10050_send_raw(UBX_CLASS_CFG, UBX_CFG_VALSET, buf, sizeof(buf));
-    return ubxm10050_wait_for_ack();
+    return ubx_core_send_command_and_wait_for_ack(UBX_CLASS_CFG, UBX_CFG_VALSET, buf, sizeof(buf));
 }
 
 /* -------------------------------------------------------------------------
@@ -444,11 +335,9 @@ static bool ubxm10050_valdel_keys(uint8_t layers,
     }
 
     usart_gps_drain_dma();
-    parse_sync = 0;
-    parse_pos  = 0;
+    ubx_core_resync();
 
-    ubxm10050_send_raw(UBX_CLASS_CFG, UBX_CFG_VALDEL, buf, sizeof(buf));
-    return ubxm10050_wait_for_ack();
+    return ubx_core_send_command_and_wait_for_ack(UBX_CLASS_CFG, UBX_CFG_VALDEL, buf, sizeof(buf));
 }
 #endif
 
@@ -463,8 +352,8 @@ static void ubxm10050_cold_reset(void)
         .resetMode  = 0x02,     /* Controlled SW reset (GNSS + host) */
         .reserved   = 0x00,
     };
-    ubxm10050_send_raw(UBX_CLASS_CFG, UBX_CFG_RST,
-                       (const uint8_t *)&rst, sizeof(rst));
+    ubx_core_send_command(UBX_CLASS_CFG, UBX_CFG_RST,
+                          (const uint8_t *)&rst, sizeof(rst));
     /* No ACK expected for reset */
 }
 
@@ -486,293 +375,133 @@ __attribute__((unused)) static const char *fix_type_str(uint8_t fix)
 }
 
 /* -------------------------------------------------------------------------
- * Packet handler (called from parser when a complete valid packet arrives)
+ * Message handlers (called from the UBX core when a complete valid frame
+ * of a message in the table below arrives)
+ *
+ * The payload is still in the USART DMA ring and may wrap around its end,
+ * so the fields are read with the ubx_frame_*() accessors at their offsets
+ * in the payload structures above.
  * ------------------------------------------------------------------------- */
 
-static void ubxm10050_handle_packet(uint8_t msgClass, uint8_t msgId,
-                                     const uint8_t *payload, uint16_t len)
-{
-    if (msgClass == UBX_CLASS_ACK) {
-        if (msgId == UBX_ACK_ACK)  { ack_received  = true; return; }
-        if (msgId == UBX_ACK_NAK)  { nack_received = true; return; }
-    }
+#define PVT_U1(field) ubx_frame_u1(frame, offsetof(UbxNavPvtPayload, field))
+#define PVT_U2(field) ubx_frame_u2(frame, offsetof(UbxNavPvtPayload, field))
+#define PVT_U4(field) ubx_frame_u4(frame, offsetof(UbxNavPvtPayload, field))
 
-    if (msgClass == UBX_CLASS_NAV && msgId == UBX_NAV_PVT) {
-        if (len < sizeof(UbxNavPvtPayload)) return;
-        const UbxNavPvtPayload *pvt = (const UbxNavPvtPayload *)payload;
-
-        m10_current_gps_data.ok_packets++;
-        pvt_packet_count++;
-        m10_current_gps_data.time_of_week_millis          = pvt->iTOW;
-        m10_current_gps_data.year                         = pvt->year;
-        m10_current_gps_data.month                        = pvt->month;
-        m10_current_gps_data.day                          = pvt->day;
-        m10_current_gps_data.hours                        = pvt->hour;
-        m10_current_gps_data.minutes                      = pvt->min;
-        m10_current_gps_data.seconds                      = pvt->sec;
-        m10_current_gps_data.fix                          = pvt->fixType;
-        m10_current_gps_data.fix_ok                       = (pvt->flags & 0x01) != 0;
-        m10_current_gps_data.satellites_visible           = pvt->numSV;
-        m10_current_gps_data.time_valid_flags             = pvt->valid;
-        m10_current_gps_data.time_accuracy_ns             = pvt->tAcc;
-        m10_current_gps_data.latitude_degrees_10000000     = pvt->lat;
-        m10_current_gps_data.longitude_degrees_10000000    = pvt->lon;
-        m10_current_gps_data.altitude_mm                  = pvt->hMSL;
-        m10_current_gps_data.ground_speed_cm_per_second   = pvt->gSpeed / 10;
-        m10_current_gps_data.heading_degrees_100000       = pvt->headMot;
-        m10_current_gps_data.climb_cm_per_second          = -(pvt->velD / 10);
-        m10_current_gps_data.position_dilution_of_precision = pvt->pDOP;
-        /* PSM state from flags bits [4:2] — log transitions for diagnostics */
-        {
-            static uint8_t prev_psm_state = 0xFF;
-            uint8_t new_psm_state = (pvt->flags >> 2) & 0x07;
-            if (new_psm_state != prev_psm_state) {
+static void ubxm10050_handle_nav_pvt(const ubx_frame *frame, gps_data *data)
+{
+    uint8_t fix_type = PVT_U1(fixType);
+    uint8_t flags    = PVT_U1(flags);
+    uint8_t num_sv   = PVT_U1(numSV);
+
+    data->ok_packets++;
+    pvt_packet_count++;
+    data->time_of_week_millis          = PVT_U4(iTOW);
+    data->year                         = PVT_U2(year);
+    data->month                        = PVT_U1(month);
+    data->day                          = PVT_U1(day);
+    data->hours                        = PVT_U1(hour);
+    data->minutes                      = PVT_U1(min);
+    data->seconds                      = PVT_U1(sec);
+    data->fix                          = fix_type;
+    data->fix_ok                       = (flags & 0x01) != 0;
+    data->satellites_visible           = num_sv;
+    data->time_valid_flags             = PVT_U1(valid);
+    data->time_accuracy_ns             = PVT_U4(tAcc);
+    data->latitude_degrees_10000000     = (int32_t) PVT_U4(lat);
+    data->longitude_degrees_10000000    = (int32_t) PVT_U4(lon);
+    data->altitude_mm                  = (int32_t) PVT_U4(hMSL);
+    data->ground_speed_cm_per_second   = (int32_t) PVT_U4(gSpeed) / 10;
+    data->heading_degrees_100000       = (int32_t) PVT_U4(headMot);
+    data->climb_cm_per_second          = -((int32_t) PVT_U4(velD) / 10);
+    data->position_dilution_of_precision = PVT_U2(pDOP);
+    /* PSM state from flags bits [4:2] — log transitions for diagnostics */
+    {
+        static uint8_t prev_psm_state = 0xFF;
+        uint8_t new_psm_state = (flags >> 2) & 0x07;
+        if (new_psm_state != prev_psm_state) {
 #ifdef GPS_LOGGING_ENABLE
-                log_info("GPS M10: psmState %u -> %u (fix=%u sats=%u flags=0x%02X)\n",
-                         prev_psm_state, new_psm_state, pvt->fixType, pvt->numSV, pvt->flags);
+            log_info("GPS M10: psmState %u -> %u (fix=%u sats=%u flags=0x%02X)\n",
+                     prev_psm_state, new_psm_state, fix_type, num_sv, flags);
 #endif
-                prev_psm_state = new_psm_state;
-            }
-            m10_current_gps_data.power_safe_mode_state = new_psm_state;
+            prev_psm_state = new_psm_state;
         }
+        data->power_safe_mode_state = new_psm_state;
+    }
 
-        m10_current_gps_data.updated                      = true;
+    data->updated                      = true;
 
-        /* Debug: log every PVT packet so we can see communication, fix, time,
-         * and satellite status in real time.
-         *   valid bits: bit0=date valid  bit1=time valid  bit2=fully resolved
-         *   fix types:  0=none 2=2D 3=3D 4=GNSS+DR 5=time-only
-         */
+    /* Debug: log every PVT packet so we can see communication, fix, time,
+     * and satellite status in real time.
+     *   valid bits: bit0=date valid  bit1=time valid  bit2=fully resolved
+     *   fix types:  0=none 2=2D 3=3D 4=GNSS+DR 5=time-only
+     */
 #ifdef GPS_LOGGING_ENABLE
-        log_info("GPS PVT #%u: fix=%s fixOK=%d sats=%u "
-                 "%04u-%02u-%02u %02u:%02u:%02u valid=0x%02X tAcc=%luus "
-                 "pDOP=%u.%02u hAcc=%lum vAcc=%lum "
-                 "psm=%u flags=0x%02X\n",
-                 pvt_packet_count,
-                 fix_type_str(pvt->fixType), (pvt->flags & 0x01),
-                 pvt->numSV,
-                 pvt->year, pvt->month, pvt->day,
-                 pvt->hour, pvt->min, pvt->sec,
-                 pvt->valid,
-                 (unsigned long)(pvt->tAcc / 1000),
-                 pvt->pDOP / 100, pvt->pDOP % 100,
-                 (unsigned long)(pvt->hAcc / 1000),
-                 (unsigned long)(pvt->vAcc / 1000),
-                 m10_current_gps_data.power_safe_mode_state, pvt->flags);
+    log_info("GPS PVT #%u: fix=%s fixOK=%d sats=%u "
+             "%04u-%02u-%02u %02u:%02u:%02u valid=0x%02X tAcc=%luus "
+             "pDOP=%u.%02u hAcc=%lum vAcc=%lum "
+             "psm=%u flags=0x%02X\n",
+             pvt_packet_count,
+             fix_type_str(fix_type), (flags & 0x01),
+             num_sv,
+             data->year, data->month, data->day,
+             data->hours, data->minutes, data->seconds,
+             data->time_valid_flags,
+             (unsigned long)(data->time_accuracy_ns / 1000),
+             data->position_dilution_of_precision / 100,
+             data->position_dilution_of_precision % 100,
+             (unsigned long)(PVT_U4(hAcc) / 1000),
+             (unsigned long)(PVT_U4(vAcc) / 1000),
+             data->power_safe_mode_state, flags);
 #endif
-        return;
-    }
+}
 
-    if (msgClass == UBX_CLASS_NAV && msgId == UBX_NAV_TIMEGPS) {
-        if (len < sizeof(UbxNavTimeGpsPayload)) return;
-        const UbxNavTimeGpsPayload *t = (const UbxNavTimeGpsPayload *)payload;
+static void ubxm10050_handle_nav_timegps(const ubx_frame *frame, gps_data *data)
+{
+    uint8_t valid = ubx_frame_u1(frame, offsetof(UbxNavTimeGpsPayload, valid));
 
-        m10_current_gps_data.time_of_week_millis = t->iTOW;
-        m10_current_gps_data.week                = t->week;
-        if (t->valid & 0x04) {
-            m10_current_gps_data.leap_seconds    = t->leapS;
-        }
-        m10_current_gps_data.updated = true;
-
-        /* Debug: log GPS time info - leapS valid is bit2 of valid byte.
-         * When leapS becomes valid, UTC = GPS_time - leapS is accurate. */
-        // log_info("GPS TIMEGPS: iTOW=%lu week=%d leapS=%d leapValid=%d tAcc=%luns\n",
-        //          (unsigned long)t->iTOW, t->week, t->leapS,
-        //          (t->valid & 0x04) ? 1 : 0,
-        //          (unsigned long)t->tAcc);
-        return;
+    data->time_of_week_millis = ubx_frame_u4(frame, offsetof(UbxNavTimeGpsPayload, iTOW));
+    data->week                = (int16_t) ubx_frame_u2(frame, offsetof(UbxNavTimeGpsPayload, week));
+    if (valid & 0x04) {
+        data->leap_seconds    = (int8_t) ubx_frame_u1(frame, offsetof(UbxNavTimeGpsPayload, leapS));
     }
-
-    /* Silently ignore other messages (MON-VER etc.) */
-    (void)len;
+    data->updated = true;
 }
 
 /* -------------------------------------------------------------------------
- * Byte-level parser
- *
- * State machine:
- *   parse_sync == 0: waiting for 0xB5
- *   parse_sync == 1: waiting for 0x62
- *   parse_sync == 2: accumulating bytes into parse_buf
+ * Chip description for the UBX core
  *
- * parse_buf layout: [class][id][lenL][lenH][payload...][ck_a][ck_b]
- * parse_pos counts bytes stored after the two sync bytes.
+ * Other messages (MON-VER etc.) are silently ignored.
  * ------------------------------------------------------------------------- */
 
-void ubxm10050_reset_parser(void)
-{
-    parse_sync = 0;
-    parse_pos  = 0;
-#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
-    nmea_sync  = 0;
-#endif
-}
-
-void ubxm10050_clear_data(void)
-{
+static const ubx_core_message ubxm10050_messages[] = {
+    { UBX_CLASS_NAV, UBX_NAV_PVT,     sizeof(UbxNavPvtPayload),     ubxm10050_handle_nav_pvt },
+    { UBX_CLASS_NAV, UBX_NAV_TIMEGPS, sizeof(UbxNavTimeGpsPayload), ubxm10050_handle_nav_timegps },
+};
+
+const ubx_chip ubxm10050_chip = {
+    .name                              = "M10",
+    .messages                          = ubxm10050_messages,
+    .message_count                     = sizeof(ubxm10050_messages) / sizeof(ubxm10050_messages[0]),
+    .max_payload_length                = 256,
+    .ack_timeout_ms                    = UBX_ACK_TIMEOUT_MS,
+    /* ACKs are polled straight off the DMA ring, so configuration does
+     * not have to wait for the timer interrupt to drain it */
+    .ack_wait_drains_dma               = true,
     /* Preserve diagnostic packet counters across sleep/wake cycles so it's
-     * possible to tell whether the receiver is communicating after wake.
-     * Zero only the position/time/fix fields. */
-    uint16_t saved_ok  = m10_current_gps_data.ok_packets;
-    uint16_t saved_bad = m10_current_gps_data.bad_packets;
-    memset(&m10_current_gps_data, 0, sizeof(gps_data));
-    m10_current_gps_data.ok_packets  = saved_ok;
-    m10_current_gps_data.bad_packets = saved_bad;
-}
-
-#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
-static void ubxm10050_handle_nmea_sentence_start(uint8_t data)
-{
-    if (nmea_sync == 0 && data == '$') {
-        nmea_sync = 1;
-    } else if (nmea_sync == 1) {
-        if (data == 'G') {
-            nmea_sync = 2;
-        } else {
-            nmea_sync = 0;
-        }
-    } else if (nmea_sync == 2) {
-        if (data >= 'A' && data <= 'Z') {
-            usart_ext_send_byte('$');
-            usart_ext_send_byte('G');
-            usart_ext_send_byte(data);
-            nmea_sync = 3;
-        } else {
-            nmea_sync = 0;
-        }
-    }
-}
-
-static void ubxm10050_handle_nmea_output(uint8_t data)
-{
-    usart_ext_send_byte(data);
-    if (data == '\r') {
-        nmea_sync = 3;
-    } else if (nmea_sync == 3 && data == '\n') {
-        nmea_sync = 0;
-    }
-}
-#endif
-
-void ubxm10050_handle_incoming_byte(uint8_t data, uint8_t reset)
-{
-    if (reset) {
-       parse_sync = 0;
-       parse_pos = 0;
-#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
-       nmea_sync = 0;
-#endif
-    }
-    if (raw_capture_pos < RAW_CAPTURE_SIZE) {
-        raw_capture_buf[raw_capture_pos++] = data;
-    }
-
-#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
-    /* If we are in the middle of forwarding an NMEA sentence, keep forwarding */
-    if (nmea_sync >= 3) {
-        ubxm10050_handle_nmea_output(data);
-        return;
-    }
-#endif
-
-    if (parse_sync == 0) {
-        if (data == UBX_SYNC1) {
-            parse_sync = 1;
-            parse_pos = 0;
-        }
-#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
-        else {
-            ubxm10050_handle_nmea_sentence_start(data);
-        }
-#endif
-        return;
-    }
-
-    if (parse_sync == 1) {
-        if (data == UBX_SYNC2) {
-            parse_sync = 2;
-        } else {
-            parse_sync = 0; /* false start */
-#if GPS_NMEA_OUTPUT_VIA_SERIAL_PORT_ENABLE
-            ubxm10050_handle_nmea_sentence_start(data);
-#endif
-        }
-        return;
-    }
-
-    /* parse_sync == 2: accumulating */
-    if (parse_pos < sizeof(parse_buf)) {
-        parse_buf[parse_pos++] = data;
-    } else {
-        /* Buffer overflow - abandon packet */
-        parse_sync = 0;
-        parse_pos  = 0;
-        return;
-    }
-
-    /* Need at least class + id + len(2) = 4 bytes before we know total length */
-    if (parse_pos < 4) return;
-
-    uint16_t payloadLen = (uint16_t)parse_buf[2] | ((uint16_t)parse_buf[3] << 8);
-
-    /* Guard against corrupted length: payload must fit in parse_buf
-     * alongside the 4-byte header and 2-byte checksum.  Without this,
-     * a large payloadLen causes uint16_t totalLen to wrap, bypassing
-     * the accumulation check and passing a huge len to checksum(). */
-    if (payloadLen > sizeof(parse_buf) - 6) {
-        parse_sync = 0;
-        parse_pos  = 0;
-        m10_current_gps_data.bad_packets++;
-        return;
-    }
-
-    uint16_t totalLen   = 4 + payloadLen + 2; /* class+id+len + payload + checksum */
-
-    if (parse_pos < totalLen) return; /* still accumulating */
-
-    /* Complete packet: verify checksum */
-    uint8_t  msgClass  = parse_buf[0];
-    uint8_t  msgId     = parse_buf[1];
-    const uint8_t *payload = &parse_buf[4];
-
-    UbxChecksum expected = ubxm10050_checksum(msgClass, msgId, payload, payloadLen);
-    uint8_t ck_a = parse_buf[4 + payloadLen];
-    uint8_t ck_b = parse_buf[4 + payloadLen + 1];
-
-    if (expected.ck_a == ck_a && expected.ck_b == ck_b) {
-        ubxm10050_handle_packet(msgClass, msgId, payload, payloadLen);
-    } else {
-        m10_current_gps_data.bad_packets++;
-    }
-
-    parse_sync = 0;
-    parse_pos  = 0;
-}
+     * possible to tell whether the receiver is communicating after wake. */
+    .preserve_packet_counters_on_clear = true,
+    .raw_capture_buffer                = raw_capture_buf,
+    .raw_capture_size                  = RAW_CAPTURE_SIZE,
+};
 
 /* -------------------------------------------------------------------------
  * Public API
  * ------------------------------------------------------------------------- */
 
-bool ubxm10050_get_current_gps_data(gps_data *data)
-{
-    bool was_updated = m10_current_gps_data.updated;
-    *data = m10_current_gps_data;
-    m10_current_gps_data.updated = false;
-    return was_updated;
-}
-
-/* Non-consuming read: leaves the updated flag intact so the transmit
- * scheduler, which is the sole consumer of the flag, still sees it. */
-bool ubxm10050_peek_current_gps_data(gps_data *data)
-{
-    *data = m10_current_gps_data;
-    return data->updated;
-}
-
 void ubxm10050_request_gpstime(void)
 {
     /* Poll NAV-TIMEGPS by sending an empty poll request */
-    ubxm10050_send_raw(UBX_CLASS_NAV, UBX_NAV_TIMEGPS, NULL, 0);
+    ubx_core_send_command(UBX_CLASS_NAV, UBX_NAV_TIMEGPS, NULL, 0);
 }
 
 bool ubxm10050_enable_power_save_mode(void)
@@ -844,16 +573,16 @@ void ubxm10050_sleep(void)
     };
 
     log_info("GPS M10: Entering backup (sleep) mode\n");
-    ubxm10050_send_raw(UBX_CLASS_RXM, UBX_RXM_PMREQ,
-                       (const uint8_t *)&pmreq, sizeof(pmreq));
+    ubx_core_send_command(UBX_CLASS_RXM, UBX_RXM_PMREQ,
+                          (const uint8_t *)&pmreq, sizeof(pmreq));
 
     /* No more PVT messages after backup mode - set explicitly */
-    m10_current_gps_data.power_safe_mode_state = POWER_SAFE_MODE_STATE_INACTIVE;
+    ubx_core_set_power_safe_mode_state(POWER_SAFE_MODE_STATE_INACTIVE);
 }
 
 void ubxm10050_init_and_sleep(void)
 {
-    memset(&m10_current_gps_data, 0, sizeof(gps_data));
+    ubx_core_init(&ubxm10050_chip);
 
     // ublox M10 series defaults to 38400 baud after power-on
     log_info("GPS M10: Initializing USART at 38400 baud for sleep\n");
@@ -867,11 +596,8 @@ bool ubxm10050_init(void)
 {
     bool success;
 
-    memset(&m10_current_gps_data, 0, sizeof(gps_data));
+    ubx_core_init(&ubxm10050_chip);
     m10_initialized  = false;
-    ack_received     = false;
-    nack_received    = false;
-    raw_capture_pos  = 0;
     pvt_packet_count = 0;
 
     log_info("GPS M10: Init UART at %d baud\n", GPS_SERIAL_PORT_BAUD_RATE);
@@ -887,8 +613,8 @@ bool ubxm10050_init(void)
      * Expected: ~hundreds of NMEA bytes if GPS RX is alive.
      * Zero means no bytes received - UART RX or GPS power is broken. */
     log_info("GPS M10: Post-reset gps_ints=%lu, captured %u bytes: ",
-             gps_ints, (unsigned)raw_capture_pos);
-    uint16_t dump_len = raw_capture_pos < RAW_CAPTURE_SIZE ? raw_capture_pos : RAW_CAPTURE_SIZE;
+             gps_ints, (unsigned)ubx_core_get_raw_capture_length());
+    uint16_t dump_len = ubx_core_get_raw_capture_length();
     for (uint16_t i = 0; i < dump_len; i++) {
         log_info("%02X ", raw_capture_buf[i]);
     }
@@ -1005,8 +731,8 @@ bool ubxm10050_init(void)
             .resetMode  = 0x08,     /* Controlled GNSS stop */
             .reserved   = 0x00,
         };
-        ubxm10050_send_raw(UBX_CLASS_CFG, UBX_CFG_RST,
-                           (const uint8_t *)&rst_stop, sizeof(rst_stop));
+        ubx_core_send_command(UBX_CLASS_CFG, UBX_CFG_RST,
+                              (const uint8_t *)&rst_stop, sizeof(rst_stop));
         delay_ms(500);
 
         UbxCfgRstPayload rst_start = {
@@ -1014,8 +740,8 @@ bool ubxm10050_init(void)
             .resetMode  = 0x09,     /* Controlled GNSS start */
             .reserved   = 0x00,
         };
-        ubxm10050_send_raw(UBX_CLASS_CFG, UBX_CFG_RST,
-                           (const uint8_t *)&rst_start, sizeof(rst_start));
+        ubx_core_send_command(UBX_CLASS_CFG, UBX_CFG_RST,
+                              (const uint8_t *)&rst_start, sizeof(rst_start));
         delay_ms(1000);
     }
 #endif
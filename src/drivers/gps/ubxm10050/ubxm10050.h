@@ -17,13 +17,17 @@
  *   - UBX frame format, checksum algorithm, and ACK/NAK are unchanged.
  *
  * Public API is intentionally identical to ubxg6010 so main.c only needs
- * a compile-time switch between the two drivers.
+ * a compile-time switch between the two drivers. Both drivers share the
+ * UBX core (drivers/gps/ubx_core.h) for everything else.
  */
 
 #include <stdint.h>
 #include <stdbool.h>
 
 #include "src/gps.h"
+#include "drivers/gps/ubx_core.h"
+
+extern const ubx_chip ubxm10050_chip;
 
 bool ubxm10050_init(void);
 
@@ -35,14 +39,4 @@ void ubxm10050_sleep(void);
 
 void ubxm10050_request_gpstime(void);
 
-bool ubxm10050_get_current_gps_data(gps_data *data);
-
-bool ubxm10050_peek_current_gps_data(gps_data *data);
-
-void ubxm10050_handle_incoming_byte(uint8_t data, uint8_t reset);
-
-void ubxm10050_reset_parser(void);
-
-void ubxm10050_clear_data(void);
-
 #endif /* __UBXM10050_H */
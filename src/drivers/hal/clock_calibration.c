@@ -5,6 +5,7 @@
 #include <stm32f1xx_hal.h>
 #include "clock_calibration.h"
 #include "radio_internal.h"
+#include "symbol_clock.h"
 
 /**
  * GPS-disciplined oscillator (GPSDO) for the DFM-17 Si4063.
@@ -27,6 +28,9 @@
  * The temperature LUT handles the large open-loop temperature compensation.
  * The GPS PLL handles manufacturing variance, aging, and LUT residual error.
  * Both corrections are additive: applied cap = c_value[t_look] + cap_trim_offset.
+ *
+ * The measured error is also averaged into the MCU clock error used by the symbol
+ * clocks (symbol_clock.h), which stretch the symbol periods to follow GPS time.
  */
 
 // ---- TIM4 input capture state -----------------------------------------------
@@ -49,6 +53,10 @@ static volatile int cap_trim_offset = 0;
 // Nominally 0; sign indicates direction of frequency error.
 static volatile int32_t last_us_error = 0;
 
+// MCU clock error averaged over the timepulses, for the symbol clocks (ppb).
+// Kept over GPS outages: the oscillator does not change much in the meantime.
+static volatile int32_t clock_error_ppb = 0;
+
 // P&O state machine
 typedef enum {
     PO_STARTUP,     // Collecting initial baseline measurement
@@ -118,6 +126,11 @@ uint8_t clock_calibration_get_po_state()
     return (uint8_t)po_state;
 }
 
+int32_t clock_calibration_get_clock_error_ppb()
+{
+    return clock_error_ppb;
+}
+
 // ---- TIM4 initialisation ----------------------------------------------------
 
 static void tim4_init(void)
@@ -169,6 +182,7 @@ void timepulse_init()
 
     cap_trim_offset     = 0;
     last_us_error       = 0;
+    clock_error_ppb     = 0;
     po_state            = PO_STARTUP;
     step_direction      = +1;
     settle_countdown    = 0;
@@ -258,6 +272,7 @@ void TIM4_IRQHandler(void)
 
         int32_t error = (int32_t)delta_ticks - (int32_t)TIMEPULSE_EXPECTED_TICKS;
         last_us_error = error;
+        clock_error_ppb = symbol_clock_filter_clock_error(clock_error_ppb, error);
         uint32_t abs_error = (error >= 0) ? (uint32_t)error : (uint32_t)(-error);
 
         switch (po_state) {
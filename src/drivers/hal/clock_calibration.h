@@ -1,6 +1,8 @@
 #ifndef __CLOCK_CALIBRATION_H
 #define __CLOCK_CALIBRATION_H
 
+#include <stdint.h>
+
 #include "config.h"
 
 #ifdef DFM17
@@ -18,6 +20,18 @@ extern int32_t clock_calibration_get_us_error();
 // Returns P&O state: 0=STARTUP, 1=SETTLING, 2=OBSERVING, 3=LOCKED.
 extern uint8_t clock_calibration_get_po_state();
 
+// Returns the MCU clock error averaged over the timepulses in parts per billion, positive when the clock is fast.
+// Used by the symbol clocks to follow GPS time.
+extern int32_t clock_calibration_get_clock_error_ppb();
+
+#else
+
+// No timepulse capture: the symbol clocks run uncorrected on the MCU clock
+static inline int32_t clock_calibration_get_clock_error_ppb()
+{
+    return 0;
+}
+
 #endif
 
 #endif
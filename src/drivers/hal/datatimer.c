@@ -8,11 +8,19 @@
 
 #include "datatimer.h"
 #include "timers.h"
+#include "clock_calibration.h"
+#include "symbol_clock.h"
 #include "log.h"
 
+// The data timer counts at 1 MHz
+#define DATA_TIMER_TICKS_PER_SECOND 1000000
 
 void (*system_handle_data_timer_tick)() = NULL;
 
+// Period of every timer cycle: keeps the average rate exact for rates that do not divide 1 MHz
+// and follows GPS time where the MCU clock error is measured
+static symbol_clock data_timer_symbol_clock;
+
 void data_timer_init(uint32_t baud_rate)
 {
     // Timer frequency = TIM_CLK/(TIM_PSC+1)/(TIM_ARR + 1)
@@ -32,9 +40,12 @@ void data_timer_init(uint32_t baud_rate)
 
     // The data timer assumes a 24 MHz clock source
     htim2.Instance = TIM2;
+    symbol_clock_init_rate(&data_timer_symbol_clock, DATA_TIMER_TICKS_PER_SECOND, baud_rate);
+
     htim2.Init.Prescaler = 24 - 1; // tick every 1/1000000 s
     htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
-    htim2.Init.Period = (uint16_t) ((1000000 / baud_rate) - 1);
+    htim2.Init.Period = (uint16_t) (symbol_clock_next(&data_timer_symbol_clock,
+            clock_calibration_get_clock_error_ppb()) - 1);
     htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
     htim2.Init.RepetitionCounter = 0;
     htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
@@ -80,6 +91,9 @@ void User_TIM2_IRQHandler(TIM_HandleTypeDef *htim)
 {
     if (htim->Instance == TIM2)
     {
+        // The auto-reload register is not buffered: the new period applies to the cycle that has just started
+        __HAL_TIM_SET_AUTORELOAD(htim, symbol_clock_next(&data_timer_symbol_clock,
+                clock_calibration_get_clock_error_ppb()) - 1);
         system_handle_data_timer_tick();
     }
 }
@@ -14,4 +14,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// DMA1 channel instance and interrupt of a channel number from the DMA_CHANNEL_* assignment in config_internal.h
+#define DMA1_CHANNEL(n) DMA1_CHANNEL_INSTANCE(n)
+#define DMA1_CHANNEL_INSTANCE(n) DMA1_Channel ## n
+#define DMA1_CHANNEL_IRQN(n) DMA1_CHANNEL_INSTANCE_IRQN(n)
+#define DMA1_CHANNEL_INSTANCE_IRQN(n) DMA1_Channel ## n ## _IRQn
+
 #endif
@@ -9,10 +9,12 @@
 
 #include "hal.h"
 #include "i2c.h"
+#include "i2c_queue.h"
 #include "delay.h"
 #include "log.h"
 
 #define I2C_TIMEOUT_COUNTER 0x4FFFF
+#define I2C_TIMEOUT_MS 100
 
 I2C_HandleTypeDef hi2c;
 
@@ -93,10 +95,19 @@ void i2c_init()
     if (count == 0) {
         log_error("ERROR: I²C bus busy during initialization\n");
     }
+
+    // High priority: the STM32F1 I²C master has to handle the events of 1- and 2-byte receptions promptly (AN2824),
+    // and the handlers are short.
+    HAL_NVIC_SetPriority(I2C2_EV_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(I2C2_EV_IRQn);
+    HAL_NVIC_SetPriority(I2C2_ER_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(I2C2_ER_IRQn);
 }
 
 void i2c_uninit()
 {
+    HAL_NVIC_DisableIRQ(I2C2_EV_IRQn);
+    HAL_NVIC_DisableIRQ(I2C2_ER_IRQn);
     HAL_I2C_DeInit(&hi2c);
     __HAL_RCC_I2C2_FORCE_RESET();
     delay_ms(2);
@@ -104,15 +115,74 @@ void i2c_uninit()
 }
 
 
-int i2c_read_bytes(i2c_port *port, uint8_t address, uint8_t reg, uint8_t size, uint8_t *data)
+static void i2c_reset()
+{
+    HAL_I2C_DeInit(&hi2c);
+    HAL_I2C_Init(&hi2c);
+}
+
+/**
+ * Blocking transfers wait for a queued interrupt-driven transfer to finish first.
+ * The wait relies on the I²C interrupts, so blocking transfers must not be started from interrupt context.
+ */
+static bool i2c_wait_ready()
+{
+    uint32_t start_tick = HAL_GetTick();
+    HAL_I2C_StateTypeDef state;
+    while ((state = HAL_I2C_GetState(&hi2c)) != HAL_I2C_STATE_READY && state != HAL_I2C_STATE_RESET) {
+        if (HAL_GetTick() - start_tick >= I2C_TIMEOUT_MS) {
+            i2c_reset();
+            i2c_queue_handle_transfer_complete(HAL_TIMEOUT);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Run a blocking register read or write. Only allowed in thread mode (the main loop): from an interrupt handler,
+ * the transfer fails with HAL_ERROR without touching the bus. Use the request queue there instead.
+ * The queue is suspended meanwhile, so that interrupt handlers submitting requests do not start a transfer
+ * in the middle of this one: their requests start when it ends.
+ * A transfer the HAL rejects as busy is retried until I2C_TIMEOUT_MS, and then fails like any other error.
+ */
+static int i2c_transfer_blocking(uint8_t address, uint8_t reg, uint8_t size, uint8_t *data, bool write)
 {
-    if(HAL_I2C_Mem_Read(&hi2c, ((uint16_t)address << 1), (uint16_t)reg, 1, data, (uint16_t)size, 100) != HAL_OK)
-    {
-        HAL_I2C_DeInit(&hi2c);
-        HAL_I2C_Init(&hi2c);
+    if (__get_IPSR() != 0) {
         return HAL_ERROR;
     }
-    return HAL_OK;
+
+    i2c_queue_suspend();
+
+    uint32_t start_tick = HAL_GetTick();
+    HAL_StatusTypeDef result;
+
+    do {
+        if (!i2c_wait_ready()) {
+            i2c_queue_resume();
+            return HAL_ERROR;
+        }
+        if (write) {
+            result = HAL_I2C_Mem_Write(&hi2c, ((uint16_t)address << 1), (uint16_t)reg, 1, data, (uint16_t)size,
+                    I2C_TIMEOUT_MS);
+        } else {
+            result = HAL_I2C_Mem_Read(&hi2c, ((uint16_t)address << 1), (uint16_t)reg, 1, data, (uint16_t)size,
+                    I2C_TIMEOUT_MS);
+        }
+    } while (result == HAL_BUSY && HAL_GetTick() - start_tick < I2C_TIMEOUT_MS);
+
+    if (result != HAL_OK) {
+        i2c_reset();
+    }
+
+    i2c_queue_resume();
+
+    return result == HAL_OK ? HAL_OK : HAL_ERROR;
+}
+
+int i2c_read_bytes(i2c_port *port, uint8_t address, uint8_t reg, uint8_t size, uint8_t *data)
+{
+    return i2c_transfer_blocking(address, reg, size, data, false);
 }
 
 int i2c_read_byte(i2c_port *port, uint8_t address, uint8_t reg, uint8_t *data)
@@ -122,16 +192,59 @@ int i2c_read_byte(i2c_port *port, uint8_t address, uint8_t reg, uint8_t *data)
 
 int i2c_write_bytes(i2c_port *port, uint8_t address, uint8_t reg, uint8_t size, uint8_t *data)
 {
-    if(HAL_I2C_Mem_Write(&hi2c,  ((uint16_t)address << 1), (uint16_t)reg, 1, data, (uint16_t)size, 100) != HAL_OK)
-    {
-        HAL_I2C_DeInit(&hi2c);
-        HAL_I2C_Init(&hi2c);
-        return HAL_ERROR;
-    }
-    return HAL_OK;
+    return i2c_transfer_blocking(address, reg, size, data, true);
 }
 
 int i2c_write_byte(i2c_port *port, uint8_t address, uint8_t reg, uint8_t data)
 {
     return i2c_write_bytes(port, address, reg, 1, &data);
 }
+
+int i2c_transfer_start(i2c_request *request)
+{
+    HAL_StatusTypeDef result;
+
+    if (request->write) {
+        result = HAL_I2C_Mem_Write_IT(&hi2c, ((uint16_t) request->address << 1), (uint16_t) request->reg, 1,
+                request->data, (uint16_t) request->size);
+    } else {
+        result = HAL_I2C_Mem_Read_IT(&hi2c, ((uint16_t) request->address << 1), (uint16_t) request->reg, 1,
+                request->data, (uint16_t) request->size);
+    }
+
+    return result == HAL_OK ? HAL_OK : HAL_ERROR;
+}
+
+void i2c_transfer_abort()
+{
+    i2c_reset();
+}
+
+/**
+ * The HAL is back to ready when it calls these, so the queue starts its next transfer from here.
+ * HAL_I2C_Mem_Write_IT() and HAL_I2C_Mem_Read_IT() first wait for the stop condition to leave the bus.
+ */
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *handle)
+{
+    i2c_queue_handle_transfer_complete(HAL_OK);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *handle)
+{
+    i2c_queue_handle_transfer_complete(HAL_OK);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *handle)
+{
+    i2c_queue_handle_transfer_complete(HAL_ERROR);
+}
+
+void I2C2_EV_IRQHandler(void)
+{
+    HAL_I2C_EV_IRQHandler(&hi2c);
+}
+
+void I2C2_ER_IRQHandler(void)
+{
+    HAL_I2C_ER_IRQHandler(&hi2c);
+}
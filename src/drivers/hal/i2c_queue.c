@@ -0,0 +1,209 @@
+#include "hal.h"
+#include "i2c_queue.h"
+
+static i2c_request *i2c_queue_head = NULL;
+static i2c_request *i2c_queue_tail = NULL;
+static i2c_request *volatile i2c_queue_active = NULL;
+
+// Completed requests waiting for their callback to run from i2c_queue_poll()
+static i2c_request *i2c_queue_done_head = NULL;
+static i2c_request *i2c_queue_done_tail = NULL;
+
+static volatile uint8_t i2c_queue_suspend_count = 0;
+
+/**
+ * The queue is shared between the main loop, the interrupt handlers that submit requests and the I²C interrupt
+ * that completes them: its lists are only changed with interrupts masked.
+ */
+static inline uint32_t i2c_queue_lock()
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static inline void i2c_queue_unlock(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+static void i2c_queue_append(i2c_request **head, i2c_request **tail, i2c_request *request)
+{
+    request->next = NULL;
+    if (*tail == NULL) {
+        *head = request;
+    } else {
+        (*tail)->next = request;
+    }
+    *tail = request;
+}
+
+static i2c_request *i2c_queue_remove_first(i2c_request **head, i2c_request **tail)
+{
+    i2c_request *request = *head;
+    if (request != NULL) {
+        *head = request->next;
+        if (*head == NULL) {
+            *tail = NULL;
+        }
+        request->next = NULL;
+    }
+    return request;
+}
+
+/**
+ * End the active transfer. Requests without a callback are done at once, the others wait for i2c_queue_poll().
+ */
+static void i2c_queue_complete(i2c_request *request, int status)
+{
+    uint32_t primask = i2c_queue_lock();
+
+    if (i2c_queue_active != request || request->state != I2C_REQUEST_STATE_ACTIVE) {
+        i2c_queue_unlock(primask);
+        return;
+    }
+
+    i2c_queue_active = NULL;
+    request->status = status;
+
+    if (request->callback == NULL) {
+        request->state = I2C_REQUEST_STATE_IDLE;
+    } else {
+        request->state = I2C_REQUEST_STATE_COMPLETE;
+        i2c_queue_append(&i2c_queue_done_head, &i2c_queue_done_tail, request);
+    }
+
+    i2c_queue_unlock(primask);
+}
+
+/**
+ * Start the next queued transfer unless one is active or blocking transfers have suspended the queue.
+ * Backends may complete the transfer before returning, which starts the following one from here too.
+ */
+static void i2c_queue_start_next()
+{
+    uint32_t primask = i2c_queue_lock();
+
+    if (i2c_queue_active != NULL || i2c_queue_suspend_count > 0) {
+        i2c_queue_unlock(primask);
+        return;
+    }
+
+    i2c_request *request = i2c_queue_remove_first(&i2c_queue_head, &i2c_queue_tail);
+    if (request == NULL) {
+        i2c_queue_unlock(primask);
+        return;
+    }
+
+    request->start_tick_ms = HAL_GetTick();
+    request->state = I2C_REQUEST_STATE_ACTIVE;
+    i2c_queue_active = request;
+
+    i2c_queue_unlock(primask);
+
+    if (i2c_transfer_start(request) != HAL_OK) {
+        i2c_queue_complete(request, HAL_ERROR);
+        i2c_queue_start_next();
+    }
+}
+
+/**
+ * Append a request to the queue and start it if the bus is free. Requests are transferred one at a time
+ * in submission order. May be called from the main loop or from an interrupt handler with a lower priority
+ * than the I²C interrupts. Returns false if the request is still queued or in progress.
+ */
+bool i2c_queue_submit(i2c_request *request)
+{
+    uint32_t primask = i2c_queue_lock();
+
+    if (request->state != I2C_REQUEST_STATE_IDLE) {
+        i2c_queue_unlock(primask);
+        return false;
+    }
+
+    request->status = HAL_OK;
+    request->state = I2C_REQUEST_STATE_QUEUED;
+    i2c_queue_append(&i2c_queue_head, &i2c_queue_tail, request);
+
+    i2c_queue_unlock(primask);
+
+    i2c_queue_start_next();
+
+    return true;
+}
+
+/**
+ * Called by the bus backend, usually from the I2C interrupt, when the active transfer has ended.
+ * Starts the next queued transfer, so that requests submitted from interrupt handlers do not wait for the main loop.
+ */
+void i2c_queue_handle_transfer_complete(int status)
+{
+    i2c_request *request = i2c_queue_active;
+    if (request == NULL) {
+        return;
+    }
+
+    i2c_queue_complete(request, status);
+    i2c_queue_start_next();
+}
+
+/**
+ * Run the callbacks of completed transfers, abort a transfer that has timed out and start the next queued one.
+ * Call from the main loop.
+ */
+void i2c_queue_poll()
+{
+    uint32_t primask = i2c_queue_lock();
+    i2c_request *request = i2c_queue_active;
+    if (request != NULL && request->state == I2C_REQUEST_STATE_ACTIVE
+        && HAL_GetTick() - request->start_tick_ms >= request->timeout_ms) {
+        i2c_transfer_abort();
+        i2c_queue_complete(request, HAL_TIMEOUT);
+    }
+    i2c_queue_unlock(primask);
+
+    while (true) {
+        primask = i2c_queue_lock();
+        request = i2c_queue_remove_first(&i2c_queue_done_head, &i2c_queue_done_tail);
+        if (request != NULL) {
+            request->state = I2C_REQUEST_STATE_IDLE;
+        }
+        i2c_queue_unlock(primask);
+
+        if (request == NULL) {
+            break;
+        }
+
+        // The callback may submit the request again
+        request->callback(request);
+    }
+
+    i2c_queue_start_next();
+}
+
+bool i2c_queue_busy()
+{
+    return i2c_queue_active != NULL || i2c_queue_head != NULL || i2c_queue_done_head != NULL;
+}
+
+/**
+ * Keep the queue from starting transfers while a blocking transfer uses the bus. Requests submitted in the meantime,
+ * also from interrupt handlers, stay queued until i2c_queue_resume(). Does not wait for the active transfer.
+ */
+void i2c_queue_suspend()
+{
+    uint32_t primask = i2c_queue_lock();
+    i2c_queue_suspend_count++;
+    i2c_queue_unlock(primask);
+}
+
+void i2c_queue_resume()
+{
+    uint32_t primask = i2c_queue_lock();
+    if (i2c_queue_suspend_count > 0) {
+        i2c_queue_suspend_count--;
+    }
+    i2c_queue_unlock(primask);
+
+    i2c_queue_start_next();
+}
@@ -0,0 +1,65 @@
+#ifndef __HAL_I2C_QUEUE_H
+#define __HAL_I2C_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "i2c.h"
+
+typedef enum _i2c_request_state {
+    I2C_REQUEST_STATE_IDLE = 0,
+    I2C_REQUEST_STATE_QUEUED,
+    I2C_REQUEST_STATE_ACTIVE,
+    I2C_REQUEST_STATE_COMPLETE,
+} i2c_request_state;
+
+typedef struct _i2c_request i2c_request;
+
+typedef void (*i2c_request_callback)(i2c_request *request);
+
+/**
+ * A register read or write transaction. Requests are owned by the caller (usually static) and must stay
+ * untouched from submission until the callback has run. The callback runs from i2c_queue_poll() in the main loop,
+ * never from interrupt context, with status set to HAL_OK, HAL_ERROR or HAL_TIMEOUT.
+ * A request without a callback returns to I2C_REQUEST_STATE_IDLE as soon as its transfer ends, with the result
+ * left in status: interrupt handlers use these for writes that must not wait for the main loop.
+ */
+struct _i2c_request {
+    i2c_port *port;
+    uint8_t address;
+    uint8_t reg;
+    uint8_t size;
+    uint8_t *data;
+    bool write;
+    uint16_t timeout_ms;
+    i2c_request_callback callback;
+    void *context;
+
+    // Managed by the queue
+    volatile i2c_request_state state;
+    volatile int status;
+    uint32_t start_tick_ms;
+    i2c_request *next;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool i2c_queue_submit(i2c_request *request);
+void i2c_queue_poll();
+bool i2c_queue_busy();
+void i2c_queue_handle_transfer_complete(int status);
+void i2c_queue_suspend();
+void i2c_queue_resume();
+
+// Bus backend used by the queue, implemented in i2c.c: start the transfer without blocking and report the result
+// through i2c_queue_handle_transfer_complete(), which may also be called before i2c_transfer_start() returns.
+int i2c_transfer_start(i2c_request *request);
+void i2c_transfer_abort();
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
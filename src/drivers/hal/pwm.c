@@ -7,60 +7,19 @@
 #endif
 
 
+#include "hal.h"
 #include "pwm.h"
 #include "timers.h"
 #include "log.h"
 #include "gpio.h"
 
-#if 0
+#if PWM_TIMER_DMA_ENABLE
 uint16_t pwm_timer_dma_buffer[PWM_TIMER_DMA_BUFFER_SIZE];
 
 uint16_t (*pwm_handle_dma_transfer_half)(uint16_t buffer_size, uint16_t *buffer) = NULL;
 uint16_t (*pwm_handle_dma_transfer_full)(uint16_t buffer_size, uint16_t *buffer) = NULL;
 
-DMA_Channel_TypeDef *pwm_dma_channel = DMA1_Channel2;
-
-void pwm_data_timer_init()
-{
-    // Timer frequency = TIM_CLK/(TIM_PSC+1)/(TIM_ARR + 1)
-    // TIM_CLK =
-    // TIM_PSC = Prescaler
-    // TIM_ARR = Period
-
-    __HAL_RCC_TIM2_CLK_ENABLE();
-
-    htim2.Instance = TIM2;
-    
-    HAL_TIM_Base_DeInit(&htim2);
-
-    htim2.Init.Prescaler = 2 - 1; // tick every 1/12000000 s
-    htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
-    htim2.Init.Period = 10000 - 1; // update every 1/1200 s
-    htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-    htim2.Init.RepetitionCounter = 0;
-
-    HAL_TIM_Base_Init(&htim2);
-
-    // No interrupts necessary for data timer, as it is only used for triggering DMA transfers
-    /*
-    TIM_ClearITPendingBit(TIM2, TIM_IT_Update);
-    TIM_ITConfig(TIM2, TIM_IT_Update, ENABLE);
-
-    NVIC_InitTypeDef nvic_init;
-    nvic_init.NVIC_IRQChannel = TIM2_IRQn;
-    nvic_init.NVIC_IRQChannelPreemptionPriority = 2;
-    nvic_init.NVIC_IRQChannelSubPriority = 2;
-    nvic_init.NVIC_IRQChannelCmd = ENABLE;
-    NVIC_Init(&nvic_init);
-    */
-
-    HAL_TIM_Base_Start(&htim2);
-}
-
-void pwm_data_timer_uninit()
-{
-    HAL_TIM_Base_Stop(&htim2);
-}
+static DMA_HandleTypeDef hdma_pwm;
 #endif
 
 void pwm_timer_init(uint32_t frequency_hz_100)
@@ -227,97 +186,118 @@ inline void pwm_timer_set_frequency(uint32_t pwm_period)
     __HAL_TIM_SET_AUTORELOAD(&htim15, pwm_period);
 }
 
+#if PWM_TIMER_DMA_ENABLE
+
 /**
- * Below are experimental DMA routines for supplying PWM data for APRS modulation.
- * This does not work correctly, but is left for future reference.
+ * DMA-fed PWM: every half cycle of the TIM15 output gets its own period from pwm_timer_dma_buffer.
+ *
+ * TIM15 has no DMA channel of its own that is free (TIM15_UP shares DMA1 channel 5 with the GPS USART1 RX),
+ * so TIM15 update events are routed to TRGO and TIM2 runs in slave reset mode on that trigger (ITR1).
+ * Every reset generates a TIM2 update event, whose DMA request (DMA1 channel 2) writes the next period into
+ * the preloaded TIM15 ARR register. The DMA transfers are paced by the PWM output itself, so the periods are
+ * applied exactly one half cycle at a time and the phase of the waveform is never disturbed.
  */
 
- #if 0
-
-// static void pwm_dma_init_channel()
-// {
-//     DMA_InitTypeDef dma_init;
-//     dma_init.DMA_BufferSize = PWM_TIMER_DMA_BUFFER_SIZE;
-//     dma_init.DMA_DIR = DMA_DIR_PeripheralDST;
-//     dma_init.DMA_M2M = DMA_M2M_Disable;
-//     dma_init.DMA_MemoryBaseAddr = (uint32_t) pwm_timer_dma_buffer;
-//     dma_init.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
-//     dma_init.DMA_MemoryInc = DMA_MemoryInc_Enable;
-//     dma_init.DMA_Mode = DMA_Mode_Circular;
-//     dma_init.DMA_PeripheralBaseAddr = (uint32_t) &TIM15->ARR;
-//     dma_init.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord; // DMA_PeripheralDataSize_Word ?
-//     dma_init.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
-//     dma_init.DMA_Priority = DMA_Priority_VeryHigh;
-//     DMA_Init(pwm_dma_channel, &dma_init);
-// }
-
-// inline void pwm_dma_interrupt_enable(bool enabled)
-// {
-//     DMA_ClearITPendingBit(DMA1_IT_HT2);
-//     DMA_ClearITPendingBit(DMA1_IT_TC2);
-//     DMA_ITConfig(pwm_dma_channel, DMA_IT_HT | DMA_IT_TC | DMA_IT_TE, enabled ? ENABLE : DISABLE);
-// }
+static void pwm_dma_transfer_half(DMA_HandleTypeDef *hdma)
+{
+    if (pwm_handle_dma_transfer_half != NULL) {
+        pwm_handle_dma_transfer_half(PWM_TIMER_DMA_BUFFER_SIZE, pwm_timer_dma_buffer);
+    }
+}
+
+static void pwm_dma_transfer_full(DMA_HandleTypeDef *hdma)
+{
+    if (pwm_handle_dma_transfer_full != NULL) {
+        pwm_handle_dma_transfer_full(PWM_TIMER_DMA_BUFFER_SIZE, pwm_timer_dma_buffer);
+    }
+}
 
 void pwm_dma_init()
 {
-//     DMA_DeInit(pwm_dma_channel);
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma_pwm.Instance = DMA1_CHANNEL(DMA_CHANNEL_PWM_TIMER);
+    hdma_pwm.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_pwm.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_pwm.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_pwm.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_pwm.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_pwm.Init.Mode = DMA_CIRCULAR;
+    hdma_pwm.Init.Priority = DMA_PRIORITY_VERY_HIGH;
+    hang_if_bad("HAL_DMA_Init",
+                HAL_DMA_Init(&hdma_pwm)
+               );
 
-//     RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+    hdma_pwm.XferHalfCpltCallback = pwm_dma_transfer_half;
+    hdma_pwm.XferCpltCallback = pwm_dma_transfer_full;
+
+    // Refilling the buffer must not wait for the TIM6 scheduler tick
+    HAL_NVIC_SetPriority(DMA1_CHANNEL_IRQN(DMA_CHANNEL_PWM_TIMER), 1, 0);
+    HAL_NVIC_EnableIRQ(DMA1_CHANNEL_IRQN(DMA_CHANNEL_PWM_TIMER));
+}
+
+void pwm_dma_start()
+{
+    TIM_MasterConfigTypeDef master_config = {0};
+    master_config.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    master_config.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    hang_if_bad("HAL_TIMEx_MasterConfigSynchronization",
+                HAL_TIMEx_MasterConfigSynchronization(&htim15, &master_config)
+               );
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+
+    htim2.Instance = TIM2;
+    HAL_TIM_Base_DeInit(&htim2);
 
-//     pwm_dma_init_channel();
+    // Free-running between resets: the counter never wraps within a half cycle
+    htim2.Init.Prescaler = 0;
+    htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim2.Init.Period = 0xFFFF;
+    htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim2.Init.RepetitionCounter = 0;
+    htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    hang_if_bad("HAL_TIM_Base_Init",
+                HAL_TIM_Base_Init(&htim2)
+               );
 
-//     pwm_dma_interrupt_enable(true);
+    TIM_SlaveConfigTypeDef slave_config = {0};
+    slave_config.SlaveMode = TIM_SLAVEMODE_RESET;
+    slave_config.InputTrigger = TIM_TS_ITR1; // TIM15 TRGO on STM32F100
+    hang_if_bad("HAL_TIM_SlaveConfigSynchro",
+                HAL_TIM_SlaveConfigSynchro(&htim2, &slave_config)
+               );
 
-//     DMA_Cmd(pwm_dma_channel, ENABLE);
+    hang_if_bad("HAL_DMA_Start_IT",
+                HAL_DMA_Start_IT(&hdma_pwm, (uint32_t) pwm_timer_dma_buffer, (uint32_t) &htim15.Instance->ARR,
+                        PWM_TIMER_DMA_BUFFER_SIZE)
+               );
 
-//     NVIC_InitTypeDef nvic_init;
-//     nvic_init.NVIC_IRQChannel = DMA1_Channel2_IRQn;
-//     nvic_init.NVIC_IRQChannelPreemptionPriority = 2;
-//     nvic_init.NVIC_IRQChannelSubPriority = 0;
-//     nvic_init.NVIC_IRQChannelCmd = ENABLE;
-//     NVIC_Init(&nvic_init);
+    __HAL_TIM_ENABLE_DMA(&htim2, TIM_DMA_UPDATE);
+    __HAL_TIM_ENABLE(&htim2);
 }
 
-void pwm_dma_start()
+void pwm_dma_stop()
 {
-//     //pwm_dma_init_channel();
-//     //pwm_dma_interrupt_enable(true);
-//     // TODO: Why doesn't timer DMA request restart without reinitializing the timer?
-//     pwm_timer_init(100 * 100);
-//     pwm_timer_pwm_enable(true);
-//     pwm_timer_use(true);
-//     DMA_SetCurrDataCounter(pwm_dma_channel, PWM_TIMER_DMA_BUFFER_SIZE);
-//     DMA_Cmd(pwm_dma_channel, ENABLE);
-//     pwm_data_timer_dma_request_enable(true);
+    __HAL_TIM_DISABLE_DMA(&htim2, TIM_DMA_UPDATE);
+    __HAL_TIM_DISABLE(&htim2);
+
+    // Not running if the transfer was already stopped
+    HAL_DMA_Abort(&hdma_pwm);
+
+    // Leave TIM2 in reset state for data_timer_init()
+    __HAL_RCC_TIM2_FORCE_RESET();
+    __HAL_RCC_TIM2_RELEASE_RESET();
+
+    TIM_MasterConfigTypeDef master_config = {0};
+    master_config.MasterOutputTrigger = TIM_TRGO_RESET;
+    master_config.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    HAL_TIMEx_MasterConfigSynchronization(&htim15, &master_config);
 }
 
-void pwm_dma_stop()
+void DMA1_Channel2_IRQHandler(void)
 {
-//     pwm_data_timer_dma_request_enable(false);
-//     DMA_Cmd(pwm_dma_channel, DISABLE);
-//     //pwm_dma_interrupt_enable(false);
+    HAL_DMA_IRQHandler(&hdma_pwm);
 }
 
-// void pwm_data_timer_dma_request_enable(bool enabled)
-// {
-//     // TIM2 Update DMA requests are routed to DMA1 Channel2
-//     TIM_DMACmd(TIM2, TIM_DMA_Update, enabled ? ENABLE : DISABLE);
-// }
-
-// void DMA1_Channel2_IRQHandler(void)
-// {
-//     if (DMA_GetITStatus(DMA1_IT_TE2)) {
-//         DMA_ClearITPendingBit(DMA1_IT_TE2);
-//         log_info("DMA Transfer Error\n");
-//     }
-//     if (DMA_GetITStatus(DMA1_IT_HT2)) {
-//         DMA_ClearITPendingBit(DMA1_IT_HT2);
-//         pwm_handle_dma_transfer_half(PWM_TIMER_DMA_BUFFER_SIZE, pwm_timer_dma_buffer);
-//     }
-//     if (DMA_GetITStatus(DMA1_IT_TC2)) {
-//         DMA_ClearITPendingBit(DMA1_IT_TC2);
-//         pwm_handle_dma_transfer_full(PWM_TIMER_DMA_BUFFER_SIZE, pwm_timer_dma_buffer);
-//     }
-// }
-
-#endif
\ No newline at end of file
+#endif
@@ -3,8 +3,15 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 
-#define PWM_TIMER_DMA_BUFFER_SIZE 256
+#include "config.h"
+
+// PWM timer tick rate, see pwm_timer_init()
+#define PWM_TIMER_CLOCK_HZ 1000000
+
+// Half cycles of the PWM output per DMA buffer, refilled half at a time
+#define PWM_TIMER_DMA_BUFFER_SIZE 128
 
 
 void pwm_timer_init(uint32_t frequency_hz_100);
@@ -14,14 +21,10 @@ void pwm_timer_uninit();
 uint16_t pwm_calculate_period(uint32_t frequency_hz_100);
 void pwm_timer_set_frequency(uint32_t frequency_hz_100);
 
-#if 0
-void pwm_data_timer_init();
-void pwm_data_timer_dma_request_enable(bool enabled);
-void pwm_data_timer_uninit();
+#if PWM_TIMER_DMA_ENABLE
 extern uint16_t pwm_timer_dma_buffer[PWM_TIMER_DMA_BUFFER_SIZE];
 
 void pwm_dma_init();
-void pwm_dma_interrupt_enable(bool enabled);
 void pwm_dma_start();
 void pwm_dma_stop();
 
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "config.h"
 
 #ifdef RS41_RSM4x4
@@ -7,12 +9,55 @@
 #endif
 
 
+#include "hal.h"
 #include "spi.h"
 #include "gpio.h"
 #include "log.h"
 
 SPI_HandleTypeDef hspi;
 
+#if SPI_DMA_ENABLE
+/**
+ * Write-only bursts are fed to the SPI data register by DMA instead of one HAL_SPI_Transmit() call per byte.
+ * The transfer is polled for completion, as the caller must not release the chip select before the last byte
+ * has been shifted out. Only enabled on DFM17, where SPI1_TX has DMA1 channel 3 to itself.
+ */
+static DMA_HandleTypeDef hdma_spi_tx;
+
+static void spi_dma_init()
+{
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma_spi_tx.Instance = DMA1_CHANNEL(DMA_CHANNEL_SPI_TX);
+    hdma_spi_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_spi_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi_tx.Init.Mode = DMA_NORMAL;
+    hdma_spi_tx.Init.Priority = DMA_PRIORITY_HIGH;
+    hang_if_bad("HAL_DMA_Init",
+                HAL_DMA_Init(&hdma_spi_tx)
+               );
+}
+
+static void spi_dma_transmit(const uint8_t *data, uint16_t length)
+{
+    __HAL_SPI_ENABLE(&hspi);
+
+    if (HAL_DMA_Start(&hdma_spi_tx, (uint32_t) data, (uint32_t) &hspi.Instance->DR, length) != HAL_OK) {
+        HAL_SPI_Transmit(&hspi, (uint8_t *) data, length, 100);
+        return;
+    }
+
+    SET_BIT(hspi.Instance->CR2, SPI_CR2_TXDMAEN);
+    if (HAL_DMA_PollForTransfer(&hdma_spi_tx, HAL_DMA_FULL_TRANSFER, 100) != HAL_OK) {
+        HAL_DMA_Abort(&hdma_spi_tx);
+    }
+    CLEAR_BIT(hspi.Instance->CR2, SPI_CR2_TXDMAEN);
+}
+#endif
+
 void spi_init()
 {
     GPIO_InitTypeDef gpio_init;
@@ -92,10 +137,17 @@ void spi_init()
     hang_if_bad("HAL_SPI_Init",
               HAL_SPI_Init(&hspi) 
                );
+
+#if SPI_DMA_ENABLE
+    spi_dma_init();
+#endif
 }
 
 void spi_uninit()
 {
+#if SPI_DMA_ENABLE
+    HAL_DMA_DeInit(&hdma_spi_tx);
+#endif
     HAL_SPI_DeInit(&hspi);
 
 #ifdef RS41
@@ -176,3 +228,65 @@ uint8_t spi_send_and_receive(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, uint16_t da
 
     return rx[1];
 }
+
+static void spi_transfer_segment(const spi_segment *segment)
+{
+    if (segment->length == 0) {
+        return;
+    }
+
+    if (segment->rx == NULL) {
+#if SPI_DMA_ENABLE
+        if (segment->length >= SPI_DMA_TRANSFER_LENGTH_MIN) {
+            spi_dma_transmit(segment->tx, segment->length);
+        } else {
+            HAL_SPI_Transmit(&hspi, (uint8_t *) segment->tx, segment->length, 100);
+        }
+#else
+        HAL_SPI_Transmit(&hspi, (uint8_t *) segment->tx, segment->length, 100);
+#endif
+        // Wait for the last byte to be shifted out before the next segment or the chip select release
+        while (__HAL_SPI_GET_FLAG(&hspi, SPI_FLAG_TXE) == RESET);
+        while (__HAL_SPI_GET_FLAG(&hspi, SPI_FLAG_BSY) == SET);
+
+        // Clear overrun flag caused by full-duplex transmit discarding received data
+        __HAL_SPI_CLEAR_OVRFLAG(&hspi);
+        return;
+    }
+
+    while (__HAL_SPI_GET_FLAG(&hspi, SPI_FLAG_BSY) == SET);
+
+    if (segment->tx == NULL) {
+        // Dummy bytes: the transmit pointer stays ahead of the receive pointer, so the buffer can be shared
+        memset(segment->rx, 0xFF, segment->length);
+        HAL_SPI_TransmitReceive(&hspi, segment->rx, segment->rx, segment->length, 100);
+    } else {
+        HAL_SPI_TransmitReceive(&hspi, (uint8_t *) segment->tx, segment->rx, segment->length, 100);
+    }
+}
+
+void spi_transfer_segments(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, const spi_segment *segments, uint8_t count)
+{
+    if (gpio_cs != NULL) {
+        HAL_GPIO_WritePin(gpio_cs, pin_cs, GPIO_PIN_RESET);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        spi_transfer_segment(&segments[i]);
+    }
+
+    if (gpio_cs != NULL) {
+        HAL_GPIO_WritePin(gpio_cs, pin_cs, GPIO_PIN_SET);
+    }
+}
+
+void spi_transfer(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, const uint8_t *tx, uint8_t *rx, uint16_t length)
+{
+    spi_segment segment = {
+            .tx = tx,
+            .rx = rx,
+            .length = length,
+    };
+
+    spi_transfer_segments(gpio_cs, pin_cs, &segment, 1);
+}
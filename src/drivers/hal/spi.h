@@ -7,6 +7,15 @@
 
 #include "gpio.h"
 
+/**
+ * One part of a burst transfer: tx may be NULL to clock out 0xFF, rx may be NULL to discard the received bytes.
+ */
+typedef struct _spi_segment {
+    const uint8_t *tx;
+    uint8_t *rx;
+    uint16_t length;
+} spi_segment;
+
 void spi_init();
 
 void spi_uninit();
@@ -21,4 +30,12 @@ void spi_set_chip_select(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, bool select);
 
 uint8_t spi_send_and_receive(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, uint16_t data);
 
+/**
+ * Transfer the segments back to back within a single chip select frame.
+ * With gpio_cs NULL, the chip select is left to the caller.
+ */
+void spi_transfer_segments(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, const spi_segment *segments, uint8_t count);
+
+void spi_transfer(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, const uint8_t *tx, uint8_t *rx, uint16_t length);
+
 #endif
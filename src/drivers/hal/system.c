@@ -15,7 +15,7 @@
 #include "log.h"
 #include "gpio.h"
 
-#define BUTTON_PRESS_LONG_COUNT 1000  // SysTick runs at 1 kHz, so 1000 = 1 second hold
+#define BUTTON_PRESS_LONG_COUNT 1000  // Milliseconds, so 1000 = 1 second hold
 
 #define ADC1_DR_Address ((uint32_t) 0x4001244C)
 
@@ -26,6 +26,15 @@ volatile uint32_t button_pressed = 0;
 static volatile uint16_t button_pressed_threshold = 0;
 
 void (*system_handle_timer_tick)() = NULL;
+static volatile uint16_t scheduler_tick_step = 1;
+// Ticks of a timer period cut short by a step change, covered by the next interrupt
+static volatile uint16_t scheduler_tick_carry = 0;
+// Ticks covered by the running scheduler timer interrupt
+static volatile uint16_t scheduler_interrupt_ticks = 1;
+// Ticks covered by all scheduler timer interrupts, the time base for the SysTick correction after an idle sleep
+static volatile uint32_t scheduler_ticks_total = 0;
+// Ticks slept with SysTick suspended that do not make up a full millisecond yet
+static uint32_t idle_sleep_tick_remainder = 0;
 
 static volatile uint32_t systick_counter = 0;
 
@@ -254,7 +263,7 @@ static void dma_adc_init()
 
     __HAL_RCC_DMA1_CLK_ENABLE();
 
-    hdma_adc1.Instance = DMA1_Channel1;
+    hdma_adc1.Instance = DMA1_CHANNEL(DMA_CHANNEL_ADC);
 #ifdef RS41_RSM4x4
     hdma_adc1.Init.Request = DMA_REQUEST_0;  // L4 requires DMA request source
 #endif
@@ -444,7 +453,9 @@ void system_handle_button()
     }
 
     if (current_value > (uint16_t)(button_pressed_threshold * 11U / 10U)) {
-        button_pressed++;
+        // Called once per millisecond, or once per interrupt while an idle sleep stretches the timer period
+        uint16_t pressed_ms = scheduler_interrupt_ticks / (SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND / 1000);
+        button_pressed += pressed_ms > 0 ? pressed_ms : 1;
         set_red_led(true);
         if (button_pressed >= BUTTON_PRESS_LONG_COUNT) {
             shutdown = true;
@@ -526,6 +537,90 @@ void system_enable_tick()
     HAL_NVIC_EnableIRQ(TIM6_IRQn);
 }
 
+/**
+ * Make each scheduler timer interrupt cover the given number of ticks, so that the timer wakes up the CPU
+ * less often while nothing needs the full tick resolution. The period restarts now: the ticks that have passed
+ * in the current one are added to the next interrupt.
+ */
+void system_set_tick_step(uint16_t step)
+{
+    if (step == 0 || step == scheduler_tick_step) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t elapsed_ticks = __HAL_TIM_GET_COUNTER(&htim6) / 100U;
+    if (__HAL_TIM_GET_FLAG(&htim6, TIM_FLAG_UPDATE)) {
+        // The period has ended, but its interrupt has not run yet
+        elapsed_ticks = scheduler_tick_step + __HAL_TIM_GET_COUNTER(&htim6) / 100U;
+    }
+    scheduler_tick_carry += elapsed_ticks;
+
+    scheduler_tick_step = step;
+    __HAL_TIM_SET_AUTORELOAD(&htim6, 100U * step - 1U);
+    __HAL_TIM_SET_COUNTER(&htim6, 0);
+    __HAL_TIM_CLEAR_FLAG(&htim6, TIM_FLAG_UPDATE);
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Number of ticks covered by the running scheduler timer interrupt: the tick step, plus the rest of a period
+ * cut short by a step change.
+ */
+uint16_t system_get_tick_step()
+{
+    return scheduler_interrupt_ticks;
+}
+
+/**
+ * Scheduler ticks since start-up, including the running timer period.
+ */
+static uint32_t system_get_scheduler_ticks()
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t ticks = scheduler_ticks_total + scheduler_tick_carry + __HAL_TIM_GET_COUNTER(&htim6) / 100U;
+    if (__HAL_TIM_GET_FLAG(&htim6, TIM_FLAG_UPDATE)) {
+        ticks = scheduler_ticks_total + scheduler_tick_carry + scheduler_tick_step
+                + __HAL_TIM_GET_COUNTER(&htim6) / 100U;
+    }
+
+    __set_PRIMASK(primask);
+
+    return ticks;
+}
+
+/**
+ * Sleep until the next interrupt, for the given number of scheduler ticks at most: the scheduler timer period
+ * is set to end at that deadline, so that only a single timer interrupt wakes up the CPU. SysTick is suspended
+ * while sleeping, and the system tick is advanced afterwards by the time measured with the scheduler timer.
+ * The timer period stays at the given ticks until the tick step is changed.
+ */
+void system_idle_sleep(uint16_t ticks)
+{
+    system_set_tick_step(ticks);
+
+    uint32_t start_ticks = system_get_scheduler_ticks();
+
+    HAL_SuspendTick();
+    __WFI();
+    HAL_ResumeTick();
+
+    uint32_t slept_ticks = system_get_scheduler_ticks() - start_ticks + idle_sleep_tick_remainder;
+    uint32_t ticks_per_ms = SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND / 1000;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uwTick += slept_ticks / ticks_per_ms;
+    __set_PRIMASK(primask);
+
+    idle_sleep_tick_remainder = slept_ticks % ticks_per_ms;
+}
+
 void system_set_green_led(bool enabled)
 {
 #ifdef RS41
@@ -653,6 +748,10 @@ extern void TIM6_IRQHandler()
 
 void User_TIM6_IRQHandler(TIM_HandleTypeDef *htim)
 {
+    scheduler_interrupt_ticks = scheduler_tick_step + scheduler_tick_carry;
+    scheduler_tick_carry = 0;
+    scheduler_ticks_total += scheduler_interrupt_ticks;
+
     if (system_handle_timer_tick != NULL) {
         system_handle_timer_tick();
     }
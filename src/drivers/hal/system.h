@@ -12,12 +12,18 @@
 
 
 #define SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND 10000
+// Longest idle sleep in scheduler ticks (50 ms): the scheduler timer drains the GPS UART DMA ring,
+// which fills up in 66 ms at 38400 baud, and samples the button
+#define SYSTEM_SCHEDULER_IDLE_MAX_TICKS 500
 
 void system_init();
 void system_shutdown();
 uint32_t system_get_tick();
 void system_disable_tick();
 void system_enable_tick();
+void system_set_tick_step(uint16_t step);
+uint16_t system_get_tick_step();
+void system_idle_sleep(uint16_t ticks);
 void system_disable_irq();
 void system_enable_irq();
 void system_set_green_led(bool enabled);
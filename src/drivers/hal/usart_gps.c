@@ -8,6 +8,7 @@
 #include <stm32f1xx_hal.h>
 #endif
 
+#include "hal.h"
 #include "usart_gps.h"
 #include "gpio.h"
 #include "log.h"
@@ -34,16 +35,10 @@
  * STM32F1: fixed mapping — USART1_RX = DMA1_Ch5, USART2_RX = DMA1_Ch6
  * STM32L4: any channel via CSELR mux — we use DMA1_Ch5 with request 2 (USART1_RX)
  */
-#if defined(DFM17)
-#define GPS_DMA_CHANNEL     DMA1_Channel6
-#define GPS_DMA_IRQn        DMA1_Channel6_IRQn
-#elif defined(RS41_RSM4x4)
-#define GPS_DMA_CHANNEL     DMA1_Channel5
-#define GPS_DMA_IRQn        DMA1_Channel5_IRQn
+#define GPS_DMA_CHANNEL     DMA1_CHANNEL(DMA_CHANNEL_GPS_USART_RX)
+#define GPS_DMA_IRQn        DMA1_CHANNEL_IRQN(DMA_CHANNEL_GPS_USART_RX)
+#if defined(RS41_RSM4x4)
 #define GPS_DMA_REQUEST     2   /* USART1_RX on STM32L412 CSELR */
-#else  /* RS41_RSM4x2 */
-#define GPS_DMA_CHANNEL     DMA1_Channel5
-#define GPS_DMA_IRQn        DMA1_Channel5_IRQn
 #endif
 
 #define GPS_DMA_BUF_SIZE    256
@@ -57,7 +52,8 @@ volatile uint32_t drain_byte_calls = 0;
 volatile uint32_t reset_gps_parse = 0;
 
 
-void (*usart_gps_handle_incoming_byte)(uint8_t data, uint8_t reset) = NULL;
+void (*usart_gps_handle_incoming_data)(const uint8_t *ring, uint16_t ring_size, uint16_t start, uint16_t end,
+        uint8_t reset) = NULL;
 
 UART_HandleTypeDef gps_usart;
 
@@ -211,16 +207,17 @@ void usart_gps_drain_dma(void)
 #endif
 
     uint16_t wr_pos = GPS_DMA_BUF_SIZE - __HAL_DMA_GET_COUNTER(&hdma_usart_rx);
+    if (wr_pos == GPS_DMA_BUF_SIZE) {
+        wr_pos = 0;
+    }
 
-    while (dma_rd_pos != wr_pos) {
-        uint8_t byte = dma_rx_buf[dma_rd_pos];
-        dma_rd_pos = (dma_rd_pos + 1) % GPS_DMA_BUF_SIZE;
-        if (usart_gps_handle_incoming_byte) {
-            drain_byte_calls++;
-            usart_gps_handle_incoming_byte(byte,reset_gps_parse);
-        }
+    /* The parser gets the whole received range at once and parses it in place */
+    if (usart_gps_handle_incoming_data && dma_rd_pos != wr_pos) {
+        drain_byte_calls += (wr_pos + GPS_DMA_BUF_SIZE - dma_rd_pos) % GPS_DMA_BUF_SIZE;
+        usart_gps_handle_incoming_data(dma_rx_buf, GPS_DMA_BUF_SIZE, dma_rd_pos, wr_pos, reset_gps_parse);
         reset_gps_parse = 0;	// We're processing bytes.  Clear the parse reset until/unless something bad happens.
     }
+    dma_rd_pos = wr_pos;
 
     draining = false;
 }
@@ -12,7 +12,8 @@ void usart_gps_send_byte(uint8_t data);
 void usart_gps_send_break(void);
 void usart_gps_drain_dma(void);
 
-extern void (*usart_gps_handle_incoming_byte)(uint8_t data, uint8_t reset);
+extern void (*usart_gps_handle_incoming_data)(const uint8_t *ring, uint16_t ring_size, uint16_t start, uint16_t end,
+        uint8_t reset);
 extern volatile uint32_t gps_ints;
 extern volatile uint32_t drain_interrupted;
 extern volatile uint32_t drain_not_enabled;
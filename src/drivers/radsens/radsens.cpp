@@ -60,7 +60,7 @@ float RadSens::getRadIntensityDynamic()
     if (!i2c_read(RS_REG_RAD_INTENSITY_DYNAMIC, res, 3)) {
         return -1;
     }
-    return (((uint32_t) res[0] << 16) | ((uint16_t) res[1] << 8) | res[2]) / 10.0;
+    return toRadIntensity(res);
 }
 
 /**
@@ -74,7 +74,7 @@ float RadSens::getRadIntensityStatic()
     if (!i2c_read(RS_REG_RAD_INTENSITY_STATIC, res, 3)) {
         return -1;
     }
-    return (((uint32_t) res[0] << 16) | ((uint16_t) res[1] << 8) | res[2]) / 10.0;
+    return toRadIntensity(res);
 }
 
 bool RadSens::updatePulses()
@@ -83,10 +83,34 @@ bool RadSens::updatePulses()
     if (!i2c_read(RS_REG_PULSE_COUNTER, res, 2)) {
         return false;
     }
-    _pulse_count += (res[0] << 8) | res[1];
+    addPulses(res);
     return true;
 }
 
+/**
+ * Accumulate the pulse counter register contents, for reads done through the I2C request queue.
+ */
+void RadSens::addPulses(const uint8_t *res)
+{
+    _pulse_count += (res[0] << 8) | res[1];
+}
+
+/**
+ * Convert the contents of a 24-bit radiation intensity register.
+ */
+float RadSens::toRadIntensity(const uint8_t *res)
+{
+    return (((uint32_t) res[0] << 16) | ((uint16_t) res[1] << 8) | res[2]) / 10.0;
+}
+
+/**
+ * Get the accumulated number of pulses without reading the sensor.
+ */
+uint32_t RadSens::getAccumulatedPulses()
+{
+    return _pulse_count;
+}
+
 /**
  * Get the accumulated number of pulses registered by the module since the last I2C data reading.
  */
@@ -98,6 +98,9 @@ public:
     bool setHVGeneratorState(bool state);
     bool setSensitivity(uint16_t sens);
     bool setLedState(bool state);
+    void addPulses(const uint8_t *res);
+    uint32_t getAccumulatedPulses();
+    static float toRadIntensity(const uint8_t *res);
 };
 
 #endif
@@ -48,12 +48,22 @@ void si4032_disable_tx()
     si4032_write(0x07, 0x00);
 }
 
+// Burst write: the register address auto-increments after each byte, except for the FIFO (0x7F)
+static void si4032_write_burst(uint8_t reg, const uint8_t *data, uint8_t length)
+{
+    uint8_t address = reg | SPI_WRITE_FLAG;
+    spi_segment segments[] = {
+            {.tx = &address, .rx = NULL, .length = 1},
+            {.tx = data, .rx = NULL, .length = length},
+    };
+
+    spi_transfer_segments(BANK_NSEL, PIN_NSEL, segments, 2);
+}
+
 // Returns number of bytes sent from *data
 // If less than len, remaining bytes will need to be used to top up the buffer
 uint16_t si4032_start_tx(uint8_t *data, int len)
 {
-    const uint8_t buffer_size = 64;
-
     // No TX header
     // Fixed packet length (don't transmit length)
     si4032_write(0x33, 0b00001000);
@@ -63,10 +73,10 @@ uint16_t si4032_start_tx(uint8_t *data, int len)
     si4032_write(0x08, 0);
 
     // set almost full threshold to buffer_size
-    si4032_write(0x7C, buffer_size);
+    si4032_write(0x7C, SI4032_FIFO_SIZE);
 
     // set almost empty threshold
-    si4032_write(0x7D, 16);
+    si4032_write(0x7D, SI4032_FIFO_ALMOST_EMPTY_THRESHOLD);
 
     // enable interrupts
     si4032_write(0x05, 0b11100100);
@@ -77,17 +87,15 @@ uint16_t si4032_start_tx(uint8_t *data, int len)
     // disable packet handler - just transmit whatever's in the FIFO
     si4032_write(0x30, 0x00);
 
-    // Set packet length (max 255 bytes)
+    // Set packet length, the caller must not pass more than SI4032_PACKET_LENGTH_MAX bytes
     si4032_write(0x3E, len);
 
     // Fill our FIFO
     int fifo_len = len;
-    if (fifo_len > buffer_size) {
-        fifo_len = buffer_size;
-    }
-    for (int i = 0; i < fifo_len; i++) {
-        si4032_write(0x7F, data[i]);
+    if (fifo_len > SI4032_FIFO_SIZE) {
+        fifo_len = SI4032_FIFO_SIZE;
     }
+    si4032_write_burst(0x7F, data, fifo_len);
 
     // Start transmitting
     si4032_write(0x07, 0x09);
@@ -95,29 +103,35 @@ uint16_t si4032_start_tx(uint8_t *data, int len)
     return fifo_len;
 }
 
+uint8_t si4032_read_interrupt_status()
+{
+    // Reading the status also clears the latched interrupt flags
+    return si4032_read(0x03);
+}
+
 // Add additional bytes to the si4032's FIFO buffer
 // Needed for large packets that don't fit in its buffer.
-// Keep refilling it while transmitting
-// Returns number of bytes taken from *data
+// Call only after the TX FIFO almost empty interrupt is seen, so that the FIFO has room for the whole burst.
+// Does not block, returns number of bytes taken from *data
 // If less than len, you will need to keep calling this
-uint16_t si4032_refill_buffer(uint8_t *data, int len, bool *overflow)
+// The interrupt status read after the burst is stored in *status, as reading it clears the latched flags
+uint16_t si4032_refill_buffer(uint8_t *data, int len, uint8_t *status)
 {
-    uint8_t interrupts;
-    int i = 0;
+    *status = 0;
 
-    while (i < len) {
-        do {
-            si4032_write(0x7F, data[i]);
-            i++;
-            delay_us(10);
+    if (len > SI4032_FIFO_SIZE - SI4032_FIFO_ALMOST_EMPTY_THRESHOLD) {
+        len = SI4032_FIFO_SIZE - SI4032_FIFO_ALMOST_EMPTY_THRESHOLD;
+    }
+    if (len <= 0) {
+        return 0;
+    }
 
-            interrupts = si4032_read(0x03);
-        } while ((interrupts & 0x20) && i < len);
+    si4032_write_burst(0x7F, data, len);
 
-        delay_us(500);
-    }
+    // The almost empty flag latched while the FIFO was draining, clear it so that it reflects the new level
+    *status = si4032_read(0x03);
 
-    return i;
+    return len;
 }
 
 int si4032_wait_for_tx_complete(int timeout_ms)
@@ -126,7 +140,7 @@ int si4032_wait_for_tx_complete(int timeout_ms)
         uint8_t status = si4032_read(0x03);
 
         // ipksent is set
-        if (status & 0x04) {
+        if (status & SI4032_INTERRUPT_PACKET_SENT) {
             return HAL_OK;
         }
 
@@ -155,9 +169,12 @@ void si4032_set_tx_frequency(const float frequency_mhz)
 #ifdef RADIO_LOGGING_ENABLE
     log_info("Setting tx frequency to %ld\n", (uint32_t) (1000000 * frequency_mhz));
 #endif
-    si4032_write(0x75, (uint8_t) (0b01000000 | (fb & 0b11111) | ((hbsel & 0b1) << 5)));
-    si4032_write(0x76, (uint8_t) (((uint16_t) fc >> 8U) & 0xffU));
-    si4032_write(0x77, (uint8_t) ((uint16_t) fc & 0xff));
+    uint8_t data[] = {
+            (uint8_t) (0b01000000 | (fb & 0b11111) | ((hbsel & 0b1) << 5)), // 0x75
+            (uint8_t) (((uint16_t) fc >> 8U) & 0xffU), // 0x76
+            (uint8_t) ((uint16_t) fc & 0xff), // 0x77
+    };
+    si4032_write_burst(0x75, data, sizeof(data));
 }
 
 void si4032_set_data_rate(const uint32_t rate_bps)
@@ -169,9 +186,12 @@ void si4032_set_data_rate(const uint32_t rate_bps)
     log_info("Rate (raw): %lu\n", rate);
 #endif
 
-    si4032_write(0x6E, rate >> 8);
-    si4032_write(0x6F, rate & 0xFF);
-    si4032_write(0x70, 0b00100000);
+    uint8_t data[] = {
+            rate >> 8, // 0x6E
+            rate & 0xFF, // 0x6F
+            0b00100000, // 0x70
+    };
+    si4032_write_burst(0x6E, data, sizeof(data));
 }
 
 void si4032_set_tx_power(uint8_t power)
@@ -185,8 +205,11 @@ void si4032_set_tx_power(uint8_t power)
  */
 void si4032_set_frequency_offset(uint16_t offset)
 {
-    si4032_write(0x73, offset);
-    si4032_write(0x74, 0);
+    uint8_t data[] = {
+            offset, // 0x73
+            0, // 0x74
+    };
+    si4032_write_burst(0x73, data, sizeof(data));
 }
 
 inline void si4032_set_frequency_offset_small(uint8_t offset)
@@ -4,6 +4,16 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#define SI4032_FIFO_SIZE 64
+#define SI4032_FIFO_ALMOST_EMPTY_THRESHOLD 16
+// The packet length register 0x3E is 8 bits wide
+#define SI4032_PACKET_LENGTH_MAX 255
+
+// Interrupt status 1 (register 0x03) flags
+#define SI4032_INTERRUPT_FIFO_ERROR 0x80
+#define SI4032_INTERRUPT_TX_FIFO_ALMOST_EMPTY 0x20
+#define SI4032_INTERRUPT_PACKET_SENT 0x04
+
 typedef enum _si4032_modulation_type {
     SI4032_MODULATION_TYPE_NONE = 0,
     SI4032_MODULATION_TYPE_OOK,
@@ -16,7 +26,8 @@ void si4032_enable_tx();
 void si4032_inhibit_tx();
 void si4032_disable_tx();
 uint16_t si4032_start_tx(uint8_t *data, int len);
-uint16_t si4032_refill_buffer(uint8_t *data, int len, bool *overflow);
+uint16_t si4032_refill_buffer(uint8_t *data, int len, uint8_t *status);
+uint8_t si4032_read_interrupt_status();
 int si4032_wait_for_tx_complete(int timeout_ms);
 void si4032_use_direct_mode(bool use);
 void si4032_set_tx_frequency(float frequency_mhz);
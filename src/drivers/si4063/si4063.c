@@ -6,6 +6,7 @@
  */
 
 #include <stdbool.h>
+#include <string.h>
 
 #include "config.h"
 #ifndef RS41_RSM4x4
@@ -25,6 +26,9 @@
 
 #define SI4063_CLOCK 25600000UL
 
+// Each poll takes two SPI bytes, about 20 us at 750 kHz SPI clock
+#define SI4063_CTS_POLL_COUNT_MAX 5000
+
 #define SI4063_COMMAND_PART_INFO    0x01
 #define SI4063_COMMAND_POWER_UP     0x02
 #define SI4063_COMMAND_SET_PROPERTY 0x11
@@ -86,63 +90,79 @@ uint8_t si4063_filter_6db_1200_4400[9] = {0x81, 0x9f, 0xc4, 0xee, 0x18, 0x3e, 0x
 uint32_t current_frequency_hz = 434000000UL;
 uint32_t current_deviation_hz = 0;
 
+static si4063_command_trace si4063_trace = {0};
+
 static inline void si4063_set_chip_select(bool select)
 {
     spi_set_chip_select(BANK_NSEL, PIN_NSEL, select);
 
-    // Output enable time, 20ns
-    for (uint32_t i = 0; i < 0xFFFF; i++);
-}
-
-static int si4063_wait_for_cts()
-{
-    uint16_t timeout = 0xFFFF;
-    uint8_t response;
-
-    // Poll CTS over SPI
-    do
-    {
-        si4063_set_chip_select(true);
-        spi_send(SI4063_COMMAND_READ_CMD_BUFF);
-        response = spi_read();
-        si4063_set_chip_select(false);
-    } while (response != 0xFF && timeout--);
-
-    if (timeout == 0) {
-        log_error("ERROR: Si4063 timeout\n");
+    // NSEL setup time (20 ns) and hold time are already covered by the GPIO write and by spi_send()
+    // waiting for the SPI peripheral to go idle. Keep NSEL high for at least 80 ns between frames.
+    if (!select) {
+        __NOP();
+        __NOP();
+        __NOP();
     }
-
-    return timeout > 0 ? HAL_OK : HAL_ERROR;
 }
 
-static int si4063_read_response(uint8_t length, uint8_t *data)
+/**
+ * Poll CTS over SPI up to SI4063_CTS_POLL_COUNT_MAX times.
+ * On success, the chip stays selected when keep_selected is set, so that the command response can be read.
+ */
+static int si4063_poll_cts(bool keep_selected, bool delay_between_polls)
 {
-    uint16_t timeout = 0xFFFF;
+    uint16_t polls = 0;
     uint8_t response;
 
-    // Poll CTS over SPI
-    do {
+    while (true) {
         si4063_set_chip_select(true);
         spi_send(SI4063_COMMAND_READ_CMD_BUFF);
         response = spi_read();
+        polls++;
+
         if (response == 0xFF) {
             break;
         }
+
         si4063_set_chip_select(false);
 
-        delay_us(10);
-    } while(timeout--);
+        if (polls >= SI4063_CTS_POLL_COUNT_MAX) {
+            si4063_trace.cts_poll_count += polls;
+            si4063_trace.cts_timeout_count++;
+            log_error("ERROR: Si4063 timeout\n");
+            return HAL_ERROR;
+        }
+
+        if (delay_between_polls) {
+            delay_us(10);
+        }
+    }
 
-    if (timeout == 0) {
-        log_error("ERROR: Si4063 timeout\n");
+    if (!keep_selected) {
         si4063_set_chip_select(false);
+    }
+
+    si4063_trace.cts_poll_count += polls;
+    if (polls > si4063_trace.cts_poll_max) {
+        si4063_trace.cts_poll_max = polls;
+    }
+
+    return HAL_OK;
+}
+
+static int si4063_wait_for_cts()
+{
+    return si4063_poll_cts(false, false);
+}
+
+static int si4063_read_response(uint8_t length, uint8_t *data)
+{
+    if (si4063_poll_cts(true, true) != HAL_OK) {
         return HAL_ERROR;
     }
 
     // Read the requested data
-    while (length--) {
-        *(data++) = spi_read();
-    }
+    spi_transfer(NULL, 0, NULL, data, length);
 
     si4063_set_chip_select(false);
 
@@ -153,14 +173,15 @@ static void si4063_send_command(uint8_t command, uint8_t length, uint8_t *data)
 {
     si4063_wait_for_cts();
 
-    si4063_set_chip_select(true);
-
-    spi_send(command);
+    si4063_trace.command_count++;
 
-    while (length--) {
-        spi_send(*(data++));
-    }
+    spi_segment segments[] = {
+            {.tx = &command, .rx = NULL, .length = 1},
+            {.tx = data, .rx = NULL, .length = length},
+    };
 
+    si4063_set_chip_select(true);
+    spi_transfer_segments(NULL, 0, segments, 2);
     si4063_set_chip_select(false);
 }
 
@@ -199,6 +220,16 @@ static void si4063_set_state(uint8_t state)
     si4063_send_command(SI4063_COMMAND_CHANGE_STATE, 1, &state);
 }
 
+void si4063_get_command_trace(si4063_command_trace *trace)
+{
+    *trace = si4063_trace;
+}
+
+void si4063_reset_command_trace()
+{
+    memset(&si4063_trace, 0, sizeof(si4063_trace));
+}
+
 void si4063_enable_tx()
 {
 #ifdef RADIO_LOGGING_ENABLE
@@ -277,19 +308,25 @@ uint16_t si4063_refill_buffer(uint8_t *data, int len)
     return len;
 }
 
+// Check whether our buffer has been emptied and the si4063 has left TX mode, does not block
+bool si4063_is_tx_complete()
+{
+    uint8_t status = 0;
+    si4063_send_command(SI4063_COMMAND_REQUEST_DEVICE_STATE, 0, NULL);
+    si4063_read_response(1, &status);
+
+    return status == SI4063_STATE_SLEEP ||
+           status == SI4063_STATE_READY ||
+           status == SI4063_STATE_READY2 ||
+           status == SI4063_STATE_SPI_ACTIVE;
+}
+
 // Wait for our buffer to be emptied, and for the si4063 to leave TX mode
 // If timeout, we force it to sleep
 int si4063_wait_for_tx_complete(int timeout_ms)
 {
     for(int i = 0; i < timeout_ms; i++) {
-        uint8_t status = 0;
-        si4063_send_command(SI4063_COMMAND_REQUEST_DEVICE_STATE, 0, NULL);
-        si4063_read_response(1, &status);
-
-        if(status == SI4063_STATE_SLEEP ||
-           status == SI4063_STATE_READY ||
-           status == SI4063_STATE_READY2 ||
-           status == SI4063_STATE_SPI_ACTIVE) {
+        if (si4063_is_tx_complete()) {
             return HAL_OK;
         }
 
@@ -11,11 +11,20 @@ typedef enum _si4063_modulation_type {
     SI4063_MODULATION_TYPE_FIFO_FSK,
 } si4063_modulation_type;
 
+typedef struct _si4063_command_trace {
+    uint32_t command_count;
+    // CTS polls over SPI, each of them adds a READ_CMD_BUFF frame to the command latency
+    uint32_t cts_poll_count;
+    uint16_t cts_poll_max;
+    uint16_t cts_timeout_count;
+} si4063_command_trace;
+
 void si4063_enable_tx();
 void si4063_inhibit_tx();
 void si4063_disable_tx();
 uint16_t si4063_start_tx(uint8_t *data, int len);
 uint16_t si4063_refill_buffer(uint8_t *data, int len);
+bool si4063_is_tx_complete();
 int si4063_wait_for_tx_complete(int timeout_ms);
 bool si4063_fifo_underflow();
 void si4063_set_tx_frequency(uint32_t frequency_hz);
@@ -28,5 +37,7 @@ int32_t si4063_read_temperature_celsius_100();
 void si4063_set_direct_mode_pin(bool high);
 void si4063_set_crystal_capacitance(uint8_t c_count);
 int si4063_init();
+void si4063_get_command_trace(si4063_command_trace *trace);
+void si4063_reset_command_trace();
 
 #endif
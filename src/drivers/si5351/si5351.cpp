@@ -510,42 +510,10 @@ Si5351::set_ms(enum si5351_clock clk, struct Si5351RegSet ms_reg, uint8_t int_mo
 {
     uint8_t params[20];
     uint8_t i = 0;
-    uint8_t temp;
-    uint8_t reg_val;
-
+    uint8_t temp = 0;
 
     if ((uint8_t) clk <= (uint8_t) SI5351_CLK5) {
-        // Registers 42-43 for CLK0
-        temp = (uint8_t) ((ms_reg.p3 >> 8) & 0xFF);
-        params[i++] = temp;
-
-        temp = (uint8_t) (ms_reg.p3 & 0xFF);
-        params[i++] = temp;
-
-        // Register 44 for CLK0
-        reg_val = si5351_read((SI5351_CLK0_PARAMETERS + 2) + (clk * 8));
-        reg_val &= ~(0x03);
-        temp = reg_val | ((uint8_t) ((ms_reg.p1 >> 16) & 0x03));
-        params[i++] = temp;
-
-        // Registers 45-46 for CLK0
-        temp = (uint8_t) ((ms_reg.p1 >> 8) & 0xFF);
-        params[i++] = temp;
-
-        temp = (uint8_t) (ms_reg.p1 & 0xFF);
-        params[i++] = temp;
-
-        // Register 47 for CLK0
-        temp = (uint8_t) ((ms_reg.p3 >> 12) & 0xF0);
-        temp += (uint8_t) ((ms_reg.p2 >> 16) & 0x0F);
-        params[i++] = temp;
-
-        // Registers 48-49 for CLK0
-        temp = (uint8_t) ((ms_reg.p2 >> 8) & 0xFF);
-        params[i++] = temp;
-
-        temp = (uint8_t) (ms_reg.p2 & 0xFF);
-        params[i++] = temp;
+        i = pack_ms_params(clk, ms_reg, params);
     } else {
         // MS6 and MS7 only use one register
         temp = ms_reg.p1;
@@ -594,6 +562,32 @@ Si5351::set_ms(enum si5351_clock clk, struct Si5351RegSet ms_reg, uint8_t int_mo
     }
 }
 
+/*
+ * calc_ms_params(uint64_t freq, enum si5351_clock clk, uint8_t *params)
+ *
+ * Calculate the SI5351_MS_PARAMETER_COUNT multisynth registers that set_freq() writes for MS0 through MS5
+ * when no PLL change is needed (freq up to SI5351_MULTISYNTH_SHARE_MAX), without writing them. Register 44
+ * keeps the R_DIV and DIVBY4 bits currently set on the chip, so the values only apply while the output runs
+ * with the returned R divider.
+ *
+ * freq - Output frequency in Hz
+ * clk - Clock output
+ *   (use the si5351_clock enum)
+ * params - Register values starting from the CLKx_PARAMETERS register
+ *
+ * Returns the R divider value for freq.
+ */
+uint8_t Si5351::calc_ms_params(uint64_t freq, enum si5351_clock clk, uint8_t *params)
+{
+    struct Si5351RegSet ms_reg;
+
+    uint8_t r_div = select_r_div(&freq);
+    multisynth_calc(freq, pll_assignment[clk] == SI5351_PLLA ? plla_freq : pllb_freq, &ms_reg);
+    pack_ms_params(clk, ms_reg, params);
+
+    return r_div;
+}
+
 /*
  * output_enable(enum si5351_clock clk, uint8_t enable)
  *
@@ -1503,6 +1497,47 @@ void Si5351::ms_div(enum si5351_clock clk, uint8_t r_div, uint8_t div_by_4)
     si5351_write(reg_addr, reg_val);
 }
 
+uint8_t Si5351::pack_ms_params(enum si5351_clock clk, struct Si5351RegSet ms_reg, uint8_t *params)
+{
+    uint8_t i = 0;
+    uint8_t temp;
+    uint8_t reg_val;
+
+    // Registers 42-43 for CLK0
+    temp = (uint8_t) ((ms_reg.p3 >> 8) & 0xFF);
+    params[i++] = temp;
+
+    temp = (uint8_t) (ms_reg.p3 & 0xFF);
+    params[i++] = temp;
+
+    // Register 44 for CLK0
+    reg_val = si5351_read((SI5351_CLK0_PARAMETERS + 2) + (clk * 8));
+    reg_val &= ~(0x03);
+    temp = reg_val | ((uint8_t) ((ms_reg.p1 >> 16) & 0x03));
+    params[i++] = temp;
+
+    // Registers 45-46 for CLK0
+    temp = (uint8_t) ((ms_reg.p1 >> 8) & 0xFF);
+    params[i++] = temp;
+
+    temp = (uint8_t) (ms_reg.p1 & 0xFF);
+    params[i++] = temp;
+
+    // Register 47 for CLK0
+    temp = (uint8_t) ((ms_reg.p3 >> 12) & 0xF0);
+    temp += (uint8_t) ((ms_reg.p2 >> 16) & 0x0F);
+    params[i++] = temp;
+
+    // Registers 48-49 for CLK0
+    temp = (uint8_t) ((ms_reg.p2 >> 8) & 0xFF);
+    params[i++] = temp;
+
+    temp = (uint8_t) (ms_reg.p2 & 0xFF);
+    params[i++] = temp;
+
+    return i;
+}
+
 uint8_t Si5351::select_r_div(uint64_t *freq)
 {
     uint8_t r_div = SI5351_OUTPUT_CLK_DIV_1;
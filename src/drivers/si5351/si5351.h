@@ -122,6 +122,7 @@
 #define SI5351_PLLA_PARAMETERS          26
 #define SI5351_PLLB_PARAMETERS          34
 #define SI5351_CLK0_PARAMETERS          42
+#define SI5351_MS_PARAMETER_COUNT       8
 #define SI5351_CLK1_PARAMETERS          50
 #define SI5351_CLK2_PARAMETERS          58
 #define SI5351_CLK3_PARAMETERS          66
@@ -301,6 +302,8 @@ public:
 
     void set_ms(enum si5351_clock, struct Si5351RegSet, uint8_t, uint8_t, uint8_t);
 
+    uint8_t calc_ms_params(uint64_t, enum si5351_clock, uint8_t *);
+
     void output_enable(enum si5351_clock, uint8_t);
 
     void drive_strength(enum si5351_clock, enum si5351_drive);
@@ -359,6 +362,8 @@ private:
 
     uint64_t multisynth67_calc(uint64_t, uint64_t, struct Si5351RegSet *);
 
+    uint8_t pack_ms_params(enum si5351_clock, struct Si5351RegSet, uint8_t *);
+
     void update_sys_status(struct Si5351Status *);
 
     void update_int_status(struct Si5351IntStatus *);
@@ -31,6 +31,8 @@
 
 typedef struct _gps_data {
     bool updated;
+    /* Incremented for every solution published by the GPS driver */
+    uint32_t sequence;
 
     uint32_t time_of_week_millis;
     int16_t week;
@@ -1,5 +1,6 @@
 #include "drivers/hal/system.h"
 #include "drivers/hal/i2c.h"
+#include "drivers/hal/i2c_queue.h"
 #include "drivers/hal/spi.h"
 #include "drivers/hal/usart_gps.h"
 #include "drivers/hal/usart_ext.h"
@@ -35,30 +36,36 @@ gps_data current_gps_data;
 
 void handle_timer_tick()
 {
-    if(counter % 100 == 0)
-        usart_gps_drain_dma();
+    // A single interrupt covers several ticks while the scheduler is idle. The ticks end at the updated counter:
+    // a periodic task is due when they reach a multiple of its period, i.e. when counter % period < ticks.
+    uint16_t ticks = system_get_tick_step();
 
     if (!system_initialized) {		// Timer may pop before everything fully initialized
+        usart_gps_drain_dma();
         return;
     }
 
+    counter = (counter + ticks) % SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND;
+
+    if(counter % 100 < ticks)
+        usart_gps_drain_dma();
+
     radio_handle_timer_tick();
 
 #if ALLOW_POWER_OFF
-    if(counter % 10 == 0)
+    if(counter % 10 < ticks)
         system_handle_button();
 #endif
 
-    counter = (counter + 1) % SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND;
-    if (counter == 0) {
-        // Peek only: consuming the updated flag here would race the transmit
-        // scheduler, which gates time-synced entries on it (see radio.c Tier 2).
+    if (counter < ticks) {
+        // Peek only: leaves the updated flag to telemetry. The transmit
+        // scheduler follows the solutions by their sequence number.
         gps_driver_peek_current_gps_data(&current_gps_data);
     }
 
 #if LEDS_ENABLE && !ENABLE_FOX_MODE
     // Green LED: solid on when GPS acquired, 2Hz blink when no fix (suppressed during red strobe)
-    if (counter % (SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND / 4) == 0) {
+    if (counter % (SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND / 4) < ticks) {
         if (red_led_strobe_ticks > 0) {
             set_green_led(false);
         } else if (GPS_HAS_FIX(current_gps_data)) {
@@ -71,11 +78,11 @@ void handle_timer_tick()
 
     // Red LED: strobe at 2Hz for 5 seconds on error
     if (red_led_strobe_ticks > 0) {
-        if (counter % (SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND / 4) == 0) {
+        if (counter % (SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND / 4) < ticks) {
             red_led_strobe_state = !red_led_strobe_state;
             system_set_red_led(red_led_strobe_state);
         }
-        red_led_strobe_ticks--;
+        red_led_strobe_ticks = red_led_strobe_ticks > ticks ? red_led_strobe_ticks - ticks : 0;
         if (red_led_strobe_ticks == 0) {
             red_led_strobe_state = false;
             system_set_red_led(false);
@@ -158,7 +165,7 @@ int main(void)
     // Set up interrupt handlers
     system_handle_timer_tick = handle_timer_tick;
     system_handle_data_timer_tick = radio_handle_data_timer_tick;
-    usart_gps_handle_incoming_byte = gps_driver_handle_incoming_byte;
+    usart_gps_handle_incoming_data = gps_driver_handle_incoming_data;
 
     //log_info("System init\n");
     system_init();
@@ -323,6 +330,10 @@ int main(void)
     while (true) {
         usart_gps_drain_dma();
 
+#if I2C_QUEUE_ENABLE
+        i2c_queue_poll();
+#endif
+
 #if GPS_SLEEP_TEST_SECONDS > 0
         {
             static bool gps_sleep_test_done = false;
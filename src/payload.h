@@ -10,4 +10,18 @@ typedef struct _payload_encoder {
     uint16_t (*encode)(uint8_t *payload, uint16_t length, telemetry_data *data, char *message);
 } payload_encoder;
 
+/**
+ * Payload encoders build the packet on the payload buffer itself, which the radio transmits from as is
+ * (also when feeding the transmitter FIFO). Stages that work in place (CRC, whitening, Horus Golay FEC) run where
+ * the packet ends up. A stage that cannot work in place (CATS interleaving, AX.25 framing, G3RUH scrambling) takes
+ * its input from a scratch area at the end of the buffer and writes its output from the start, which must not
+ * reach the scratch area.
+ *
+ * Returns the start of a scratch area of the given size at the end of the payload buffer.
+ */
+static inline uint8_t *payload_scratch(uint8_t *payload, uint16_t length, uint16_t size)
+{
+    return payload + length - size;
+}
+
 #endif
@@ -7,6 +7,8 @@
 #include "drivers/hal/system.h"
 #include "drivers/hal/delay.h"
 #include "drivers/hal/usart_gps.h"
+#include "drivers/hal/i2c_queue.h"
+#include "drivers/hal/clock_calibration.h"
 #include "codecs/morse/morse.h"
 #include "codecs/bell/bell.h"
 #include "codecs/mfsk/mfsk.h"
@@ -15,6 +17,8 @@
 #include "gps.h"
 #include "drivers/gps/gps_driver.h"
 #include "radio_internal.h"
+#include "radio_time_sync.h"
+#include "symbol_clock.h"
 #include "landed.h"
 #ifdef RS41
 #include "radio_si4032.h"
@@ -619,6 +623,8 @@ static uint8_t radio_next_non_synced_index = 0;
 
 static volatile uint32_t radio_post_transmit_delay_counter = 0;
 static volatile uint32_t radio_next_symbol_counter = 0;
+// Symbol periods in scheduler timer ticks for the symbols timed by radio_handle_timer_tick()
+static symbol_clock radio_symbol_clock;
 
 static radio_transmit_entry *radio_start_transmit_entry = NULL;
 
@@ -627,6 +633,7 @@ char radio_current_payload_message[RADIO_PAYLOAD_MESSAGE_MAX_LENGTH];
 uint8_t radio_current_payload[RADIO_PAYLOAD_MAX_LENGTH];
 uint16_t radio_current_payload_length = 0;
 
+// Symbols of the jtencode modes. The other modes render their symbol stream here: jtencode has no render().
 uint8_t radio_current_symbol_data[RADIO_SYMBOL_DATA_MAX_LENGTH];
 
 uint32_t precalculated_pwm_periods[FSK_TONE_COUNT_MAX];
@@ -637,6 +644,15 @@ static volatile uint32_t start_tick = 0, end_tick = 0;
 static bool gps_fix_ever_acquired = false;
 #endif
 
+// Sequence number of the last GPS solution the time-synced entries were checked against
+static uint32_t radio_gps_sequence = 0;
+
+#if TELEMETRY_SENSOR_TRIGGER_LEAD_MS > 0 || SYSTEM_IDLE_SLEEP_ENABLE
+// System tick at which the next slot window of the time-synced entries opens, as of the last GPS solution
+static uint32_t radio_time_sync_next_tick_ms = 0;
+static bool radio_time_sync_next_known = false;
+#endif
+
 telemetry_data current_telemetry_data;
 
 radio_module_state radio_shared_state = {
@@ -655,7 +671,13 @@ radio_module_state radio_shared_state = {
         .radio_current_tone_spacing_hz_100 = 0,
 
         .radio_current_symbol_rate = 0,
-        .radio_current_symbol_delay_ms_100 = 0
+        .radio_current_symbol_delay_ms_100 = 0,
+
+        .radio_symbol_stream_active = false,
+        .radio_current_symbol_stream = {
+                .symbols = radio_current_symbol_data,
+                .symbols_length = sizeof(radio_current_symbol_data),
+        },
 };
 
 static jtencode_mode_type radio_jtencode_mode_type_for(radio_data_mode mode)
@@ -684,17 +706,22 @@ static jtencode_mode_type radio_jtencode_mode_type_for(radio_data_mode mode)
     }
 }
 
-static inline void radio_reset_next_symbol_counter()
+static void radio_start_symbol_clock()
 {
     if (radio_shared_state.radio_current_symbol_rate > 0) {
-        radio_next_symbol_counter = (uint32_t) (((float) SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND) /
-                                                (float) radio_shared_state.radio_current_symbol_rate);
+        symbol_clock_init_rate(&radio_symbol_clock, SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND,
+                radio_shared_state.radio_current_symbol_rate);
     } else {
-        radio_next_symbol_counter = (uint32_t) (((float) radio_shared_state.radio_current_symbol_delay_ms_100) *
-                                                (float) SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND / 100000.0f);
+        symbol_clock_init_delay(&radio_symbol_clock, SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND,
+                radio_shared_state.radio_current_symbol_delay_ms_100);
     }
 }
 
+static inline void radio_reset_next_symbol_counter()
+{
+    radio_next_symbol_counter = symbol_clock_next(&radio_symbol_clock, clock_calibration_get_clock_error_ppb());
+}
+
 static inline bool radio_should_transmit_next_symbol()
 {
     return radio_next_symbol_counter == 0;
@@ -743,9 +770,16 @@ static bool radio_start_transmit(radio_transmit_entry *entry)
         return true;
     }
 
+#if TELEMETRY_CACHE_ENABLE
+    telemetry_snapshot(&current_telemetry_data);
+#else
     telemetry_collect(&current_telemetry_data);
+#endif
 
-    if (entry->messages != NULL && entry->message_count > 0) {
+    if (entry->compiled_messages != NULL) {
+        template_render(radio_current_payload_message, sizeof(radio_current_payload_message),
+                &entry->compiled_messages[entry->current_message_index], &current_telemetry_data);
+    } else if (entry->messages != NULL && entry->message_count > 0) {
         template_replace(radio_current_payload_message, sizeof(radio_current_payload_message),
                 entry->messages[entry->current_message_index], &current_telemetry_data);
     } else {
@@ -784,6 +818,11 @@ static bool radio_start_transmit(radio_transmit_entry *entry)
         case RADIO_DATA_MODE_RTTY:
             break;
         case RADIO_DATA_MODE_APRS_1200:
+#if PWM_TIMER_DMA_ENABLE
+            // The tones are clocked out by DMA (see radio_si4032.c), so interrupts do not disturb
+            // the symbol timing and the GPS can keep running during the transmission.
+            enable_gps_during_transmit = true;
+#else
             // APRS-1200 is bit-banged in thread mode with delay_us_loop() for symbol
             // timing, which measures real time and so is corrupted by any ISR that
             // preempts the loop. The Bell-202 symbol loop therefore stops the TIM6
@@ -795,6 +834,7 @@ static bool radio_start_transmit(radio_transmit_entry *entry)
             // before TX, and the time-sync scheduler keys off GPS time-of-week, so
             // pausing GPS for the packet does not drift the schedule.
             enable_gps_during_transmit = false;
+#endif
 
             // TODO: make bell tones and flag field count configurable
             bell_encoder_new(&entry->fsk_encoder, entry->symbol_rate, BELL_FLAG_FIELD_COUNT_1200, bell202_tones);
@@ -870,6 +910,10 @@ static bool radio_start_transmit(radio_transmit_entry *entry)
             return false;
     }
 
+    // Expand the whole packet into tone indexes now, so that the data timer interrupt only reads them
+    radio_shared_state.radio_symbol_stream_active = entry->fsk_encoder_api->render != NULL
+            && entry->fsk_encoder_api->render(&entry->fsk_encoder, &radio_shared_state.radio_current_symbol_stream);
+
     usart_gps_enable(enable_gps_during_transmit);
     if (!enable_gps_during_transmit) {
         gps_driver_reset_parser();
@@ -925,6 +969,8 @@ static inline void radio_reset_transmit_state()
 
     radio_shared_state.radio_current_symbol_rate = 0;
     radio_shared_state.radio_current_symbol_delay_ms_100 = 0;
+
+    radio_shared_state.radio_symbol_stream_active = false;
 }
 
 static bool radio_stop_transmit(radio_transmit_entry *entry)
@@ -1049,8 +1095,11 @@ static void radio_reset_transmit_delay_counter()
 
 static void radio_next_transmit_entry()
 {
-    radio_current_transmit_entry->current_message_index =
-            (radio_current_transmit_entry->current_message_index + 1) % radio_current_transmit_entry->message_count;
+    // Binary modes (e.g. Horus) have no messages: avoid the division by zero
+    if (radio_current_transmit_entry->message_count > 0) {
+        radio_current_transmit_entry->current_message_index =
+                (radio_current_transmit_entry->current_message_index + 1) % radio_current_transmit_entry->message_count;
+    }
 
     radio_current_transmit_entry->current_transmit_index =
             (radio_current_transmit_entry->current_transmit_index + 1) % radio_current_transmit_entry->transmit_count;
@@ -1081,6 +1130,8 @@ void radio_handle_timer_tick()
         return;
     }
 
+    uint16_t ticks = system_get_tick_step();
+
     if (radio_shared_state.radio_transmission_active) {
         if (radio_next_symbol_counter > 0) {
             radio_next_symbol_counter--;
@@ -1091,9 +1142,8 @@ void radio_handle_timer_tick()
             radio_reset_next_symbol_counter();
         }
     } else {
-        if (radio_post_transmit_delay_counter > 0) {
-            radio_post_transmit_delay_counter--;
-        }
+        radio_post_transmit_delay_counter = radio_post_transmit_delay_counter > ticks
+                ? radio_post_transmit_delay_counter - ticks : 0;
     }
 }
 
@@ -1110,30 +1160,6 @@ void radio_handle_data_timer_tick()
 #endif
 }
 
-static bool radio_check_time_sync(radio_transmit_entry *entry, uint32_t time_millis, uint8_t gps_fix)
-{
-    uint32_t time_sync_offset_millis = entry->time_sync_seconds_offset * 1000;
-
-    if (time_millis < time_sync_offset_millis) {
-        return false;
-    }
-
-    uint32_t time_sync_millis = entry->time_sync_seconds * 1000;
-
-    uint32_t time_with_offset_millis = time_millis - time_sync_offset_millis;
-    uint32_t time_sync_period_millis = time_with_offset_millis % time_sync_millis;
-
-    if (time_sync_period_millis >= RADIO_TIME_SYNC_THRESHOLD_MS) {
-        return false;
-    }
-
-    log_info("Time: %lu, fix: %d, sync: %lu - Schedule TX at %ds offset %d\n",
-            time_millis, gps_fix, time_sync_period_millis,
-            entry->time_sync_seconds, entry->time_sync_seconds_offset);
-
-    return true;
-}
-
 static radio_transmit_entry *radio_find_ready_entry()
 {
     // Tier 1: current entry mid-repeat sequence
@@ -1146,31 +1172,21 @@ static radio_transmit_entry *radio_find_ready_entry()
         return radio_current_transmit_entry;
     }
 
-    // Tier 2: scan time-synced entries for matching window
+    // Tier 2: scan time-synced entries for matching window, once for every new GPS solution
     gps_data gps;
-    gps_driver_get_current_gps_data(&gps);
-
-    if (gps.updated) {
+    if (gps_driver_get_gps_data_since(radio_gps_sequence, &gps)) {
+        radio_gps_sequence = gps.sequence;
         uint32_t time_millis = gps.time_of_week_millis - (gps_time_leap_seconds * 1000);
 
-        for (uint8_t i = 0; i < radio_transmit_entry_count; i++) {
-            radio_transmit_entry *entry = &radio_transmit_schedule[i];
-            if (!entry->enabled || entry->time_sync_seconds == 0) continue;
-
-            uint32_t offset_millis = entry->time_sync_seconds_offset * 1000;
-            if (time_millis < offset_millis) continue;
-
-            // The scheduled slot is constant across the whole tolerance window
-            // (RADIO_TIME_SYNC_THRESHOLD_MS) and increments once per period.
-            // Dedup on it so the entry fires exactly once per period, no matter
-            // how many GPS measurements land inside the window.
-            uint32_t slot = (time_millis - offset_millis) / (entry->time_sync_seconds * 1000);
-            if (entry->last_tx_slot == slot) continue;
-
-            if (radio_check_time_sync(entry, time_millis, gps.fix)) {
-                entry->last_tx_slot = slot;
-                return entry;
-            }
+        radio_transmit_entry *entry = radio_time_sync_find_ready_entry(radio_transmit_schedule,
+                radio_transmit_entry_count, time_millis);
+#if TELEMETRY_SENSOR_TRIGGER_LEAD_MS > 0 || SYSTEM_IDLE_SLEEP_ENABLE
+        uint32_t until_next_ms = entry != NULL ? UINT32_MAX : radio_time_sync_millis_until_next(time_millis);
+        radio_time_sync_next_known = until_next_ms < INT32_MAX;
+        radio_time_sync_next_tick_ms = HAL_GetTick() + until_next_ms;
+#endif
+        if (entry != NULL) {
+            return entry;
         }
     }
 
@@ -1189,6 +1205,134 @@ static radio_transmit_entry *radio_find_ready_entry()
     return NULL;
 }
 
+#if TELEMETRY_SENSOR_TRIGGER_LEAD_MS > 0
+/**
+ * Whether a transmission is expected to start within the given time: the next slot window of the time-synced
+ * entries opens, or the post-transmit delay ends for an entry that waits for it.
+ */
+static bool radio_transmit_expected_within(uint32_t window_ms)
+{
+    if (radio_time_sync_next_known) {
+        // The entry fires on the first GPS solution in the window, which may come up to the threshold late
+        int32_t remaining_ms = (int32_t) (radio_time_sync_next_tick_ms - HAL_GetTick());
+        if (remaining_ms > -RADIO_TIME_SYNC_THRESHOLD_MS && remaining_ms <= (int32_t) window_ms) {
+            return true;
+        }
+    }
+
+    if (radio_post_transmit_delay_counter * 1000 / SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND > window_ms) {
+        return false;
+    }
+
+    if (radio_current_transmit_entry != NULL && radio_current_transmit_entry->enabled
+        && radio_current_transmit_entry->current_transmit_index != 0) {
+        return true;
+    }
+
+    for (uint8_t i = 0; i < radio_transmit_entry_count; i++) {
+        radio_transmit_entry *entry = &radio_transmit_schedule[i];
+        if (entry->enabled && entry->time_sync_seconds == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+#endif
+
+/**
+ * Use the time the radio is idle for the telemetry: start the sensor measurements when a transmission is about
+ * to start, so that their conversion time has passed by then, and refresh the telemetry cache otherwise.
+ */
+static void radio_handle_idle_telemetry()
+{
+#if TELEMETRY_SENSOR_TRIGGER_LEAD_MS > 0
+    if (radio_transmit_expected_within(TELEMETRY_SENSOR_TRIGGER_LEAD_MS)) {
+        telemetry_prepare();
+        return;
+    }
+#endif
+#if TELEMETRY_CACHE_ENABLE
+    // The radio is idle: read the sensors now instead of at the start of the next transmission
+    telemetry_refresh();
+#endif
+}
+
+#if SYSTEM_IDLE_SLEEP_ENABLE
+/**
+ * Time from now until the idle telemetry needs to run for the next slot window of the time-synced entries:
+ * the sensor trigger lead time before the window opens, or the window itself. Returns the given timeout
+ * if that is earlier, or if the window is unknown or the lead time has already begun.
+ */
+static uint32_t radio_idle_deadline_ms(uint32_t timeout_ms)
+{
+    if (!radio_time_sync_next_known) {
+        return timeout_ms;
+    }
+
+    int32_t remaining_ms = (int32_t) (radio_time_sync_next_tick_ms - HAL_GetTick()) - TELEMETRY_SENSOR_TRIGGER_LEAD_MS;
+    if (remaining_ms <= 0 || (uint32_t) remaining_ms >= timeout_ms) {
+        return timeout_ms;
+    }
+
+    return (uint32_t) remaining_ms;
+}
+
+/**
+ * Sleep until something may make a transmit entry ready: a new GPS solution (time-synced entries),
+ * the end of the post-transmit delay (non-synced entries), the sensor trigger lead time before the next slot window
+ * or the given timeout for the rest of the main loop. Each sleep programs a single scheduler timer interrupt
+ * at the earliest of these deadlines, at most SYSTEM_SCHEDULER_IDLE_MAX_TICKS away: the GPS solutions are parsed
+ * from the UART DMA ring by the scheduler timer.
+ */
+static void radio_idle_wait(uint32_t timeout_ms)
+{
+    bool delay_active = radio_post_transmit_delay_counter > 0;
+    uint32_t deadline_ms = radio_idle_deadline_ms(timeout_ms);
+    uint32_t wait_start_tick = HAL_GetTick();
+
+    // An entry repeating after the post-transmit delay keeps radio_find_ready_entry() from checking new GPS solutions
+    uint32_t gps_sequence = radio_gps_sequence;
+    if (delay_active && radio_current_transmit_entry != NULL && radio_current_transmit_entry->enabled
+        && radio_current_transmit_entry->current_transmit_index != 0) {
+        gps_sequence = gps_driver_get_gps_data_sequence();
+    }
+
+    while (true) {
+        uint32_t waited_ms = HAL_GetTick() - wait_start_tick;
+        if (waited_ms >= deadline_ms) {
+            return;
+        }
+        if (gps_driver_get_gps_data_sequence() != gps_sequence) {
+            return;
+        }
+        if (delay_active && radio_post_transmit_delay_counter == 0) {
+            return;
+        }
+#if I2C_QUEUE_ENABLE
+        // Sensor transfers complete by interrupt, which also wakes up the CPU
+        i2c_queue_poll();
+        if (i2c_queue_busy()) {
+            // The queue times transfers with HAL_GetTick(), so keep SysTick running until they have completed
+            __WFI();
+            continue;
+        }
+#endif
+
+        uint32_t sleep_ticks = (deadline_ms - waited_ms) * (SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND / 1000);
+        uint32_t delay_ticks = radio_post_transmit_delay_counter;
+        if (delay_active && delay_ticks > 0 && delay_ticks < sleep_ticks) {
+            sleep_ticks = delay_ticks;
+        }
+        if (sleep_ticks > SYSTEM_SCHEDULER_IDLE_MAX_TICKS) {
+            sleep_ticks = SYSTEM_SCHEDULER_IDLE_MAX_TICKS;
+        }
+
+        system_idle_sleep((uint16_t) sleep_ticks);
+    }
+}
+#endif
+
 void radio_handle_main_loop()
 {
     if (!radio_shared_state.radio_transmission_active &&
@@ -1217,11 +1361,21 @@ void radio_handle_main_loop()
                     (current_telemetry_data.gps.altitude_mm / 1000));
             #endif
 
+#if SYSTEM_IDLE_SLEEP_ENABLE
+            // Symbol timing needs every scheduler tick
+            system_set_tick_step(1);
+#endif
+
             radio_current_transmit_entry = ready;
             radio_reset_transmit_delay_counter();
             radio_start_transmit_entry = ready;
         } else {
+            radio_handle_idle_telemetry();
+#if SYSTEM_IDLE_SLEEP_ENABLE
+            radio_idle_wait(100);
+#else
             delay_ms(100);
+#endif
             return;
         }
     }
@@ -1268,6 +1422,7 @@ void radio_handle_main_loop()
             bool success = radio_transmit_symbol(radio_current_transmit_entry);
             if (success) {
                 if (first_symbol) {
+                    radio_start_symbol_clock();
                     radio_reset_next_symbol_counter();
                 }
             } else {
@@ -1303,7 +1458,11 @@ void radio_init()
 
     memset(&current_telemetry_data, 0, sizeof(current_telemetry_data));
 
+#if TELEMETRY_CACHE_ENABLE
+    telemetry_snapshot(&current_telemetry_data);
+#else
     telemetry_collect(&current_telemetry_data);
+#endif
 
     for (uint8_t i = 0; i < radio_transmit_entry_count; i++) {
         radio_transmit_entry *entry = &radio_transmit_schedule[i];
@@ -1344,12 +1503,16 @@ void radio_init()
         }
         if (entry->messages != NULL) {
             for (entry->message_count = 0; entry->messages[entry->message_count] != NULL; entry->message_count++);
+#if TEMPLATE_COMPILE_ENABLE
+            entry->compiled_messages = template_compile(entry->messages, entry->message_count);
+#endif
         }
         if (entry->transmit_count == 0) {
             entry->transmit_count = 1;
         }
         entry->last_tx_slot = UINT32_MAX;
     }
+    radio_time_sync_reset();
 
     // radio_current_transmit_entry starts NULL; radio_find_ready_entry() will
     // select the first ready entry when radio_handle_main_loop() runs.
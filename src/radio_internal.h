@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include "payload.h"
+#include "template.h"
 #include "codecs/jtencode/jtencode.h"
 #include "codecs/fsk/fsk.h"
 
@@ -57,6 +58,8 @@ typedef struct _radio_transmit_entry {
     char **messages;
     uint8_t current_message_index;
     uint8_t message_count;
+    // Parsed messages, NULL if template_replace() is used
+    template_compiled *compiled_messages;
 
     uint8_t current_transmit_index;
     uint8_t transmit_count;
@@ -88,6 +91,9 @@ typedef struct _radio_module_state {
 
     uint32_t radio_current_symbol_rate;
     uint32_t radio_current_symbol_delay_ms_100;
+
+    bool radio_symbol_stream_active;
+    fsk_symbol_stream radio_current_symbol_stream;
 } radio_module_state;
 
 extern radio_transmit_entry *radio_current_transmit_entry;
@@ -96,4 +102,17 @@ extern radio_transmit_entry radio_transmit_schedule[];
 extern uint8_t radio_transmit_entry_count;
 extern uint32_t precalculated_pwm_periods[];
 
+/**
+ * Returns the next tone index from the symbol stream rendered before TX, if any,
+ * and otherwise evaluates the encoder lazily.
+ */
+static inline int8_t radio_next_tone(radio_transmit_entry *entry, radio_module_state *shared_state)
+{
+    if (shared_state->radio_symbol_stream_active) {
+        return fsk_symbol_stream_next_tone(&shared_state->radio_current_symbol_stream);
+    }
+
+    return entry->fsk_encoder_api->next_tone(&entry->fsk_encoder);
+}
+
 #endif
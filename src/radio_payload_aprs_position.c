@@ -8,17 +8,20 @@
 #include "log.h"
 #include "radio_payload_aprs_position.h"
 
+#define APRS_9600_PACKET_MAX_LENGTH 128
+
 uint16_t radio_aprs_position_encode(uint8_t *payload, uint16_t length, telemetry_data *telemetry_data, char *message)
 {
-    uint8_t aprs_packet[RADIO_APRS_PAYLOAD_MAX_LENGTH];
+    // The AX.25 frame is written from the start of the payload buffer, ahead of the information field at its end
+    uint8_t *aprs_packet = payload_scratch(payload, length, RADIO_APRS_PAYLOAD_MAX_LENGTH);
 
-    aprs_generate_position(aprs_packet, sizeof(aprs_packet), telemetry_data,
+    aprs_generate_position(aprs_packet, RADIO_APRS_PAYLOAD_MAX_LENGTH, telemetry_data,
             APRS_SYMBOL_TABLE, APRS_SYMBOL, false, message);
 
     log_debug("APRS packet: %s\n", aprs_packet);
 
     return ax25_encode_packet_aprs(APRS_CALLSIGN, APRS_SSID, APRS_DESTINATION, APRS_DESTINATION_SSID, APRS_RELAYS,
-            (char *) aprs_packet, length, payload);
+            (char *) aprs_packet, length - RADIO_APRS_PAYLOAD_MAX_LENGTH, payload);
 }
 
 payload_encoder radio_aprs_position_payload_encoder = {
@@ -27,20 +30,20 @@ payload_encoder radio_aprs_position_payload_encoder = {
 
 uint16_t radio_aprs_9600_position_encode(uint8_t *payload, uint16_t length, telemetry_data *telemetry_data, char *message)
 {
-    uint8_t aprs_packet[128];
-    uint8_t ax25_frame[128];
+    // The information field and the AX.25 frame are built at the end of the payload buffer,
+    // and the scrambled bit stream is written from its start up to the frame.
+    uint8_t *aprs_packet = payload_scratch(payload, length, APRS_9600_PACKET_MAX_LENGTH);
+    uint8_t *ax25_frame = aprs_packet - APRS_9600_FRAME_MAX_LENGTH;
 
-    aprs_generate_position(aprs_packet, sizeof(aprs_packet), telemetry_data,
+    aprs_generate_position(aprs_packet, APRS_9600_PACKET_MAX_LENGTH, telemetry_data,
             APRS_SYMBOL_TABLE, APRS_SYMBOL, false, message);
 
     log_debug("APRS packet: %s\n", aprs_packet);
 
     uint16_t ax25_length = ax25_encode_packet_aprs(APRS_CALLSIGN, APRS_SSID, APRS_DESTINATION, APRS_DESTINATION_SSID,
-            APRS_RELAYS, (char *) aprs_packet, sizeof(ax25_frame), ax25_frame);
-
-
+            APRS_RELAYS, (char *) aprs_packet, APRS_9600_FRAME_MAX_LENGTH, ax25_frame);
 
-    return g3ruh_encode(ax25_frame, ax25_length, payload, length);
+    return g3ruh_encode(ax25_frame, ax25_length, payload, (uint16_t) (ax25_frame - payload));
 }
 
 payload_encoder radio_aprs_9600_position_payload_encoder = {
@@ -2,6 +2,12 @@
 #define __RADIO_PAYLOAD_APRS_POSITION_H
 
 #include "payload.h"
+#include "codecs/aprs_9600/aprs_9600.h"
+
+#define APRS_9600_FRAME_MAX_LENGTH 128
+
+// Longest APRS 9600 payload, the G3RUH-encoded AX.25 frame
+#define RADIO_APRS_9600_PAYLOAD_MAX_LENGTH G3RUH_ENCODED_MAX_LENGTH(APRS_9600_FRAME_MAX_LENGTH)
 
 extern payload_encoder radio_aprs_position_payload_encoder;
 extern payload_encoder radio_aprs_9600_position_payload_encoder;
@@ -9,14 +9,15 @@
 
 uint16_t radio_aprs_weather_report_encode(uint8_t *payload, uint16_t length, telemetry_data *telemetry_data, char *message)
 {
-    uint8_t aprs_packet[RADIO_APRS_PAYLOAD_MAX_LENGTH];
+    // The AX.25 frame is written from the start of the payload buffer, ahead of the information field at its end
+    uint8_t *aprs_packet = payload_scratch(payload, length, RADIO_APRS_PAYLOAD_MAX_LENGTH);
 
-    aprs_generate_weather_report(aprs_packet, sizeof(aprs_packet), telemetry_data,true, message);
+    aprs_generate_weather_report(aprs_packet, RADIO_APRS_PAYLOAD_MAX_LENGTH, telemetry_data,true, message);
 
     log_debug("APRS packet: %s\n", aprs_packet);
 
     return ax25_encode_packet_aprs(APRS_CALLSIGN, APRS_SSID, APRS_DESTINATION, APRS_DESTINATION_SSID, APRS_RELAYS,
-            (char *) aprs_packet, length, payload);
+            (char *) aprs_packet, length - RADIO_APRS_PAYLOAD_MAX_LENGTH, payload);
 }
 
 payload_encoder radio_aprs_weather_report_payload_encoder = {
@@ -6,13 +6,12 @@
 #include "telemetry.h"
 #include "payload.h"
 #include "log.h"
+#include "radio_payload_cats.h"
 #include "codecs/cats/cats.h"
 #include "codecs/cats/whisker.h"
 
 #define CATS_PREAMBLE_BYTE 0x55
-#define CATS_PREAMBLE_LENGTH 4
 #define CATS_SYNC_WORD 0xABCDEF12
-#define CATS_SYNC_WORD_LENGTH 4
 
 uint16_t radio_cats_encode(uint8_t *payload, uint16_t length, telemetry_data *telemetry_data, char *message)
 {
@@ -28,8 +27,11 @@ uint16_t radio_cats_encode(uint8_t *payload, uint16_t length, telemetry_data *te
         *(cur++) = (CATS_SYNC_WORD >> (i * 8));
     }
 
-    static uint8_t data[RADIO_PAYLOAD_MAX_LENGTH];
-    memset(data, 0, sizeof(data));
+    // The packet is built and FEC-encoded in place in the second half of the payload buffer,
+    // and interleaved from there into the first half.
+    uint16_t scratch_length = length / 2;
+    uint8_t *data = payload_scratch(payload, length, scratch_length);
+    memset(data, 0, scratch_length);
     cats_packet packet = cats_create(data);
     cats_append_identification_whisker(&packet, CATS_CALLSIGN, CATS_SSID, CATS_ICON); // 11
     cats_append_comment_whisker(&packet, message); // 102
@@ -42,7 +44,13 @@ uint16_t radio_cats_encode(uint8_t *payload, uint16_t length, telemetry_data *te
 
     cats_append_node_info_whisker(&packet, telemetry_data); // 16
 
-    size_t len = cats_fully_encode(packet, cur);
+    size_t len = cats_fully_encoded_length(&packet);
+    if (cur + len > data || len - 2 > scratch_length) {
+        log_error("CATS packet too long: %i\n", (int) len);
+        return 0;
+    }
+
+    len = cats_fully_encode(packet, cur);
     log_info("CATS packet length: %i\n", (int)(len + CATS_PREAMBLE_LENGTH + CATS_SYNC_WORD_LENGTH));
 
     return (uint16_t)(CATS_PREAMBLE_LENGTH + CATS_SYNC_WORD_LENGTH + len);
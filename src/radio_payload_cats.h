@@ -1,8 +1,28 @@
 #ifndef __RADIO_PAYLOAD_CATS_H
 #define __RADIO_PAYLOAD_CATS_H
 
+#include "config.h"
+#include "config_internal.h"
 #include "payload.h"
 
+#define CATS_PREAMBLE_LENGTH 4
+#define CATS_SYNC_WORD_LENGTH 4
+
+/**
+ * Longest CATS packet data: the identification (5 + callsign), comment (2 + message), GPS (16)
+ * and node info (16) whiskers and the CRC (2).
+ */
+#define RADIO_CATS_DATA_MAX_LENGTH \
+    ((5 + sizeof(CATS_CALLSIGN) - 1) + (2 + RADIO_PAYLOAD_MESSAGE_MAX_LENGTH - 1) + 16 + 16 + 2)
+
+/**
+ * Longest CATS payload, the preamble and sync word followed by the fully encoded packet. Below 128 bytes of data,
+ * the LDPC codes add at most the data length plus 7 bytes of parity, and the encoder adds the LDPC length (2) and
+ * the packet length (2). The bound does not hold for longer data, which the tm2048 code pads to 128 parity bytes.
+ */
+#define RADIO_CATS_PAYLOAD_MAX_LENGTH \
+    (CATS_PREAMBLE_LENGTH + CATS_SYNC_WORD_LENGTH + 2 * RADIO_CATS_DATA_MAX_LENGTH + 7 + 2 + 2)
+
 extern payload_encoder radio_cats_payload_encoder;
 
 #endif
@@ -14,14 +14,15 @@
 
 uint16_t radio_horus_v2_encode(uint8_t *payload, uint16_t length, telemetry_data *telemetry_data, char *message)
 {
-    horus_packet_v2 horus_packet;
+    // The packet is built where the Golay encoder expects it in the transmitted packet and encoded in place.
+    uint8_t *horus_packet = payload + HORUS_V2_PREAMBLE_LENGTH + HORUS_L2_TX_PAYLOAD_OFFSET;
 
-    size_t packet_length = horus_packet_v2_create((uint8_t *) &horus_packet, sizeof(horus_packet),
-            telemetry_data, HORUS_V2_PAYLOAD_ID);
+    size_t packet_length = horus_packet_v2_create(horus_packet,
+            length - HORUS_V2_PREAMBLE_LENGTH - HORUS_L2_TX_PAYLOAD_OFFSET, telemetry_data, HORUS_V2_PAYLOAD_ID);
 
 #ifdef SEMIHOSTING_ENABLE
     log_info("Horus V2 packet: ");
-    log_bytes_hex((int) packet_length, (char *) &horus_packet);
+    log_bytes_hex((int) packet_length, (char *) horus_packet);
     log_info("\n");
 #endif
 
@@ -33,7 +34,7 @@ uint16_t radio_horus_v2_encode(uint8_t *payload, uint16_t length, telemetry_data
     // Encode the packet, and write into the mfsk buffer.
     int encoded_length = horus_l2_encode_tx_packet(
             (unsigned char *) payload + HORUS_V2_PREAMBLE_LENGTH,
-            (unsigned char *) &horus_packet, (int) packet_length);
+            (unsigned char *) horus_packet, (int) packet_length);
 
     return encoded_length + HORUS_V2_PREAMBLE_LENGTH;
 }
@@ -15,15 +15,16 @@
 
 uint16_t radio_horus_v3_encode(uint8_t *payload, uint16_t length, telemetry_data *telemetry_data, char *message)
 {
-    char horus_packet[HORUS_UNCODED_BUFFER_SIZE];
+    // The packet is built where the Golay encoder expects it in the transmitted packet and encoded in place.
+    uint8_t *horus_packet = payload + HORUS_V3_PREAMBLE_LENGTH + HORUS_L2_TX_PAYLOAD_OFFSET;
 
     memset(horus_packet, 0, HORUS_UNCODED_BUFFER_SIZE);
 
-    size_t packet_length = horus_packet_v3_create((uint8_t *) &horus_packet, telemetry_data);
+    size_t packet_length = horus_packet_v3_create(horus_packet, telemetry_data);
 
 #ifdef SEMIHOSTING_ENABLE
     log_info("Horus V3 packet: ");
-    log_bytes_hex((int) packet_length, (char *) &horus_packet);
+    log_bytes_hex((int) packet_length, (char *) horus_packet);
     log_info("\n");
 #endif
 
@@ -35,7 +36,7 @@ uint16_t radio_horus_v3_encode(uint8_t *payload, uint16_t length, telemetry_data
     // Encode the packet, and write into the mfsk buffer.
     int encoded_length = horus_l2_encode_tx_packet(
             (unsigned char *) payload + HORUS_V3_PREAMBLE_LENGTH,
-            (unsigned char *) &horus_packet, (int) packet_length);
+            (unsigned char *) horus_packet, (int) packet_length);
 
     return encoded_length + HORUS_V3_PREAMBLE_LENGTH;
 }
@@ -12,33 +12,66 @@
 #include "log.h"
 
 #include "radio_si4032.h"
+#include "radio_payload_cats.h"
+#include "radio_payload_aprs_position.h"
+#include "codecs/afsk/afsk.h"
+#include "codecs/bell/bell.h"
 #include "codecs/mfsk/mfsk.h"
 
 #define CW_SYMBOL_RATE_MULTIPLIER 4
 
 /**
- * I have attempted to implement Bell 202 frequency generation using hardware DMA and PWM, but have failed to generate
- * correct symbol rate that other APRS equipment are able to decode. I have tried to decode the DMA-based modulation with
- * some tools intended for debugging APRS and while some bytes are decoded correctly every once in a while,
- * the timings are mostly off for some unknown reason.
+ * The Bell 202 modulation implementation uses hardware PWM to generate the individual tone frequencies.
  *
- * The Bell 202 modulation implementation uses hardware PWM to generate the individual tone frequencies,
- * but when si4032_use_dma is false, the symbol timing is created in a loop with delay that was chosen
- * carefully via experiments.
+ * With PWM_TIMER_DMA_ENABLE, the PWM timer period of every half cycle is supplied by DMA from a buffer filled
+ * with a phase-continuous AFSK generator (codecs/afsk), so the symbol timing does not depend on the CPU and
+ * interrupts (including the scheduler tick and GPS) may keep running during the transmission.
+ * Otherwise, the symbol timing is created in a loop with delay that was chosen carefully via experiments.
  */
-// static bool si4032_use_dma = false;
-
 // TODO: Add support for multiple APRS baud rates
 // This delay is for RS41 radiosondes
 #define symbol_delay_bell_202_1200bps_us 823
 #define SI4032_DEVIATION_HZ_625_CATS 8 // 4800 / 625
 #define SI4032_DEVIATION_HZ_625_APRS_9600 5 // 3125 / 625 (~3 kHz standard G3RUH deviation)
 
+/**
+ * CATS and APRS 9600 packets are sent through the Si4032 TX FIFO. The radio nIRQ line is not wired to the MCU,
+ * so the data timer polls the FIFO almost empty flag every few bytes and tops up the FIFO with burst writes.
+ * The data timer ISR only paces the polls: it counts down the timeout and flags a pending poll, and the main
+ * loop does the SPI transfers, so none of them run in interrupt context.
+ */
+#define RADIO_SI4032_FIFO_POLL_BYTES 4
+#define RADIO_SI4032_FIFO_TX_COMPLETE_TIMEOUT_MS 500
+
+// The Si4032 packet length register has 8 bits, so the FIFO modes are limited to single packets of 255 bytes
+#if RADIO_TX_CATS
+_Static_assert(RADIO_CATS_DATA_MAX_LENGTH < 128 && RADIO_CATS_PAYLOAD_MAX_LENGTH <= SI4032_PACKET_LENGTH_MAX,
+        "CATS packets do not fit the Si4032 packet length, shorten CATS_CALLSIGN");
+#endif
+#if RADIO_TX_APRS_9600
+_Static_assert(RADIO_APRS_9600_PAYLOAD_MAX_LENGTH <= SI4032_PACKET_LENGTH_MAX,
+        "APRS 9600 packets do not fit the Si4032 packet length");
+#endif
+
 static volatile bool radio_si4032_state_change = false;
 static volatile uint32_t radio_si4032_freq = 0;
+
+static uint8_t *radio_si4032_fifo_data = NULL;
+static volatile uint16_t radio_si4032_fifo_remaining = 0;
+static volatile uint32_t radio_si4032_fifo_timeout_ticks = 0;
+static volatile bool radio_si4032_fifo_poll_pending = false;
+
+static void radio_si4032_start_fifo_transmit(radio_transmit_entry *entry, uint32_t data_rate);
+
+#if PWM_TIMER_DMA_ENABLE
 static volatile int8_t radio_dma_transfer_stop_after_counter = -1;
+static afsk_generator radio_si4032_afsk_generator;
 
-uint16_t radio_si4032_fill_pwm_buffer(uint16_t offset, uint16_t length, uint16_t *buffer);
+static int8_t radio_si4032_next_tone();
+static uint16_t radio_si4032_fill_pwm_buffer(uint16_t offset, uint16_t length, uint16_t *buffer);
+static uint16_t radio_si4032_handle_pwm_transfer_half(uint16_t buffer_size, uint16_t *buffer);
+static uint16_t radio_si4032_handle_pwm_transfer_full(uint16_t buffer_size, uint16_t *buffer);
+#endif
 
 bool radio_start_transmit_si4032(radio_transmit_entry *entry, radio_module_state *shared_state)
 {
@@ -72,10 +105,6 @@ bool radio_start_transmit_si4032(radio_transmit_entry *entry, radio_module_state
             frequency_offset = 0;
             modulation_type = SI4032_MODULATION_TYPE_FSK;
             use_direct_mode = true;
-            // if (si4032_use_dma) {
-            //     pwm_data_timer_init();
-            //     radio_si4032_fill_pwm_buffer(0, PWM_TIMER_DMA_BUFFER_SIZE, pwm_timer_dma_buffer);
-            // }
             break;
         case RADIO_DATA_MODE_HORUS_V2:
         case RADIO_DATA_MODE_HORUS_V3: {
@@ -121,6 +150,14 @@ bool radio_start_transmit_si4032(radio_transmit_entry *entry, radio_module_state
             return false;
     }
 
+    if (use_fifo_mode) {
+        uint16_t len = entry->fsk_encoder_api->get_data_len(&entry->fsk_encoder);
+        if (len > SI4032_PACKET_LENGTH_MAX) {
+            log_error("ERROR: Si4032 FIFO packet too long: %d bytes\n", len);
+            return false;
+        }
+    }
+
     si4032_set_tx_frequency(((float) entry->frequency) / 1000000.0f);
     si4032_set_tx_power(entry->tx_power);
     si4032_set_frequency_offset(frequency_offset);
@@ -158,14 +195,23 @@ bool radio_start_transmit_si4032(radio_transmit_entry *entry, radio_module_state
             #endif
             break;
         case RADIO_DATA_MODE_APRS_1200:
-            // if (si4032_use_dma) {
-            //     shared_state->radio_dma_transfer_active = true;
-            //     radio_dma_transfer_stop_after_counter = -1;
-            //     system_disable_tick();
-            //     pwm_dma_start();
-            // } else {
+#if PWM_TIMER_DMA_ENABLE
+            afsk_generator_init(&radio_si4032_afsk_generator, PWM_TIMER_CLOCK_HZ,
+                    shared_state->radio_current_symbol_rate, shared_state->radio_current_fsk_tones,
+                    FSK_TONE_INDEX_BELL_MARK, radio_si4032_next_tone);
+            radio_dma_transfer_stop_after_counter = -1;
+            if (radio_si4032_fill_pwm_buffer(0, PWM_TIMER_DMA_BUFFER_SIZE, pwm_timer_dma_buffer)
+                < PWM_TIMER_DMA_BUFFER_SIZE / 2) {
+                radio_dma_transfer_stop_after_counter = 1;
+            }
+
+            pwm_handle_dma_transfer_half = radio_si4032_handle_pwm_transfer_half;
+            pwm_handle_dma_transfer_full = radio_si4032_handle_pwm_transfer_full;
+            shared_state->radio_dma_transfer_active = true;
+            pwm_dma_start();
+#else
             shared_state->radio_manual_transmit_active = true;
-            // }
+#endif
             break;
         case RADIO_DATA_MODE_HORUS_V2:
         case RADIO_DATA_MODE_HORUS_V3:
@@ -174,7 +220,9 @@ bool radio_start_transmit_si4032(radio_transmit_entry *entry, radio_module_state
             break;
         case RADIO_DATA_MODE_CATS:
         case RADIO_DATA_MODE_APRS_9600:
+            radio_si4032_start_fifo_transmit(entry, data_rate);
             shared_state->radio_fifo_transmit_active = true;
+            shared_state->radio_interrupt_transmit_active = true;
             break;
         case RADIO_DATA_MODE_LONG_TONE:
             #if !ENABLE_FM_CW
@@ -201,7 +249,7 @@ static uint32_t radio_next_symbol_si4032(radio_transmit_entry *entry, radio_modu
         case RADIO_DATA_MODE_RTTY:
             return 0;
         case RADIO_DATA_MODE_APRS_1200: {
-            int8_t next_tone_index = entry->fsk_encoder_api->next_tone(&entry->fsk_encoder);
+            int8_t next_tone_index = radio_next_tone(entry, shared_state);
             if (next_tone_index < 0) {
                 return 0;
             }
@@ -233,15 +281,13 @@ static void radio_handle_main_loop_manual_si4032(radio_transmit_entry *entry, ra
         #if ENABLE_FM_CW
         case RADIO_DATA_MODE_CW:
         case RADIO_DATA_MODE_PIP: {
-            fsk_encoder_api *fsk_encoder_api = entry->fsk_encoder_api;
-            fsk_encoder *fsk_enc = &entry->fsk_encoder;
             int8_t tone_index;
             uint32_t symbol_delay_ms = 1000 / entry->symbol_rate;
 
             // Dead carrier before CW
             delay_ms(FM_CW_TX_DELAY);
 
-            while ((tone_index = fsk_encoder_api->next_tone(fsk_enc)) >= 0) {
+            while ((tone_index = radio_next_tone(entry, shared_state)) >= 0) {
                 pwm_timer_pwm_enable(tone_index != 0);
                 delay_ms(symbol_delay_ms);
                 shared_state->radio_symbol_count_loop++;
@@ -286,9 +332,6 @@ static void radio_handle_main_loop_manual_si4032(radio_transmit_entry *entry, ra
         return;
     }
 
-    fsk_encoder_api *fsk_encoder_api = entry->fsk_encoder_api;
-    fsk_encoder *fsk_enc = &entry->fsk_encoder;
-
     for (uint8_t i = 0; i < shared_state->radio_current_fsk_tone_count; i++) {
         precalculated_pwm_periods[i] = pwm_calculate_period(shared_state->radio_current_fsk_tones[i].frequency_hz_100);
     }
@@ -308,7 +351,7 @@ static void radio_handle_main_loop_manual_si4032(radio_transmit_entry *entry, ra
 
             system_disable_tick();
 
-            while ((tone_index = fsk_encoder_api->next_tone(fsk_enc)) >= 0) {
+            while ((tone_index = radio_next_tone(entry, shared_state)) >= 0) {
                 pwm_timer_set_frequency(precalculated_pwm_periods[tone_index]);
                 shared_state->radio_symbol_count_loop++;
                 delay_us_loop(symbol_delay_bell_202_1200bps_us);
@@ -325,7 +368,8 @@ static void radio_handle_main_loop_manual_si4032(radio_transmit_entry *entry, ra
     }
 }
 
-void radio_handle_fifo_si4032(radio_transmit_entry *entry, radio_module_state *shared_state) {
+static void radio_si4032_start_fifo_transmit(radio_transmit_entry *entry, uint32_t data_rate)
+{
 #ifdef RADIO_LOGGING_ENABLE
     log_debug("Start FIFO TX\n");
 #endif
@@ -334,40 +378,78 @@ void radio_handle_fifo_si4032(radio_transmit_entry *entry, radio_module_state *s
 
     uint8_t *data = fsk_encoder_api->get_data(fsk_enc);
     uint16_t len = fsk_encoder_api->get_data_len(fsk_enc);
-
-    bool overflow = false;
+    uint32_t poll_rate = data_rate / (8 * RADIO_SI4032_FIFO_POLL_BYTES);
 
     uint16_t written = si4032_start_tx(data, len);
-    data += written;
-    len -= written;
+    radio_si4032_fifo_data = data + written;
+    radio_si4032_fifo_remaining = len - written;
+    radio_si4032_fifo_timeout_ticks = len / RADIO_SI4032_FIFO_POLL_BYTES
+            + poll_rate * RADIO_SI4032_FIFO_TX_COMPLETE_TIMEOUT_MS / 1000;
 
-    si4032_refill_buffer(data, len, &overflow);
+    radio_si4032_fifo_poll_pending = false;
+
+    data_timer_init(poll_rate);
+}
 
-    int err = si4032_wait_for_tx_complete(500);
-    if (err != HAL_OK) {
-        log_error("Error waiting for tx complete: %d\n", err);
+static void radio_si4032_handle_fifo_poll()
+{
+    uint8_t status = si4032_read_interrupt_status();
+
+    if (radio_si4032_fifo_remaining > 0 && (status & SI4032_INTERRUPT_TX_FIFO_ALMOST_EMPTY)) {
+        uint8_t refill_status;
+        uint16_t written = si4032_refill_buffer(radio_si4032_fifo_data, radio_si4032_fifo_remaining, &refill_status);
+        radio_si4032_fifo_data += written;
+        radio_si4032_fifo_remaining -= written;
+        status |= refill_status;
     }
 
+    if (radio_si4032_fifo_remaining == 0 && (status & SI4032_INTERRUPT_PACKET_SENT)) {
 #ifdef RADIO_LOGGING_ENABLE
-    log_debug("Finished FIFO TX\n");
+        log_debug("Finished FIFO TX\n");
 #endif
+        radio_shared_state.radio_interrupt_transmit_active = false;
+        radio_shared_state.radio_transmission_finished = true;
+        return;
+    }
+
+    if (status & SI4032_INTERRUPT_FIFO_ERROR) {
+        // The FIFO ran empty before the packet was complete, the rest of the packet would go out corrupted
+        si4032_disable_tx();
+        log_error("ERROR: Si4032 FIFO underflow - Aborting\n");
+        radio_shared_state.radio_interrupt_transmit_active = false;
+        radio_shared_state.radio_transmission_finished = true;
+        return;
+    }
 
-    shared_state->radio_transmission_finished = true;
+    if (radio_si4032_fifo_timeout_ticks == 0) {
+        // clear txon manually
+        si4032_disable_tx();
+        log_error("ERROR: Si4032 FIFO TX timeout\n");
+        radio_shared_state.radio_interrupt_transmit_active = false;
+        radio_shared_state.radio_transmission_finished = true;
+    }
 }
 
 void radio_handle_main_loop_si4032(radio_transmit_entry *entry, radio_module_state *shared_state)
 {
-    if (entry->radio_type != RADIO_TYPE_SI4032 || shared_state->radio_interrupt_transmit_active || shared_state->radio_transmission_finished) {
+    if (entry->radio_type != RADIO_TYPE_SI4032 || shared_state->radio_transmission_finished) {
         return;
     }
 
-    if (shared_state->radio_manual_transmit_active) {
-        radio_handle_main_loop_manual_si4032(entry, shared_state);
+    if (shared_state->radio_fifo_transmit_active) {
+        if (shared_state->radio_interrupt_transmit_active && radio_si4032_fifo_poll_pending) {
+            radio_si4032_fifo_poll_pending = false;
+            radio_si4032_handle_fifo_poll();
+        }
         return;
     }
 
-    if (shared_state->radio_fifo_transmit_active) {
-        radio_handle_fifo_si4032(entry, shared_state);
+    if (shared_state->radio_interrupt_transmit_active) {
+        return;
+    }
+
+    if (shared_state->radio_manual_transmit_active) {
+        radio_handle_main_loop_manual_si4032(entry, shared_state);
         return;
     }
 
@@ -396,11 +478,9 @@ inline void radio_handle_data_timer_si4032()
 
             cw_symbol_rate_multiplier = CW_SYMBOL_RATE_MULTIPLIER;
 
-            fsk_encoder_api *fsk_encoder_api = radio_current_transmit_entry->fsk_encoder_api;
-            fsk_encoder *fsk_enc = &radio_current_transmit_entry->fsk_encoder;
             int8_t tone_index;
 
-            tone_index = fsk_encoder_api->next_tone(fsk_enc);
+            tone_index = radio_next_tone(radio_current_transmit_entry, &radio_shared_state);
             if (tone_index < 0) {
                 si4032_set_sdi_pin(false);
                 #ifdef RADIO_LOGGING_ENABLE
@@ -419,11 +499,9 @@ inline void radio_handle_data_timer_si4032()
         }
         case RADIO_DATA_MODE_HORUS_V2:
         case RADIO_DATA_MODE_HORUS_V3: {
-            fsk_encoder_api *fsk_encoder_api = radio_current_transmit_entry->fsk_encoder_api;
-            fsk_encoder *fsk_enc = &radio_current_transmit_entry->fsk_encoder;
             int8_t tone_index;
 
-            tone_index = fsk_encoder_api->next_tone(fsk_enc);
+            tone_index = radio_next_tone(radio_current_transmit_entry, &radio_shared_state);
             if (tone_index < 0) {
                 #ifdef RADIO_LOGGING_ENABLE
                 log_info("Horus TX finished\n");
@@ -439,6 +517,14 @@ inline void radio_handle_data_timer_si4032()
             radio_shared_state.radio_symbol_count_interrupt++;
             break;
         }
+        case RADIO_DATA_MODE_CATS:
+        case RADIO_DATA_MODE_APRS_9600:
+            // The FIFO is serviced from the main loop
+            if (radio_si4032_fifo_timeout_ticks > 0) {
+                radio_si4032_fifo_timeout_ticks--;
+            }
+            radio_si4032_fifo_poll_pending = true;
+            break;
         default:
             break;
     }
@@ -462,6 +548,8 @@ bool radio_stop_transmit_si4032(radio_transmit_entry *entry, radio_module_state
         case RADIO_DATA_MODE_RTTY:
         case RADIO_DATA_MODE_HORUS_V2:
         case RADIO_DATA_MODE_HORUS_V3:
+        case RADIO_DATA_MODE_CATS:
+        case RADIO_DATA_MODE_APRS_9600:
             data_timer_uninit();
             break;
         case RADIO_DATA_MODE_APRS_1200:
@@ -496,10 +584,10 @@ bool radio_stop_transmit_si4032(radio_transmit_entry *entry, radio_module_state
             // system_enable_tick();
             break;
         case RADIO_DATA_MODE_APRS_1200:
-            // if (si4032_use_dma) {
-            //     pwm_data_timer_uninit();
-            //     system_enable_tick();
-            // }
+#if PWM_TIMER_DMA_ENABLE
+            pwm_dma_stop();
+            shared_state->radio_dma_transfer_active = false;
+#endif
             break;
         case RADIO_DATA_MODE_HORUS_V2:
         case RADIO_DATA_MODE_HORUS_V3:
@@ -512,24 +600,22 @@ bool radio_stop_transmit_si4032(radio_transmit_entry *entry, radio_module_state
     return true;
 }
 
-uint16_t radio_si4032_fill_pwm_buffer(uint16_t offset, uint16_t length, uint16_t *buffer)
+#if PWM_TIMER_DMA_ENABLE
+static int8_t radio_si4032_next_tone()
 {
-    uint16_t count = 0;
-    for (uint16_t i = offset; i < (offset + length); i++, count++) {
-        uint32_t frequency = radio_next_symbol_si4032(radio_current_transmit_entry, &radio_shared_state);
-        if (frequency == 0) {
-            // TODO: fill the other side of the buffer with zeroes too?
-            memset(buffer + offset, 0, (length - i) * sizeof(uint16_t));
-            break;
-        }
-        buffer[i] = pwm_calculate_period(frequency);
-    }
+    return radio_next_tone(radio_current_transmit_entry, &radio_shared_state);
+}
 
-    return count;
+static uint16_t radio_si4032_fill_pwm_buffer(uint16_t offset, uint16_t length, uint16_t *buffer)
+{
+    return afsk_generator_fill(&radio_si4032_afsk_generator, length, buffer + offset);
 }
 
-#if 0
-bool radio_si4032_stop_dma_transfer_if_requested(radio_module_state *shared_state)
+/**
+ * Once a buffer half runs out of symbols, the transfer is stopped at the second interrupt after that:
+ * only then has the whole half, with idle tone padding after the last symbol, been clocked out.
+ */
+static bool radio_si4032_stop_dma_transfer_if_requested(radio_module_state *shared_state)
 {
     if (radio_dma_transfer_stop_after_counter > 0) {
         radio_dma_transfer_stop_after_counter--;
@@ -544,43 +630,35 @@ bool radio_si4032_stop_dma_transfer_if_requested(radio_module_state *shared_stat
     return false;
 }
 
-uint16_t radio_si4032_handle_pwm_transfer_half(uint16_t buffer_size, uint16_t *buffer)
+static uint16_t radio_si4032_handle_pwm_transfer(uint16_t offset, uint16_t length, uint16_t *buffer)
 {
     if (radio_si4032_stop_dma_transfer_if_requested(&radio_shared_state)) {
         return 0;
     }
-    if (radio_shared_state.radio_transmission_finished) {
-        //log_info("Should not be here, half-transfer!\n");
-    }
 
-    uint16_t length = radio_si4032_fill_pwm_buffer(0, buffer_size / 2, buffer);
-    if (radio_dma_transfer_stop_after_counter < 0 && length < buffer_size / 2) {
-        radio_dma_transfer_stop_after_counter = 2;
+    uint16_t symbol_length = radio_si4032_fill_pwm_buffer(offset, length, buffer);
+    if (radio_dma_transfer_stop_after_counter < 0 && symbol_length < length) {
+        radio_dma_transfer_stop_after_counter = 1;
     }
 
-    return length;
+    return symbol_length;
 }
 
-uint16_t radio_si4032_handle_pwm_transfer_full(uint16_t buffer_size, uint16_t *buffer)
+static uint16_t radio_si4032_handle_pwm_transfer_half(uint16_t buffer_size, uint16_t *buffer)
 {
-    if (radio_si4032_stop_dma_transfer_if_requested(&radio_shared_state)) {
-        return 0;
-    }
-    if (radio_shared_state.radio_transmission_finished) {
-        //log_info("Should not be here, transfer complete!\n");
-    }
-
-    uint16_t length = radio_si4032_fill_pwm_buffer(buffer_size / 2, buffer_size / 2, buffer);
-    if (radio_dma_transfer_stop_after_counter < 0 && length < buffer_size / 2) {
-        radio_dma_transfer_stop_after_counter = 2;
-    }
+    return radio_si4032_handle_pwm_transfer(0, buffer_size / 2, buffer);
+}
 
-    return length;
+static uint16_t radio_si4032_handle_pwm_transfer_full(uint16_t buffer_size, uint16_t *buffer)
+{
+    return radio_si4032_handle_pwm_transfer(buffer_size / 2, buffer_size / 2, buffer);
 }
 #endif
 
 void radio_init_si4032()
 {
-    return;
+#if PWM_TIMER_DMA_ENABLE
+    pwm_dma_init();
+#endif
 }
 #endif
@@ -24,9 +24,25 @@
 // This delay is for DFM-17 radiosondes
 #define symbol_delay_bell_202_1200bps_us 821
 
+/**
+ * CATS and APRS 9600 packets are sent through the Si4063 TX FIFO. The radio nIRQ line is not wired to the MCU,
+ * so the data timer polls the FIFO free space every few bytes and tops up the FIFO with WRITE_TX_FIFO bursts.
+ * The data timer ISR only paces the polls: it counts down the timeout and flags a pending poll, and the main
+ * loop does the FIFO writes and their CTS waits, so none of them run in interrupt context.
+ */
+#define RADIO_SI4063_FIFO_POLL_BYTES 16
+#define RADIO_SI4063_FIFO_TX_COMPLETE_TIMEOUT_MS 1000
+
 static volatile bool radio_si4063_state_change = false;
 static volatile uint32_t radio_si4063_freq = 0;
 
+static uint8_t *radio_si4063_fifo_data = NULL;
+static volatile uint16_t radio_si4063_fifo_remaining = 0;
+static volatile uint32_t radio_si4063_fifo_timeout_ticks = 0;
+static volatile bool radio_si4063_fifo_poll_pending = false;
+
+static void radio_si4063_start_fifo_transmit(radio_transmit_entry *entry, uint32_t data_rate);
+
 bool radio_start_transmit_si4063(radio_transmit_entry *entry, radio_module_state *shared_state)
 {
     uint16_t frequency_offset;
@@ -149,7 +165,9 @@ bool radio_start_transmit_si4063(radio_transmit_entry *entry, radio_module_state
             break;
         case RADIO_DATA_MODE_CATS:
         case RADIO_DATA_MODE_APRS_9600:
+            radio_si4063_start_fifo_transmit(entry, data_rate);
             shared_state->radio_fifo_transmit_active = true;
+            shared_state->radio_interrupt_transmit_active = true;
             break;
         case RADIO_DATA_MODE_LONG_TONE:
             #if !ENABLE_FM_CW
@@ -175,7 +193,7 @@ static uint32_t radio_next_symbol_si4063(radio_transmit_entry *entry, radio_modu
         case RADIO_DATA_MODE_RTTY:
             return 0;
         case RADIO_DATA_MODE_APRS_1200: {
-            int8_t next_tone_index = entry->fsk_encoder_api->next_tone(&entry->fsk_encoder);
+            int8_t next_tone_index = radio_next_tone(entry, shared_state);
             if (next_tone_index < 0) {
                 return 0;
             }
@@ -207,15 +225,13 @@ static void radio_handle_main_loop_manual_si4063(radio_transmit_entry *entry, ra
         #if ENABLE_FM_CW
         case RADIO_DATA_MODE_CW:
         case RADIO_DATA_MODE_PIP: {
-            fsk_encoder_api *fsk_encoder_api = entry->fsk_encoder_api;
-            fsk_encoder *fsk_enc = &entry->fsk_encoder;
             int8_t tone_index;
             uint32_t symbol_delay_ms = 1000 / entry->symbol_rate;
 
             // Dead carrier before CW
             delay_ms(FM_CW_TX_DELAY);
 
-            while ((tone_index = fsk_encoder_api->next_tone(fsk_enc)) >= 0) {
+            while ((tone_index = radio_next_tone(entry, shared_state)) >= 0) {
                 pwm_timer_pwm_enable(tone_index != 0);
                 delay_ms(symbol_delay_ms);
                 shared_state->radio_symbol_count_loop++;
@@ -260,9 +276,6 @@ static void radio_handle_main_loop_manual_si4063(radio_transmit_entry *entry, ra
         return;
     }
 
-    fsk_encoder_api *fsk_encoder_api = entry->fsk_encoder_api;
-    fsk_encoder *fsk_enc = &entry->fsk_encoder;
-
     for (uint8_t i = 0; i < shared_state->radio_current_fsk_tone_count; i++) {
         precalculated_pwm_periods[i] = pwm_calculate_period(shared_state->radio_current_fsk_tones[i].frequency_hz_100);
     }
@@ -282,7 +295,7 @@ static void radio_handle_main_loop_manual_si4063(radio_transmit_entry *entry, ra
 
             system_disable_tick();
 
-            while ((tone_index = fsk_encoder_api->next_tone(fsk_enc)) >= 0) {
+            while ((tone_index = radio_next_tone(entry, shared_state)) >= 0) {
                 pwm_timer_set_frequency(precalculated_pwm_periods[tone_index]);
                 shared_state->radio_symbol_count_loop++;
                 delay_us_loop(symbol_delay_bell_202_1200bps_us);
@@ -299,58 +312,89 @@ static void radio_handle_main_loop_manual_si4063(radio_transmit_entry *entry, ra
     }
 }
 
-void radio_handle_fifo_si4063(radio_transmit_entry *entry, radio_module_state *shared_state) {
+static void radio_si4063_start_fifo_transmit(radio_transmit_entry *entry, uint32_t data_rate)
+{
 #ifdef RADIO_LOGGING_ENABLE
     log_debug("Start FIFO TX\n");
+    si4063_reset_command_trace();
 #endif
     fsk_encoder_api *fsk_encoder_api = entry->fsk_encoder_api;
     fsk_encoder *fsk_enc = &entry->fsk_encoder;
 
     uint8_t *data = fsk_encoder_api->get_data(fsk_enc);
     uint16_t len = fsk_encoder_api->get_data_len(fsk_enc);
+    uint32_t poll_rate = data_rate / (8 * RADIO_SI4063_FIFO_POLL_BYTES);
 
+    // START_TX takes a 16-bit packet length, so the whole payload goes out as a single packet
     uint16_t written = si4063_start_tx(data, len);
-    data += written;
-    len -= written;
-    
-    while(len > 0) {
-        uint16_t written = si4063_refill_buffer(data, len);
-        data += written;
-        len -= written;
-
-        if(si4063_fifo_underflow()) {
-            log_info("FIFO underflow - Aborting\n");
-            shared_state->radio_transmission_finished = true;
+    radio_si4063_fifo_data = data + written;
+    radio_si4063_fifo_remaining = len - written;
+    radio_si4063_fifo_timeout_ticks = len / RADIO_SI4063_FIFO_POLL_BYTES
+            + poll_rate * RADIO_SI4063_FIFO_TX_COMPLETE_TIMEOUT_MS / 1000;
 
-            return;
-        }
-    }
+    radio_si4063_fifo_poll_pending = false;
 
-    int err = si4063_wait_for_tx_complete(1000);
-    if(err != HAL_OK) {
-        log_error("Error waiting for tx complete: %d\n", err);
-    }
+    data_timer_init(poll_rate);
+}
 
+static void radio_si4063_finish_fifo_transmit()
+{
 #ifdef RADIO_LOGGING_ENABLE
-    log_debug("Finished FIFO TX\n");
+    si4063_command_trace trace;
+    si4063_get_command_trace(&trace);
+    log_debug("Finished FIFO TX: %lu commands, %lu CTS polls, max %u, %u timeouts\n", trace.command_count,
+            trace.cts_poll_count, trace.cts_poll_max, trace.cts_timeout_count);
 #endif
 
-    shared_state->radio_transmission_finished = true;
+    radio_shared_state.radio_interrupt_transmit_active = false;
+    radio_shared_state.radio_transmission_finished = true;
 }
 
-void radio_handle_main_loop_si4063(radio_transmit_entry *entry, radio_module_state *shared_state)
+static void radio_si4063_handle_fifo_poll()
 {
-    if (entry->radio_type != RADIO_TYPE_SI4063 || shared_state->radio_interrupt_transmit_active || shared_state->radio_transmission_finished) {
+    if (radio_si4063_fifo_remaining > 0) {
+        uint16_t written = si4063_refill_buffer(radio_si4063_fifo_data, radio_si4063_fifo_remaining);
+        radio_si4063_fifo_data += written;
+        radio_si4063_fifo_remaining -= written;
+
+        if (si4063_fifo_underflow()) {
+            log_info("FIFO underflow - Aborting\n");
+            radio_si4063_finish_fifo_transmit();
+            return;
+        }
+    } else if (si4063_is_tx_complete()) {
+        radio_si4063_finish_fifo_transmit();
         return;
     }
 
-    if (shared_state->radio_manual_transmit_active) {
-        radio_handle_main_loop_manual_si4063(entry, shared_state);
+    if (radio_si4063_fifo_timeout_ticks == 0) {
+        // Force the radio to sleep
+        si4063_disable_tx();
+        log_error("ERROR: Si4063 FIFO TX timeout\n");
+        radio_si4063_finish_fifo_transmit();
+    }
+}
+
+void radio_handle_main_loop_si4063(radio_transmit_entry *entry, radio_module_state *shared_state)
+{
+    if (entry->radio_type != RADIO_TYPE_SI4063 || shared_state->radio_transmission_finished) {
         return;
     }
 
     if (shared_state->radio_fifo_transmit_active) {
-        radio_handle_fifo_si4063(entry, shared_state);
+        if (shared_state->radio_interrupt_transmit_active && radio_si4063_fifo_poll_pending) {
+            radio_si4063_fifo_poll_pending = false;
+            radio_si4063_handle_fifo_poll();
+        }
+        return;
+    }
+
+    if (shared_state->radio_interrupt_transmit_active) {
+        return;
+    }
+
+    if (shared_state->radio_manual_transmit_active) {
+        radio_handle_main_loop_manual_si4063(entry, shared_state);
         return;
     }
 
@@ -379,11 +423,9 @@ inline void radio_handle_data_timer_si4063()
 
             cw_symbol_rate_multiplier = CW_SYMBOL_RATE_MULTIPLIER;
 
-            fsk_encoder_api *fsk_encoder_api = radio_current_transmit_entry->fsk_encoder_api;
-            fsk_encoder *fsk_enc = &radio_current_transmit_entry->fsk_encoder;
             int8_t tone_index;
 
-            tone_index = fsk_encoder_api->next_tone(fsk_enc);
+            tone_index = radio_next_tone(radio_current_transmit_entry, &radio_shared_state);
             if (tone_index < 0) {
                 si4063_set_direct_mode_pin(false);
                 #ifdef RADIO_LOGGING_ENABLE
@@ -402,11 +444,9 @@ inline void radio_handle_data_timer_si4063()
         }
         case RADIO_DATA_MODE_HORUS_V2:
         case RADIO_DATA_MODE_HORUS_V3: {
-            fsk_encoder_api *fsk_encoder_api = radio_current_transmit_entry->fsk_encoder_api;
-            fsk_encoder *fsk_enc = &radio_current_transmit_entry->fsk_encoder;
             int8_t tone_index;
 
-            tone_index = fsk_encoder_api->next_tone(fsk_enc);
+            tone_index = radio_next_tone(radio_current_transmit_entry, &radio_shared_state);
             if (tone_index < 0) {
                 #ifdef RADIO_LOGGING_ENABLE
                 log_info("Horus TX finished\n");
@@ -423,6 +463,14 @@ inline void radio_handle_data_timer_si4063()
             radio_shared_state.radio_symbol_count_interrupt++;
             break;
         }
+        case RADIO_DATA_MODE_CATS:
+        case RADIO_DATA_MODE_APRS_9600:
+            // The FIFO is serviced from the main loop
+            if (radio_si4063_fifo_timeout_ticks > 0) {
+                radio_si4063_fifo_timeout_ticks--;
+            }
+            radio_si4063_fifo_poll_pending = true;
+            break;
         default:
             break;
     }
@@ -445,10 +493,9 @@ bool radio_stop_transmit_si4063(radio_transmit_entry *entry, radio_module_state
         case RADIO_DATA_MODE_RTTY:
         case RADIO_DATA_MODE_HORUS_V2:
         case RADIO_DATA_MODE_HORUS_V3:
-            data_timer_uninit();
-            break;
         case RADIO_DATA_MODE_CATS:
         case RADIO_DATA_MODE_APRS_9600:
+            data_timer_uninit();
             break;
         case RADIO_DATA_MODE_APRS_1200:
             use_direct_mode = true;
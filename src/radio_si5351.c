@@ -10,7 +10,22 @@
 
 static volatile bool radio_si5351_state_change = false;
 static volatile uint64_t radio_si5351_freq = 0;
-static volatile bool radio_si5351_frequency_not_set = false;
+static bool radio_si5351_frequency_not_set = false;
+static bool radio_si5351_tone_table_active = false;
+
+/**
+ * With the tone table and the I²C request queue, the data timer interrupt submits the register bytes of each
+ * Horus tone to the queue itself, so that the tone switches keep the timing of the interrupt.
+ * Otherwise (CW, or Horus without the tone table) the interrupt only picks the next tone and the main loop,
+ * which spins during the transmission, writes it to the Si5351: the blocking I²C transfers are not allowed
+ * in interrupt context. The sequence tells the main loop that a new tone has been picked, and how many it has
+ * missed. Missed tones were never transmitted, which is counted as an error in both cases.
+ */
+static bool radio_si5351_tone_queue_active = false;
+static volatile int8_t radio_si5351_tone_index = 0;
+static volatile uint32_t radio_si5351_tone_sequence = 0;
+static uint32_t radio_si5351_tone_sequence_written = 0;
+static volatile uint32_t radio_si5351_tone_skip_count = 0;
 
 bool radio_start_transmit_si5351(radio_transmit_entry *entry, radio_module_state *shared_state)
 {
@@ -39,6 +54,11 @@ bool radio_start_transmit_si5351(radio_transmit_entry *entry, radio_module_state
         si5351_output_enable(SI5351_CLOCK_CLK0, true);
     }
 
+    radio_si5351_tone_table_active = false;
+    radio_si5351_tone_queue_active = false;
+    radio_si5351_tone_sequence_written = radio_si5351_tone_sequence;
+    radio_si5351_tone_skip_count = 0;
+
     switch (entry->data_mode) {
         case RADIO_DATA_MODE_CW:
         case RADIO_DATA_MODE_PIP:
@@ -49,6 +69,11 @@ bool radio_start_transmit_si5351(radio_transmit_entry *entry, radio_module_state
             break;
         case RADIO_DATA_MODE_HORUS_V2:
         case RADIO_DATA_MODE_HORUS_V3:
+            // Precalculate the tone registers, so that the data timer interrupt only writes the changed bytes
+            radio_si5351_tone_table_active = si5351_set_tone_table(SI5351_CLOCK_CLK0,
+                    ((uint64_t) entry->frequency) * 100ULL, shared_state->radio_current_tone_spacing_hz_100,
+                    shared_state->radio_current_fsk_tone_count);
+            radio_si5351_tone_queue_active = I2C_QUEUE_ENABLE && radio_si5351_tone_table_active;
             // system_disable_tick();
             shared_state->radio_interrupt_transmit_active = true;
             break;
@@ -68,7 +93,7 @@ bool radio_transmit_symbol_si5351(radio_transmit_entry *entry, radio_module_stat
         case RADIO_DATA_MODE_HORUS_V3:
             return false;
         default: {
-            int8_t next_tone_index = entry->fsk_encoder_api->next_tone(&entry->fsk_encoder);
+            int8_t next_tone_index = radio_next_tone(entry, shared_state);
             if (next_tone_index < 0) {
                 return false;
             }
@@ -86,9 +111,57 @@ bool radio_transmit_symbol_si5351(radio_transmit_entry *entry, radio_module_stat
     return true;
 }
 
+static void radio_si5351_write_tone(radio_transmit_entry *entry, radio_module_state *shared_state, int8_t tone_index)
+{
+    bool success = true;
+
+    switch (entry->data_mode) {
+        case RADIO_DATA_MODE_CW:
+        case RADIO_DATA_MODE_PIP: {
+            bool enable = tone_index != 0;
+
+            if (enable && radio_si5351_frequency_not_set) {
+                success = si5351_set_frequency(SI5351_CLOCK_CLK0, ((uint64_t) entry->frequency) * 100ULL);
+                radio_si5351_frequency_not_set = false;
+            }
+            si5351_output_enable(SI5351_CLOCK_CLK0, enable);
+            break;
+        }
+        case RADIO_DATA_MODE_HORUS_V2:
+        case RADIO_DATA_MODE_HORUS_V3:
+            if (radio_si5351_tone_table_active) {
+                success = si5351_set_tone(tone_index);
+            } else {
+                uint64_t frequency =
+                        ((uint64_t) entry->frequency) * 100UL + (tone_index * shared_state->radio_current_tone_spacing_hz_100);
+
+                success = si5351_set_frequency(SI5351_CLOCK_CLK0, frequency);
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (!success) {
+        log_error("ERROR: Si5351 tone %d write failed\n", tone_index);
+    }
+}
+
 void radio_handle_main_loop_si5351(radio_transmit_entry *entry, radio_module_state *shared_state)
 {
-    if (entry->radio_type != RADIO_TYPE_SI5351 || shared_state->radio_interrupt_transmit_active) {
+    if (entry->radio_type != RADIO_TYPE_SI5351) {
+        return;
+    }
+
+    // Also after the last symbol, which ends the transmission before the tone it picked has been written
+    uint32_t tone_sequence = radio_si5351_tone_sequence;
+    if (tone_sequence != radio_si5351_tone_sequence_written) {
+        radio_si5351_tone_skip_count += tone_sequence - radio_si5351_tone_sequence_written - 1;
+        radio_si5351_tone_sequence_written = tone_sequence;
+        radio_si5351_write_tone(entry, shared_state, radio_si5351_tone_index);
+    }
+
+    if (shared_state->radio_interrupt_transmit_active) {
         return;
     }
 
@@ -107,7 +180,6 @@ inline void radio_handle_data_timer_si5351()
         return;
     }
 
-    // TODO: handle Si5351 errors
     switch (radio_current_transmit_entry->data_mode) {
         case RADIO_DATA_MODE_CW:
         case RADIO_DATA_MODE_PIP: {
@@ -118,13 +190,11 @@ inline void radio_handle_data_timer_si5351()
 
             cw_symbol_rate_multiplier = CW_SYMBOL_RATE_MULTIPLIER;
 
-            fsk_encoder_api *fsk_encoder_api = radio_current_transmit_entry->fsk_encoder_api;
-            fsk_encoder *fsk_enc = &radio_current_transmit_entry->fsk_encoder;
             int8_t tone_index;
 
-            tone_index = fsk_encoder_api->next_tone(fsk_enc);
+            tone_index = radio_next_tone(radio_current_transmit_entry, &radio_shared_state);
             if (tone_index < 0) {
-                si5351_output_enable(SI5351_CLOCK_CLK0, false);
+                // radio_stop_transmit_si5351() turns off the output
                 #ifdef RADIO_LOGGING_ENABLE
                 log_info("CW TX finished\n");
                 #endif
@@ -134,24 +204,17 @@ inline void radio_handle_data_timer_si5351()
                 break;
             }
 
-            bool enable = tone_index != 0;
-
-            if (enable && radio_si5351_frequency_not_set) {
-                si5351_set_frequency(SI5351_CLOCK_CLK0, ((uint64_t) radio_current_transmit_entry->frequency) * 100ULL);
-                radio_si5351_frequency_not_set = false;
-            }
-            si5351_output_enable(SI5351_CLOCK_CLK0, enable);
+            radio_si5351_tone_index = tone_index;
+            radio_si5351_tone_sequence++;
 
             radio_shared_state.radio_symbol_count_interrupt++;
             break;
         }
         case RADIO_DATA_MODE_HORUS_V2:
         case RADIO_DATA_MODE_HORUS_V3: {
-            fsk_encoder_api *fsk_encoder_api = radio_current_transmit_entry->fsk_encoder_api;
-            fsk_encoder *fsk_enc = &radio_current_transmit_entry->fsk_encoder;
             int8_t tone_index;
 
-            tone_index = fsk_encoder_api->next_tone(fsk_enc);
+            tone_index = radio_next_tone(radio_current_transmit_entry, &radio_shared_state);
             if (tone_index < 0) {
                 #ifdef RADIO_LOGGING_ENABLE
                 log_info("Horus TX finished\n");
@@ -162,10 +225,14 @@ inline void radio_handle_data_timer_si5351()
                 break;
             }
 
-            uint64_t frequency =
-                    ((uint64_t) radio_current_transmit_entry->frequency) * 100UL + (tone_index * radio_shared_state.radio_current_tone_spacing_hz_100);
-
-            si5351_set_frequency(SI5351_CLOCK_CLK0, frequency);
+            if (radio_si5351_tone_queue_active) {
+                if (!si5351_queue_tone(tone_index)) {
+                    radio_si5351_tone_skip_count++;
+                }
+            } else {
+                radio_si5351_tone_index = tone_index;
+                radio_si5351_tone_sequence++;
+            }
 
             radio_shared_state.radio_symbol_count_interrupt++;
             break;
@@ -179,6 +246,10 @@ bool radio_stop_transmit_si5351(radio_transmit_entry *entry, radio_module_state
 {
     si5351_output_enable(SI5351_CLOCK_CLK0, false);
 
+    if (radio_si5351_tone_skip_count > 0) {
+        log_error("ERROR: Si5351 skipped %lu tones\n", (unsigned long) radio_si5351_tone_skip_count);
+    }
+
     switch (entry->data_mode) {
         case RADIO_DATA_MODE_CW:
         case RADIO_DATA_MODE_PIP:
@@ -0,0 +1,105 @@
+#include "config.h"
+#include "log.h"
+#include "radio_time_sync.h"
+
+// Time of week range in which no time-synced entry can fire: until_millis is the earliest next slot window
+// of all entries, computed when the schedule was last scanned at from_millis
+static uint32_t radio_time_sync_idle_from_millis = 0;
+static uint32_t radio_time_sync_idle_until_millis = 0;
+
+void radio_time_sync_check(radio_transmit_entry *entry, uint32_t time_millis, radio_time_sync_result *result)
+{
+    uint32_t offset_millis = entry->time_sync_seconds_offset * 1000;
+
+    if (time_millis < offset_millis) {
+        result->slot = 0;
+        result->slot_millis = 0;
+        result->next_millis = offset_millis;
+        result->ready = false;
+        return;
+    }
+
+    uint32_t period_millis = entry->time_sync_seconds * 1000;
+    uint32_t time_with_offset_millis = time_millis - offset_millis;
+
+    result->slot = time_with_offset_millis / period_millis;
+    result->slot_millis = time_with_offset_millis - result->slot * period_millis;
+
+    // The slot is constant across the whole tolerance window (RADIO_TIME_SYNC_THRESHOLD_MS) and increments
+    // once per period. Dedup on it so the entry fires exactly once per period, no matter how many GPS
+    // measurements land inside the window.
+    result->ready = result->slot != entry->last_tx_slot && result->slot_millis < RADIO_TIME_SYNC_THRESHOLD_MS;
+
+    if (result->ready) {
+        result->next_millis = time_millis;
+        return;
+    }
+
+    // For the rest of the slot, the entry has either fired already or missed the window
+    uint32_t slot_end_millis = time_millis - result->slot_millis + period_millis;
+    result->next_millis = slot_end_millis < time_millis ? UINT32_MAX : slot_end_millis;
+}
+
+/**
+ * Find a time-synced entry whose slot window is open and mark the slot as serviced.
+ *
+ * The entries are only scanned when the time leaves the range in which none of them can fire, that is,
+ * once the earliest next slot window opens or the time of week jumps back (week rollover or a leap second
+ * change). All other calls return without a single division.
+ */
+radio_transmit_entry *radio_time_sync_find_ready_entry(radio_transmit_entry *entries, uint8_t entry_count,
+        uint32_t time_millis)
+{
+    if (time_millis >= radio_time_sync_idle_from_millis && time_millis < radio_time_sync_idle_until_millis) {
+        return NULL;
+    }
+
+    uint32_t next_millis = UINT32_MAX;
+
+    for (uint8_t i = 0; i < entry_count; i++) {
+        radio_transmit_entry *entry = &entries[i];
+        if (entry->time_sync_seconds == 0) continue;
+
+        radio_time_sync_result sync;
+        radio_time_sync_check(entry, time_millis, &sync);
+
+        if (entry->enabled && sync.ready) {
+            log_info("Time: %lu, sync: %lu - Schedule TX at %ds offset %d\n",
+                    time_millis, sync.slot_millis,
+                    entry->time_sync_seconds, entry->time_sync_seconds_offset);
+
+            entry->last_tx_slot = sync.slot;
+            radio_time_sync_reset();
+            return entry;
+        }
+
+        // Disabled entries limit the range too, as they may get enabled before it ends
+        if (sync.next_millis < next_millis) {
+            next_millis = sync.next_millis;
+        }
+    }
+
+    radio_time_sync_idle_from_millis = time_millis;
+    radio_time_sync_idle_until_millis = next_millis;
+
+    return NULL;
+}
+
+void radio_time_sync_reset()
+{
+    radio_time_sync_idle_from_millis = 0;
+    radio_time_sync_idle_until_millis = 0;
+}
+
+/**
+ * Time until the earliest next slot window of the time-synced entries, as of the last scan of the schedule,
+ * or UINT32_MAX if the schedule has not been scanned for this time. Entries that are disabled are included.
+ */
+uint32_t radio_time_sync_millis_until_next(uint32_t time_millis)
+{
+    if (time_millis < radio_time_sync_idle_from_millis || time_millis >= radio_time_sync_idle_until_millis) {
+        return UINT32_MAX;
+    }
+
+    return radio_time_sync_idle_until_millis - time_millis;
+}
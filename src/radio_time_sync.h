@@ -0,0 +1,30 @@
+#ifndef __RADIO_TIME_SYNC_H
+#define __RADIO_TIME_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "radio_internal.h"
+
+/**
+ * Slot of a time-synced transmit entry at a given GPS time of week (with leap seconds applied).
+ *
+ * Slot N starts at time_sync_seconds_offset + N * time_sync_seconds and the entry fires once per slot,
+ * less than RADIO_TIME_SYNC_THRESHOLD_MS after the slot start.
+ */
+typedef struct _radio_time_sync_result {
+    uint32_t slot;
+    uint32_t slot_millis;
+    // Earliest time the entry may fire at, if it is not ready now
+    uint32_t next_millis;
+    bool ready;
+} radio_time_sync_result;
+
+void radio_time_sync_check(radio_transmit_entry *entry, uint32_t time_millis, radio_time_sync_result *result);
+
+radio_transmit_entry *radio_time_sync_find_ready_entry(radio_transmit_entry *entries, uint8_t entry_count,
+        uint32_t time_millis);
+void radio_time_sync_reset();
+uint32_t radio_time_sync_millis_until_next(uint32_t time_millis);
+
+#endif
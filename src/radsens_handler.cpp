@@ -2,12 +2,21 @@
 #include "drivers/radsens/radsens.h"
 #include "radsens_handler.h"
 #include "drivers/hal/delay.h"
+#include "drivers/hal/i2c_queue.h"
 #include "log.h"
 
 RadSens *radsens = NULL;
 
 static bool radsens_initialization_required = true;
 
+#if I2C_QUEUE_ENABLE
+static uint8_t radsens_pulse_counter_buffer[2];
+static uint8_t radsens_intensity_buffer[3];
+static i2c_request radsens_pulse_counter_request;
+static i2c_request radsens_intensity_request;
+static telemetry_request_callback radsens_request_callback;
+#endif
+
 static bool radsens_handler_init_sensor();
 
 bool radsens_handler_init()
@@ -179,3 +188,84 @@ bool radsens_read_telemetry(telemetry_data *data)
 
     return success;
 }
+
+#if I2C_QUEUE_ENABLE
+static void radsens_pulse_counter_request_complete(i2c_request *request)
+{
+    telemetry_data *data = (telemetry_data *) request->context;
+
+    if (request->status != HAL_OK) {
+        log_error("Failed to read RadSens pulse counter\n");
+        radsens_initialization_required = true;
+        // The intensity read queued after it completes the request
+        return;
+    }
+
+    radsens->addPulses(request->data);
+    data->pulse_count = (uint16_t) (radsens->getAccumulatedPulses() % 0x10000);
+}
+
+static void radsens_intensity_request_complete(i2c_request *request)
+{
+    telemetry_data *data = (telemetry_data *) request->context;
+
+    if (request->status != HAL_OK) {
+        log_error("Failed to read RadSens dynamic radiation intensity\n");
+        radsens_initialization_required = true;
+    } else {
+        data->radiation_intensity_uR_h = RadSens::toRadIntensity(request->data);
+    }
+
+    radsens_request_callback();
+}
+
+static bool radsens_submit(i2c_request *request, uint8_t reg, uint8_t *buffer, uint8_t size,
+        i2c_request_callback callback, telemetry_data *data)
+{
+    request->port = &DEFAULT_I2C_PORT;
+    request->address = SENSOR_RADSENS_I2C_ADDRESS;
+    request->reg = reg;
+    request->size = size;
+    request->data = buffer;
+    request->write = false;
+    request->timeout_ms = I2C_QUEUE_REQUEST_TIMEOUT_MS;
+    request->callback = callback;
+    request->context = data;
+
+    return i2c_queue_submit(request);
+}
+
+/**
+ * Queue reads of the pulse counter and the dynamic radiation intensity. The telemetry data is updated when
+ * the transfers complete, after which the callback is called. Falls back to radsens_read_telemetry() while
+ * the sensor needs to be re-initialized, calling the callback before returning, as it does when the reads
+ * cannot be queued.
+ */
+bool radsens_request_telemetry(telemetry_data *data, telemetry_request_callback callback)
+{
+    if (radsens_initialization_required) {
+        bool success = radsens_read_telemetry(data);
+        callback();
+        return success;
+    }
+
+    // Still in flight from an earlier call
+    if (radsens_pulse_counter_request.state != I2C_REQUEST_STATE_IDLE
+        || radsens_intensity_request.state != I2C_REQUEST_STATE_IDLE) {
+        callback();
+        return false;
+    }
+
+    radsens_request_callback = callback;
+
+    // Any I²C command seems to reset the pulse counter, so it is queued first. The queue runs the requests in order
+    // and both are idle, so they are both accepted and the intensity read completes last.
+    radsens_submit(&radsens_pulse_counter_request, RS_REG_PULSE_COUNTER,
+            radsens_pulse_counter_buffer, sizeof(radsens_pulse_counter_buffer),
+            radsens_pulse_counter_request_complete, data);
+
+    return radsens_submit(&radsens_intensity_request, RS_REG_RAD_INTENSITY_DYNAMIC,
+            radsens_intensity_buffer, sizeof(radsens_intensity_buffer),
+            radsens_intensity_request_complete, data);
+}
+#endif
@@ -11,6 +11,7 @@ extern "C" {
 bool radsens_handler_init();
 bool radsens_read(uint16_t *pulse_count, float *dynamic_intensity, float *static_intensity);
 bool radsens_read_telemetry(telemetry_data *data);
+bool radsens_request_telemetry(telemetry_data *data, telemetry_request_callback callback);
 
 #ifdef __cplusplus
 }
@@ -6,6 +6,9 @@
 #include "drivers/si5351/si5351.h"
 #endif
 #include "si5351_handler.h"
+#if I2C_QUEUE_ENABLE
+#include "drivers/hal/i2c_queue.h"
+#endif
 
 #if SI5351_FAST_ENABLE
 Si5351mcu si5351_fast;
@@ -13,6 +16,8 @@ Si5351mcu si5351_fast;
 Si5351 *si5351;
 #endif
 
+#define SI5351_TONE_COUNT_MAX 16
+
 #if SI5351_FAST_ENABLE
 bool si5351_handler_init()
 {
@@ -35,6 +40,23 @@ void si5351_output_enable(si5351_clock_id clock, bool enabled)
     }
 }
 
+bool si5351_set_tone_table(si5351_clock_id clock, uint64_t frequency_hz_100, uint32_t tone_spacing_hz_100,
+        uint8_t tone_count)
+{
+    // The fast driver keeps its own divider state, tones go through si5351_set_frequency()
+    return false;
+}
+
+bool si5351_set_tone(uint8_t tone_index)
+{
+    return false;
+}
+
+bool si5351_queue_tone(uint8_t tone_index)
+{
+    return false;
+}
+
 void si5351_set_drive_strength(si5351_clock_id clock, uint8_t drive)
 {
     int si5351_drive;
@@ -59,6 +81,57 @@ void si5351_set_drive_strength(si5351_clock_id clock, uint8_t drive)
     si5351_fast.setPower(si5351_drive, (uint8_t) clock);
 }
 #else
+/**
+ * Tone table: the multisynth registers of every MFSK tone are calculated once at TX start. Switching tones then
+ * only writes the register bytes that differ from the current tone (usually the P2 bytes) in one I2C burst,
+ * instead of recalculating the dividers and doing the read-modify-write cycles of Si5351::set_freq().
+ */
+#if SI5351_TONE_TABLE_ENABLE
+static uint8_t si5351_tone_registers[SI5351_TONE_COUNT_MAX][SI5351_MS_PARAMETER_COUNT];
+static uint8_t si5351_tone_count = 0;
+static uint8_t si5351_tone_current = 0;
+static si5351_clock_id si5351_tone_clock = SI5351_CLOCK_CLK0;
+
+#if I2C_QUEUE_ENABLE
+// Tone writes submitted from the data timer interrupt. The request has no callback: it is idle again as soon as
+// the write has ended, and its status tells the next tone switch whether the chip got the previous tone.
+static i2c_request si5351_tone_request;
+#endif
+
+/**
+ * Find the tone register bytes to write for switching to a tone: the range that differs from the current tone,
+ * or all of them if the last queued write failed and left the chip with an unknown mix of two tones.
+ * Returns the number of bytes, zero for tones closer than the multisynth resolution.
+ */
+static uint8_t si5351_tone_changes(uint8_t tone_index, uint8_t *first)
+{
+    uint8_t *current = si5351_tone_registers[si5351_tone_current];
+    uint8_t *next = si5351_tone_registers[tone_index];
+
+#if I2C_QUEUE_ENABLE
+    if (si5351_tone_request.status != HAL_OK) {
+        *first = 0;
+        return SI5351_MS_PARAMETER_COUNT;
+    }
+#endif
+
+    uint8_t start = 0;
+    while (start < SI5351_MS_PARAMETER_COUNT && current[start] == next[start]) {
+        start++;
+    }
+    if (start == SI5351_MS_PARAMETER_COUNT) {
+        return 0;
+    }
+    uint8_t last = SI5351_MS_PARAMETER_COUNT - 1;
+    while (current[last] == next[last]) {
+        last--;
+    }
+
+    *first = start;
+    return last - start + 1;
+}
+#endif
+
 bool si5351_handler_init()
 {
     si5351 = new Si5351(&DEFAULT_I2C_PORT);
@@ -104,4 +177,114 @@ void si5351_set_drive_strength(si5351_clock_id clock, uint8_t drive)
 
     si5351->drive_strength((enum si5351_clock) clock, si5351_drive);
 }
+bool si5351_set_tone_table(si5351_clock_id clock, uint64_t frequency_hz_100, uint32_t tone_spacing_hz_100,
+        uint8_t tone_count)
+{
+#if SI5351_TONE_TABLE_ENABLE
+    si5351_tone_count = 0;
+
+    uint64_t highest_frequency_hz_100 = frequency_hz_100 + (uint64_t) (tone_count - 1) * tone_spacing_hz_100;
+    if (tone_count == 0 || tone_count > SI5351_TONE_COUNT_MAX || clock > SI5351_CLOCK_CLK5
+        || frequency_hz_100 < SI5351_CLKOUT_MIN_FREQ * SI5351_FREQ_MULT
+        || highest_frequency_hz_100 > SI5351_MULTISYNTH_SHARE_MAX * SI5351_FREQ_MULT) {
+        return false;
+    }
+
+    // Leaves the output running at the first tone with its R divider and integer mode settings
+    if (!si5351_set_frequency(clock, frequency_hz_100)) {
+        return false;
+    }
+
+    uint8_t r_div = 0;
+    for (uint8_t i = 0; i < tone_count; i++) {
+        uint8_t tone_r_div = si5351->calc_ms_params(frequency_hz_100 + (uint64_t) i * tone_spacing_hz_100,
+                (enum si5351_clock) clock, si5351_tone_registers[i]);
+        if (i == 0) {
+            r_div = tone_r_div;
+        } else if (tone_r_div != r_div) {
+            // The tones span an R divider boundary
+            return false;
+        }
+    }
+
+    si5351_tone_clock = clock;
+    si5351_tone_current = 0;
+    si5351_tone_count = tone_count;
+#if I2C_QUEUE_ENABLE
+    // si5351_set_frequency() has written all registers of the first tone
+    if (si5351_tone_request.state == I2C_REQUEST_STATE_IDLE) {
+        si5351_tone_request.status = HAL_OK;
+    }
+#endif
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool si5351_set_tone(uint8_t tone_index)
+{
+#if SI5351_TONE_TABLE_ENABLE
+    if (tone_index >= si5351_tone_count) {
+        return false;
+    }
+
+    uint8_t first = 0;
+    uint8_t size = si5351_tone_changes(tone_index, &first);
+    if (size > 0 && si5351->si5351_write_bulk(SI5351_CLK0_PARAMETERS + (si5351_tone_clock * 8) + first, size,
+            &si5351_tone_registers[tone_index][first]) != 0) {
+        return false;
+    }
+
+#if I2C_QUEUE_ENABLE
+    if (si5351_tone_request.state == I2C_REQUEST_STATE_IDLE) {
+        si5351_tone_request.status = HAL_OK;
+    }
+#endif
+    si5351_tone_current = tone_index;
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Switch tones without waiting for the I²C transfer: the changed register bytes are submitted to the request queue,
+ * which starts the write right away if the bus is free. For the data timer interrupt.
+ * Fails if the write of the previous tone has not ended yet, in which case this tone is not transmitted.
+ */
+bool si5351_queue_tone(uint8_t tone_index)
+{
+#if SI5351_TONE_TABLE_ENABLE && I2C_QUEUE_ENABLE
+    if (tone_index >= si5351_tone_count || si5351_tone_request.state != I2C_REQUEST_STATE_IDLE) {
+        return false;
+    }
+
+    uint8_t first = 0;
+    uint8_t size = si5351_tone_changes(tone_index, &first);
+    if (size == 0) {
+        si5351_tone_current = tone_index;
+        return true;
+    }
+
+    si5351_tone_request.port = &DEFAULT_I2C_PORT;
+    si5351_tone_request.address = SI5351_BUS_BASE_ADDR;
+    si5351_tone_request.reg = SI5351_CLK0_PARAMETERS + (si5351_tone_clock * 8) + first;
+    si5351_tone_request.size = size;
+    si5351_tone_request.data = &si5351_tone_registers[tone_index][first];
+    si5351_tone_request.write = true;
+    si5351_tone_request.timeout_ms = I2C_QUEUE_REQUEST_TIMEOUT_MS;
+    si5351_tone_request.callback = NULL;
+
+    if (!i2c_queue_submit(&si5351_tone_request)) {
+        return false;
+    }
+
+    si5351_tone_current = tone_index;
+    return true;
+#else
+    return false;
+#endif
+}
 #endif
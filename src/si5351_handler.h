@@ -23,6 +23,10 @@ bool si5351_handler_init();
 bool si5351_set_frequency(si5351_clock_id clock, uint64_t frequency_hz_100);
 void si5351_output_enable(si5351_clock_id clock, bool enabled);
 void si5351_set_drive_strength(si5351_clock_id clock, uint8_t drive);
+bool si5351_set_tone_table(si5351_clock_id clock, uint64_t frequency_hz_100, uint32_t tone_spacing_hz_100,
+        uint8_t tone_count);
+bool si5351_set_tone(uint8_t tone_index);
+bool si5351_queue_tone(uint8_t tone_index);
 
 #ifdef __cplusplus
 }
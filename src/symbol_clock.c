@@ -0,0 +1,44 @@
+#include "symbol_clock.h"
+
+// Longest period: 65535 ticks, so that adding it to the fraction of the accumulator cannot overflow
+#define SYMBOL_CLOCK_MAX_PERIOD_Q16 0xFFFF0000U
+
+static void symbol_clock_init(symbol_clock *clock, uint64_t period_q16)
+{
+    clock->nominal_period_q16 = period_q16 > SYMBOL_CLOCK_MAX_PERIOD_Q16
+            ? SYMBOL_CLOCK_MAX_PERIOD_Q16 : (uint32_t) period_q16;
+    clock->period_q16 = clock->nominal_period_q16;
+    clock->clock_error_ppb = 0;
+    clock->phase_q16 = 0;
+}
+
+void symbol_clock_init_rate(symbol_clock *clock, uint32_t ticks_per_second, uint32_t symbol_rate)
+{
+    symbol_clock_init(clock, ((uint64_t) ticks_per_second << SYMBOL_CLOCK_FRACTION_BITS) / symbol_rate);
+}
+
+void symbol_clock_init_delay(symbol_clock *clock, uint32_t ticks_per_second, uint32_t symbol_delay_ms_100)
+{
+    symbol_clock_init(clock,
+            (((uint64_t) symbol_delay_ms_100 * ticks_per_second) << SYMBOL_CLOCK_FRACTION_BITS) / 100000U);
+}
+
+/**
+ * Returns the number of timer ticks until the next symbol. A fast MCU clock counts more ticks in the same time,
+ * so the period is lengthened by the clock error. The correction is recalculated only when the error changes.
+ */
+uint32_t symbol_clock_next(symbol_clock *clock, int32_t clock_error_ppb)
+{
+    if (clock_error_ppb != clock->clock_error_ppb) {
+        int64_t correction = (int64_t) clock->nominal_period_q16 * clock_error_ppb / 1000000000;
+        int64_t period = (int64_t) clock->nominal_period_q16 + correction;
+        clock->period_q16 = period > SYMBOL_CLOCK_MAX_PERIOD_Q16 ? SYMBOL_CLOCK_MAX_PERIOD_Q16 : (uint32_t) period;
+        clock->clock_error_ppb = clock_error_ppb;
+    }
+
+    // Only the fraction is kept in the accumulator
+    uint32_t phase = clock->phase_q16 + clock->period_q16;
+    clock->phase_q16 = phase & ((1U << SYMBOL_CLOCK_FRACTION_BITS) - 1U);
+
+    return phase >> SYMBOL_CLOCK_FRACTION_BITS;
+}
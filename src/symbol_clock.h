@@ -0,0 +1,46 @@
+#ifndef __SYMBOL_CLOCK_H
+#define __SYMBOL_CLOCK_H
+
+#include <stdint.h>
+
+/**
+ * Symbol clock counting timer ticks with a Q16 phase accumulator.
+ *
+ * The symbol period is kept in timer ticks with 16 fractional bits. Each symbol lasts the whole ticks of the
+ * accumulated phase and carries the fraction over to the next one, so the symbol edges stay within one tick of
+ * the exact time over any number of symbols. The period is corrected for the error of the MCU clock measured
+ * against GPS time, so that the symbols follow GPS time instead of the MCU oscillator. Periods up to 65535 ticks
+ * are supported.
+ */
+
+#define SYMBOL_CLOCK_FRACTION_BITS 16
+
+// Averaging of the timepulse error: each new measurement moves the clock error by 1 / (1 << shift)
+#define SYMBOL_CLOCK_ERROR_FILTER_SHIFT 3
+
+typedef struct _symbol_clock {
+    // Symbol period in timer ticks (Q16) at the nominal MCU clock frequency
+    uint32_t nominal_period_q16;
+    // Symbol period in timer ticks (Q16) corrected for the MCU clock error
+    uint32_t period_q16;
+    // MCU clock error the period was corrected for, in parts per billion
+    int32_t clock_error_ppb;
+    // Fraction of a tick accumulated over the previous symbols (Q16)
+    uint32_t phase_q16;
+} symbol_clock;
+
+void symbol_clock_init_rate(symbol_clock *clock, uint32_t ticks_per_second, uint32_t symbol_rate);
+void symbol_clock_init_delay(symbol_clock *clock, uint32_t ticks_per_second, uint32_t symbol_delay_ms_100);
+uint32_t symbol_clock_next(symbol_clock *clock, int32_t clock_error_ppb);
+
+/**
+ * Averages the GPS timepulse measurements of the MCU clock error. The timepulse error is the number of
+ * 1 MHz timer ticks counted over one GPS second minus 1000000, which is the clock error in ppm.
+ * Returns the new clock error in parts per billion, positive when the MCU clock is fast.
+ */
+static inline int32_t symbol_clock_filter_clock_error(int32_t clock_error_ppb, int32_t timepulse_error_us)
+{
+    return clock_error_ppb + ((timepulse_error_us * 1000 - clock_error_ppb) >> SYMBOL_CLOCK_ERROR_FILTER_SHIFT);
+}
+
+#endif
@@ -1,5 +1,9 @@
+#include <string.h>
+
 #include "telemetry.h"
 #include "drivers/hal/system.h"
+#include "drivers/hal/i2c_queue.h"
+#include "drivers/hal/delay.h"
 #include "drivers/gps/gps_driver.h"
 #include "drivers/pulse_counter/pulse_counter.h"
 #include "bmp280_handler.h"
@@ -29,23 +33,134 @@ int8_t gps_time_leap_seconds = GPS_TIME_LEAP_SECONDS;
 static bool gps_power_saving_enabled = false;
 #endif
 
-void telemetry_collect(telemetry_data *data)
+static void telemetry_read_power(telemetry_data *data)
 {
-    log_info("Collecting telemetry...\n");
-
+    // The ADC values are sampled continuously by DMA
     data->button_adc_value = system_get_button_adc_value();
     data->battery_voltage_millivolts = system_get_battery_voltage_millivolts();
     log_info("Battery voltage: %u mV\n", data->battery_voltage_millivolts);
+#ifdef DFM17
+    data->current_milliamps = system_get_current_milliamps();
+    if(data->current_milliamps > 0)
+        log_info("Current: %u mA\n", data->current_milliamps);
+#endif
+
+#if PULSE_COUNTER_ENABLE
+    data->pulse_count = pulse_counter_get_count();
+#endif
+}
+
+static void telemetry_read_radio_temperature(telemetry_data *data)
+{
 #ifdef RS41
     data->internal_temperature_celsius_100 = si4032_read_temperature_celsius_100();
 #endif
 #ifdef DFM17
     data->internal_temperature_celsius_100 = si4063_read_temperature_celsius_100();
-    data->current_milliamps = system_get_current_milliamps();
-    if(data->current_milliamps > 0)
-        log_info("Current: %u mA\n", data->current_milliamps);
 #endif
+}
+
+static inline uint32_t telemetry_max_ms(uint32_t a_ms, uint32_t b_ms)
+{
+    return a_ms > b_ms ? a_ms : b_ms;
+}
+
+/**
+ * Start the sensor measurements that take a while to convert (forced mode), so that the next read of the sensors
+ * does not have to wait for them. Returns the time in milliseconds until all of them are ready.
+ */
+static uint32_t telemetry_trigger_sensors()
+{
+    uint32_t ready_ms = 0;
 
+#if SENSOR_BMP280_ENABLE
+    ready_ms = telemetry_max_ms(ready_ms, bmp280_trigger_measurement());
+#endif
+
+#if SENSOR_BME68X_ENABLE
+    ready_ms = telemetry_max_ms(ready_ms, bme68x_trigger_measurement());
+#endif
+
+#if SENSOR_BME690_ENABLE
+    ready_ms = telemetry_max_ms(ready_ms, bme690_trigger_measurement());
+#endif
+
+    return ready_ms;
+}
+
+#if I2C_QUEUE_ENABLE
+static uint8_t telemetry_sensor_requests_pending = 0;
+static telemetry_request_callback telemetry_sensor_requests_callback;
+
+static void telemetry_sensor_request_complete()
+{
+    if (--telemetry_sensor_requests_pending == 0) {
+        telemetry_sensor_requests_callback();
+    }
+}
+
+/**
+ * Queue the sensor reads through the I2C request queue. Values are written to the data when the transfers complete,
+ * after the last of which the callback is called. Sensors that cannot be read through the queue at the moment
+ * are read synchronously.
+ */
+static void telemetry_request_sensor_reads(telemetry_data *data, telemetry_request_callback callback)
+{
+    // Held until all reads have been requested, as the ones that fall back to synchronous reads complete right away
+    telemetry_sensor_requests_pending = 1;
+    telemetry_sensor_requests_callback = callback;
+
+#if SENSOR_BMP280_ENABLE
+    telemetry_sensor_requests_pending++;
+    bmp280_request_telemetry(data, telemetry_sensor_request_complete);
+#endif
+
+#if SENSOR_BME68X_ENABLE
+    telemetry_sensor_requests_pending++;
+    bme68x_request_telemetry(data, telemetry_sensor_request_complete);
+#endif
+
+#if SENSOR_BME690_ENABLE
+    telemetry_sensor_requests_pending++;
+    bme690_request_telemetry(data, telemetry_sensor_request_complete);
+#endif
+
+#if SENSOR_RADSENS_ENABLE
+    telemetry_sensor_requests_pending++;
+    radsens_request_telemetry(data, telemetry_sensor_request_complete);
+#endif
+
+    telemetry_sensor_request_complete();
+}
+
+static bool telemetry_sensor_reads_active = false;
+
+static void telemetry_sensor_reads_complete()
+{
+    telemetry_sensor_reads_active = false;
+}
+#endif
+
+/**
+ * Read the sensors now. With the I2C request queue, the forced-mode measurements are started if needed and
+ * their data is read through the queue once they are ready, polling the queue until the reads have completed.
+ */
+static void telemetry_read_sensors(telemetry_data *data)
+{
+#if I2C_QUEUE_ENABLE
+    uint32_t ready_ms = telemetry_trigger_sensors();
+    if (ready_ms > 0) {
+        delay_ms(ready_ms);
+    }
+
+    telemetry_sensor_reads_active = true;
+    telemetry_request_sensor_reads(data, telemetry_sensor_reads_complete);
+
+    // The queue times out its transfers
+    while (telemetry_sensor_reads_active) {
+        i2c_queue_poll();
+    }
+#else
 #if SENSOR_BMP280_ENABLE
     bmp280_read_telemetry(data);
 #endif
@@ -61,11 +176,11 @@ void telemetry_collect(telemetry_data *data)
 #if SENSOR_RADSENS_ENABLE
     radsens_read_telemetry(data);
 #endif
-
-#if PULSE_COUNTER_ENABLE
-    data->pulse_count = pulse_counter_get_count();
 #endif
+}
 
+static void telemetry_read_gps(telemetry_data *data)
+{
     gps_driver_get_current_gps_data(&data->gps);
 
     // RS41 RSM4X4 can enable power saving immediately
@@ -99,7 +214,10 @@ void telemetry_collect(telemetry_data *data)
         data->gps.heading_degrees_100000 = 0;
         data->gps.climb_cm_per_second = 0;
     }
+}
 
+static void telemetry_read_clock_calibration(telemetry_data *data)
+{
     #ifdef DFM17
         data->cap_trim_offset = clock_calibration_get_cap_trim_offset();
         data->timepulse_error_us = clock_calibration_get_us_error();
@@ -126,7 +244,20 @@ void telemetry_collect(telemetry_data *data)
 
         data->si4063_capacitance_trim = (uint8_t)cap_adjusted;
     #endif
+#else
+    (void) data;
 #endif
+}
+
+void telemetry_collect(telemetry_data *data)
+{
+    log_info("Collecting telemetry...\n");
+
+    telemetry_read_power(data);
+    telemetry_read_radio_temperature(data);
+    telemetry_read_sensors(data);
+    telemetry_read_gps(data);
+    telemetry_read_clock_calibration(data);
 
     locator_from_lonlat(data->gps.longitude_degrees_10000000, data->gps.latitude_degrees_10000000,
             LOCATOR_PAIR_COUNT_FULL, data->locator);
@@ -135,3 +266,245 @@ void telemetry_collect(telemetry_data *data)
 
     log_info("Telemetry collected!\n");
 }
+
+#if TELEMETRY_CACHE_ENABLE
+
+typedef struct _telemetry_source {
+    void (*read)(telemetry_data *data);
+    // Non-blocking variant of read used for background refreshes, if available
+    void (*request)(telemetry_data *data);
+    // Starts a measurement that read or request picks up later, returning the time until it is ready, if needed
+    uint32_t (*trigger)();
+    uint32_t refresh_interval_ms;
+    uint32_t updated_tick_ms;
+    uint32_t ready_tick_ms;
+    bool valid;
+    bool triggered;
+    // A request is in flight: the source is updated when it completes
+    bool requested;
+} telemetry_source;
+
+typedef enum _telemetry_source_index {
+    TELEMETRY_SOURCE_RADIO_TEMPERATURE = 0,
+    TELEMETRY_SOURCE_SENSORS,
+    TELEMETRY_SOURCE_COUNT,
+} telemetry_source_index;
+
+#if I2C_QUEUE_ENABLE
+static void telemetry_request_sensors(telemetry_data *data);
+#endif
+
+// Sources that need bus transfers to read. GPS data and the ADC values are copied at every snapshot.
+static telemetry_source telemetry_sources[TELEMETRY_SOURCE_COUNT] = {
+        [TELEMETRY_SOURCE_RADIO_TEMPERATURE] = {
+                .read = telemetry_read_radio_temperature,
+                .refresh_interval_ms = TELEMETRY_CACHE_RADIO_TEMPERATURE_INTERVAL_MS,
+        },
+        [TELEMETRY_SOURCE_SENSORS] = {
+                .read = telemetry_read_sensors,
+#if I2C_QUEUE_ENABLE
+                .request = telemetry_request_sensors,
+#endif
+                .trigger = telemetry_trigger_sensors,
+                .refresh_interval_ms = TELEMETRY_CACHE_SENSOR_INTERVAL_MS,
+        },
+};
+
+static telemetry_data telemetry_cache;
+
+// Position the cached locator was computed for
+static int32_t telemetry_locator_latitude;
+static int32_t telemetry_locator_longitude;
+static bool telemetry_locator_valid = false;
+
+static void telemetry_read_source(telemetry_source *source)
+{
+    source->triggered = false;
+    source->read(&telemetry_cache);
+    source->updated_tick_ms = HAL_GetTick();
+    source->valid = true;
+}
+
+static void telemetry_update_source(telemetry_source *source)
+{
+    if (source->request != NULL) {
+        source->triggered = false;
+        source->requested = true;
+        source->request(&telemetry_cache);
+    } else {
+        telemetry_read_source(source);
+    }
+}
+
+/**
+ * Called when all the queued reads of a request have completed, from i2c_queue_poll() in the main loop.
+ * The values are only valid from here on, not from when the reads were queued.
+ */
+static void telemetry_complete_source(telemetry_source *source)
+{
+    source->requested = false;
+    source->updated_tick_ms = HAL_GetTick();
+    source->valid = true;
+}
+
+#if I2C_QUEUE_ENABLE
+static void telemetry_complete_sensors()
+{
+    telemetry_complete_source(&telemetry_sources[TELEMETRY_SOURCE_SENSORS]);
+}
+
+static void telemetry_request_sensors(telemetry_data *data)
+{
+    telemetry_request_sensor_reads(data, telemetry_complete_sensors);
+}
+#endif
+
+
+/**
+ * Read the source that is most overdue for a refresh, if any. Sources with a trigger get their measurement
+ * started first and are read by a later call once it is ready. Reads at most one source per call
+ * to keep the main loop responsive. Must only be called while the radio is not transmitting,
+ * because the radio chip and the I2C bus may be in use during a transmission.
+ */
+void telemetry_refresh()
+{
+    uint32_t now = HAL_GetTick();
+    telemetry_source *overdue = NULL;
+    uint32_t overdue_ms = 0;
+
+    for (size_t i = 0; i < TELEMETRY_SOURCE_COUNT; i++) {
+        telemetry_source *source = &telemetry_sources[i];
+        if (source->triggered && (int32_t) (now - source->ready_tick_ms) >= 0) {
+            telemetry_update_source(source);
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < TELEMETRY_SOURCE_COUNT; i++) {
+        telemetry_source *source = &telemetry_sources[i];
+        if (source->triggered || source->requested) {
+            continue;
+        }
+        if (!source->valid) {
+            overdue = source;
+            break;
+        }
+
+        uint32_t age_ms = now - source->updated_tick_ms;
+        if (age_ms >= source->refresh_interval_ms && age_ms - source->refresh_interval_ms >= overdue_ms) {
+            overdue = source;
+            overdue_ms = age_ms - source->refresh_interval_ms;
+        }
+    }
+
+    if (overdue == NULL) {
+        return;
+    }
+
+    if (overdue->trigger != NULL) {
+        uint32_t ready_ms = overdue->trigger();
+        if (ready_ms > 0) {
+            overdue->triggered = true;
+            overdue->ready_tick_ms = now + ready_ms;
+            return;
+        }
+    }
+
+    telemetry_update_source(overdue);
+}
+
+/**
+ * Start the measurements of the sources with a trigger ahead of a transmission, so that telemetry_snapshot()
+ * reads them without waiting for the conversion. Sources with a request read a finished measurement into the cache
+ * in the background, and are not triggered again until the next transmission. Call instead of telemetry_refresh()
+ * while a transmission is expected within TELEMETRY_SENSOR_TRIGGER_LEAD_MS.
+ */
+void telemetry_prepare()
+{
+#if I2C_QUEUE_ENABLE
+    // The triggers use blocking transfers: try again on the next call
+    if (i2c_queue_busy()) {
+        return;
+    }
+#endif
+
+    uint32_t now = HAL_GetTick();
+
+    for (size_t i = 0; i < TELEMETRY_SOURCE_COUNT; i++) {
+        telemetry_source *source = &telemetry_sources[i];
+        if (source->trigger == NULL || source->requested) {
+            continue;
+        }
+        if (source->triggered) {
+            if (source->request != NULL && (int32_t) (now - source->ready_tick_ms) >= 0) {
+                telemetry_update_source(source);
+            }
+            continue;
+        }
+        // Already read ahead of this transmission
+        if (source->request != NULL && source->valid
+            && now - source->updated_tick_ms < TELEMETRY_SENSOR_TRIGGER_LEAD_MS) {
+            continue;
+        }
+
+        source->ready_tick_ms = now + source->trigger();
+        source->triggered = true;
+    }
+}
+
+/**
+ * Copy the cached telemetry at TX start. Sources that have not been refreshed in the background for
+ * TELEMETRY_CACHE_STALE_FACTOR refresh intervals (for example when transmissions run back-to-back)
+ * are read synchronously, as are sources triggered ahead of the transmission, which only wait for
+ * what is left of their conversion time. With the I2C request queue, the sensors are read through it
+ * also here. GPS data is always current.
+ */
+void telemetry_snapshot(telemetry_data *data)
+{
+    uint32_t now = HAL_GetTick();
+
+    for (size_t i = 0; i < TELEMETRY_SOURCE_COUNT; i++) {
+        telemetry_source *source = &telemetry_sources[i];
+#if I2C_QUEUE_ENABLE
+        // Let a request in flight complete instead of reading the sensors again. The queue times out its transfers.
+        while (source->requested) {
+            i2c_queue_poll();
+        }
+#endif
+        if (source->triggered || !source->valid
+            || now - source->updated_tick_ms >= source->refresh_interval_ms * TELEMETRY_CACHE_STALE_FACTOR) {
+            telemetry_read_source(source);
+        }
+    }
+
+    telemetry_read_power(&telemetry_cache);
+    telemetry_read_gps(&telemetry_cache);
+    telemetry_read_clock_calibration(&telemetry_cache);
+
+    if (!telemetry_locator_valid
+        || telemetry_locator_latitude != telemetry_cache.gps.latitude_degrees_10000000
+        || telemetry_locator_longitude != telemetry_cache.gps.longitude_degrees_10000000) {
+        locator_from_lonlat(telemetry_cache.gps.longitude_degrees_10000000,
+                telemetry_cache.gps.latitude_degrees_10000000, LOCATOR_PAIR_COUNT_FULL, telemetry_cache.locator);
+        telemetry_locator_latitude = telemetry_cache.gps.latitude_degrees_10000000;
+        telemetry_locator_longitude = telemetry_cache.gps.longitude_degrees_10000000;
+        telemetry_locator_valid = true;
+    }
+
+    telemetry_cache.data_counter++;
+
+    memcpy(data, &telemetry_cache, sizeof(telemetry_data));
+}
+
+#else
+
+/**
+ * Start the sensor measurements ahead of a transmission, so that telemetry_collect() reads them
+ * without waiting for the conversion.
+ */
+void telemetry_prepare()
+{
+    telemetry_trigger_sensors();
+}
+
+#endif
@@ -34,7 +34,15 @@ typedef struct _telemetry_data {
     uint8_t po_state;
 } telemetry_data;
 
+// Called once the values of a queued sensor read have been written to the telemetry data, or the read has failed
+typedef void (*telemetry_request_callback)();
+
 void telemetry_collect(telemetry_data *data);
+void telemetry_prepare();
+#if TELEMETRY_CACHE_ENABLE
+void telemetry_refresh();
+void telemetry_snapshot(telemetry_data *data);
+#endif
 
 extern int8_t gps_time_leap_seconds;
 
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdbool.h>
 #include "utils.h"
 #include "config.h"
 #include "strlcpy.h"
@@ -142,5 +143,333 @@ size_t template_replace(char *dest, size_t dest_len, char *src, telemetry_data *
     str_replace(dest, dest_len, temp, "$xs", replacement);
 #endif
 
-return len;
+    return len;
+}
+
+typedef struct _template_field_name {
+    const char *name;
+    uint8_t length;
+    template_field field;
+} template_field_name;
+
+// Placeholder names without the leading '$'. No name is a prefix of another one.
+static const template_field_name template_field_names[] = {
+        {"cs", 2, TEMPLATE_FIELD_CALLSIGN},
+        {"loc4", 4, TEMPLATE_FIELD_LOCATOR_4},
+        {"loc6", 4, TEMPLATE_FIELD_LOCATOR_6},
+        {"loc8", 4, TEMPLATE_FIELD_LOCATOR_8},
+        {"loc12", 5, TEMPLATE_FIELD_LOCATOR_12},
+        {"bv", 2, TEMPLATE_FIELD_BATTERY_VOLTAGE},
+        {"bu", 2, TEMPLATE_FIELD_BUTTON_ADC},
+        {"te", 2, TEMPLATE_FIELD_TEMPERATURE},
+        {"ti", 2, TEMPLATE_FIELD_INTERNAL_TEMPERATURE},
+        {"hu", 2, TEMPLATE_FIELD_HUMIDITY},
+        {"pr", 2, TEMPLATE_FIELD_PRESSURE},
+        {"gas", 3, TEMPLATE_FIELD_GAS_RESISTANCE},
+        {"tow", 3, TEMPLATE_FIELD_TIME_OF_WEEK},
+        {"hh", 2, TEMPLATE_FIELD_HOURS},
+        {"mm", 2, TEMPLATE_FIELD_MINUTES},
+        {"ss", 2, TEMPLATE_FIELD_SECONDS},
+        {"sv", 2, TEMPLATE_FIELD_SATELLITES_VISIBLE},
+        {"lat", 3, TEMPLATE_FIELD_LATITUDE},
+        {"lon", 3, TEMPLATE_FIELD_LONGITUDE},
+        {"alt", 3, TEMPLATE_FIELD_ALTITUDE},
+        {"gs", 2, TEMPLATE_FIELD_GROUND_SPEED},
+        {"cl", 2, TEMPLATE_FIELD_CLIMB},
+        {"he", 2, TEMPLATE_FIELD_HEADING},
+        {"pc", 2, TEMPLATE_FIELD_PULSE_COUNT},
+        {"ri", 2, TEMPLATE_FIELD_RADIATION_INTENSITY},
+        {"dc", 2, TEMPLATE_FIELD_DATA_COUNTER},
+        {"gu", 2, TEMPLATE_FIELD_GPS_UPDATED},
+        {"apc", 3, TEMPLATE_FIELD_APRS_PACKET_COUNTER},
+#ifdef DFM17
+        {"xc", 2, TEMPLATE_FIELD_CAPACITANCE_TRIM},
+        {"xo", 2, TEMPLATE_FIELD_CAPACITANCE_TRIM_OFFSET},
+        {"xe", 2, TEMPLATE_FIELD_TIMEPULSE_ERROR},
+        {"xs", 2, TEMPLATE_FIELD_PO_STATE},
+#endif
+};
+
+static template_compiled template_compiled_list[TEMPLATE_COMPILED_MAX_COUNT];
+static uint8_t template_compiled_count = 0;
+
+static template_token template_tokens[TEMPLATE_TOKEN_MAX_COUNT];
+static uint8_t template_token_count = 0;
+
+void template_reset()
+{
+    template_compiled_count = 0;
+    template_token_count = 0;
+}
+
+static const template_field_name *template_match_field(const char *placeholder)
+{
+    for (size_t i = 0; i < sizeof(template_field_names) / sizeof(template_field_name); i++) {
+        const template_field_name *field_name = &template_field_names[i];
+        if (strncmp(placeholder, field_name->name, field_name->length) == 0) {
+            return field_name;
+        }
+    }
+
+    return NULL;
+}
+
+static bool template_compile_one(const char *src, template_compiled *compiled)
+{
+    size_t src_length = strlen(src);
+    if (src_length > UINT8_MAX) {
+        return false;
+    }
+
+    compiled->source = src;
+    compiled->first_token = template_token_count;
+    compiled->token_count = 0;
+
+    size_t literal_start = 0;
+    size_t i = 0;
+
+    while (true) {
+        const template_field_name *field_name = NULL;
+
+        if (i < src_length) {
+            if (src[i] != '$') {
+                i++;
+                continue;
+            }
+            field_name = template_match_field(&src[i + 1]);
+            if (field_name == NULL) {
+                i++;
+                continue;
+            }
+        }
+
+        if (field_name == NULL && i == literal_start) {
+            // Nothing after the last placeholder
+            break;
+        }
+
+        if (template_token_count >= TEMPLATE_TOKEN_MAX_COUNT) {
+            return false;
+        }
+
+        template_token *token = &template_tokens[template_token_count++];
+        token->literal_offset = (uint8_t) literal_start;
+        token->literal_length = (uint8_t) (i - literal_start);
+        token->field = field_name != NULL ? field_name->field : TEMPLATE_FIELD_NONE;
+        compiled->token_count++;
+
+        if (field_name == NULL) {
+            break;
+        }
+
+        i += 1 + field_name->length;
+        literal_start = i;
+    }
+
+    return true;
+}
+
+/**
+ * Parse message templates into literal spans and placeholders for template_render().
+ * Arrays that have already been compiled are shared.
+ *
+ * @return The compiled templates in the same order as the source array or NULL if the templates do not fit
+ * in the token space, in which case template_replace() has to be used.
+ */
+template_compiled *template_compile(char **templates, uint8_t count)
+{
+    if (count == 0) {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i + count <= template_compiled_count; i++) {
+        if (template_compiled_list[i].source == templates[0]) {
+            bool match = true;
+            for (uint8_t j = 1; j < count; j++) {
+                if (template_compiled_list[i + j].source != templates[j]) {
+                    match = false;
+                    break;
+                }
+            }
+            if (match) {
+                return &template_compiled_list[i];
+            }
+        }
+    }
+
+    if (template_compiled_count + count > TEMPLATE_COMPILED_MAX_COUNT) {
+        return NULL;
+    }
+
+    uint8_t compiled_count = template_compiled_count;
+    uint8_t token_count = template_token_count;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (!template_compile_one(templates[i], &template_compiled_list[compiled_count + i])) {
+            template_token_count = token_count;
+            return NULL;
+        }
+    }
+
+    template_compiled_count += count;
+
+    return &template_compiled_list[compiled_count];
+}
+
+static size_t template_append(char *dest, size_t dest_len, size_t length, const char *text, size_t text_length)
+{
+    if (length + text_length >= dest_len) {
+        text_length = dest_len - 1 - length;
+    }
+    memcpy(dest + length, text, text_length);
+
+    return length + text_length;
+}
+
+/**
+ * Format a placeholder value directly into the output buffer.
+ * Uses the same formats as template_replace().
+ */
+static size_t template_render_field(char *dest, size_t dest_len, size_t length, template_field field,
+        telemetry_data *data)
+{
+    char *out = dest + length;
+    size_t out_len = dest_len - length;
+    int written;
+
+    switch (field) {
+        case TEMPLATE_FIELD_CALLSIGN:
+            return template_append(dest, dest_len, length, CALLSIGN, strlen(CALLSIGN));
+        case TEMPLATE_FIELD_LOCATOR_4:
+            return template_append(dest, dest_len, length, data->locator, strnlen(data->locator, 4));
+        case TEMPLATE_FIELD_LOCATOR_6:
+            return template_append(dest, dest_len, length, data->locator, strnlen(data->locator, 6));
+        case TEMPLATE_FIELD_LOCATOR_8:
+            return template_append(dest, dest_len, length, data->locator, strnlen(data->locator, 8));
+        case TEMPLATE_FIELD_LOCATOR_12:
+            return template_append(dest, dest_len, length, data->locator, strnlen(data->locator, 12));
+        case TEMPLATE_FIELD_BATTERY_VOLTAGE:
+            written = snprintf(out, out_len, "%d", data->battery_voltage_millivolts);
+            break;
+        case TEMPLATE_FIELD_BUTTON_ADC:
+            written = snprintf(out, out_len, "%d", data->button_adc_value);
+            break;
+        case TEMPLATE_FIELD_TEMPERATURE:
+            written = snprintf(out, out_len, "%d", (int) data->temperature_celsius_100 / 100);
+            break;
+        case TEMPLATE_FIELD_INTERNAL_TEMPERATURE:
+            written = snprintf(out, out_len, "%d", (int) data->internal_temperature_celsius_100 / 100);
+            break;
+        case TEMPLATE_FIELD_HUMIDITY:
+            written = snprintf(out, out_len, "%d", (int) data->humidity_percentage_100 / 100);
+            break;
+        case TEMPLATE_FIELD_PRESSURE:
+            written = snprintf(out, out_len, "%d", (int) data->pressure_mbar_100 / 100);
+            break;
+        case TEMPLATE_FIELD_GAS_RESISTANCE:
+            written = snprintf(out, out_len, "%d", (int) data->bme6xx_gas_r);
+            break;
+        case TEMPLATE_FIELD_TIME_OF_WEEK:
+            written = snprintf(out, out_len, "%u", (unsigned int) data->gps.time_of_week_millis);
+            break;
+        case TEMPLATE_FIELD_HOURS:
+            written = snprintf(out, out_len, "%02d", data->gps.hours);
+            break;
+        case TEMPLATE_FIELD_MINUTES:
+            written = snprintf(out, out_len, "%02d", data->gps.minutes);
+            break;
+        case TEMPLATE_FIELD_SECONDS:
+            written = snprintf(out, out_len, "%02d", data->gps.seconds);
+            break;
+        case TEMPLATE_FIELD_SATELLITES_VISIBLE:
+            written = snprintf(out, out_len, "%d", data->gps.satellites_visible);
+            break;
+        case TEMPLATE_FIELD_LATITUDE:
+            written = snprintf(out, out_len, "%05d", (int) data->gps.latitude_degrees_10000000 / 10000);
+            break;
+        case TEMPLATE_FIELD_LONGITUDE:
+            written = snprintf(out, out_len, "%05d", (int) data->gps.longitude_degrees_10000000 / 10000);
+            break;
+        case TEMPLATE_FIELD_ALTITUDE:
+            written = snprintf(out, out_len, "%d", (int) data->gps.altitude_mm / 1000);
+            break;
+        case TEMPLATE_FIELD_GROUND_SPEED:
+            written = snprintf(out, out_len, "%d",
+                    (int) ((float) data->gps.ground_speed_cm_per_second * 3.6f / 100.0f));
+            break;
+        case TEMPLATE_FIELD_CLIMB:
+            written = snprintf(out, out_len, "%d", (int) data->gps.climb_cm_per_second / 100);
+            break;
+        case TEMPLATE_FIELD_HEADING:
+            written = snprintf(out, out_len, "%03d", (int) data->gps.heading_degrees_100000 / 100000);
+            break;
+        case TEMPLATE_FIELD_PULSE_COUNT:
+            written = snprintf(out, out_len, "%d", (int) data->pulse_count);
+            break;
+        case TEMPLATE_FIELD_RADIATION_INTENSITY:
+            written = snprintf(out, out_len, "%d", (int) data->radiation_intensity_uR_h);
+            break;
+        case TEMPLATE_FIELD_DATA_COUNTER:
+            written = snprintf(out, out_len, "%d", (int) data->data_counter);
+            break;
+        case TEMPLATE_FIELD_GPS_UPDATED:
+            written = snprintf(out, out_len, "%d", (int) data->gps.updated);
+            break;
+        case TEMPLATE_FIELD_APRS_PACKET_COUNTER:
+            written = snprintf(out, out_len, "%u", (unsigned int) aprs_packet_counter);
+            break;
+#ifdef DFM17
+        case TEMPLATE_FIELD_CAPACITANCE_TRIM:
+            written = snprintf(out, out_len, "%d", (int) data->si4063_capacitance_trim);
+            break;
+        case TEMPLATE_FIELD_CAPACITANCE_TRIM_OFFSET:
+            written = snprintf(out, out_len, "%d", data->cap_trim_offset);
+            break;
+        case TEMPLATE_FIELD_TIMEPULSE_ERROR:
+            written = snprintf(out, out_len, "%ld", (long) data->timepulse_error_us);
+            break;
+        case TEMPLATE_FIELD_PO_STATE:
+            written = snprintf(out, out_len, "%d", (int) data->po_state);
+            break;
+#endif
+        default:
+            return length;
+    }
+
+    if (written < 0) {
+        return length;
+    }
+    if ((size_t) written >= out_len) {
+        return dest_len - 1;
+    }
+
+    return length + written;
+}
+
+/**
+ * Render a compiled template in a single pass: only the placeholders present in the template are formatted.
+ * The output is truncated to fit dest_len.
+ *
+ * @return Length of the rendered message
+ */
+size_t template_render(char *dest, size_t dest_len, template_compiled *compiled, telemetry_data *data)
+{
+    if (dest_len == 0) {
+        return 0;
+    }
+
+    size_t length = 0;
+    template_token *token = &template_tokens[compiled->first_token];
+
+    for (uint8_t i = 0; i < compiled->token_count; i++, token++) {
+        length = template_append(dest, dest_len, length, compiled->source + token->literal_offset,
+                token->literal_length);
+        if (token->field != TEMPLATE_FIELD_NONE) {
+            length = template_render_field(dest, dest_len, length, (template_field) token->field, data);
+        }
+    }
+
+    dest[length] = '\0';
+
+    return length;
 }
@@ -1,9 +1,71 @@
 #ifndef __TEMPLATE_H
 #define __TEMPLATE_H
 
+#include <stdint.h>
 #include <string.h>
 #include "telemetry.h"
 
+// Space for compiled message templates, shared by all transmit entries
+#define TEMPLATE_COMPILED_MAX_COUNT 16
+#define TEMPLATE_TOKEN_MAX_COUNT 64
+
+typedef enum _template_field {
+    TEMPLATE_FIELD_NONE = 0,
+    TEMPLATE_FIELD_CALLSIGN,
+    TEMPLATE_FIELD_LOCATOR_4,
+    TEMPLATE_FIELD_LOCATOR_6,
+    TEMPLATE_FIELD_LOCATOR_8,
+    TEMPLATE_FIELD_LOCATOR_12,
+    TEMPLATE_FIELD_BATTERY_VOLTAGE,
+    TEMPLATE_FIELD_BUTTON_ADC,
+    TEMPLATE_FIELD_TEMPERATURE,
+    TEMPLATE_FIELD_INTERNAL_TEMPERATURE,
+    TEMPLATE_FIELD_HUMIDITY,
+    TEMPLATE_FIELD_PRESSURE,
+    TEMPLATE_FIELD_GAS_RESISTANCE,
+    TEMPLATE_FIELD_TIME_OF_WEEK,
+    TEMPLATE_FIELD_HOURS,
+    TEMPLATE_FIELD_MINUTES,
+    TEMPLATE_FIELD_SECONDS,
+    TEMPLATE_FIELD_SATELLITES_VISIBLE,
+    TEMPLATE_FIELD_LATITUDE,
+    TEMPLATE_FIELD_LONGITUDE,
+    TEMPLATE_FIELD_ALTITUDE,
+    TEMPLATE_FIELD_GROUND_SPEED,
+    TEMPLATE_FIELD_CLIMB,
+    TEMPLATE_FIELD_HEADING,
+    TEMPLATE_FIELD_PULSE_COUNT,
+    TEMPLATE_FIELD_RADIATION_INTENSITY,
+    TEMPLATE_FIELD_DATA_COUNTER,
+    TEMPLATE_FIELD_GPS_UPDATED,
+    TEMPLATE_FIELD_APRS_PACKET_COUNTER,
+#ifdef DFM17
+    TEMPLATE_FIELD_CAPACITANCE_TRIM,
+    TEMPLATE_FIELD_CAPACITANCE_TRIM_OFFSET,
+    TEMPLATE_FIELD_TIMEPULSE_ERROR,
+    TEMPLATE_FIELD_PO_STATE,
+#endif
+} template_field;
+
+/**
+ * A literal span of the template source followed by a placeholder (or TEMPLATE_FIELD_NONE at the end)
+ */
+typedef struct _template_token {
+    uint8_t literal_offset;
+    uint8_t literal_length;
+    uint8_t field;
+} template_token;
+
+typedef struct _template_compiled {
+    const char *source;
+    uint8_t first_token;
+    uint8_t token_count;
+} template_compiled;
+
 size_t template_replace(char *dest, size_t dest_len, char *src, telemetry_data *data);
 
+template_compiled *template_compile(char **templates, uint8_t count);
+size_t template_render(char *dest, size_t dest_len, template_compiled *compiled, telemetry_data *data);
+void template_reset();
+
 #endif
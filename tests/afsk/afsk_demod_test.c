@@ -0,0 +1,346 @@
+/**
+ * Reference demodulator test for the DMA-fed Bell 202 AFSK generator.
+ *
+ * An APRS packet is encoded the same way radio_start_transmit() does, rendered to a symbol stream and turned into
+ * PWM timer periods with afsk_generator_fill() in DMA buffer half sized chunks. The square wave described by the
+ * periods is sampled at 48 kHz and decoded with a plain non-coherent AFSK demodulator: mark/space correlators
+ * over one symbol, clock recovery from tone transitions, NRZI decoding, HDLC deframing and an FCS check.
+ *
+ * The test fails unless the decoded frame matches the encoded AX.25 frame bit for bit, the symbol timing has not
+ * drifted by the end of the packet and every half cycle lies between the two tone half periods.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "telemetry.h"
+#include "template.h"
+#include "codecs/afsk/afsk.h"
+#include "codecs/bell/bell.h"
+#include "drivers/hal/pwm.h"
+#include "radio_payload_aprs_position.h"
+
+#define AFSK_TEST_SYMBOL_RATE 1200
+#define AFSK_TEST_SAMPLE_RATE 48000
+#define AFSK_TEST_SAMPLES_PER_SYMBOL (AFSK_TEST_SAMPLE_RATE / AFSK_TEST_SYMBOL_RATE)
+#define AFSK_TEST_PERIOD_COUNT_MAX 16384
+#define AFSK_TEST_SAMPLE_COUNT_MAX (2 * AFSK_TEST_SAMPLE_RATE)
+#define AFSK_TEST_FRAME_BITS_MAX (RADIO_PAYLOAD_MAX_LENGTH * 8 * 2)
+
+#define AFSK_TEST_MESSAGE_TEMPLATE " B$bu $teC $hu% $prmb $hh:$mm:$ss @ $tow ms - " APRS_COMMENT
+
+static uint8_t test_payload[RADIO_PAYLOAD_MAX_LENGTH];
+static char test_message[RADIO_PAYLOAD_MESSAGE_MAX_LENGTH];
+
+static uint8_t test_stream_data[RADIO_SYMBOL_DATA_MAX_LENGTH];
+static fsk_symbol_stream test_stream = {
+        .symbols = test_stream_data,
+        .symbols_length = sizeof(test_stream_data),
+};
+
+static uint16_t test_periods[AFSK_TEST_PERIOD_COUNT_MAX];
+static float test_samples[AFSK_TEST_SAMPLE_COUNT_MAX];
+static bool test_decisions[AFSK_TEST_SAMPLE_COUNT_MAX];
+
+static uint8_t test_bits[AFSK_TEST_FRAME_BITS_MAX];
+static uint8_t test_frame_bits[AFSK_TEST_FRAME_BITS_MAX];
+static uint8_t test_frame[RADIO_PAYLOAD_MAX_LENGTH];
+
+static int8_t test_next_tone()
+{
+    return fsk_symbol_stream_next_tone(&test_stream);
+}
+
+static void test_fill_telemetry(telemetry_data *data)
+{
+    memset(data, 0, sizeof(telemetry_data));
+
+    data->battery_voltage_millivolts = 2870;
+    data->temperature_celsius_100 = -4520;
+    data->pressure_mbar_100 = 12050;
+    data->humidity_percentage_100 = 1230;
+
+    data->gps.time_of_week_millis = 302400000;
+    data->gps.hours = 11;
+    data->gps.minutes = 59;
+    data->gps.seconds = 42;
+    data->gps.latitude_degrees_10000000 = 601700000;
+    data->gps.longitude_degrees_10000000 = 249400000;
+    data->gps.altitude_mm = 28345000;
+    data->gps.ground_speed_cm_per_second = 2150;
+    data->gps.heading_degrees_100000 = 27312345;
+    data->gps.climb_cm_per_second = 512;
+    data->gps.fix = 3;
+    data->gps.fix_ok = true;
+
+    strcpy(data->locator, "KP20LE51WM");
+}
+
+/**
+ * Generates the periods like the DMA interrupt handlers do, plus one buffer half of idle tone after the last symbol.
+ *
+ * @return Number of periods
+ */
+static uint32_t test_generate_periods(afsk_generator *generator, uint32_t *symbol_period_count)
+{
+    uint16_t half_length = PWM_TIMER_DMA_BUFFER_SIZE / 2;
+    uint32_t count = 0;
+
+    *symbol_period_count = 0;
+
+    while (count + 2 * half_length <= AFSK_TEST_PERIOD_COUNT_MAX) {
+        uint16_t symbol_length = afsk_generator_fill(generator, half_length, test_periods + count);
+        *symbol_period_count += symbol_length;
+        count += half_length;
+
+        if (symbol_length < half_length) {
+            afsk_generator_fill(generator, half_length, test_periods + count);
+            return count + half_length;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Samples the square wave that toggles after every period (in 1 MHz timer ticks)
+ */
+static uint32_t test_sample_waveform(uint32_t period_count)
+{
+    uint64_t edge_us = 0;
+    uint32_t period_index = 0;
+    float level = 1.0f;
+    uint32_t sample_count = 0;
+
+    while (sample_count < AFSK_TEST_SAMPLE_COUNT_MAX) {
+        // Compared in units of 1 / (PWM_TIMER_CLOCK_HZ * AFSK_TEST_SAMPLE_RATE) s
+        uint64_t sample_time = (uint64_t) sample_count * PWM_TIMER_CLOCK_HZ;
+
+        while (period_index < period_count
+                && (edge_us + test_periods[period_index] + 1) * AFSK_TEST_SAMPLE_RATE <= sample_time) {
+            edge_us += test_periods[period_index] + 1;
+            period_index++;
+            level = -level;
+        }
+
+        if (period_index >= period_count) {
+            break;
+        }
+
+        test_samples[sample_count++] = level;
+    }
+
+    return sample_count;
+}
+
+static float test_correlate(uint32_t end, float frequency_hz)
+{
+    float i_sum = 0;
+    float q_sum = 0;
+
+    for (uint32_t k = end - AFSK_TEST_SAMPLES_PER_SYMBOL; k < end; k++) {
+        float phase = 2.0f * (float) M_PI * frequency_hz * (float) k / AFSK_TEST_SAMPLE_RATE;
+        i_sum += test_samples[k] * cosf(phase);
+        q_sum += test_samples[k] * sinf(phase);
+    }
+
+    return i_sum * i_sum + q_sum * q_sum;
+}
+
+/**
+ * Recovers the tone of every symbol: decisions are sampled half a symbol after each tone transition seen
+ * by the correlators, and every symbol period after that until the next transition.
+ *
+ * @return Number of NRZI-decoded bits
+ */
+static uint32_t test_demodulate(uint32_t sample_count, uint8_t *bits, uint32_t bits_max)
+{
+    float mark_hz = (float) bell202_tones[FSK_TONE_INDEX_BELL_MARK].frequency_hz_100 / 100.0f;
+    float space_hz = (float) bell202_tones[FSK_TONE_INDEX_BELL_SPACE].frequency_hz_100 / 100.0f;
+
+    for (uint32_t n = AFSK_TEST_SAMPLES_PER_SYMBOL; n < sample_count; n++) {
+        test_decisions[n] = test_correlate(n, mark_hz) > test_correlate(n, space_hz);
+    }
+
+    uint32_t bit_count = 0;
+    uint32_t next_sample = 0;
+    bool previous_mark = true;
+
+    for (uint32_t n = AFSK_TEST_SAMPLES_PER_SYMBOL + 1; n < sample_count && bit_count < bits_max; n++) {
+        if (test_decisions[n] != test_decisions[n - 1]) {
+            next_sample = n + AFSK_TEST_SAMPLES_PER_SYMBOL / 2;
+        }
+        if (next_sample == 0 || n != next_sample) {
+            continue;
+        }
+
+        bool mark = test_decisions[n];
+        // NRZI: a tone change is a zero bit
+        bits[bit_count++] = mark == previous_mark ? 1 : 0;
+        previous_mark = mark;
+        next_sample += AFSK_TEST_SAMPLES_PER_SYMBOL;
+    }
+
+    return bit_count;
+}
+
+static uint16_t test_crc_x25(uint8_t *data, uint16_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (uint16_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 1U) ? (crc >> 1U) ^ 0x8408U : crc >> 1U;
+        }
+    }
+
+    return crc ^ 0xFFFFU;
+}
+
+/**
+ * Finds the first frame between HDLC flags with a valid FCS, removing stuffed zero bits
+ *
+ * @return Frame length in bytes including the FCS, 0 if not found
+ */
+static uint16_t test_deframe(uint8_t *bits, uint32_t bit_count, uint8_t *frame, uint16_t frame_max)
+{
+    uint32_t frame_bit_count = 0;
+    int ones = 0;
+
+    for (uint32_t i = 0; i < bit_count; i++) {
+        if (bits[i]) {
+            ones++;
+            if (ones > 6 || frame_bit_count >= AFSK_TEST_FRAME_BITS_MAX) {
+                // Abort sequence
+                frame_bit_count = 0;
+                continue;
+            }
+            test_frame_bits[frame_bit_count++] = 1;
+            continue;
+        }
+
+        if (ones == 5) {
+            // Stuffed bit
+            ones = 0;
+            continue;
+        }
+
+        if (ones == 6) {
+            // Flag: 0 followed by six ones already collected
+            ones = 0;
+            uint32_t length_bits = frame_bit_count >= 7 ? frame_bit_count - 7 : 0;
+            frame_bit_count = 0;
+
+            if (length_bits == 0 || length_bits % 8 != 0 || length_bits / 8 > frame_max || length_bits / 8 < 3) {
+                continue;
+            }
+
+            uint16_t length = length_bits / 8;
+            memset(frame, 0, length);
+            for (uint32_t b = 0; b < length_bits; b++) {
+                frame[b / 8] |= test_frame_bits[b] << (b % 8);
+            }
+
+            uint16_t fcs = (uint16_t) (frame[length - 2] | (frame[length - 1] << 8U));
+            if (test_crc_x25(frame, length - 2) == fcs) {
+                return length;
+            }
+            continue;
+        }
+
+        ones = 0;
+        if (frame_bit_count < AFSK_TEST_FRAME_BITS_MAX) {
+            test_frame_bits[frame_bit_count++] = 0;
+        }
+    }
+
+    return 0;
+}
+
+static bool test_check_periods(uint32_t period_count, uint32_t symbol_period_count, uint32_t symbol_count)
+{
+    uint32_t mark_ticks = (uint32_t) ceil(PWM_TIMER_CLOCK_HZ * 100.0
+            / (2.0 * bell202_tones[FSK_TONE_INDEX_BELL_MARK].frequency_hz_100));
+    uint32_t space_ticks = (uint32_t) floor(PWM_TIMER_CLOCK_HZ * 100.0
+            / (2.0 * bell202_tones[FSK_TONE_INDEX_BELL_SPACE].frequency_hz_100));
+    bool success = true;
+
+    for (uint32_t i = 0; i < period_count; i++) {
+        uint32_t ticks = (uint32_t) test_periods[i] + 1;
+        if (ticks < space_ticks || ticks > mark_ticks) {
+            fprintf(stderr, "FAIL: half cycle %u is %u ticks, expected %u ... %u\n", i, ticks, space_ticks,
+                    mark_ticks);
+            success = false;
+        }
+    }
+
+    // The last symbol must end within the last period that contains symbols
+    uint64_t ticks_before_last = 0;
+    for (uint32_t i = 0; i + 1 < symbol_period_count; i++) {
+        ticks_before_last += (uint64_t) test_periods[i] + 1;
+    }
+    uint64_t ticks_through_last = ticks_before_last + test_periods[symbol_period_count - 1] + 1;
+    double symbols_end = (double) symbol_count * PWM_TIMER_CLOCK_HZ / AFSK_TEST_SYMBOL_RATE;
+
+    if (symbols_end < (double) ticks_before_last - 1.0 || symbols_end > (double) ticks_through_last + 1.0) {
+        fprintf(stderr, "FAIL: %u symbols end at %.1f us, the last symbol period covers %llu ... %llu us\n",
+                symbol_count, symbols_end, (unsigned long long) ticks_before_last,
+                (unsigned long long) ticks_through_last);
+        success = false;
+    }
+
+    return success;
+}
+
+int main(void)
+{
+    telemetry_data telemetry;
+    fsk_encoder encoder;
+    afsk_generator generator;
+
+    test_fill_telemetry(&telemetry);
+    template_replace(test_message, sizeof(test_message), AFSK_TEST_MESSAGE_TEMPLATE, &telemetry);
+    uint16_t payload_length = radio_aprs_position_payload_encoder.encode(test_payload, sizeof(test_payload),
+            &telemetry, test_message);
+
+    bell_encoder_new(&encoder, AFSK_TEST_SYMBOL_RATE, BELL_FLAG_FIELD_COUNT_1200, bell202_tones);
+    bell_encoder_set_data(&encoder, payload_length, test_payload);
+    if (!bell_encoder_render(&encoder, &test_stream)) {
+        fprintf(stderr, "FAIL: packet does not fit in the symbol stream\n");
+        return 1;
+    }
+
+    afsk_generator_init(&generator, PWM_TIMER_CLOCK_HZ, AFSK_TEST_SYMBOL_RATE, bell202_tones,
+            FSK_TONE_INDEX_BELL_MARK, test_next_tone);
+
+    uint32_t symbol_period_count;
+    uint32_t period_count = test_generate_periods(&generator, &symbol_period_count);
+    if (period_count == 0) {
+        fprintf(stderr, "FAIL: too many periods\n");
+        return 1;
+    }
+
+    bool success = test_check_periods(period_count, symbol_period_count, test_stream.symbol_count);
+
+    uint32_t sample_count = test_sample_waveform(period_count);
+    uint32_t bit_count = test_demodulate(sample_count, test_bits, AFSK_TEST_FRAME_BITS_MAX);
+    uint16_t frame_length = test_deframe(test_bits, bit_count, test_frame, sizeof(test_frame));
+
+    // Payload: opening flag, frame with FCS, closing flag
+    uint16_t expected_length = payload_length - 2;
+    if (frame_length != expected_length || memcmp(test_frame, test_payload + 1, expected_length) != 0) {
+        fprintf(stderr, "FAIL: decoded frame of %u bytes does not match the encoded frame of %u bytes\n",
+                frame_length, expected_length);
+        success = false;
+    }
+
+    printf("AFSK: %u symbols, %u half cycles, %u samples, %u bits, frame %u bytes: %s\n",
+            test_stream.symbol_count, period_count, sample_count, bit_count, frame_length,
+            success ? "OK" : "FAILED");
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+
+#define BENCH_COMMON_OPTIONS "bs:r:"
+
+bool bench_parse_options(int argc, char *argv[], const char *extra_options, const char *extra_usage,
+        bench_options *options)
+{
+    char getopt_options[16];
+    int opt;
+
+    snprintf(getopt_options, sizeof(getopt_options), "%s%s", BENCH_COMMON_OPTIONS, extra_options);
+
+    options->check_budgets = false;
+    options->budget_scale = 1.0;
+
+    while ((opt = getopt(argc, argv, getopt_options)) != -1) {
+        switch (opt) {
+            case 'b':
+                options->check_budgets = true;
+                break;
+            case 's':
+                options->budget_scale = atof(optarg);
+                break;
+            case 'r':
+                options->repetitions = atoi(optarg);
+                break;
+            case 'n':
+                options->count = atoi(optarg);
+                break;
+            case 'f':
+                options->filename = optarg;
+                break;
+            case 'S':
+                options->seed = (unsigned int) strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-b] [-s budget_scale] [-r repetitions]%s%s\n", argv[0],
+                        strlen(extra_usage) > 0 ? " " : "", extra_usage);
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Checks an absolute time against its budget, only with -b. A budget of 0 is not checked.
+ */
+bool bench_check_budget(const bench_options *options, const char *name, const char *metric, double value_ns,
+        double budget_ns)
+{
+    if (!options->check_budgets || budget_ns == 0 || value_ns <= budget_ns * options->budget_scale) {
+        return true;
+    }
+
+    fprintf(stderr, "FAIL: %s: %s %.2f ns exceeds budget of %.2f ns\n", name, metric, value_ns,
+            budget_ns * options->budget_scale);
+    return false;
+}
+
+/**
+ * Checks that the optimized code is at least min_speedup times as fast as the reference measured in the same run.
+ * Both are slowed down alike by a loaded host, so the ratio holds where absolute times do not. A minimum of 0 is
+ * not checked.
+ */
+bool bench_check_speedup(const char *name, const char *metric, double reference_ns, double value_ns,
+        double min_speedup)
+{
+    if (min_speedup == 0 || value_ns * min_speedup <= reference_ns) {
+        return true;
+    }
+
+    fprintf(stderr, "FAIL: %s: %s speedup %.2f is below the minimum of %.2f\n", name, metric,
+            value_ns > 0 ? reference_ns / value_ns : 0.0, min_speedup);
+    return false;
+}
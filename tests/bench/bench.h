@@ -0,0 +1,68 @@
+#ifndef __BENCH_H
+#define __BENCH_H
+
+/**
+ * Timing and option handling shared by the benchmarks.
+ *
+ * Host wall-clock times depend on the machine and on whatever else runs on it, so a benchmark does not fail on
+ * them by default. The gates that run with ctest compare the optimized code against its reference implementation
+ * measured in the same run (bench_check_speedup()). The absolute budgets in host nanoseconds are only checked with
+ * -b (bench_check_budget()), which the tests labeled "bench" do when configured with -DBENCH_BUDGET_TESTS=ON.
+ *
+ * Common options:
+ *   -b                check the absolute time budgets
+ *   -s budget_scale   multiply the absolute time budgets, for slower hosts
+ *   -r repetitions    number of timed repetitions, the fastest of which is reported
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES_AVAILABLE 1
+#else
+#define BENCH_CYCLES_AVAILABLE 0
+#endif
+
+typedef struct _bench_options {
+    bool check_budgets;
+    double budget_scale;
+    int repetitions;
+    // Options only some benchmarks take: -n, -f and -S
+    int count;
+    const char *filename;
+    unsigned int seed;
+} bench_options;
+
+static inline uint64_t bench_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static inline uint64_t bench_cycles()
+{
+#if BENCH_CYCLES_AVAILABLE
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Parses the common options and the ones listed in extra_options ("n:", "f:" and/or "S:", described by
+ * extra_usage). The repetitions, count, filename and seed keep the values set by the caller unless given.
+ * Prints the usage and returns false on an unknown option.
+ */
+bool bench_parse_options(int argc, char *argv[], const char *extra_options, const char *extra_usage,
+        bench_options *options);
+
+bool bench_check_budget(const bench_options *options, const char *name, const char *metric, double value_ns,
+        double budget_ns);
+bool bench_check_speedup(const char *name, const char *metric, double reference_ns, double value_ns,
+        double min_speedup);
+
+#endif
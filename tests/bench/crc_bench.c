@@ -0,0 +1,288 @@
+/**
+ * CRC-16 benchmark: the table-driven codecs/crc variants against the bitwise implementations they replaced
+ * (ax25_calculate_crc(), calc_crc() from CATS, gen_crc16() and calculate_crc16_checksum() from Horus).
+ *
+ * Every variant must produce the same CRC as the original implementation for random packets of all lengths
+ * up to RADIO_PAYLOAD_MAX_LENGTH. The time per byte is measured over a packet of typical APRS size, taking the
+ * fastest of all repetitions to filter out host preemption. On x86 hosts, time stamp counter cycles are
+ * reported too.
+ *
+ * Usage: crc_bench [-b] [-s budget_scale] [-r repetitions]
+ * Exits with a non-zero status on a CRC mismatch, if the byte table is not enough faster than the original
+ * implementation in the same run or, with -b, if a table variant exceeds its budget (multiplied by budget_scale).
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "config.h"
+#include "codecs/crc/crc16.h"
+
+#define BENCH_PACKET_LENGTH 128
+#define BENCH_DEFAULT_REPETITIONS 20000
+
+typedef uint16_t (*bench_crc_function)(const uint8_t *data, size_t length);
+
+typedef struct _bench_case {
+    const char *name;
+    bench_crc_function reference;
+    bench_crc_function nibble;
+    bench_crc_function byte;
+
+    // Budgets in host nanoseconds per byte
+    double budget_nibble_ns;
+    double budget_byte_ns;
+    // Minimum speedup of the byte table over the original implementation. 0 where the host compiler already
+    // turns the original bit loop into code about as fast as the table.
+    double min_byte_speedup;
+} bench_case;
+
+typedef struct _bench_timing {
+    double ns_per_byte;
+    double cycles_per_byte;
+} bench_timing;
+
+static uint8_t bench_data[RADIO_PAYLOAD_MAX_LENGTH];
+
+// Original implementations
+
+static uint16_t reference_ax25(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < length; i++) {
+        uint8_t temp = data[i];
+        for (uint16_t b = 0; b < 8; b++, temp >>= 1U) {
+            uint16_t temp_crc = crc ^ (temp & 1U);
+            crc >>= 1U;
+            if (temp_crc & 0x0001U) {
+                crc ^= 0x8408U;
+            }
+        }
+    }
+
+    return crc;
+}
+
+static uint16_t reference_cats(const uint8_t *data, size_t length)
+{
+    const uint8_t *ptr = data;
+    uint8_t crcbyte1 = 0xFF;
+    uint8_t crcbyte2 = 0xFF;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t r1 = *ptr++ ^ crcbyte2;
+        r1 = (r1 << 4) ^ r1;
+        crcbyte2 = (r1 << 4) | (r1 >> 4);
+        crcbyte2 = (crcbyte2 & 0x0F) ^ crcbyte1;
+        crcbyte1 = r1;
+        r1 = (r1 << 3) | (r1 >> 5);
+        crcbyte2 = crcbyte2 ^ (r1 & 0xF8);
+        crcbyte1 = crcbyte1 ^ (r1 & 0x07);
+    }
+
+    return ~((crcbyte1 << 8) | crcbyte2);
+}
+
+static uint16_t reference_horus_l2(const uint8_t *data, size_t length)
+{
+    unsigned char x;
+    unsigned short crc = 0xFFFF;
+
+    while (length--) {
+        x = crc >> 8 ^ *data++;
+        x ^= x >> 4;
+        crc = (crc << 8) ^ ((unsigned short) (x << 12)) ^ ((unsigned short) (x << 5)) ^ ((unsigned short) x);
+    }
+
+    return crc;
+}
+
+static uint16_t reference_horus_v2(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xffff;
+
+    for (size_t ptr = 0; ptr < length; ptr++) {
+        crc = crc ^ (data[ptr] << 8);
+        for (int i = 0; i < 8; i++) {
+            if (crc & 0x8000) {
+                crc = (uint16_t) ((crc << 1) ^ 0x1021);
+            } else {
+                crc <<= 1;
+            }
+        }
+    }
+
+    return crc;
+}
+
+// Table-driven variants, with the same initial value and final inversion as the codecs use them
+
+static uint16_t x25_nibble(const uint8_t *data, size_t length)
+{
+    return crc16_x25_update_nibble(CRC16_INIT, data, length);
+}
+
+static uint16_t x25_byte(const uint8_t *data, size_t length)
+{
+    return crc16_x25_update_byte(CRC16_INIT, data, length);
+}
+
+static uint16_t x25_inverted_nibble(const uint8_t *data, size_t length)
+{
+    return ~crc16_x25_update_nibble(CRC16_INIT, data, length);
+}
+
+static uint16_t x25_inverted_byte(const uint8_t *data, size_t length)
+{
+    return ~crc16_x25_update_byte(CRC16_INIT, data, length);
+}
+
+static uint16_t ccitt_nibble(const uint8_t *data, size_t length)
+{
+    return crc16_ccitt_update_nibble(CRC16_INIT, data, length);
+}
+
+static uint16_t ccitt_byte(const uint8_t *data, size_t length)
+{
+    return crc16_ccitt_update_byte(CRC16_INIT, data, length);
+}
+
+static bench_case bench_cases[] = {
+        {
+                .name = "AX.25 FCS",
+                .reference = reference_ax25,
+                .nibble = x25_nibble,
+                .byte = x25_byte,
+                .budget_nibble_ns = 15,
+                .budget_byte_ns = 8,
+                .min_byte_speedup = 1.5,
+        },
+        {
+                .name = "CATS",
+                .reference = reference_cats,
+                .nibble = x25_inverted_nibble,
+                .byte = x25_inverted_byte,
+                .budget_nibble_ns = 15,
+                .budget_byte_ns = 8,
+                .min_byte_speedup = 0,
+        },
+        {
+                .name = "Horus L2",
+                .reference = reference_horus_l2,
+                .nibble = ccitt_nibble,
+                .byte = ccitt_byte,
+                .budget_nibble_ns = 15,
+                .budget_byte_ns = 8,
+                .min_byte_speedup = 0,
+        },
+        {
+                .name = "Horus V2",
+                .reference = reference_horus_v2,
+                .nibble = ccitt_nibble,
+                .byte = ccitt_byte,
+                .budget_nibble_ns = 15,
+                .budget_byte_ns = 8,
+                .min_byte_speedup = 1.5,
+        },
+};
+
+static bool bench_verify(bench_case *bench, const char *variant, bench_crc_function function)
+{
+    for (size_t length = 0; length <= sizeof(bench_data); length++) {
+        uint16_t expected = bench->reference(bench_data, length);
+        uint16_t actual = function(bench_data, length);
+        if (actual != expected) {
+            fprintf(stderr, "FAIL: %s: %s CRC of %zu bytes is 0x%04X, expected 0x%04X\n", bench->name, variant,
+                    length, actual, expected);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void bench_measure(bench_crc_function function, int repetitions, bench_timing *timing)
+{
+    uint64_t min_ns = UINT64_MAX;
+    uint64_t min_cycles = UINT64_MAX;
+    volatile uint16_t sink = 0;
+
+    for (int r = 0; r < repetitions; r++) {
+        uint64_t start_cycles = bench_cycles();
+        uint64_t start_ns = bench_time_ns();
+        sink ^= function(bench_data, BENCH_PACKET_LENGTH);
+        uint64_t elapsed_ns = bench_time_ns() - start_ns;
+        uint64_t elapsed_cycles = bench_cycles() - start_cycles;
+
+        if (elapsed_ns < min_ns) {
+            min_ns = elapsed_ns;
+        }
+        if (elapsed_cycles < min_cycles) {
+            min_cycles = elapsed_cycles;
+        }
+    }
+
+    (void) sink;
+
+    timing->ns_per_byte = (double) min_ns / BENCH_PACKET_LENGTH;
+    timing->cycles_per_byte = (double) min_cycles / BENCH_PACKET_LENGTH;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_options options = {
+            .repetitions = BENCH_DEFAULT_REPETITIONS,
+    };
+
+    if (!bench_parse_options(argc, argv, "", "", &options)) {
+        return 1;
+    }
+    int repetitions = options.repetitions;
+
+    srand(1);
+    for (size_t i = 0; i < sizeof(bench_data); i++) {
+        bench_data[i] = (uint8_t) rand();
+    }
+
+    bool success = true;
+
+    printf("%-10s %14s %14s %14s %14s %14s %14s\n", "crc", "bitwise ns/B", "nibble ns/B", "byte ns/B",
+            "bitwise cyc/B", "nibble cyc/B", "byte cyc/B");
+
+    for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_case); i++) {
+        bench_case *bench = &bench_cases[i];
+
+        if (!bench_verify(bench, "nibble", bench->nibble) || !bench_verify(bench, "byte", bench->byte)) {
+            success = false;
+            continue;
+        }
+
+        bench_timing reference;
+        bench_timing nibble;
+        bench_timing byte;
+        bench_measure(bench->reference, repetitions, &reference);
+        bench_measure(bench->nibble, repetitions, &nibble);
+        bench_measure(bench->byte, repetitions, &byte);
+
+        if (BENCH_CYCLES_AVAILABLE) {
+            printf("%-10s %14.2f %14.2f %14.2f %14.2f %14.2f %14.2f\n", bench->name, reference.ns_per_byte,
+                    nibble.ns_per_byte, byte.ns_per_byte, reference.cycles_per_byte, nibble.cycles_per_byte,
+                    byte.cycles_per_byte);
+        } else {
+            printf("%-10s %14.2f %14.2f %14.2f %14s %14s %14s\n", bench->name, reference.ns_per_byte,
+                    nibble.ns_per_byte, byte.ns_per_byte, "-", "-", "-");
+        }
+
+        success &= bench_check_speedup(bench->name, "byte table", reference.ns_per_byte, byte.ns_per_byte,
+                bench->min_byte_speedup);
+        success &= bench_check_budget(&options, bench->name, "nibble table per byte", nibble.ns_per_byte,
+                bench->budget_nibble_ns);
+        success &= bench_check_budget(&options, bench->name, "byte table per byte", byte.ns_per_byte,
+                bench->budget_byte_ns);
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,487 @@
+/**
+ * Symbol timing benchmark for the FSK encoders.
+ *
+ * Each case builds a realistic packet with the same payload encoder the radio scheduler uses, from one of the
+ * fuller message templates suggested in config.c, then measures:
+ *   - packet encode time: payload_encoder->encode() plus fsk_encoder_api->set_data(), both run in thread mode
+ *     before TX starts
+ *   - average next_tone() time over the whole symbol stream
+ *   - worst-case next_tone() time: for every symbol position the fastest of all repetitions is taken (to filter
+ *     out host preemption), and the slowest of those positions is reported
+ *   - for encoders that support render(): render time and the same tone timings read from the rendered symbol
+ *     stream, which must match the lazily evaluated tones exactly
+ *
+ * next_tone() is called from the data timer ISR, so the per-call numbers are what costs symbol timing jitter.
+ * Times are host nanoseconds: they track relative regressions in the codecs, not absolute STM32 cycle counts.
+ *
+ * There is no reference implementation to compare against: the ctest run checks that every encoder runs and that
+ * the rendered symbol streams match, the budgets are checked with -b.
+ *
+ * Usage: encoder_bench [-b] [-s budget_scale] [-r repetitions]
+ * Exits with a non-zero status on a symbol stream mismatch, or with -b if any case exceeds its budget (multiplied
+ * by budget_scale).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "config.h"
+#include "telemetry.h"
+#include "template.h"
+#include "codecs/bell/bell.h"
+#include "codecs/mfsk/mfsk.h"
+#include "codecs/morse/morse.h"
+#include "codecs/jtencode/jtencode.h"
+#include "codecs/raw/raw.h"
+#include "radio_payload_aprs_position.h"
+#include "radio_payload_cats.h"
+#include "radio_payload_cw.h"
+#include "radio_payload_horus_v2.h"
+#include "radio_payload_horus_v3.h"
+#include "radio_payload_jtencode.h"
+#include "radio_payload_wspr.h"
+
+#define BENCH_SYMBOL_COUNT_MAX 16384
+#define BENCH_DEFAULT_REPETITIONS 200
+
+// WSPR accepts at most 6 callsign characters, the default CALLSIGN does not fit
+#define BENCH_WSPR_CALLSIGN "OH3XYZ"
+
+typedef enum _bench_encoder_type {
+    BENCH_ENCODER_BELL = 0,
+    BENCH_ENCODER_MFSK,
+    BENCH_ENCODER_MORSE,
+    BENCH_ENCODER_JTENCODE,
+    BENCH_ENCODER_RAW,
+} bench_encoder_type;
+
+typedef struct _bench_case {
+    const char *name;
+    bench_encoder_type encoder_type;
+    fsk_encoder_api *fsk_encoder_api;
+    payload_encoder *payload_encoder;
+    char *message_template;
+    uint32_t symbol_rate;
+    jtencode_mode_type jtencode_mode;
+
+    // Budgets in host nanoseconds
+    uint64_t budget_packet_ns;
+    uint64_t budget_tone_average_ns;
+    uint64_t budget_tone_worst_ns;
+} bench_case;
+
+typedef struct _bench_tone_result {
+    uint32_t symbol_count;
+    double average_ns;
+    uint64_t worst_ns;
+} bench_tone_result;
+
+typedef struct _bench_result {
+    uint16_t payload_length;
+    uint64_t packet_ns;
+    bench_tone_result tone;
+
+    bool rendered;
+    uint64_t render_ns;
+    bench_tone_result stream_tone;
+} bench_result;
+
+static bench_case bench_cases[] = {
+        {
+                .name = "APRS-1200 (bell)",
+                .encoder_type = BENCH_ENCODER_BELL,
+                .fsk_encoder_api = &bell_fsk_encoder_api,
+                .payload_encoder = &radio_aprs_position_payload_encoder,
+                .message_template = " B$bu $teC $hu% $prmb $hh:$mm:$ss @ $tow ms - " APRS_COMMENT,
+                .symbol_rate = 1200,
+                .budget_packet_ns = 100000,
+                .budget_tone_average_ns = 30,
+                .budget_tone_worst_ns = 250,
+        },
+        {
+                .name = "Horus V2 (mfsk)",
+                .encoder_type = BENCH_ENCODER_MFSK,
+                .fsk_encoder_api = &mfsk_fsk_encoder_api,
+                .payload_encoder = &radio_horus_v2_payload_encoder,
+                .symbol_rate = HORUS_V2_BAUD_RATE_SI4032,
+                .budget_packet_ns = 50000,
+                .budget_tone_average_ns = 30,
+                .budget_tone_worst_ns = 250,
+        },
+        {
+                .name = "Horus V3 (mfsk)",
+                .encoder_type = BENCH_ENCODER_MFSK,
+                .fsk_encoder_api = &mfsk_fsk_encoder_api,
+                .payload_encoder = &radio_horus_v3_payload_encoder,
+                .symbol_rate = HORUS_V3_BAUD_RATE_SI4032,
+                .budget_packet_ns = 50000,
+                .budget_tone_average_ns = 30,
+                .budget_tone_worst_ns = 250,
+        },
+        {
+                .name = "CW (morse)",
+                .encoder_type = BENCH_ENCODER_MORSE,
+                .fsk_encoder_api = &morse_fsk_encoder_api,
+                .payload_encoder = &radio_cw_payload_encoder,
+                .message_template = "$cs $loc6 $altm $gs km/h $tiC",
+                .symbol_rate = MORSE_WPM_TO_SYMBOL_RATE(CW_SPEED_WPM),
+                .budget_packet_ns = 50000,
+                .budget_tone_average_ns = 50,
+                .budget_tone_worst_ns = 300,
+        },
+        {
+                .name = "FT8 (jtencode)",
+                .encoder_type = BENCH_ENCODER_JTENCODE,
+                .fsk_encoder_api = &jtencode_fsk_encoder_api,
+                .payload_encoder = &radio_ft8_payload_encoder,
+                .message_template = "$cs $loc4",
+                .jtencode_mode = JTENCODE_MODE_FT8,
+                .budget_packet_ns = 150000,
+                .budget_tone_average_ns = 30,
+                .budget_tone_worst_ns = 150,
+        },
+        {
+                .name = "JT65 (jtencode)",
+                .encoder_type = BENCH_ENCODER_JTENCODE,
+                .fsk_encoder_api = &jtencode_fsk_encoder_api,
+                .payload_encoder = &radio_jt65_payload_encoder,
+                .message_template = "$cs $loc4",
+                .jtencode_mode = JTENCODE_MODE_JT65,
+                .budget_packet_ns = 50000,
+                .budget_tone_average_ns = 30,
+                .budget_tone_worst_ns = 150,
+        },
+        {
+                .name = "WSPR (jtencode)",
+                .encoder_type = BENCH_ENCODER_JTENCODE,
+                .fsk_encoder_api = &jtencode_fsk_encoder_api,
+                .payload_encoder = &radio_wspr_payload_encoder,
+                .jtencode_mode = JTENCODE_MODE_WSPR,
+                .budget_packet_ns = 75000,
+                .budget_tone_average_ns = 30,
+                .budget_tone_worst_ns = 150,
+        },
+        {
+                .name = "CATS (raw)",
+                .encoder_type = BENCH_ENCODER_RAW,
+                .fsk_encoder_api = &raw_fsk_encoder_api,
+                .payload_encoder = &radio_cats_payload_encoder,
+                .message_template = "T:$teC H:$hu% P:$prmb - " CATS_COMMENT,
+                .symbol_rate = 9600,
+                .budget_packet_ns = 300000,
+        },
+        {
+                .name = "APRS-9600 (raw)",
+                .encoder_type = BENCH_ENCODER_RAW,
+                .fsk_encoder_api = &raw_fsk_encoder_api,
+                .payload_encoder = &radio_aprs_9600_position_payload_encoder,
+                .message_template = " B$bu $teC $hu% $prmb $hh:$mm:$ss @ $tow ms - " APRS_COMMENT,
+                .symbol_rate = 9600,
+                .budget_packet_ns = 150000,
+        },
+};
+
+static uint8_t bench_payload[RADIO_PAYLOAD_MAX_LENGTH];
+static uint8_t bench_symbol_data[RADIO_SYMBOL_DATA_MAX_LENGTH];
+static char bench_message[RADIO_PAYLOAD_MESSAGE_MAX_LENGTH];
+static uint64_t bench_tone_min_ns[BENCH_SYMBOL_COUNT_MAX];
+
+static uint8_t bench_stream_data[RADIO_SYMBOL_DATA_MAX_LENGTH];
+static fsk_symbol_stream bench_stream = {
+        .symbols = bench_stream_data,
+        .symbols_length = sizeof(bench_stream_data),
+};
+
+static uint64_t bench_timer_overhead_ns = 0;
+
+static void bench_calibrate_timer()
+{
+    uint64_t min_ns = UINT64_MAX;
+
+    for (int i = 0; i < 100000; i++) {
+        uint64_t start = bench_time_ns();
+        uint64_t elapsed = bench_time_ns() - start;
+        if (elapsed < min_ns) {
+            min_ns = elapsed;
+        }
+    }
+
+    bench_timer_overhead_ns = min_ns;
+}
+
+static void bench_fill_telemetry(telemetry_data *data)
+{
+    memset(data, 0, sizeof(telemetry_data));
+
+    data->data_counter = 1234;
+    data->battery_voltage_millivolts = 2870;
+    data->internal_temperature_celsius_100 = -2150;
+    data->temperature_celsius_100 = -4520;
+    data->pressure_mbar_100 = 12050;
+    data->humidity_percentage_100 = 1230;
+
+    data->gps.time_of_week_millis = 302400000;
+    data->gps.week = 2330;
+    data->gps.year = 2024;
+    data->gps.month = 9;
+    data->gps.day = 11;
+    data->gps.hours = 11;
+    data->gps.minutes = 59;
+    data->gps.seconds = 42;
+    data->gps.latitude_degrees_10000000 = 601700000;
+    data->gps.longitude_degrees_10000000 = 249400000;
+    data->gps.altitude_mm = 28345000;
+    data->gps.ground_speed_cm_per_second = 2150;
+    data->gps.heading_degrees_100000 = 27312345;
+    data->gps.climb_cm_per_second = 512;
+    data->gps.satellites_visible = 9;
+    data->gps.fix = 3;
+    data->gps.fix_ok = true;
+    data->gps.position_dilution_of_precision = 150;
+
+    strcpy(data->locator, "KP20LE51WM");
+}
+
+static void bench_new_encoder(bench_case *bench, fsk_encoder *encoder)
+{
+    switch (bench->encoder_type) {
+        case BENCH_ENCODER_BELL:
+            bell_encoder_new(encoder, bench->symbol_rate, BELL_FLAG_FIELD_COUNT_1200, bell202_tones);
+            break;
+        case BENCH_ENCODER_MFSK:
+            mfsk_encoder_new(encoder, MFSK_4, bench->symbol_rate, HORUS_V2_TONE_SPACING_HZ_SI5351 * 100);
+            break;
+        case BENCH_ENCODER_MORSE:
+            morse_encoder_new(encoder, bench->symbol_rate);
+            break;
+        case BENCH_ENCODER_JTENCODE:
+            jtencode_encoder_new(encoder, sizeof(bench_symbol_data), bench_symbol_data, bench->jtencode_mode,
+                    BENCH_WSPR_CALLSIGN, "KP20", WSPR_DBM, FSQ_CALLSIGN_FROM);
+            break;
+        case BENCH_ENCODER_RAW:
+            raw_encoder_new(encoder);
+            break;
+    }
+}
+
+/**
+ * Encodes the packet the same way radio_start_transmit() does and returns the elapsed time
+ */
+static uint64_t bench_encode_packet(bench_case *bench, telemetry_data *telemetry, fsk_encoder *encoder,
+        uint16_t *payload_length)
+{
+    uint64_t start = bench_time_ns();
+
+    if (bench->message_template != NULL) {
+        template_replace(bench_message, sizeof(bench_message), bench->message_template, telemetry);
+    } else {
+        bench_message[0] = '\0';
+    }
+
+    *payload_length = bench->payload_encoder->encode(bench_payload, sizeof(bench_payload), telemetry, bench_message);
+    bench->fsk_encoder_api->set_data(encoder, *payload_length, bench_payload);
+
+    return bench_time_ns() - start;
+}
+
+static int8_t bench_stream_next_tone(fsk_encoder *encoder)
+{
+    return fsk_symbol_stream_next_tone(&bench_stream);
+}
+
+static void bench_rewind(bench_case *bench, fsk_encoder *encoder, uint16_t payload_length, bool rendered)
+{
+    if (rendered) {
+        bench_stream.current_symbol_index = 0;
+    } else {
+        bench->fsk_encoder_api->set_data(encoder, payload_length, bench_payload);
+    }
+}
+
+/**
+ * Measures the average and worst-case time of next_tone() over the whole symbol stream
+ */
+static void bench_measure_tones(bench_case *bench, fsk_encoder *encoder, uint16_t payload_length, bool rendered,
+        int repetitions, bench_tone_result *result)
+{
+    int8_t (*next_tone)(fsk_encoder *) = rendered ? bench_stream_next_tone : bench->fsk_encoder_api->next_tone;
+
+    result->average_ns = -1;
+    result->worst_ns = 0;
+
+    for (int i = 0; i < BENCH_SYMBOL_COUNT_MAX; i++) {
+        bench_tone_min_ns[i] = UINT64_MAX;
+    }
+
+    for (int repetition = 0; repetition < repetitions; repetition++) {
+        // Whole stream without per-call timers for the average
+        uint32_t symbol_count = 0;
+        bench_rewind(bench, encoder, payload_length, rendered);
+        uint64_t start = bench_time_ns();
+        while (next_tone(encoder) >= 0) {
+            symbol_count++;
+        }
+        uint64_t stream_ns = bench_time_ns() - start;
+
+        if (symbol_count > 0) {
+            double average_ns = (double) stream_ns / symbol_count;
+            if (result->average_ns < 0 || average_ns < result->average_ns) {
+                result->average_ns = average_ns;
+            }
+        }
+        result->symbol_count = symbol_count;
+
+        // Per-call timing for the worst case
+        bench_rewind(bench, encoder, payload_length, rendered);
+        for (uint32_t index = 0; index < BENCH_SYMBOL_COUNT_MAX; index++) {
+            uint64_t call_start = bench_time_ns();
+            int8_t tone = next_tone(encoder);
+            uint64_t call_ns = bench_time_ns() - call_start;
+
+            call_ns = call_ns > bench_timer_overhead_ns ? call_ns - bench_timer_overhead_ns : 0;
+            if (call_ns < bench_tone_min_ns[index]) {
+                bench_tone_min_ns[index] = call_ns;
+            }
+
+            if (tone < 0) {
+                break;
+            }
+        }
+    }
+
+    for (uint32_t index = 0; index < result->symbol_count && index < BENCH_SYMBOL_COUNT_MAX; index++) {
+        if (bench_tone_min_ns[index] > result->worst_ns) {
+            result->worst_ns = bench_tone_min_ns[index];
+        }
+    }
+
+    if (result->average_ns < 0) {
+        result->average_ns = 0;
+    }
+}
+
+/**
+ * The rendered symbol stream must reproduce the lazily evaluated tones exactly
+ */
+static bool bench_verify_render(bench_case *bench, fsk_encoder *encoder, uint16_t payload_length)
+{
+    uint32_t index = 0;
+    int8_t tone;
+
+    bench_stream.current_symbol_index = 0;
+    bench->fsk_encoder_api->set_data(encoder, payload_length, bench_payload);
+
+    do {
+        tone = bench->fsk_encoder_api->next_tone(encoder);
+        int8_t stream_tone = fsk_symbol_stream_next_tone(&bench_stream);
+        if (tone != stream_tone) {
+            fprintf(stderr, "FAIL: %s: rendered symbol %u is %d, expected %d\n", bench->name, index, stream_tone,
+                    tone);
+            return false;
+        }
+        index++;
+    } while (tone >= 0);
+
+    return true;
+}
+
+static bool bench_run_case(bench_case *bench, int repetitions, bench_result *result)
+{
+    telemetry_data telemetry;
+    fsk_encoder encoder;
+    bool success = true;
+
+    bench_fill_telemetry(&telemetry);
+    memset(result, 0, sizeof(bench_result));
+    result->packet_ns = UINT64_MAX;
+    result->render_ns = UINT64_MAX;
+
+    bench_new_encoder(bench, &encoder);
+
+    for (int repetition = 0; repetition < repetitions; repetition++) {
+        uint64_t packet_ns = bench_encode_packet(bench, &telemetry, &encoder, &result->payload_length);
+        if (packet_ns < result->packet_ns) {
+            result->packet_ns = packet_ns;
+        }
+    }
+
+    if (bench->fsk_encoder_api->next_tone == NULL) {
+        // FIFO-fed modes: the radio reads the packet buffer directly, there is no per-symbol work
+        result->render_ns = 0;
+        return true;
+    }
+
+    bench_measure_tones(bench, &encoder, result->payload_length, false, repetitions, &result->tone);
+
+    if (bench->fsk_encoder_api->render == NULL) {
+        result->render_ns = 0;
+        return true;
+    }
+
+    for (int repetition = 0; repetition < repetitions; repetition++) {
+        uint64_t start = bench_time_ns();
+        result->rendered = bench->fsk_encoder_api->render(&encoder, &bench_stream);
+        uint64_t render_ns = bench_time_ns() - start;
+        if (render_ns < result->render_ns) {
+            result->render_ns = render_ns;
+        }
+    }
+
+    if (!result->rendered) {
+        fprintf(stderr, "FAIL: %s: %u symbols do not fit in the symbol stream\n", bench->name,
+                (unsigned int) result->tone.symbol_count);
+        return false;
+    }
+
+    success &= bench_verify_render(bench, &encoder, result->payload_length);
+
+    bench_measure_tones(bench, &encoder, result->payload_length, true, repetitions, &result->stream_tone);
+
+    return success;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_options options = {
+            .repetitions = BENCH_DEFAULT_REPETITIONS,
+    };
+
+    if (!bench_parse_options(argc, argv, "", "", &options)) {
+        return 2;
+    }
+    int repetitions = options.repetitions;
+
+    bench_calibrate_timer();
+
+    printf("Timer overhead: %llu ns, repetitions: %d, budgets: %s (scale %.2f)\n\n",
+            (unsigned long long) bench_timer_overhead_ns, repetitions,
+            options.check_budgets ? "checked" : "not checked", options.budget_scale);
+    printf("%-18s %8s %8s %11s %12s %12s %11s %12s %12s %14s\n", "encoder", "bytes", "symbols", "packet us",
+            "tone avg ns", "tone max ns", "render us", "stream avg ns", "stream max ns", "symbol period us");
+
+    bool success = true;
+
+    for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_case); i++) {
+        bench_case *bench = &bench_cases[i];
+        bench_result result;
+
+        success &= bench_run_case(bench, repetitions, &result);
+
+        printf("%-18s %8u %8lu %11.3f %12.1f %12llu %11.3f %12.1f %12llu %14.1f\n", bench->name,
+                result.payload_length, (unsigned long) result.tone.symbol_count, (double) result.packet_ns / 1000.0,
+                result.tone.average_ns, (unsigned long long) result.tone.worst_ns, (double) result.render_ns / 1000.0,
+                result.stream_tone.average_ns, (unsigned long long) result.stream_tone.worst_ns,
+                bench->symbol_rate > 0 ? 1000000.0 / bench->symbol_rate : 0.0);
+
+        success &= bench_check_budget(&options, bench->name, "packet encode", (double) result.packet_ns,
+                (double) bench->budget_packet_ns);
+        success &= bench_check_budget(&options, bench->name, "average next_tone", result.tone.average_ns,
+                (double) bench->budget_tone_average_ns);
+        success &= bench_check_budget(&options, bench->name, "worst-case next_tone", (double) result.tone.worst_ns,
+                (double) bench->budget_tone_worst_ns);
+    }
+
+    return success ? 0 : 1;
+}
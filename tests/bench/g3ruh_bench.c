@@ -0,0 +1,256 @@
+/**
+ * G3RUH (APRS 9600 baud) encoder fuzz test and benchmark: the byte-wise scrambler and NRZI encoder in
+ * g3ruh_encode() against the original bit-serial implementation, which is kept here as the reference.
+ *
+ * Random AX.25 frames of random length (with long runs of ones to exercise bit stuffing) are encoded into output
+ * buffers of random size, including buffers too small for the whole frame. The returned length and all returned
+ * bytes must match the reference. The encode time is then measured for a full-size frame, taking the fastest of all
+ * repetitions. On x86 hosts, time stamp counter cycles are reported too.
+ *
+ * Usage: g3ruh_bench [-b] [-s budget_scale] [-r repetitions] [-n iterations] [-S seed]
+ * Exits with a non-zero status on a mismatch, if the byte-wise encoder is not enough faster than the bit-serial one
+ * in the same run or, with -b, if it exceeds its budget (multiplied by budget_scale).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "config.h"
+#include "codecs/aprs_9600/aprs_9600.h"
+
+#define BENCH_DEFAULT_REPETITIONS 20000
+#define BENCH_DEFAULT_ITERATIONS 20000
+
+#define BENCH_FRAME_MAX_LENGTH 330
+#define BENCH_OUTPUT_MAX_LENGTH (BENCH_FRAME_MAX_LENGTH * 2)
+
+// Budget in host nanoseconds for a full-size frame
+#define BENCH_BUDGET_NS 8000
+// Minimum speedup of the byte-wise encoder over the bit-serial one
+#define BENCH_MIN_SPEEDUP 2.0
+
+typedef uint16_t (*bench_encode_function)(uint8_t *ax25_frame, uint16_t ax25_length, uint8_t *output,
+        uint16_t max_output_length);
+
+typedef struct _bench_timing {
+    double ns;
+    double cycles;
+} bench_timing;
+
+static uint8_t bench_frame[BENCH_FRAME_MAX_LENGTH];
+static uint8_t bench_output[BENCH_OUTPUT_MAX_LENGTH];
+static uint8_t bench_reference_output[BENCH_OUTPUT_MAX_LENGTH];
+
+// Original bit-serial implementation
+
+#define REFERENCE_PREAMBLE_FLAGS 64
+
+typedef struct {
+    uint8_t *output;
+    uint16_t max_length;
+    uint16_t byte_index;
+    uint8_t bit_index;
+    uint32_t scrambler_state;
+    uint8_t nrzi_state;
+} reference_state;
+
+static void reference_emit_bit(reference_state *state, uint8_t bit)
+{
+    if (state->byte_index >= state->max_length) {
+        return;
+    }
+
+    uint8_t tap12 = (state->scrambler_state >> 11) & 1;
+    uint8_t tap17 = (state->scrambler_state >> 16) & 1;
+    uint8_t scrambled = (bit ^ tap12 ^ tap17) & 1;
+    state->scrambler_state = (state->scrambler_state << 1) | scrambled;
+
+    if (!scrambled) {
+        state->nrzi_state ^= 1;
+    }
+
+    if (state->nrzi_state) {
+        state->output[state->byte_index] |= (1U << state->bit_index);
+    }
+
+    if (state->bit_index == 0) {
+        state->bit_index = 7;
+        state->byte_index++;
+    } else {
+        state->bit_index--;
+    }
+}
+
+static void reference_emit_byte_raw(reference_state *state, uint8_t byte)
+{
+    for (uint8_t i = 0; i < 8; i++) {
+        reference_emit_bit(state, (byte >> i) & 1);
+    }
+}
+
+static uint8_t reference_emit_byte_stuffed(reference_state *state, uint8_t byte, uint8_t ones_count)
+{
+    for (uint8_t i = 0; i < 8; i++) {
+        uint8_t bit = (byte >> i) & 1;
+        reference_emit_bit(state, bit);
+
+        if (bit) {
+            ones_count++;
+            if (ones_count == 5) {
+                reference_emit_bit(state, 0);
+                ones_count = 0;
+            }
+        } else {
+            ones_count = 0;
+        }
+    }
+    return ones_count;
+}
+
+static uint16_t reference_g3ruh_encode(uint8_t *ax25_frame, uint16_t ax25_length, uint8_t *output,
+        uint16_t max_output_length)
+{
+    reference_state state;
+    memset(&state, 0, sizeof(state));
+    state.output = output;
+    state.max_length = max_output_length;
+    state.bit_index = 7;
+    memset(output, 0, max_output_length);
+
+    for (uint16_t i = 0; i < REFERENCE_PREAMBLE_FLAGS + 1; i++) {
+        reference_emit_byte_raw(&state, 0x7E);
+    }
+
+    uint8_t ones_count = 0;
+    for (uint16_t i = 1; i < ax25_length - 1; i++) {
+        ones_count = reference_emit_byte_stuffed(&state, ax25_frame[i], ones_count);
+    }
+
+    reference_emit_byte_raw(&state, 0x7E);
+
+    return state.byte_index + (state.bit_index < 7 ? 1 : 0);
+}
+
+/**
+ * Mostly random bytes, with enough 0xFF, 0x7E and other ones-heavy bytes to produce runs of ones across byte
+ * boundaries
+ */
+static void bench_fill_frame(uint16_t length)
+{
+    static const uint8_t ones_heavy[] = {0xFF, 0x7E, 0xFE, 0x7F, 0xF8, 0x1F, 0xEF, 0xF7};
+
+    for (uint16_t i = 0; i < length; i++) {
+        if (rand() % 3 == 0) {
+            bench_frame[i] = ones_heavy[rand() % sizeof(ones_heavy)];
+        } else {
+            bench_frame[i] = (uint8_t) rand();
+        }
+    }
+
+    bench_frame[0] = 0x7E;
+    bench_frame[length - 1] = 0x7E;
+}
+
+static bool bench_verify(int iterations)
+{
+    for (int i = 0; i < iterations; i++) {
+        uint16_t frame_length = (uint16_t) (2 + rand() % (BENCH_FRAME_MAX_LENGTH - 1));
+        uint16_t max_output_length = (uint16_t) (rand() % (BENCH_OUTPUT_MAX_LENGTH + 1));
+
+        bench_fill_frame(frame_length);
+        // Garbage in the output buffer must not leak into the encoded stream
+        memset(bench_output, rand(), sizeof(bench_output));
+
+        uint16_t expected = reference_g3ruh_encode(bench_frame, frame_length, bench_reference_output,
+                max_output_length);
+        uint16_t actual = g3ruh_encode(bench_frame, frame_length, bench_output, max_output_length);
+
+        if (actual != expected) {
+            fprintf(stderr, "FAIL: iteration %d: %u byte frame into %u bytes: length %u, expected %u\n", i,
+                    frame_length, max_output_length, actual, expected);
+            return false;
+        }
+
+        for (uint16_t j = 0; j < expected; j++) {
+            if (bench_output[j] != bench_reference_output[j]) {
+                fprintf(stderr, "FAIL: iteration %d: %u byte frame into %u bytes: byte %u is 0x%02X, expected 0x%02X\n",
+                        i, frame_length, max_output_length, j, bench_output[j], bench_reference_output[j]);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void bench_measure(bench_encode_function encode, int repetitions, bench_timing *timing)
+{
+    uint64_t min_ns = UINT64_MAX;
+    uint64_t min_cycles = UINT64_MAX;
+
+    for (int r = 0; r < repetitions; r++) {
+        uint64_t start_cycles = bench_cycles();
+        uint64_t start_ns = bench_time_ns();
+        encode(bench_frame, BENCH_FRAME_MAX_LENGTH, bench_output, BENCH_OUTPUT_MAX_LENGTH);
+        uint64_t elapsed_ns = bench_time_ns() - start_ns;
+        uint64_t elapsed_cycles = bench_cycles() - start_cycles;
+
+        if (elapsed_ns < min_ns) {
+            min_ns = elapsed_ns;
+        }
+        if (elapsed_cycles < min_cycles) {
+            min_cycles = elapsed_cycles;
+        }
+    }
+
+    timing->ns = (double) min_ns;
+    timing->cycles = (double) min_cycles;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_options options = {
+            .repetitions = BENCH_DEFAULT_REPETITIONS,
+            .count = BENCH_DEFAULT_ITERATIONS,
+            .seed = 1,
+    };
+
+    if (!bench_parse_options(argc, argv, "n:S:", "[-n iterations] [-S seed]", &options)) {
+        return 1;
+    }
+    int repetitions = options.repetitions;
+
+    srand(options.seed);
+
+    if (!bench_verify(options.count)) {
+        return 1;
+    }
+
+    bench_fill_frame(BENCH_FRAME_MAX_LENGTH);
+
+    bench_timing bitwise;
+    bench_timing bytewise;
+    bench_measure(reference_g3ruh_encode, repetitions, &bitwise);
+    bench_measure(g3ruh_encode, repetitions, &bytewise);
+
+    printf("%-16s %12s %12s %12s %12s %8s\n", "frame", "bitwise ns", "byte ns", "bitwise cyc", "byte cyc",
+            "speedup");
+
+    if (BENCH_CYCLES_AVAILABLE) {
+        printf("%-16s %12.0f %12.0f %12.0f %12.0f %8.2f\n", "Full (330 B)", bitwise.ns, bytewise.ns,
+                bitwise.cycles, bytewise.cycles, bitwise.ns / bytewise.ns);
+    } else {
+        printf("%-16s %12.0f %12.0f %12s %12s %8.2f\n", "Full (330 B)", bitwise.ns, bytewise.ns, "-", "-",
+                bitwise.ns / bytewise.ns);
+    }
+
+    bool success = bench_check_speedup("Full (330 B)", "byte-wise encoder", bitwise.ns, bytewise.ns,
+            BENCH_MIN_SPEEDUP);
+    success &= bench_check_budget(&options, "Full (330 B)", "byte-wise encoder", bytewise.ns, BENCH_BUDGET_NS);
+
+    return success ? 0 : 1;
+}
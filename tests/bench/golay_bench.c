@@ -0,0 +1,200 @@
+/**
+ * Horus L2 Golay (23,12) encoder benchmark: the lookup table encoder against the original bit-serial one.
+ *
+ * For random payloads of every length up to HORUS_UNCODED_BUFFER_SIZE, both encoders must produce identical
+ * output, and the complete packets from horus_l2_encode_tx_packet() must decode back to the payload with
+ * horus_l2_decode_rx_packet() (the decoder of the horus_l2.c unit test harness), also with a bit error inserted.
+ * Encoding in place, with the payload already at its position after the unique word, must give the same packet.
+ * The Golay encode time (without interleaving and scrambling) is measured for a Horus v2 sized and a full-size
+ * payload, taking the fastest of all repetitions. On x86 hosts, time stamp counter cycles are reported too.
+ *
+ * Usage: golay_bench [-b] [-s budget_scale] [-r repetitions]
+ * Exits with a non-zero status on a mismatch, if the table encoder is not enough faster than the bit-serial one
+ * in the same run or, with -b, if the table encoder exceeds its budget (multiplied by budget_scale).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "config.h"
+#include "codecs/horus/horus_l2.h"
+
+#define BENCH_DEFAULT_REPETITIONS 20000
+
+void golay23_init(void);
+
+typedef int (*bench_encode_function)(unsigned char *output_tx_data, unsigned char *input_payload_data,
+        int num_payload_data_bytes);
+
+typedef struct _bench_case {
+    const char *name;
+    int payload_length;
+
+    // Budget in host nanoseconds per packet
+    double budget_table_ns;
+    // Minimum speedup of the table encoder over the bit-serial one
+    double min_speedup;
+} bench_case;
+
+typedef struct _bench_timing {
+    double ns;
+    double cycles;
+} bench_timing;
+
+static bench_case bench_cases[] = {
+        {
+                .name = "Horus v2 (22 B)",
+                .payload_length = 22,
+                .budget_table_ns = 300,
+                .min_speedup = 3,
+        },
+        {
+                .name = "Full (128 B)",
+                .payload_length = HORUS_UNCODED_BUFFER_SIZE,
+                .budget_table_ns = 1000,
+                .min_speedup = 5,
+        },
+};
+
+static unsigned char bench_payload[HORUS_UNCODED_BUFFER_SIZE];
+static unsigned char bench_decoded[HORUS_UNCODED_BUFFER_SIZE];
+static unsigned char bench_table_packet[HORUS_CODED_BUFFER_SIZE];
+static unsigned char bench_bitwise_packet[HORUS_CODED_BUFFER_SIZE];
+
+static void bench_fill_payload()
+{
+    for (size_t i = 0; i < sizeof(bench_payload); i++) {
+        bench_payload[i] = (unsigned char) rand();
+    }
+}
+
+/**
+ * The decoder descrambles and deinterleaves the packet in place
+ */
+static bool bench_decode(unsigned char *packet, int payload_length, bool insert_errors)
+{
+    if (insert_errors) {
+        int packet_length = horus_l2_get_num_tx_data_bytes(payload_length);
+        // A single bit error is always correctable, wherever the interleaver puts it. Skip the unique word.
+        int bit = 16 + (payload_length * 37) % (packet_length * 8 - 16);
+        packet[bit / 8] ^= 0x80 >> (bit % 8);
+    }
+
+    horus_l2_decode_rx_packet(bench_decoded, packet, payload_length);
+
+    return memcmp(bench_decoded, bench_payload, payload_length) == 0;
+}
+
+static bool bench_verify()
+{
+    for (int length = 1; length <= HORUS_UNCODED_BUFFER_SIZE; length++) {
+        bench_fill_payload();
+
+        int table_length = horus_l2_encode_golay_table(bench_table_packet, bench_payload, length);
+        int bitwise_length = horus_l2_encode_golay_bitwise(bench_bitwise_packet, bench_payload, length);
+
+        if (table_length != bitwise_length || memcmp(bench_table_packet, bench_bitwise_packet, table_length) != 0) {
+            fprintf(stderr, "FAIL: %d byte payload: table and bitwise encoders differ\n", length);
+            return false;
+        }
+
+        int packet_length = horus_l2_encode_tx_packet(bench_table_packet, bench_payload, length);
+
+        memset(bench_bitwise_packet, 0, sizeof(bench_bitwise_packet));
+        memcpy(bench_bitwise_packet + HORUS_L2_TX_PAYLOAD_OFFSET, bench_payload, length);
+        horus_l2_encode_tx_packet(bench_bitwise_packet, bench_bitwise_packet + HORUS_L2_TX_PAYLOAD_OFFSET, length);
+        if (memcmp(bench_table_packet, bench_bitwise_packet, packet_length) != 0) {
+            fprintf(stderr, "FAIL: %d byte payload: in-place encoding differs\n", length);
+            return false;
+        }
+
+        if (!bench_decode(bench_table_packet, length, false)) {
+            fprintf(stderr, "FAIL: %d byte payload does not decode\n", length);
+            return false;
+        }
+
+        horus_l2_encode_tx_packet(bench_table_packet, bench_payload, length);
+        if (!bench_decode(bench_table_packet, length, true)) {
+            fprintf(stderr, "FAIL: %d byte payload does not decode with a bit error\n", length);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void bench_measure(bench_encode_function encode, int payload_length, int repetitions, bench_timing *timing)
+{
+    uint64_t min_ns = UINT64_MAX;
+    uint64_t min_cycles = UINT64_MAX;
+
+    for (int r = 0; r < repetitions; r++) {
+        uint64_t start_cycles = bench_cycles();
+        uint64_t start_ns = bench_time_ns();
+        encode(bench_table_packet, bench_payload, payload_length);
+        uint64_t elapsed_ns = bench_time_ns() - start_ns;
+        uint64_t elapsed_cycles = bench_cycles() - start_cycles;
+
+        if (elapsed_ns < min_ns) {
+            min_ns = elapsed_ns;
+        }
+        if (elapsed_cycles < min_cycles) {
+            min_cycles = elapsed_cycles;
+        }
+    }
+
+    timing->ns = (double) min_ns;
+    timing->cycles = (double) min_cycles;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_options options = {
+            .repetitions = BENCH_DEFAULT_REPETITIONS,
+    };
+
+    if (!bench_parse_options(argc, argv, "", "", &options)) {
+        return 1;
+    }
+    int repetitions = options.repetitions;
+
+    srand(1);
+    golay23_init();
+
+    if (!bench_verify()) {
+        return 1;
+    }
+
+    bool success = true;
+
+    printf("%-16s %12s %12s %12s %12s %8s\n", "payload", "bitwise ns", "table ns", "bitwise cyc", "table cyc",
+            "speedup");
+
+    for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_case); i++) {
+        bench_case *bench = &bench_cases[i];
+
+        bench_fill_payload();
+
+        bench_timing bitwise;
+        bench_timing table;
+        bench_measure(horus_l2_encode_golay_bitwise, bench->payload_length, repetitions, &bitwise);
+        bench_measure(horus_l2_encode_golay_table, bench->payload_length, repetitions, &table);
+
+        if (BENCH_CYCLES_AVAILABLE) {
+            printf("%-16s %12.0f %12.0f %12.0f %12.0f %8.2f\n", bench->name, bitwise.ns, table.ns, bitwise.cycles,
+                    table.cycles, bitwise.ns / table.ns);
+        } else {
+            printf("%-16s %12.0f %12.0f %12s %12s %8.2f\n", bench->name, bitwise.ns, table.ns, "-", "-",
+                    bitwise.ns / table.ns);
+        }
+
+        success &= bench_check_speedup(bench->name, "table encoder", bitwise.ns, table.ns, bench->min_speedup);
+        success &= bench_check_budget(&options, bench->name, "table encoder", table.ns, bench->budget_table_ns);
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+/**
+ * Horus v3 packet encoder benchmark: the precomputed prefix encoder against the generic asn1scc encoder.
+ *
+ * Both encoders run on the same random telemetry, including values outside the ranges of the ASN.1 definition,
+ * and must produce identical packets: the same frame size, CRC and every byte of the uncoded buffer. The encode
+ * time of a complete packet (message, padding and CRC) is measured for a typical telemetry sample, taking the
+ * fastest of all repetitions. On x86 hosts, time stamp counter cycles are reported too. Built for RS41, and for
+ * DFM17 where the calibration values are sent as extra sensors.
+ *
+ * Usage: horus_v3_bench [-b] [-s budget_scale] [-r repetitions] [-n packets] [-S seed]
+ * Exits with a non-zero status on a mismatch, if the fast encoder is not enough faster than asn1scc in the same run
+ * or, with -b, if it exceeds its budget (multiplied by budget_scale).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "config.h"
+#include "codecs/horus/horus_packet_v3.h"
+
+#define BENCH_DEFAULT_REPETITIONS 20000
+#define BENCH_DEFAULT_PACKETS 200000
+
+// Budget in host nanoseconds per packet
+#define BENCH_BUDGET_FAST_NS 1500
+
+// Minimum speedup of the fast encoder over asn1scc: the extra sensors of the DFM17 are encoded generically
+#ifdef DFM17
+#define BENCH_MIN_SPEEDUP 1.3
+#else
+#define BENCH_MIN_SPEEDUP 2.0
+#endif
+
+typedef size_t (*bench_encode_function)(uint8_t *payload, telemetry_data *data);
+
+typedef struct _bench_timing {
+    double ns;
+    double cycles;
+} bench_timing;
+
+extern volatile uint16_t horus_v3_packet_counter;
+
+static uint8_t bench_fast_packet[HORUS_UNCODED_BUFFER_SIZE];
+static uint8_t bench_asn1_packet[HORUS_UNCODED_BUFFER_SIZE];
+
+static int32_t bench_random_range(int32_t min, int32_t max)
+{
+    uint32_t value = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+    uint64_t span = (uint64_t) ((int64_t) max - min) + 1;
+    return (int32_t) ((int64_t) min + (int64_t) (value % span));
+}
+
+/**
+ * Mostly in-range values with a share of out-of-range and boundary values for every field.
+ */
+static int32_t bench_random_field(int32_t min, int32_t max, int32_t limit_min, int32_t limit_max)
+{
+    switch (rand() % 8) {
+        case 0:
+            return bench_random_range(limit_min, limit_max);
+        case 1:
+            return rand() & 1 ? min : max;
+        default:
+            return bench_random_range(min, max);
+    }
+}
+
+static void bench_random_telemetry(telemetry_data *data)
+{
+    memset(data, 0, sizeof(telemetry_data));
+
+    data->gps.hours = (uint8_t) bench_random_field(0, 23, 0, 255);
+    data->gps.minutes = (uint8_t) bench_random_field(0, 59, 0, 255);
+    data->gps.seconds = (uint8_t) bench_random_field(0, 59, 0, 255);
+    data->gps.latitude_degrees_10000000 = bench_random_field(-900000000, 900000000, INT32_MIN, INT32_MAX);
+    data->gps.longitude_degrees_10000000 = bench_random_field(-1800000000, 1800000000, INT32_MIN, INT32_MAX);
+    data->gps.altitude_mm = bench_random_field(-1000000, 50000000, INT32_MIN, INT32_MAX);
+    data->gps.ground_speed_cm_per_second = (uint32_t) bench_random_field(0, 14000, 0, 1000000);
+    data->gps.climb_cm_per_second = bench_random_field(-32767, 32767, -10000000, 10000000);
+    data->gps.satellites_visible = (uint8_t) bench_random_field(0, 31, 0, 255);
+    data->gps.power_safe_mode_state = (uint8_t) bench_random_field(0, 5, 0, 7);
+
+    data->internal_temperature_celsius_100 = bench_random_field(-10230, 10230, -400000, 400000);
+    data->battery_voltage_millivolts = (uint16_t) bench_random_field(0, 16383, 0, 65535);
+
+    data->ext_sensor_type = (sensor_type) bench_random_range(NO_EXT_SENSOR, SENSOR_BME690);
+    data->temperature_celsius_100 = bench_random_field(-10230, 10230, -400000, 400000);
+    data->humidity_percentage_100 = (uint32_t) bench_random_field(0, 10000, 0, 1000000);
+    data->pressure_mbar_100 = (uint32_t) bench_random_field(0, 120000, 0, 1000000);
+
+    data->pulse_count = (uint16_t) rand();
+    data->radiation_intensity_uR_h = (float) bench_random_range(0, 100000) / 10.0f;
+    data->bme6xx_gas_r = (uint32_t) rand();
+    data->si4063_capacitance_trim = (uint8_t) rand();
+    data->cap_trim_offset = bench_random_range(-127, 127);
+    data->timepulse_error_us = bench_random_field(-1000, 1000, -10000000, 10000000);
+    data->po_state = (uint8_t) rand();
+}
+
+static void bench_typical_telemetry(telemetry_data *data)
+{
+    memset(data, 0, sizeof(telemetry_data));
+
+    data->gps.hours = 12;
+    data->gps.minutes = 34;
+    data->gps.seconds = 56;
+    data->gps.latitude_degrees_10000000 = 601234567;
+    data->gps.longitude_degrees_10000000 = 249876543;
+    data->gps.altitude_mm = 23456000;
+    data->gps.ground_speed_cm_per_second = 1234;
+    data->gps.climb_cm_per_second = 512;
+    data->gps.satellites_visible = 11;
+    data->internal_temperature_celsius_100 = -2150;
+    data->battery_voltage_millivolts = 2950;
+}
+
+static bool bench_verify(int packets)
+{
+    telemetry_data data;
+
+    for (int n = 0; n < packets; n++) {
+        bench_random_telemetry(&data);
+
+        // Both encoders must fill the whole buffer, whatever was there before
+        memset(bench_fast_packet, 0xA5, sizeof(bench_fast_packet));
+        memset(bench_asn1_packet, 0x5A, sizeof(bench_asn1_packet));
+
+        uint16_t counter = (uint16_t) rand();
+
+        horus_v3_packet_counter = counter;
+        size_t asn1_length = horus_packet_v3_create_asn1(bench_asn1_packet, &data);
+        horus_v3_packet_counter = counter;
+        size_t fast_length = horus_packet_v3_create_fast(bench_fast_packet, &data);
+
+        if (fast_length != asn1_length) {
+            fprintf(stderr, "FAIL: packet %d: fast encoder length %zu, asn1scc %zu\n", n, fast_length, asn1_length);
+            return false;
+        }
+        if (asn1_length > 0 && memcmp(bench_fast_packet, bench_asn1_packet, sizeof(bench_fast_packet)) != 0) {
+            fprintf(stderr, "FAIL: packet %d: fast encoder output differs from asn1scc\n", n);
+            for (size_t i = 0; i < asn1_length; i++) {
+                fprintf(stderr, "%02X%s", bench_asn1_packet[i], bench_fast_packet[i] != bench_asn1_packet[i] ? "*" : " ");
+            }
+            fprintf(stderr, "\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void bench_measure(bench_encode_function encode, telemetry_data *data, int repetitions, bench_timing *timing)
+{
+    uint64_t min_ns = UINT64_MAX;
+    uint64_t min_cycles = UINT64_MAX;
+
+    for (int r = 0; r < repetitions; r++) {
+        uint64_t start_cycles = bench_cycles();
+        uint64_t start_ns = bench_time_ns();
+        encode(bench_fast_packet, data);
+        uint64_t elapsed_ns = bench_time_ns() - start_ns;
+        uint64_t elapsed_cycles = bench_cycles() - start_cycles;
+
+        if (elapsed_ns < min_ns) {
+            min_ns = elapsed_ns;
+        }
+        if (elapsed_cycles < min_cycles) {
+            min_cycles = elapsed_cycles;
+        }
+    }
+
+    timing->ns = (double) min_ns;
+    timing->cycles = (double) min_cycles;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_options options = {
+            .repetitions = BENCH_DEFAULT_REPETITIONS,
+            .count = BENCH_DEFAULT_PACKETS,
+            .seed = 1,
+    };
+
+    if (!bench_parse_options(argc, argv, "n:S:", "[-n packets] [-S seed]", &options)) {
+        return 1;
+    }
+    int repetitions = options.repetitions;
+
+    srand(options.seed);
+
+    if (!bench_verify(options.count)) {
+        return 1;
+    }
+
+    telemetry_data data;
+    bench_typical_telemetry(&data);
+
+    bench_timing asn1;
+    bench_timing fast;
+    bench_measure(horus_packet_v3_create_asn1, &data, repetitions, &asn1);
+    bench_measure(horus_packet_v3_create_fast, &data, repetitions, &fast);
+
+#ifdef DFM17
+    const char *name = "DFM17";
+#else
+    const char *name = "RS41";
+#endif
+
+    printf("%-16s %12s %12s %12s %12s %8s\n", "target", "asn1scc ns", "fast ns", "asn1scc cyc", "fast cyc",
+            "speedup");
+
+    if (BENCH_CYCLES_AVAILABLE) {
+        printf("%-16s %12.0f %12.0f %12.0f %12.0f %8.2f\n", name, asn1.ns, fast.ns, asn1.cycles, fast.cycles,
+                asn1.ns / fast.ns);
+    } else {
+        printf("%-16s %12.0f %12.0f %12s %12s %8.2f\n", name, asn1.ns, fast.ns, "-", "-", asn1.ns / fast.ns);
+    }
+
+    bool success = bench_check_speedup(name, "fast encoder", asn1.ns, fast.ns, BENCH_MIN_SPEEDUP);
+    success &= bench_check_budget(&options, name, "fast encoder", fast.ns, BENCH_BUDGET_FAST_NS);
+
+    return success ? 0 : 1;
+}
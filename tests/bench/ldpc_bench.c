@@ -0,0 +1,276 @@
+/**
+ * CATS LDPC encoder benchmark: the 32-bit word encoder in cats_ldpc_encode_chunk() against the original
+ * byte-oriented implementation, which is kept here as the reference.
+ *
+ * For every code (tc128, tc256, tc512, tm2048), random data blocks must produce parity identical to the reference,
+ * and cats_ldpc_encode() must produce the same output as the reference for packets of all lengths it accepts.
+ * The time to encode one block is measured for each code, taking the fastest of all repetitions. On x86 hosts,
+ * time stamp counter cycles are reported too.
+ *
+ * Usage: ldpc_bench [-b] [-s budget_scale] [-r repetitions]
+ * Exits with a non-zero status on a mismatch, if the word encoder is not enough faster than the byte-oriented one
+ * in the same run or, with -b, if it exceeds its budget (multiplied by budget_scale).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "codecs/cats/ldpc.h"
+
+#define BENCH_DEFAULT_REPETITIONS 2000
+#define BENCH_VERIFY_BLOCKS 200
+
+// Largest packet accepted by cats_ldpc_encode(), data + parity + padding + length
+#define BENCH_PACKET_MAX_LENGTH 511
+#define BENCH_PACKET_BUFFER_LENGTH (BENCH_PACKET_MAX_LENGTH * 2 + 128 + 2)
+
+typedef size_t (*bench_encode_function)(uint8_t *data, cats_ldpc_code_t *code, uint8_t *parity_out);
+
+typedef struct _bench_case {
+    const char *name;
+    cats_ldpc_code_t *code;
+
+    // Budget in host nanoseconds per block
+    double budget_word_ns;
+    // Minimum speedup of the word encoder over the byte-oriented one
+    double min_speedup;
+} bench_case;
+
+typedef struct _bench_timing {
+    double ns;
+    double cycles;
+} bench_timing;
+
+static bench_case bench_cases[] = {
+        {
+                .name = "tc128",
+                .code = &tc128,
+                .budget_word_ns = 500,
+                .min_speedup = 1.3,
+        },
+        {
+                .name = "tc256",
+                .code = &tc256,
+                .budget_word_ns = 1500,
+                .min_speedup = 1.5,
+        },
+        {
+                .name = "tc512",
+                .code = &tc512,
+                .budget_word_ns = 5000,
+                .min_speedup = 2,
+        },
+        {
+                .name = "tm2048",
+                .code = &tm2048,
+                .budget_word_ns = 40000,
+                .min_speedup = 2,
+        },
+};
+
+static uint8_t bench_data[128];
+static uint8_t bench_parity[128];
+static uint8_t bench_reference_parity[128];
+
+static uint8_t bench_packet[BENCH_PACKET_BUFFER_LENGTH];
+static uint8_t bench_reference_packet[BENCH_PACKET_BUFFER_LENGTH];
+
+// Original byte-oriented implementation
+
+#define REFERENCE_GET_BIT(byte, bit) (((byte) & (1 << (7-(bit)))) != 0)
+
+static size_t reference_encode_chunk(uint8_t *data, cats_ldpc_code_t *code, uint8_t *parity_out)
+{
+    int data_length_bits = code->data_length_bits;
+    int parity_length_bits = code->code_length_bits - code->data_length_bits;
+    int circ_size = (int) code->circulant_size;
+    const uint64_t* gc = code->matrix;
+    int row_len = parity_length_bits / 64;
+
+    memset(parity_out, 0x00, parity_length_bits / 8);
+
+    for (int offset = 0; offset < circ_size; offset++) {
+        for (int crow = 0; crow < data_length_bits / circ_size; crow++) {
+            int bit = crow * circ_size + offset;
+            if (REFERENCE_GET_BIT(data[bit / 8], bit % 8)) {
+                for (int idx = 0; idx < row_len; idx++) {
+                    uint64_t circ = gc[(crow * row_len) + idx];
+                    for (int j = 0; j < 8; j++) {
+                        parity_out[idx * 8 + j] ^= (uint8_t)(circ >> ((7 - j) * 8));
+                    }
+                }
+            }
+        }
+
+        for (int block = 0; block < parity_length_bits / circ_size; block++) {
+            uint8_t* parityblock = &parity_out[block * circ_size / 8];
+            uint8_t carry = parityblock[0] >> 7;
+            for (int x = (circ_size / 8) - 1; x >= 0; x--) {
+                uint8_t c = parityblock[x] >> 7;
+                parityblock[x] = (parityblock[x] << 1) | carry;
+                carry = c;
+            }
+        }
+    }
+
+    return parity_length_bits / 8;
+}
+
+static size_t reference_encode(uint8_t *data, size_t len)
+{
+    uint8_t parity[128];
+
+    size_t i = 0;
+    while (i < len) {
+        cats_ldpc_code_t *code = cats_ldpc_pick_code(len - i);
+        int data_length_bits = code->data_length_bits;
+        size_t data_length = data_length_bits / 8;
+
+        uint8_t chunk[code->code_length_bits / 8];
+        memset(chunk, 0xAA, data_length);
+        memcpy(chunk, data + i, (len - i < data_length) ? (len - i) : data_length);
+
+        size_t parity_len = reference_encode_chunk(chunk, code, parity);
+        memcpy(data + len + i, parity, parity_len);
+
+        i += parity_len;
+    }
+
+    size_t new_len = (len * 2) + (i - len) + 2;
+    data[new_len - 2] = len;
+    data[new_len - 1] = len >> 8;
+    return new_len;
+}
+
+static void bench_fill(uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (uint8_t) rand();
+    }
+}
+
+static bool bench_verify_chunk(bench_case *bench)
+{
+    size_t parity_length = (bench->code->code_length_bits - bench->code->data_length_bits) / 8;
+
+    for (int i = 0; i < BENCH_VERIFY_BLOCKS; i++) {
+        bench_fill(bench_data, sizeof(bench_data));
+        // Sparse and dense blocks too
+        if (i == 0) {
+            memset(bench_data, 0x00, sizeof(bench_data));
+            bench_data[0] = 0x80;
+        } else if (i == 1) {
+            memset(bench_data, 0xFF, sizeof(bench_data));
+        }
+
+        size_t expected = reference_encode_chunk(bench_data, bench->code, bench_reference_parity);
+        size_t actual = cats_ldpc_encode_chunk(bench_data, bench->code, bench_parity);
+
+        if (actual != expected || actual != parity_length ||
+                memcmp(bench_parity, bench_reference_parity, parity_length) != 0) {
+            fprintf(stderr, "FAIL: %s: block %d: parity differs from the reference\n", bench->name, i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool bench_verify_packets()
+{
+    for (size_t length = 1; length <= BENCH_PACKET_MAX_LENGTH; length++) {
+        memset(bench_packet, 0, sizeof(bench_packet));
+        bench_fill(bench_packet, length);
+        memcpy(bench_reference_packet, bench_packet, sizeof(bench_packet));
+
+        size_t expected = reference_encode(bench_reference_packet, length);
+        size_t actual = cats_ldpc_encode(bench_packet, length);
+
+        if (actual != expected || memcmp(bench_packet, bench_reference_packet, expected) != 0) {
+            fprintf(stderr, "FAIL: %zu byte packet: encoded packet differs from the reference\n", length);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void bench_measure(bench_encode_function encode, cats_ldpc_code_t *code, int repetitions,
+        bench_timing *timing)
+{
+    uint64_t min_ns = UINT64_MAX;
+    uint64_t min_cycles = UINT64_MAX;
+
+    for (int r = 0; r < repetitions; r++) {
+        uint64_t start_cycles = bench_cycles();
+        uint64_t start_ns = bench_time_ns();
+        encode(bench_data, code, bench_parity);
+        uint64_t elapsed_ns = bench_time_ns() - start_ns;
+        uint64_t elapsed_cycles = bench_cycles() - start_cycles;
+
+        if (elapsed_ns < min_ns) {
+            min_ns = elapsed_ns;
+        }
+        if (elapsed_cycles < min_cycles) {
+            min_cycles = elapsed_cycles;
+        }
+    }
+
+    timing->ns = (double) min_ns;
+    timing->cycles = (double) min_cycles;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_options options = {
+            .repetitions = BENCH_DEFAULT_REPETITIONS,
+    };
+
+    if (!bench_parse_options(argc, argv, "", "", &options)) {
+        return 1;
+    }
+    int repetitions = options.repetitions;
+
+    srand(1);
+
+    if (!bench_verify_packets()) {
+        return 1;
+    }
+
+    bool success = true;
+
+    printf("%-10s %12s %12s %12s %12s %8s\n", "code", "byte ns", "word ns", "byte cyc", "word cyc", "speedup");
+
+    for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_case); i++) {
+        bench_case *bench = &bench_cases[i];
+
+        if (!bench_verify_chunk(bench)) {
+            success = false;
+            continue;
+        }
+
+        bench_fill(bench_data, sizeof(bench_data));
+
+        bench_timing byte;
+        bench_timing word;
+        bench_measure(reference_encode_chunk, bench->code, repetitions, &byte);
+        bench_measure(cats_ldpc_encode_chunk, bench->code, repetitions, &word);
+
+        if (BENCH_CYCLES_AVAILABLE) {
+            printf("%-10s %12.0f %12.0f %12.0f %12.0f %8.2f\n", bench->name, byte.ns, word.ns, byte.cycles,
+                    word.cycles, byte.ns / word.ns);
+        } else {
+            printf("%-10s %12.0f %12.0f %12s %12s %8.2f\n", bench->name, byte.ns, word.ns, "-", "-",
+                    byte.ns / word.ns);
+        }
+
+        success &= bench_check_speedup(bench->name, "word encoder", byte.ns, word.ns, bench->min_speedup);
+        success &= bench_check_budget(&options, bench->name, "word encoder", word.ns, bench->budget_word_ns);
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+/**
+ * Message template benchmark: template_compile() + template_render() against template_replace().
+ *
+ * A corpus of templates covering every placeholder (and the templates from config.c) must render to the same
+ * message as template_replace() for several sets of telemetry data, including negative and zero values.
+ * Rendering into a short buffer must truncate the message. The time to produce each message of the corpus is
+ * measured for both engines, taking the fastest of all repetitions. On x86 hosts, time stamp counter cycles are
+ * reported too.
+ *
+ * Usage: template_bench [-b] [-s budget_scale] [-r repetitions]
+ * Exits with a non-zero status on a mismatch, if rendering is not enough faster than template_replace() in the same
+ * run or, with -b, if it exceeds its budget (multiplied by budget_scale).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "config.h"
+#include "strlcpy.h"
+#include "template.h"
+#include "codecs/aprs/aprs.h"
+
+#define BENCH_DEFAULT_REPETITIONS 20000
+#define BENCH_MESSAGE_LENGTH 256
+
+// Budget in host nanoseconds for rendering all templates of the corpus once
+#define BENCH_BUDGET_NS 20000
+// Minimum speedup of rendering over template_replace()
+#define BENCH_MIN_SPEEDUP 5.0
+
+static char *bench_templates[] = {
+        // Every placeholder on its own
+        "$cs", "$loc4", "$loc6", "$loc8", "$loc12", "$bv", "$bu", "$te", "$ti", "$hu", "$pr", "$gas", "$tow",
+        "$hh", "$mm", "$ss", "$sv", "$lat", "$lon", "$alt", "$gs", "$cl", "$he", "$pc", "$ri", "$dc", "$gu", "$apc",
+        // Every placeholder in one message, adjacent to literals and other placeholders
+        "$cs$loc4$loc6$loc8$loc12$bv$bu$te$ti$hu$pr$gas$tow$hh$mm$ss$sv$lat$lon$alt$gs$cl$he$pc$ri$dc$gu$apc",
+        // Unknown placeholders and a lone '$' are kept as they are
+        "$ $$cs $x $loc $locx $csv$",
+        // No placeholders at all
+        "",
+        "E",
+        // Templates from config.c
+        "$cs $loc6 $altm $gs km/h $tiC",
+        "$cs $loc6",
+        "$alt m",
+        "$gs km/h $ti C",
+        " B$bu $teC $hu% $prmb $hh:$mm:$ss @ $tow ms - " APRS_COMMENT,
+        " B$bu $teC $hu% $prmb - " APRS_COMMENT,
+        " B$bu $loc12 $hh:$mm:$ss - " APRS_COMMENT,
+        " $loc12 - " APRS_COMMENT,
+        " $teC $hu% $prmb PC $pc RI $ri uR/h - " APRS_COMMENT,
+        "/P$apcS$svT$tiV$bvC$clA$bu " APRS_COMMENT,
+        " " APRS_COMMENT,
+        "$dc $gu $sv $lat $lon - $hh:$mm:$ss @ $tow ms",
+        "T:$teC H:$hu% P:$prmb - " CATS_COMMENT,
+        "T:$teC H:$hu% P:$prmb PC:$pc RI:$ri uR/h - " CATS_COMMENT,
+        CATS_COMMENT,
+        "TEST $loc6 $altm $tiC",
+        " $lat $lon, $alt m, $cl m/s, $gs km/h, $he deg - " CATS_COMMENT,
+        " $loc12, $teC $hu% $prmb $hh:$mm:$ss @ $tow ms - " CATS_COMMENT,
+        "$cs $loc4",
+        "$loc12",
+        "$altm $cl",
+        "$bvmV $tiC",
+};
+
+#define BENCH_TEMPLATE_COUNT (sizeof(bench_templates) / sizeof(char *))
+
+typedef struct _bench_timing {
+    double ns;
+    double cycles;
+} bench_timing;
+
+static telemetry_data bench_data[3];
+
+static char bench_rendered[BENCH_MESSAGE_LENGTH];
+static char bench_replaced[BENCH_MESSAGE_LENGTH];
+
+static void bench_fill_data()
+{
+    telemetry_data *data = &bench_data[0];
+    memset(data, 0, sizeof(telemetry_data));
+    data->data_counter = 1234;
+    data->battery_voltage_millivolts = 3247;
+    data->button_adc_value = 1021;
+    data->internal_temperature_celsius_100 = -7 * 100;
+    data->temperature_celsius_100 = 24 * 100;
+    data->humidity_percentage_100 = 68 * 100;
+    data->pressure_mbar_100 = 1023 * 100;
+    data->bme6xx_gas_r = 123456;
+    data->pulse_count = 42;
+    data->radiation_intensity_uR_h = 15.7f;
+    strlcpy(data->locator, "KP21FA35jk45", sizeof(data->locator));
+    data->gps.time_of_week_millis = 110022330;
+    data->gps.hours = 18;
+    data->gps.minutes = 3;
+    data->gps.seconds = 51;
+    data->gps.satellites_visible = 11;
+    data->gps.latitude_degrees_10000000 = 601234567;
+    data->gps.longitude_degrees_10000000 = 249876543;
+    data->gps.altitude_mm = 31234567;
+    data->gps.ground_speed_cm_per_second = 2345;
+    data->gps.climb_cm_per_second = 512;
+    data->gps.heading_degrees_100000 = 27512345;
+    data->gps.updated = true;
+
+    // Southern and western hemisphere, descending, freezing
+    data = &bench_data[1];
+    memcpy(data, &bench_data[0], sizeof(telemetry_data));
+    data->temperature_celsius_100 = -56 * 100;
+    data->internal_temperature_celsius_100 = -31 * 100;
+    data->gps.latitude_degrees_10000000 = -338765432;
+    data->gps.longitude_degrees_10000000 = -1512345678;
+    data->gps.altitude_mm = -12000;
+    data->gps.climb_cm_per_second = -1520;
+    data->gps.heading_degrees_100000 = 512345;
+    strlcpy(data->locator, "QF56", sizeof(data->locator));
+
+    // No GPS fix and no sensors
+    data = &bench_data[2];
+    memset(data, 0, sizeof(telemetry_data));
+}
+
+static bool bench_verify(char *template, template_compiled *compiled)
+{
+    for (size_t d = 0; d < sizeof(bench_data) / sizeof(telemetry_data); d++) {
+        aprs_packet_counter = (uint16_t) (d * 1000 + 7);
+
+        template_replace(bench_replaced, sizeof(bench_replaced), template, &bench_data[d]);
+        size_t length = template_render(bench_rendered, sizeof(bench_rendered), compiled, &bench_data[d]);
+
+        if (strcmp(bench_rendered, bench_replaced) != 0 || length != strlen(bench_replaced)) {
+            fprintf(stderr, "FAIL: data set %zu: \"%s\" rendered as \"%s\" (%zu), expected \"%s\"\n", d,
+                    template, bench_rendered, length, bench_replaced);
+            return false;
+        }
+
+        // Truncation to a message buffer shorter than the message
+        for (size_t short_length = 1; short_length <= length; short_length++) {
+            char truncated[BENCH_MESSAGE_LENGTH];
+            size_t truncated_length = template_render(truncated, short_length, compiled, &bench_data[d]);
+            if (truncated_length != short_length - 1 || strncmp(truncated, bench_replaced, truncated_length) != 0
+                    || truncated[truncated_length] != '\0') {
+                fprintf(stderr, "FAIL: data set %zu: \"%s\" truncated to %zu bytes as \"%s\"\n", d, template,
+                        short_length, truncated);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool bench_verify_compile_limits()
+{
+    template_reset();
+    template_compiled *compiled = template_compile(bench_templates, 4);
+
+    // The same array is compiled only once
+    if (compiled == NULL || template_compile(bench_templates, 4) != compiled) {
+        fprintf(stderr, "FAIL: compiling the same templates again does not share the compiled templates\n");
+        return false;
+    }
+
+    // Templates that do not fit are left to template_replace()
+    static char *many_placeholders[] = {
+            "$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv"
+            "$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv$bv"
+            "$bv",
+    };
+    template_reset();
+    if (template_compile(many_placeholders, 1) != NULL) {
+        fprintf(stderr, "FAIL: template with more than %d placeholders was compiled\n", TEMPLATE_TOKEN_MAX_COUNT);
+        return false;
+    }
+
+    return true;
+}
+
+static void bench_measure(char *template, template_compiled *compiled, bool render, int repetitions,
+        bench_timing *timing)
+{
+    uint64_t min_ns = UINT64_MAX;
+    uint64_t min_cycles = UINT64_MAX;
+
+    for (int r = 0; r < repetitions; r++) {
+        uint64_t start_cycles = bench_cycles();
+        uint64_t start_ns = bench_time_ns();
+        if (render) {
+            template_render(bench_rendered, sizeof(bench_rendered), compiled, &bench_data[0]);
+        } else {
+            template_replace(bench_replaced, sizeof(bench_replaced), template, &bench_data[0]);
+        }
+        uint64_t elapsed_ns = bench_time_ns() - start_ns;
+        uint64_t elapsed_cycles = bench_cycles() - start_cycles;
+
+        if (elapsed_ns < min_ns) {
+            min_ns = elapsed_ns;
+        }
+        if (elapsed_cycles < min_cycles) {
+            min_cycles = elapsed_cycles;
+        }
+    }
+
+    timing->ns += (double) min_ns;
+    timing->cycles += (double) min_cycles;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_options options = {
+            .repetitions = BENCH_DEFAULT_REPETITIONS,
+    };
+
+    if (!bench_parse_options(argc, argv, "", "", &options)) {
+        return 1;
+    }
+    int repetitions = options.repetitions;
+
+    bench_fill_data();
+
+    if (!bench_verify_compile_limits()) {
+        return 1;
+    }
+
+    bench_timing replace = {0};
+    bench_timing render = {0};
+
+    // The corpus is larger than the template space of the firmware, so each template is compiled on its own
+    for (size_t i = 0; i < BENCH_TEMPLATE_COUNT; i++) {
+        template_reset();
+        template_compiled *compiled = template_compile(&bench_templates[i], 1);
+        if (compiled == NULL) {
+            fprintf(stderr, "FAIL: \"%s\" does not compile\n", bench_templates[i]);
+            return 1;
+        }
+
+        if (!bench_verify(bench_templates[i], compiled)) {
+            return 1;
+        }
+
+        bench_measure(bench_templates[i], compiled, false, repetitions, &replace);
+        bench_measure(bench_templates[i], compiled, true, repetitions, &render);
+    }
+
+    printf("%-16s %12s %12s %12s %12s %8s\n", "corpus", "replace ns", "render ns", "replace cyc", "render cyc",
+            "speedup");
+
+    if (BENCH_CYCLES_AVAILABLE) {
+        printf("%-16s %12.0f %12.0f %12.0f %12.0f %8.2f\n", "all templates", replace.ns, render.ns, replace.cycles,
+                render.cycles, replace.ns / render.ns);
+    } else {
+        printf("%-16s %12.0f %12.0f %12s %12s %8.2f\n", "all templates", replace.ns, render.ns, "-", "-",
+                replace.ns / render.ns);
+    }
+
+    bool success = bench_check_speedup("all templates", "rendering", replace.ns, render.ns, BENCH_MIN_SPEEDUP);
+    success &= bench_check_budget(&options, "all templates", "rendering", render.ns, BENCH_BUDGET_NS);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,934 @@
+/**
+ * UBX parser benchmark: the streaming parser working in place on the GPS DMA ring against the original byte parser
+ * of the u-blox M10 driver.
+ *
+ * Receiver traffic is written into a 256-byte ring in chunks of random size, the way the USART DMA fills it, and
+ * every chunk is handed to both parsers: the original one byte by byte through a function pointer, as the DMA drain
+ * used to, and the UBX core running the M10 chip description (ubx_core_handle_incoming_data()) as one range of the
+ * ring. The GPS data and the packet counters must match after every chunk. The generic parser is also run with
+ * a passthrough handler forwarding NMEA sentences, which must forward the same bytes and hand over the same frames
+ * as the original parser with NMEA output enabled.
+ * The traffic is synthetic (NAV-PVT, NAV-TIMEGPS, ACK and other frames, NMEA sentences, corrupted and truncated
+ * frames and noise) unless a raw capture of receiver output is given with -f. The parse rate of both is reported
+ * in bytes per microsecond. The traffic is timed in blocks of about 4 KB, taking the fastest of all repetitions for
+ * every block, and the repetitions of both parsers alternate, so that a loaded host slows both down alike.
+ *
+ * Usage: ubx_parser_bench [-b] [-s budget_scale] [-r repetitions] [-n items] [-f capture_file] [-S seed]
+ * Exits with a non-zero status on a mismatch, if the streaming parser is not enough faster than the original one
+ * in the same run or, with -b, if it exceeds its budget (multiplied by budget_scale).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "config.h"
+#include "gps.h"
+#include "drivers/gps/ubx_stream.h"
+#include "drivers/gps/ubxm10050/ubxm10050.h"
+
+#define BENCH_DEFAULT_REPETITIONS 20
+#define BENCH_DEFAULT_ITEMS 20000
+
+#define BENCH_RING_SIZE 256
+#define BENCH_MAX_CHUNK_SIZE 128
+#define BENCH_MAX_FRAMES 65536
+// Chunks per timed block, about 4 KB
+#define BENCH_TIMED_CHUNKS 64
+
+// Budget in host nanoseconds per byte for the streaming parser
+#define BENCH_BUDGET_NS_PER_BYTE 10.0
+// Minimum speedup of the streaming parser over the original one
+#define BENCH_MIN_SPEEDUP 1.2
+
+#define UBX_CLASS_NAV 0x01
+#define UBX_CLASS_ACK 0x05
+#define UBX_CLASS_MON 0x0A
+#define UBX_NAV_PVT 0x07
+#define UBX_NAV_TIMEGPS 0x20
+#define UBX_MON_VER 0x04
+
+typedef struct __attribute__((packed)) {
+    uint32_t iTOW;
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t min;
+    uint8_t sec;
+    uint8_t valid;
+    uint32_t tAcc;
+    int32_t nano;
+    uint8_t fixType;
+    uint8_t flags;
+    uint8_t flags2;
+    uint8_t numSV;
+    int32_t lon;
+    int32_t lat;
+    int32_t height;
+    int32_t hMSL;
+    uint32_t hAcc;
+    uint32_t vAcc;
+    int32_t velN;
+    int32_t velE;
+    int32_t velD;
+    int32_t gSpeed;
+    int32_t headMot;
+    uint32_t sAcc;
+    uint32_t headAcc;
+    uint16_t pDOP;
+    uint8_t flags3;
+    uint8_t reserved1[5];
+    int32_t headVeh;
+    int16_t magDec;
+    uint16_t magAcc;
+} bench_nav_pvt;
+
+typedef struct __attribute__((packed)) {
+    uint32_t iTOW;
+    int32_t fTOW;
+    int16_t week;
+    int8_t leapS;
+    uint8_t valid;
+    uint32_t tAcc;
+} bench_nav_timegps;
+
+typedef struct _bench_frame {
+    uint8_t msg_class;
+    uint8_t msg_id;
+    uint16_t length;
+    uint16_t payload_checksum;
+} bench_frame;
+
+typedef struct _bench_frames {
+    bench_frame frames[BENCH_MAX_FRAMES];
+    uint32_t count;
+    uint8_t *forwarded;
+    size_t forwarded_length;
+} bench_frames;
+
+// Firmware functions used by the M10 driver outside of the parser
+uint32_t gps_ints = 0;
+
+uint32_t HAL_GetTick()
+{
+    return 0;
+}
+
+void delay_ms(uint32_t ms)
+{
+    (void) ms;
+}
+
+void usart_gps_init(uint32_t baud_rate, bool enable_irq)
+{
+    (void) baud_rate;
+    (void) enable_irq;
+}
+
+void usart_gps_send_byte(uint8_t data)
+{
+    (void) data;
+}
+
+void usart_gps_drain_dma(void)
+{
+}
+
+void usart_gps_set_baud_rate(uint32_t baud_rate)
+{
+    (void) baud_rate;
+}
+
+void system_disable_irq()
+{
+}
+
+void system_enable_irq()
+{
+}
+
+/*
+ * Reference: the original byte parser and packet handler of the M10 driver, with the optional NMEA forwarding
+ * writing to a buffer instead of the external serial port.
+ */
+
+static gps_data reference_gps_data;
+static uint8_t reference_parse_sync = 0;
+static uint8_t reference_parse_buf[256 + 6 + 2];
+static uint16_t reference_parse_pos = 0;
+static bool reference_nmea_enabled = false;
+static uint8_t reference_nmea_sync = 0;
+static bench_frames *reference_frames = NULL;
+
+static uint16_t bench_payload_checksum(uint16_t sum, uint8_t data)
+{
+    return (uint16_t) ((sum << 1 | sum >> 15) ^ data);
+}
+
+static void bench_record_forwarded(bench_frames *frames, uint8_t data)
+{
+    frames->forwarded[frames->forwarded_length++] = data;
+}
+
+static void bench_record_frame(bench_frames *frames, uint8_t msg_class, uint8_t msg_id, uint16_t length,
+        uint16_t payload_checksum)
+{
+    if (frames->count < BENCH_MAX_FRAMES) {
+        bench_frame *frame = &frames->frames[frames->count++];
+        frame->msg_class = msg_class;
+        frame->msg_id = msg_id;
+        frame->length = length;
+        frame->payload_checksum = payload_checksum;
+    }
+}
+
+static void reference_handle_nmea_sentence_start(uint8_t data)
+{
+    if (reference_nmea_sync == 0 && data == '$') {
+        reference_nmea_sync = 1;
+    } else if (reference_nmea_sync == 1) {
+        reference_nmea_sync = data == 'G' ? 2 : 0;
+    } else if (reference_nmea_sync == 2) {
+        if (data >= 'A' && data <= 'Z') {
+            bench_record_forwarded(reference_frames, '$');
+            bench_record_forwarded(reference_frames, 'G');
+            bench_record_forwarded(reference_frames, data);
+            reference_nmea_sync = 3;
+        } else {
+            reference_nmea_sync = 0;
+        }
+    }
+}
+
+static void reference_handle_nmea_output(uint8_t data)
+{
+    bench_record_forwarded(reference_frames, data);
+    if (data == '\r') {
+        reference_nmea_sync = 3;
+    } else if (reference_nmea_sync == 3 && data == '\n') {
+        reference_nmea_sync = 0;
+    }
+}
+
+static void reference_handle_packet(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t len)
+{
+    if (reference_frames != NULL) {
+        uint16_t sum = 0;
+        for (uint16_t i = 0; i < len; i++) {
+            sum = bench_payload_checksum(sum, payload[i]);
+        }
+        bench_record_frame(reference_frames, msg_class, msg_id, len, sum);
+        return;
+    }
+
+    if (msg_class == UBX_CLASS_NAV && msg_id == UBX_NAV_PVT) {
+        if (len < sizeof(bench_nav_pvt)) return;
+        const bench_nav_pvt *pvt = (const bench_nav_pvt *) payload;
+
+        reference_gps_data.ok_packets++;
+        reference_gps_data.time_of_week_millis = pvt->iTOW;
+        reference_gps_data.year = pvt->year;
+        reference_gps_data.month = pvt->month;
+        reference_gps_data.day = pvt->day;
+        reference_gps_data.hours = pvt->hour;
+        reference_gps_data.minutes = pvt->min;
+        reference_gps_data.seconds = pvt->sec;
+        reference_gps_data.fix = pvt->fixType;
+        reference_gps_data.fix_ok = (pvt->flags & 0x01) != 0;
+        reference_gps_data.satellites_visible = pvt->numSV;
+        reference_gps_data.time_valid_flags = pvt->valid;
+        reference_gps_data.time_accuracy_ns = pvt->tAcc;
+        reference_gps_data.latitude_degrees_10000000 = pvt->lat;
+        reference_gps_data.longitude_degrees_10000000 = pvt->lon;
+        reference_gps_data.altitude_mm = pvt->hMSL;
+        reference_gps_data.ground_speed_cm_per_second = pvt->gSpeed / 10;
+        reference_gps_data.heading_degrees_100000 = pvt->headMot;
+        reference_gps_data.climb_cm_per_second = -(pvt->velD / 10);
+        reference_gps_data.position_dilution_of_precision = pvt->pDOP;
+        reference_gps_data.power_safe_mode_state = (pvt->flags >> 2) & 0x07;
+        reference_gps_data.updated = true;
+        return;
+    }
+
+    if (msg_class == UBX_CLASS_NAV && msg_id == UBX_NAV_TIMEGPS) {
+        if (len < sizeof(bench_nav_timegps)) return;
+        const bench_nav_timegps *t = (const bench_nav_timegps *) payload;
+
+        reference_gps_data.time_of_week_millis = t->iTOW;
+        reference_gps_data.week = t->week;
+        if (t->valid & 0x04) {
+            reference_gps_data.leap_seconds = t->leapS;
+        }
+        reference_gps_data.updated = true;
+    }
+}
+
+static void reference_handle_incoming_byte(uint8_t data, uint8_t reset)
+{
+    if (reset) {
+        reference_parse_sync = 0;
+        reference_parse_pos = 0;
+        reference_nmea_sync = 0;
+    }
+
+    if (reference_nmea_enabled && reference_nmea_sync >= 3) {
+        reference_handle_nmea_output(data);
+        return;
+    }
+
+    if (reference_parse_sync == 0) {
+        if (data == UBX_SYNC_CHAR_1) {
+            reference_parse_sync = 1;
+            reference_parse_pos = 0;
+        } else if (reference_nmea_enabled) {
+            reference_handle_nmea_sentence_start(data);
+        }
+        return;
+    }
+
+    if (reference_parse_sync == 1) {
+        if (data == UBX_SYNC_CHAR_2) {
+            reference_parse_sync = 2;
+        } else {
+            reference_parse_sync = 0;
+            if (reference_nmea_enabled) {
+                reference_handle_nmea_sentence_start(data);
+            }
+        }
+        return;
+    }
+
+    if (reference_parse_pos < sizeof(reference_parse_buf)) {
+        reference_parse_buf[reference_parse_pos++] = data;
+    } else {
+        reference_parse_sync = 0;
+        reference_parse_pos = 0;
+        return;
+    }
+
+    if (reference_parse_pos < 4) return;
+
+    uint16_t payload_length = (uint16_t) reference_parse_buf[2] | ((uint16_t) reference_parse_buf[3] << 8);
+    if (payload_length > sizeof(reference_parse_buf) - 6) {
+        reference_parse_sync = 0;
+        reference_parse_pos = 0;
+        reference_gps_data.bad_packets++;
+        return;
+    }
+
+    uint16_t total_length = 4 + payload_length + 2;
+    if (reference_parse_pos < total_length) return;
+
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+    for (uint16_t i = 0; i < 4 + payload_length; i++) {
+        ck_a += reference_parse_buf[i];
+        ck_b += ck_a;
+    }
+
+    if (ck_a == reference_parse_buf[4 + payload_length] && ck_b == reference_parse_buf[4 + payload_length + 1]) {
+        reference_handle_packet(reference_parse_buf[0], reference_parse_buf[1], &reference_parse_buf[4],
+                payload_length);
+    } else {
+        reference_gps_data.bad_packets++;
+    }
+
+    reference_parse_sync = 0;
+    reference_parse_pos = 0;
+}
+
+static void reference_reset(bool nmea_enabled, bench_frames *frames)
+{
+    memset(&reference_gps_data, 0, sizeof(reference_gps_data));
+    reference_parse_sync = 0;
+    reference_parse_pos = 0;
+    reference_nmea_sync = 0;
+    reference_nmea_enabled = nmea_enabled;
+    reference_frames = frames;
+}
+
+/*
+ * The streaming parser with the NMEA forwarding of the M10 driver as the passthrough handler
+ */
+
+static uint8_t stream_nmea_sync = 0;
+static bench_frames *stream_frames = NULL;
+
+static void stream_handle_frame(const ubx_frame *frame)
+{
+    uint16_t sum = 0;
+    for (uint16_t i = 0; i < frame->length; i++) {
+        sum = bench_payload_checksum(sum, ubx_frame_u1(frame, i));
+    }
+    bench_record_frame(stream_frames, frame->msg_class, frame->msg_id, frame->length, sum);
+}
+
+static bool stream_handle_passthrough(uint8_t data)
+{
+    if (stream_nmea_sync >= 3) {
+        bench_record_forwarded(stream_frames, data);
+        if (data == '\r') {
+            stream_nmea_sync = 3;
+        } else if (stream_nmea_sync == 3 && data == '\n') {
+            stream_nmea_sync = 0;
+        }
+    } else if (stream_nmea_sync == 0 && data == '$') {
+        stream_nmea_sync = 1;
+    } else if (stream_nmea_sync == 1) {
+        stream_nmea_sync = data == 'G' ? 2 : 0;
+    } else if (stream_nmea_sync == 2) {
+        if (data >= 'A' && data <= 'Z') {
+            bench_record_forwarded(stream_frames, '$');
+            bench_record_forwarded(stream_frames, 'G');
+            bench_record_forwarded(stream_frames, data);
+            stream_nmea_sync = 3;
+        } else {
+            stream_nmea_sync = 0;
+        }
+    }
+    return stream_nmea_sync >= 3;
+}
+
+/*
+ * Receiver traffic
+ */
+
+typedef struct _bench_traffic {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} bench_traffic;
+
+static void bench_append(bench_traffic *traffic, uint8_t data)
+{
+    if (traffic->length == traffic->capacity) {
+        traffic->capacity = traffic->capacity ? traffic->capacity * 2 : 65536;
+        traffic->data = realloc(traffic->data, traffic->capacity);
+        if (traffic->data == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+    }
+    traffic->data[traffic->length++] = data;
+}
+
+static void bench_random_bytes(uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (uint8_t) rand();
+    }
+}
+
+/**
+ * Appends a frame, optionally with one byte after the length field flipped or cut short after a random number
+ * of bytes. The length field is left intact: a corrupted length is generated separately.
+ */
+static void bench_append_frame(bench_traffic *traffic, uint8_t msg_class, uint8_t msg_id, const uint8_t *payload,
+        uint16_t length, bool corrupt, bool truncate)
+{
+    uint8_t frame[UBX_FRAME_OVERHEAD + 256];
+    uint16_t frame_length = 0;
+
+    frame[frame_length++] = UBX_SYNC_CHAR_1;
+    frame[frame_length++] = UBX_SYNC_CHAR_2;
+    frame[frame_length++] = msg_class;
+    frame[frame_length++] = msg_id;
+    frame[frame_length++] = (uint8_t) (length & 0xFF);
+    frame[frame_length++] = (uint8_t) (length >> 8);
+    memcpy(&frame[frame_length], payload, length);
+    frame_length += length;
+
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+    for (uint16_t i = 2; i < frame_length; i++) {
+        ck_a += frame[i];
+        ck_b += ck_a;
+    }
+    frame[frame_length++] = ck_a;
+    frame[frame_length++] = ck_b;
+
+    if (corrupt) {
+        frame[6 + rand() % (frame_length - 6)] ^= (uint8_t) (1 + rand() % 255);
+    }
+    if (truncate) {
+        frame_length = (uint16_t) (1 + rand() % (frame_length - 1));
+    }
+
+    for (uint16_t i = 0; i < frame_length; i++) {
+        bench_append(traffic, frame[i]);
+    }
+}
+
+static void bench_append_nmea(bench_traffic *traffic)
+{
+    static const char *sentences[] = {
+            "GNGGA,123519.00,4807.03812,N,01131.00012,E,1,08,0.9,545.4,M,46.9,M,,",
+            "GNRMC,123519.00,A,4807.03812,N,01131.00012,E,0.022,,230394,,,A",
+            "GNGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1",
+            "GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45",
+            "GNTXT,01,01,02,u-blox AG - www.u-blox.com",
+    };
+    const char *sentence = sentences[rand() % (sizeof(sentences) / sizeof(sentences[0]))];
+
+    uint8_t checksum = 0;
+    bench_append(traffic, '$');
+    for (const char *c = sentence; *c; c++) {
+        bench_append(traffic, (uint8_t) *c);
+        checksum ^= (uint8_t) *c;
+    }
+
+    char tail[8];
+    snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+    for (const char *c = tail; *c; c++) {
+        bench_append(traffic, (uint8_t) *c);
+    }
+}
+
+static void bench_generate(bench_traffic *traffic, int items)
+{
+    uint8_t payload[256];
+
+    for (int n = 0; n < items; n++) {
+        int kind = rand() % 100;
+        bool corrupt = kind >= 90 && kind < 95;
+        bool truncate = kind >= 95;
+
+        if (kind < 30 || corrupt) {
+            bench_nav_pvt pvt;
+            bench_random_bytes((uint8_t *) &pvt, sizeof(pvt));
+            bench_append_frame(traffic, UBX_CLASS_NAV, UBX_NAV_PVT, (uint8_t *) &pvt, sizeof(pvt), corrupt, false);
+        } else if (kind < 40) {
+            bench_nav_timegps timegps;
+            bench_random_bytes((uint8_t *) &timegps, sizeof(timegps));
+            bench_append_frame(traffic, UBX_CLASS_NAV, UBX_NAV_TIMEGPS, (uint8_t *) &timegps, sizeof(timegps),
+                    false, false);
+        } else if (kind < 45) {
+            bench_random_bytes(payload, 2);
+            bench_append_frame(traffic, UBX_CLASS_ACK, (uint8_t) (rand() & 1), payload, 2, false, false);
+        } else if (kind < 55) {
+            // Short frames of other messages, also NAV-PVT too short to decode
+            uint16_t length = (uint16_t) (rand() % 100);
+            bench_random_bytes(payload, length);
+            bool pvt = rand() % 4 == 0;
+            bench_append_frame(traffic, pvt ? UBX_CLASS_NAV : UBX_CLASS_MON, pvt ? UBX_NAV_PVT : UBX_MON_VER,
+                    payload, length, false, false);
+        } else if (kind < 80) {
+            bench_append_nmea(traffic);
+        } else if (kind < 85) {
+            // A length field the parsers must reject without waiting for the frame
+            bench_random_bytes(payload, 8);
+            uint16_t length = (uint16_t) (0x400 + rand() % 0xF000);
+            bench_append(traffic, UBX_SYNC_CHAR_1);
+            bench_append(traffic, UBX_SYNC_CHAR_2);
+            bench_append(traffic, payload[0]);
+            bench_append(traffic, payload[1]);
+            bench_append(traffic, (uint8_t) (length & 0xFF));
+            bench_append(traffic, (uint8_t) (length >> 8));
+        } else if (kind < 90) {
+            // Line noise, with stray first sync characters
+            int count = 1 + rand() % 20;
+            for (int i = 0; i < count; i++) {
+                uint8_t data = rand() % 4 == 0 ? UBX_SYNC_CHAR_1 : (uint8_t) rand();
+                bench_append(traffic, data == UBX_SYNC_CHAR_2 ? '$' : data);
+            }
+        } else {
+            uint16_t length = (uint16_t) (rand() % 100);
+            bench_random_bytes(payload, length);
+            bench_append_frame(traffic, UBX_CLASS_MON, UBX_MON_VER, payload, length, false, truncate);
+        }
+    }
+}
+
+static bool bench_load(bench_traffic *traffic, const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        perror(filename);
+        return false;
+    }
+
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        bench_append(traffic, (uint8_t) c);
+    }
+    fclose(file);
+
+    return true;
+}
+
+/*
+ * The DMA ring, filled in chunks of random size
+ */
+
+static uint8_t bench_ring[BENCH_RING_SIZE];
+static uint16_t *bench_chunks = NULL;
+static size_t bench_chunk_count = 0;
+
+static void bench_split_chunks(const bench_traffic *traffic)
+{
+    bench_chunks = malloc((traffic->length + 1) * sizeof(uint16_t));
+    bench_chunk_count = 0;
+
+    for (size_t pos = 0; pos < traffic->length;) {
+        uint16_t size = (uint16_t) (1 + rand() % BENCH_MAX_CHUNK_SIZE);
+        if (size > traffic->length - pos) {
+            size = (uint16_t) (traffic->length - pos);
+        }
+        bench_chunks[bench_chunk_count++] = size;
+        pos += size;
+    }
+}
+
+static uint16_t bench_ring_write(const uint8_t *data, uint16_t length, uint16_t wr_pos)
+{
+    for (uint16_t i = 0; i < length; i++) {
+        bench_ring[wr_pos] = data[i];
+        wr_pos = (uint16_t) ((wr_pos + 1) % BENCH_RING_SIZE);
+    }
+    return wr_pos;
+}
+
+static bool bench_compare_gps_data(const gps_data *expected, const gps_data *actual)
+{
+#define BENCH_COMPARE(field) if (expected->field != actual->field) { \
+        fprintf(stderr, "FAIL: " #field " %ld, original parser %ld\n", (long) actual->field, (long) expected->field); \
+        return false; \
+    }
+    BENCH_COMPARE(updated)
+    BENCH_COMPARE(time_of_week_millis)
+    BENCH_COMPARE(week)
+    BENCH_COMPARE(year)
+    BENCH_COMPARE(month)
+    BENCH_COMPARE(day)
+    BENCH_COMPARE(seconds)
+    BENCH_COMPARE(minutes)
+    BENCH_COMPARE(hours)
+    BENCH_COMPARE(leap_seconds)
+    BENCH_COMPARE(time_valid_flags)
+    BENCH_COMPARE(time_accuracy_ns)
+    BENCH_COMPARE(latitude_degrees_10000000)
+    BENCH_COMPARE(longitude_degrees_10000000)
+    BENCH_COMPARE(altitude_mm)
+    BENCH_COMPARE(ground_speed_cm_per_second)
+    BENCH_COMPARE(heading_degrees_100000)
+    BENCH_COMPARE(climb_cm_per_second)
+    BENCH_COMPARE(satellites_visible)
+    BENCH_COMPARE(fix)
+    BENCH_COMPARE(fix_ok)
+    BENCH_COMPARE(ok_packets)
+    BENCH_COMPARE(bad_packets)
+    BENCH_COMPARE(power_safe_mode_state)
+    BENCH_COMPARE(position_dilution_of_precision)
+#undef BENCH_COMPARE
+    return true;
+}
+
+static bool bench_verify_driver(const bench_traffic *traffic)
+{
+    reference_reset(false, NULL);
+    ubx_core_clear_data();
+    ubx_core_reset_parser();
+
+    // Every packet counted so far has to be counted again from zero
+    gps_data initial;
+    ubx_core_peek_current_gps_data(&initial);
+    uint16_t ok_offset = initial.ok_packets;
+    uint16_t bad_offset = initial.bad_packets;
+
+    uint16_t wr_pos = 0;
+    uint16_t rd_pos = 0;
+    size_t pos = 0;
+
+    for (size_t c = 0; c < bench_chunk_count; c++) {
+        uint16_t size = bench_chunks[c];
+        wr_pos = bench_ring_write(&traffic->data[pos], size, wr_pos);
+        pos += size;
+
+        uint8_t reset = c % 1000 == 999;
+
+        for (uint16_t p = rd_pos; p != wr_pos; p = (uint16_t) ((p + 1) % BENCH_RING_SIZE)) {
+            reference_handle_incoming_byte(bench_ring[p], reset);
+            reset = 0;
+        }
+        ubx_core_handle_incoming_data(bench_ring, BENCH_RING_SIZE, rd_pos, wr_pos, c % 1000 == 999);
+        rd_pos = wr_pos;
+
+        gps_data data;
+        ubx_core_peek_current_gps_data(&data);
+        data.ok_packets -= ok_offset;
+        data.bad_packets -= bad_offset;
+        if (!bench_compare_gps_data(&reference_gps_data, &data)) {
+            fprintf(stderr, "FAIL: GPS data differs after chunk %zu at byte %zu\n", c, pos);
+            return false;
+        }
+    }
+
+    printf("%zu bytes, %zu chunks: %u NAV-PVT, %u bad frames\n", traffic->length, bench_chunk_count,
+            reference_gps_data.ok_packets, reference_gps_data.bad_packets);
+
+    return true;
+}
+
+static bool bench_verify_passthrough(const bench_traffic *traffic)
+{
+    static bench_frames reference_result;
+    static bench_frames stream_result;
+
+    reference_result.count = 0;
+    reference_result.forwarded_length = 0;
+    reference_result.forwarded = malloc(traffic->length + 3);
+    stream_result.count = 0;
+    stream_result.forwarded_length = 0;
+    stream_result.forwarded = malloc(traffic->length + 3);
+
+    reference_reset(true, &reference_result);
+
+    ubx_stream stream = {
+            .frame_handler = stream_handle_frame,
+            .passthrough_handler = stream_handle_passthrough,
+            .max_payload_length = 256,
+    };
+    ubx_stream_reset(&stream);
+    stream_nmea_sync = 0;
+    stream_frames = &stream_result;
+
+    uint16_t wr_pos = 0;
+    uint16_t rd_pos = 0;
+    size_t pos = 0;
+
+    for (size_t c = 0; c < bench_chunk_count; c++) {
+        uint16_t size = bench_chunks[c];
+        wr_pos = bench_ring_write(&traffic->data[pos], size, wr_pos);
+        pos += size;
+
+        for (uint16_t p = rd_pos; p != wr_pos; p = (uint16_t) ((p + 1) % BENCH_RING_SIZE)) {
+            reference_handle_incoming_byte(bench_ring[p], 0);
+        }
+        ubx_stream_parse(&stream, bench_ring, BENCH_RING_SIZE, rd_pos, wr_pos);
+        rd_pos = wr_pos;
+    }
+
+    bool ok = true;
+    if (stream_result.count != reference_result.count) {
+        fprintf(stderr, "FAIL: %u frames with NMEA forwarding, original parser %u\n", stream_result.count,
+                reference_result.count);
+        ok = false;
+    } else if (memcmp(stream_result.frames, reference_result.frames, reference_result.count * sizeof(bench_frame))) {
+        fprintf(stderr, "FAIL: frames differ with NMEA forwarding\n");
+        ok = false;
+    } else if (stream_result.forwarded_length != reference_result.forwarded_length
+            || memcmp(stream_result.forwarded, reference_result.forwarded, reference_result.forwarded_length)) {
+        fprintf(stderr, "FAIL: %zu NMEA bytes forwarded, original parser %zu\n", stream_result.forwarded_length,
+                reference_result.forwarded_length);
+        ok = false;
+    }
+
+    printf("NMEA forwarding: %u frames, %zu bytes forwarded\n", reference_result.count,
+            reference_result.forwarded_length);
+
+    free(reference_result.forwarded);
+    free(stream_result.forwarded);
+    reference_frames = NULL;
+
+    return ok;
+}
+
+/**
+ * A frame that does not fit in the ring together with the DMA margin is not handed over: the DMA could be
+ * overwriting it already.
+ */
+static bool bench_verify_overrun()
+{
+    static bench_frames result;
+    result.count = 0;
+    stream_frames = &result;
+
+    ubx_stream stream = {
+            .frame_handler = stream_handle_frame,
+            .max_payload_length = 256,
+    };
+    ubx_stream_reset(&stream);
+
+    uint8_t payload[256];
+    bench_traffic traffic = {0};
+    bench_random_bytes(payload, sizeof(payload));
+
+    uint16_t fits = BENCH_RING_SIZE - UBX_FRAME_OVERHEAD - UBX_STREAM_DMA_MARGIN;
+    bench_append_frame(&traffic, UBX_CLASS_MON, UBX_MON_VER, payload, fits + 1, false, false);
+    bench_append_frame(&traffic, UBX_CLASS_MON, UBX_MON_VER, payload, fits, false, false);
+
+    uint16_t wr_pos = 0;
+    uint16_t rd_pos = 0;
+    // Hand over every byte right after it has been received, so that nothing else occupies the ring
+    for (size_t pos = 0; pos < traffic.length; pos++) {
+        wr_pos = bench_ring_write(&traffic.data[pos], 1, wr_pos);
+        if (ubx_stream_parse(&stream, bench_ring, BENCH_RING_SIZE, rd_pos, wr_pos) != 0) {
+            fprintf(stderr, "FAIL: frame that does not fit in the ring counted as bad\n");
+            free(traffic.data);
+            return false;
+        }
+        rd_pos = wr_pos;
+    }
+    free(traffic.data);
+
+    if (result.count != 1 || result.frames[0].length != fits) {
+        fprintf(stderr, "FAIL: %u frames handed over, expected only the one that fits in the ring\n", result.count);
+        return false;
+    }
+
+    return true;
+}
+
+typedef struct _bench_drain {
+    size_t chunk;
+    size_t pos;
+    uint16_t wr_pos;
+    uint16_t rd_pos;
+} bench_drain;
+
+typedef void (*bench_drain_function)(const bench_traffic *traffic, bench_drain *drain, size_t chunk_end);
+
+static void bench_reference_drain(const bench_traffic *traffic, bench_drain *drain, size_t chunk_end)
+{
+    // Through a function pointer as in the original DMA drain loop
+    void (*volatile handle_incoming_byte)(uint8_t data, uint8_t reset) = reference_handle_incoming_byte;
+
+    for (; drain->chunk < chunk_end; drain->chunk++) {
+        drain->wr_pos = bench_ring_write(&traffic->data[drain->pos], bench_chunks[drain->chunk], drain->wr_pos);
+        drain->pos += bench_chunks[drain->chunk];
+        while (drain->rd_pos != drain->wr_pos) {
+            uint8_t byte = bench_ring[drain->rd_pos];
+            drain->rd_pos = (uint16_t) ((drain->rd_pos + 1) % BENCH_RING_SIZE);
+            handle_incoming_byte(byte, 0);
+        }
+    }
+}
+
+static void bench_stream_drain(const bench_traffic *traffic, bench_drain *drain, size_t chunk_end)
+{
+    void (*volatile handle_incoming_data)(const uint8_t *ring, uint16_t ring_size, uint16_t start, uint16_t end,
+            uint8_t reset) = ubx_core_handle_incoming_data;
+
+    for (; drain->chunk < chunk_end; drain->chunk++) {
+        drain->wr_pos = bench_ring_write(&traffic->data[drain->pos], bench_chunks[drain->chunk], drain->wr_pos);
+        drain->pos += bench_chunks[drain->chunk];
+        handle_incoming_data(bench_ring, BENCH_RING_SIZE, drain->rd_pos, drain->wr_pos, 0);
+        drain->rd_pos = drain->wr_pos;
+    }
+}
+
+/**
+ * Drains all of the traffic, timing it in blocks of BENCH_TIMED_CHUNKS chunks, and keeps the fastest time of every
+ * block. A host preemption only spoils the block it hits instead of the whole repetition.
+ */
+static void bench_time_drain(bench_drain_function drain_function, const bench_traffic *traffic, uint64_t *block_min_ns)
+{
+    bench_drain drain = {0};
+
+    for (size_t block = 0; drain.chunk < bench_chunk_count; block++) {
+        size_t chunk_end = drain.chunk + BENCH_TIMED_CHUNKS;
+        if (chunk_end > bench_chunk_count) {
+            chunk_end = bench_chunk_count;
+        }
+
+        uint64_t start_ns = bench_time_ns();
+        drain_function(traffic, &drain, chunk_end);
+        uint64_t elapsed_ns = bench_time_ns() - start_ns;
+
+        if (elapsed_ns < block_min_ns[block]) {
+            block_min_ns[block] = elapsed_ns;
+        }
+    }
+}
+
+static double bench_sum_blocks(const uint64_t *block_min_ns, size_t block_count)
+{
+    double ns = 0;
+    for (size_t block = 0; block < block_count; block++) {
+        ns += (double) block_min_ns[block];
+    }
+    return ns;
+}
+
+static void bench_measure(const bench_traffic *traffic, int repetitions, double *reference_ns, double *stream_ns)
+{
+    size_t block_count = (bench_chunk_count + BENCH_TIMED_CHUNKS - 1) / BENCH_TIMED_CHUNKS;
+    uint64_t *reference_min_ns = malloc(block_count * sizeof(uint64_t));
+    uint64_t *stream_min_ns = malloc(block_count * sizeof(uint64_t));
+
+    for (size_t block = 0; block < block_count; block++) {
+        reference_min_ns[block] = UINT64_MAX;
+        stream_min_ns[block] = UINT64_MAX;
+    }
+
+    // Alternate the parsers, so that a loaded host slows both down alike
+    for (int r = 0; r < repetitions; r++) {
+        bench_time_drain(bench_reference_drain, traffic, reference_min_ns);
+        bench_time_drain(bench_stream_drain, traffic, stream_min_ns);
+    }
+
+    *reference_ns = bench_sum_blocks(reference_min_ns, block_count);
+    *stream_ns = bench_sum_blocks(stream_min_ns, block_count);
+
+    free(reference_min_ns);
+    free(stream_min_ns);
+}
+
+int main(int argc, char *argv[])
+{
+    bench_options options = {
+            .repetitions = BENCH_DEFAULT_REPETITIONS,
+            .count = BENCH_DEFAULT_ITEMS,
+            .seed = 1,
+    };
+
+    if (!bench_parse_options(argc, argv, "n:f:S:", "[-n items] [-f capture_file] [-S seed]", &options)) {
+        return 1;
+    }
+
+    srand(options.seed);
+
+    bench_traffic traffic = {0};
+    if (options.filename != NULL) {
+        if (!bench_load(&traffic, options.filename)) {
+            return 1;
+        }
+    } else {
+        bench_generate(&traffic, options.count);
+    }
+    if (traffic.length == 0) {
+        fprintf(stderr, "No receiver traffic\n");
+        return 1;
+    }
+    bench_split_chunks(&traffic);
+
+    ubx_core_init(&ubxm10050_chip);
+
+    if (!bench_verify_driver(&traffic) || !bench_verify_passthrough(&traffic) || !bench_verify_overrun()) {
+        return 1;
+    }
+
+    reference_reset(false, NULL);
+    double reference_ns;
+    double stream_ns;
+    bench_measure(&traffic, options.repetitions, &reference_ns, &stream_ns);
+
+    double bytes = (double) traffic.length;
+    printf("%-16s %12s %12s %8s\n", "parser", "bytes/us", "ns/byte", "speedup");
+    printf("%-16s %12.1f %12.2f %8s\n", "original", bytes * 1000.0 / reference_ns, reference_ns / bytes, "");
+    printf("%-16s %12.1f %12.2f %8.2f\n", "stream", bytes * 1000.0 / stream_ns, stream_ns / bytes,
+            reference_ns / stream_ns);
+
+    free(bench_chunks);
+    free(traffic.data);
+
+    bool success = bench_check_speedup("stream", "streaming parser", reference_ns, stream_ns, BENCH_MIN_SPEEDUP);
+    success &= bench_check_budget(&options, "stream", "streaming parser per byte", stream_ns / bytes,
+            BENCH_BUDGET_NS_PER_BYTE);
+
+    return success ? 0 : 1;
+}
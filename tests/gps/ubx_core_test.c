@@ -0,0 +1,670 @@
+/**
+ * UBX core test: runs the receiver traffic of both u-blox drivers through the shared UBX core.
+ *
+ * The traffic of each chip is written into a 256-byte ring in chunks of random size, the way the USART DMA fills
+ * it, and handed to ubx_core_handle_incoming_data() after every chunk. The u-blox 6 (G6010) sends the six NAV
+ * messages of an epoch back to back, as the receiver does, the M10 sends NAV-PVT and NAV-TIMEGPS among ACKs and
+ * unhandled messages. After every epoch the GPS data must match the values encoded into the frames and every frame
+ * must have been counted, including the ones with a bad checksum. The chip-specific parts of the core are checked
+ * against the chip descriptions: messages shorter than their table entry, the ACK wait of both chips with a mock
+ * receiver answering from the DMA drain or during the delay, and whether clearing the data keeps the counters.
+ * The published solutions must be numbered one by one, one per epoch however its messages are split over the
+ * drains, for every reader. The traffic is synthetic.
+ *
+ * Usage: ubx_core_test [-S seed]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "gps.h"
+#include "drivers/gps/ubx_core.h"
+#include "drivers/gps/ubxg6010/ubxg6010.h"
+#include "drivers/gps/ubxm10050/ubxm10050.h"
+
+#define TEST_RING_SIZE 256
+#define TEST_MAX_CHUNK_SIZE 64
+#define TEST_EPOCH_COUNT 500
+#define TEST_MAX_TRAFFIC_LENGTH 1024
+
+#define UBX_NAV_POSLLH 0x02
+#define UBX_NAV_STATUS 0x03
+#define UBX_NAV_SOL 0x06
+#define UBX_NAV_PVT 0x07
+#define UBX_NAV_VELNED 0x12
+#define UBX_NAV_TIMEGPS 0x20
+#define UBX_NAV_TIMEUTC 0x21
+#define UBX_MON_VER 0x04
+
+typedef struct _test_traffic {
+    uint8_t data[TEST_MAX_TRAFFIC_LENGTH];
+    size_t length;
+} test_traffic;
+
+static uint8_t test_ring[TEST_RING_SIZE];
+static uint16_t test_wr_pos;
+static uint16_t test_rd_pos;
+
+static uint32_t mock_tick;
+static uint8_t mock_sent[64];
+static size_t mock_sent_length;
+// Answer of the mock receiver to the next command, written into the ring once mock_reply_tick has been reached
+static test_traffic mock_reply;
+static uint32_t mock_reply_tick;
+
+// Firmware functions used by the drivers outside of the UBX core
+uint32_t gps_ints = 0;
+
+uint32_t HAL_GetTick()
+{
+    return mock_tick;
+}
+
+void system_disable_irq()
+{
+}
+
+void system_enable_irq()
+{
+}
+
+void usart_gps_init(uint32_t baud_rate, bool enable_irq)
+{
+    (void) baud_rate;
+    (void) enable_irq;
+}
+
+void usart_gps_set_baud_rate(uint32_t baud_rate)
+{
+    (void) baud_rate;
+}
+
+void usart_gps_send_byte(uint8_t data)
+{
+    if (mock_sent_length < sizeof(mock_sent)) {
+        mock_sent[mock_sent_length] = data;
+    }
+    mock_sent_length++;
+}
+
+static void test_feed(const uint8_t *data, size_t length)
+{
+    size_t pos = 0;
+    while (pos < length) {
+        size_t size = 1 + (size_t) rand() % TEST_MAX_CHUNK_SIZE;
+        if (size > length - pos) {
+            size = length - pos;
+        }
+        for (size_t i = 0; i < size; i++) {
+            test_ring[test_wr_pos] = data[pos++];
+            test_wr_pos = (uint16_t) ((test_wr_pos + 1) % TEST_RING_SIZE);
+        }
+        ubx_core_handle_incoming_data(test_ring, TEST_RING_SIZE, test_rd_pos, test_wr_pos, 0);
+        test_rd_pos = test_wr_pos;
+    }
+}
+
+static void mock_receive_reply()
+{
+    if (mock_reply.length > 0 && mock_tick >= mock_reply_tick) {
+        size_t length = mock_reply.length;
+        mock_reply.length = 0;
+        test_feed(mock_reply.data, length);
+    }
+}
+
+// The M10 driver drains the DMA ring itself while waiting for an ACK
+void usart_gps_drain_dma(void)
+{
+    mock_tick++;
+    mock_receive_reply();
+}
+
+// The G6010 driver waits for the timer interrupt to drain the DMA ring
+void delay_ms(uint32_t ms)
+{
+    mock_tick += ms;
+    mock_receive_reply();
+}
+
+static void test_put_u1(uint8_t *payload, uint16_t offset, uint8_t value)
+{
+    payload[offset] = value;
+}
+
+static void test_put_u2(uint8_t *payload, uint16_t offset, uint16_t value)
+{
+    payload[offset] = (uint8_t) value;
+    payload[offset + 1] = (uint8_t) (value >> 8);
+}
+
+static void test_put_u4(uint8_t *payload, uint16_t offset, uint32_t value)
+{
+    test_put_u2(payload, offset, (uint16_t) value);
+    test_put_u2(payload, offset + 2, (uint16_t) (value >> 16));
+}
+
+static void test_append_frame(test_traffic *traffic, uint8_t msg_class, uint8_t msg_id, const uint8_t *payload,
+        uint16_t length, bool corrupt)
+{
+    uint8_t *frame = &traffic->data[traffic->length];
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+
+    frame[0] = UBX_SYNC_CHAR_1;
+    frame[1] = UBX_SYNC_CHAR_2;
+    frame[2] = msg_class;
+    frame[3] = msg_id;
+    test_put_u2(frame, 4, length);
+    memcpy(&frame[6], payload, length);
+
+    for (uint16_t i = 2; i < length + 6; i++) {
+        ck_a += frame[i];
+        ck_b += ck_a;
+    }
+    frame[length + 6] = ck_a;
+    frame[length + 7] = (uint8_t) (ck_b ^ (corrupt ? 0x5A : 0x00));
+
+    traffic->length += length + UBX_FRAME_OVERHEAD;
+}
+
+static void test_append_noise(test_traffic *traffic)
+{
+    size_t count = (size_t) rand() % 8;
+    for (size_t i = 0; i < count; i++) {
+        traffic->data[traffic->length++] = (uint8_t) (rand() % UBX_SYNC_CHAR_1);
+    }
+}
+
+static uint32_t test_random_u4()
+{
+    return ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+}
+
+static void test_init_chip(const ubx_chip *chip)
+{
+    ubx_core_init(chip);
+    test_wr_pos = 0;
+    test_rd_pos = 0;
+    mock_reply.length = 0;
+}
+
+#define TEST_EXPECT(field, value) \
+    if (data.field != (value)) { \
+        fprintf(stderr, "FAIL: %s epoch %u: " #field " is %ld, expected %ld\n", chip_name, epoch, \
+                (long) data.field, (long) (value)); \
+        return false; \
+    }
+
+/**
+ * Back-to-back NAV messages of the u-blox 6, in the order the receiver sends them. One in eight NAV-SOL has a bad
+ * checksum, and leaves the fix and the satellite count of the previous epoch.
+ */
+static bool test_g6010_traffic()
+{
+    const char *chip_name = ubxg6010_chip.name;
+    test_init_chip(&ubxg6010_chip);
+    uint32_t first_sequence = ubx_core_get_gps_data_sequence();
+
+    uint8_t expected_fix = 0;
+    uint8_t expected_satellites = 0;
+    uint16_t expected_pdop = 0;
+    uint16_t expected_bad_packets = 0;
+
+    for (uint32_t epoch = 0; epoch < TEST_EPOCH_COUNT; epoch++) {
+        static test_traffic traffic;
+        uint8_t payload[52];
+
+        uint32_t itow = test_random_u4() % 604800000U;
+        int32_t lat = (int32_t) (test_random_u4() % 1800000000U) - 900000000;
+        int32_t lon = (int32_t) (test_random_u4() % 3600000000U) - 1800000000;
+        int32_t hmsl = (int32_t) (test_random_u4() % 40000000U) - 1000000;
+        int32_t vel_d = (int32_t) (test_random_u4() % 20000U) - 10000;
+        uint32_t ground_speed = test_random_u4() % 100000U;
+        int32_t heading = (int32_t) (test_random_u4() % 36000000U);
+        uint8_t fix = (uint8_t) (rand() % 6);
+        uint8_t fix_ok = (uint8_t) (rand() % 2);
+        uint8_t satellites = (uint8_t) (rand() % 20);
+        uint16_t pdop = (uint16_t) (rand() % 10000);
+        uint8_t psm = (uint8_t) (rand() % 4);
+        uint16_t week = (uint16_t) (2000 + rand() % 500);
+        int8_t leap_seconds = (int8_t) (10 + rand() % 10);
+        uint16_t year = (uint16_t) (2020 + rand() % 20);
+        uint8_t month = (uint8_t) (1 + rand() % 12);
+        uint8_t day = (uint8_t) (1 + rand() % 28);
+        uint8_t hours = (uint8_t) (rand() % 24);
+        uint8_t minutes = (uint8_t) (rand() % 60);
+        uint8_t seconds = (uint8_t) (rand() % 60);
+        bool corrupt_sol = rand() % 8 == 0;
+
+        traffic.length = 0;
+        test_append_noise(&traffic);
+
+        memset(payload, 0, sizeof(payload));
+        test_put_u4(payload, 0, itow);
+        test_put_u4(payload, 4, (uint32_t) lon);
+        test_put_u4(payload, 8, (uint32_t) lat);
+        test_put_u4(payload, 16, (uint32_t) hmsl);
+        test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_POSLLH, payload, 28, false);
+
+        memset(payload, 0, sizeof(payload));
+        test_put_u4(payload, 0, itow);
+        test_put_u1(payload, 4, fix);
+        test_put_u1(payload, 5, fix_ok);
+        test_put_u1(payload, 7, psm);
+        test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_STATUS, payload, 16, false);
+
+        memset(payload, 0, sizeof(payload));
+        test_put_u4(payload, 0, itow);
+        test_put_u2(payload, 8, week);
+        test_put_u1(payload, 10, fix);
+        test_put_u1(payload, 11, fix_ok);
+        test_put_u2(payload, 44, pdop);
+        test_put_u1(payload, 47, satellites);
+        test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_SOL, payload, 52, corrupt_sol);
+
+        memset(payload, 0, sizeof(payload));
+        test_put_u4(payload, 0, itow);
+        test_put_u4(payload, 12, (uint32_t) vel_d);
+        test_put_u4(payload, 20, ground_speed);
+        test_put_u4(payload, 24, (uint32_t) heading);
+        test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_VELNED, payload, 36, false);
+
+        memset(payload, 0, sizeof(payload));
+        test_put_u4(payload, 0, itow);
+        test_put_u2(payload, 12, year);
+        test_put_u1(payload, 14, month);
+        test_put_u1(payload, 15, day);
+        test_put_u1(payload, 16, hours);
+        test_put_u1(payload, 17, minutes);
+        test_put_u1(payload, 18, seconds);
+        test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_TIMEUTC, payload, 20, false);
+
+        memset(payload, 0, sizeof(payload));
+        test_put_u4(payload, 0, itow);
+        test_put_u2(payload, 8, week);
+        test_put_u1(payload, 10, (uint8_t) leap_seconds);
+        test_put_u1(payload, 11, 0x07);
+        test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_TIMEGPS, payload, 16, false);
+
+        test_feed(traffic.data, traffic.length);
+
+        if (corrupt_sol) {
+            expected_bad_packets++;
+        } else {
+            expected_fix = fix;
+            expected_satellites = satellites;
+            expected_pdop = pdop;
+        }
+
+        gps_data data;
+        if (!ubx_core_get_current_gps_data(&data)) {
+            fprintf(stderr, "FAIL: %s epoch %u: GPS data not updated\n", chip_name, epoch);
+            return false;
+        }
+
+        TEST_EXPECT(ok_packets, (uint16_t) (3 * (epoch + 1)))
+        TEST_EXPECT(bad_packets, expected_bad_packets)
+        TEST_EXPECT(sequence, first_sequence + epoch + 1)
+        TEST_EXPECT(time_of_week_millis, itow)
+        TEST_EXPECT(week, (int16_t) week)
+        TEST_EXPECT(leap_seconds, leap_seconds)
+        TEST_EXPECT(latitude_degrees_10000000, lat)
+        TEST_EXPECT(longitude_degrees_10000000, lon)
+        TEST_EXPECT(altitude_mm, hmsl)
+        TEST_EXPECT(ground_speed_cm_per_second, ground_speed)
+        TEST_EXPECT(heading_degrees_100000, heading)
+        TEST_EXPECT(climb_cm_per_second, -vel_d)
+        TEST_EXPECT(fix, expected_fix)
+        TEST_EXPECT(fix_ok, fix_ok != 0)
+        TEST_EXPECT(satellites_visible, expected_satellites)
+        TEST_EXPECT(position_dilution_of_precision, expected_pdop)
+        TEST_EXPECT(power_safe_mode_state, (uint8_t) (POWER_SAFE_MODE_STATE_ACQUISITION + psm))
+        TEST_EXPECT(year, year)
+        TEST_EXPECT(month, month)
+        TEST_EXPECT(day, day)
+        TEST_EXPECT(hours, hours)
+        TEST_EXPECT(minutes, minutes)
+        TEST_EXPECT(seconds, seconds)
+    }
+
+    return true;
+}
+
+/**
+ * NAV-PVT and NAV-TIMEGPS of the M10, with ACKs, unhandled MON-VER answers and frames with a bad checksum in between
+ */
+static bool test_m10_traffic()
+{
+    const char *chip_name = ubxm10050_chip.name;
+    test_init_chip(&ubxm10050_chip);
+    uint32_t first_sequence = ubx_core_get_gps_data_sequence();
+
+    uint16_t expected_bad_packets = 0;
+
+    for (uint32_t epoch = 0; epoch < TEST_EPOCH_COUNT; epoch++) {
+        static test_traffic traffic;
+        uint8_t payload[160];
+
+        uint32_t itow = test_random_u4() % 604800000U;
+        int32_t lat = (int32_t) (test_random_u4() % 1800000000U) - 900000000;
+        int32_t lon = (int32_t) (test_random_u4() % 3600000000U) - 1800000000;
+        int32_t hmsl = (int32_t) (test_random_u4() % 40000000U) - 1000000;
+        int32_t vel_d = (int32_t) (test_random_u4() % 200000U) - 100000;
+        uint32_t ground_speed = test_random_u4() % 1000000U;
+        int32_t heading = (int32_t) (test_random_u4() % 36000000U);
+        uint32_t time_accuracy = test_random_u4() % 1000000U;
+        uint8_t fix = (uint8_t) (rand() % 6);
+        uint8_t flags = (uint8_t) (rand() % 32);
+        uint8_t valid = (uint8_t) (rand() % 8);
+        uint8_t satellites = (uint8_t) (rand() % 30);
+        uint16_t pdop = (uint16_t) (rand() % 10000);
+        uint16_t week = (uint16_t) (2000 + rand() % 500);
+        int8_t leap_seconds = (int8_t) (10 + rand() % 10);
+
+        traffic.length = 0;
+
+        if (rand() % 4 == 0) {
+            memset(payload, 0, sizeof(payload));
+            test_append_frame(&traffic, UBX_CLASS_ACK, UBX_ACK_ACK, payload, 2, false);
+        }
+        if (rand() % 8 == 0) {
+            for (size_t i = 0; i < sizeof(payload); i++) {
+                payload[i] = (uint8_t) rand();
+            }
+            bool corrupt = rand() % 2 == 0;
+            test_append_frame(&traffic, UBX_CLASS_MON, UBX_MON_VER, payload, sizeof(payload), corrupt);
+            expected_bad_packets += corrupt;
+        }
+        test_append_noise(&traffic);
+
+        memset(payload, 0, sizeof(payload));
+        test_put_u4(payload, 0, itow);
+        test_put_u2(payload, 4, 2024);
+        test_put_u1(payload, 11, valid);
+        test_put_u4(payload, 12, time_accuracy);
+        test_put_u1(payload, 20, fix);
+        test_put_u1(payload, 21, flags);
+        test_put_u1(payload, 23, satellites);
+        test_put_u4(payload, 24, (uint32_t) lon);
+        test_put_u4(payload, 28, (uint32_t) lat);
+        test_put_u4(payload, 36, (uint32_t) hmsl);
+        test_put_u4(payload, 56, (uint32_t) vel_d);
+        test_put_u4(payload, 60, ground_speed);
+        test_put_u4(payload, 64, (uint32_t) heading);
+        test_put_u2(payload, 76, pdop);
+        test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_PVT, payload, 92, false);
+
+        memset(payload, 0, sizeof(payload));
+        test_put_u4(payload, 0, itow);
+        test_put_u2(payload, 8, week);
+        test_put_u1(payload, 10, (uint8_t) leap_seconds);
+        test_put_u1(payload, 11, 0x07);
+        test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_TIMEGPS, payload, 16, false);
+
+        test_feed(traffic.data, traffic.length);
+
+        gps_data data;
+        if (!ubx_core_get_current_gps_data(&data)) {
+            fprintf(stderr, "FAIL: %s epoch %u: GPS data not updated\n", chip_name, epoch);
+            return false;
+        }
+
+        TEST_EXPECT(ok_packets, (uint16_t) (epoch + 1))
+        TEST_EXPECT(bad_packets, expected_bad_packets)
+        TEST_EXPECT(sequence, first_sequence + epoch + 1)
+        TEST_EXPECT(time_of_week_millis, itow)
+        TEST_EXPECT(week, (int16_t) week)
+        TEST_EXPECT(leap_seconds, leap_seconds)
+        TEST_EXPECT(year, 2024)
+        TEST_EXPECT(time_valid_flags, valid)
+        TEST_EXPECT(time_accuracy_ns, time_accuracy)
+        TEST_EXPECT(latitude_degrees_10000000, lat)
+        TEST_EXPECT(longitude_degrees_10000000, lon)
+        TEST_EXPECT(altitude_mm, hmsl)
+        TEST_EXPECT(ground_speed_cm_per_second, ground_speed / 10)
+        TEST_EXPECT(heading_degrees_100000, heading)
+        TEST_EXPECT(climb_cm_per_second, -(vel_d / 10))
+        TEST_EXPECT(fix, fix)
+        TEST_EXPECT(fix_ok, (flags & 0x01) != 0)
+        TEST_EXPECT(satellites_visible, satellites)
+        TEST_EXPECT(position_dilution_of_precision, pdop)
+        TEST_EXPECT(power_safe_mode_state, (flags >> 2) & 0x07)
+    }
+
+    return true;
+}
+
+/**
+ * Frames shorter than their message table entry and unknown messages are ignored, frames longer than the maximum
+ * payload of the chip are bad
+ */
+static bool test_rejected_frames(const ubx_chip *chip, uint8_t msg_id, uint16_t min_length)
+{
+    static test_traffic traffic;
+    uint8_t payload[256];
+    gps_data before;
+    gps_data after;
+
+    test_init_chip(chip);
+    memset(payload, 0x11, sizeof(payload));
+
+    ubx_core_peek_current_gps_data(&before);
+
+    traffic.length = 0;
+    test_append_frame(&traffic, UBX_CLASS_NAV, msg_id, payload, min_length - 1, false);
+    test_append_frame(&traffic, UBX_CLASS_NAV, 0x35, payload, 64, false);
+    test_feed(traffic.data, traffic.length);
+
+    ubx_core_peek_current_gps_data(&after);
+    if (memcmp(&before, &after, sizeof(gps_data)) != 0) {
+        fprintf(stderr, "FAIL: %s: short or unknown message changed the GPS data\n", chip->name);
+        return false;
+    }
+
+    // Only the header of the oversized frame is needed: the parser gives up on it right there
+    static const uint8_t oversized[] = {UBX_SYNC_CHAR_1, UBX_SYNC_CHAR_2, UBX_CLASS_NAV, 0x07, 0x01, 0x02};
+    test_feed(oversized, sizeof(oversized));
+
+    ubx_core_peek_current_gps_data(&after);
+    if (after.bad_packets != 1 || after.ok_packets != 0) {
+        fprintf(stderr, "FAIL: %s: oversized frame counted as %u bad, %u ok packets\n", chip->name,
+                after.bad_packets, after.ok_packets);
+        return false;
+    }
+
+    return true;
+}
+
+typedef enum _test_reply {
+    TEST_REPLY_ACK = 0,
+    TEST_REPLY_NAK,
+    TEST_REPLY_NONE,
+    // An ACK received before the command was sent must not be taken for its answer
+    TEST_REPLY_STALE_ACK,
+} test_reply;
+
+static bool test_ack(const ubx_chip *chip, test_reply reply)
+{
+    static const uint8_t command[] = {0x01, 0x07, 0x01};
+    static const uint8_t expected[] = {UBX_SYNC_CHAR_1, UBX_SYNC_CHAR_2, UBX_CLASS_CFG, 0x01, 0x03, 0x00,
+            0x01, 0x07, 0x01, 0x13, 0x51};
+    uint8_t ack_payload[2] = {UBX_CLASS_CFG, 0x01};
+
+    test_init_chip(chip);
+    mock_sent_length = 0;
+
+    if (reply == TEST_REPLY_STALE_ACK) {
+        test_traffic stale = {0};
+        test_append_frame(&stale, UBX_CLASS_ACK, UBX_ACK_ACK, ack_payload, sizeof(ack_payload), false);
+        test_feed(stale.data, stale.length);
+    } else if (reply != TEST_REPLY_NONE) {
+        test_append_frame(&mock_reply, UBX_CLASS_ACK, reply == TEST_REPLY_ACK ? UBX_ACK_ACK : UBX_ACK_NAK,
+                ack_payload, sizeof(ack_payload), false);
+    }
+    mock_reply_tick = mock_tick + 1 + (uint32_t) rand() % (chip->ack_timeout_ms / 2);
+
+    uint32_t start_tick = mock_tick;
+    bool acked = ubx_core_send_command_and_wait_for_ack(UBX_CLASS_CFG, 0x01, command, sizeof(command));
+    uint32_t wait_ms = mock_tick - start_tick;
+
+    if (mock_sent_length != sizeof(expected) || memcmp(mock_sent, expected, sizeof(expected)) != 0) {
+        fprintf(stderr, "FAIL: %s: command sent as %zu bytes, expected CFG-MSG frame\n", chip->name,
+                mock_sent_length);
+        return false;
+    }
+    if (acked != (reply == TEST_REPLY_ACK)) {
+        fprintf(stderr, "FAIL: %s: reply %d taken for %s\n", chip->name, reply, acked ? "ACK" : "no ACK");
+        return false;
+    }
+    bool answered = reply == TEST_REPLY_ACK || reply == TEST_REPLY_NAK;
+    if (answered ? mock_tick != mock_reply_tick : wait_ms < chip->ack_timeout_ms) {
+        fprintf(stderr, "FAIL: %s: reply %d waited for %u ms\n", chip->name, reply, wait_ms);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Every drain that decodes the first message of a new epoch publishes the next solution, further messages of the
+ * epoch in later drains update it. Bad frames and clearing the data publish the counters without a new solution.
+ * Readers following the sequence number see each solution once, independently of the updated flag of
+ * ubx_core_get_current_gps_data().
+ */
+static bool test_sequence(const ubx_chip *chip)
+{
+    static test_traffic traffic;
+    uint8_t payload[16] = {0};
+    gps_data data;
+
+    test_init_chip(chip);
+    uint32_t first = ubx_core_get_gps_data_sequence();
+
+    // NAV-TIMEGPS is decoded by both chips. Each epoch sends it in three drains.
+    for (uint32_t i = 1; i <= 10; i++) {
+        test_put_u4(payload, 0, i * 1000);
+        for (int drain = 0; drain < 3; drain++) {
+            traffic.length = 0;
+            test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_TIMEGPS, payload, sizeof(payload), false);
+            test_feed(traffic.data, traffic.length);
+        }
+
+        if (ubx_core_get_gps_data_sequence() != first + i) {
+            fprintf(stderr, "FAIL: %s: sequence %u after %u solutions\n", chip->name,
+                    ubx_core_get_gps_data_sequence() - first, i);
+            return false;
+        }
+        if (!ubx_core_get_gps_data_since(first + i - 1, &data) || data.sequence != first + i
+                || ubx_core_get_gps_data_since(first + i, &data)) {
+            fprintf(stderr, "FAIL: %s: solution %u not new exactly once\n", chip->name, i);
+            return false;
+        }
+    }
+
+    // Consuming the updated flag leaves other readers alone
+    ubx_core_get_current_gps_data(&data);
+    if (ubx_core_peek_current_gps_data(&data) || !ubx_core_get_gps_data_since(first + 5, &data)) {
+        fprintf(stderr, "FAIL: %s: updated flag shared with sequence readers\n", chip->name);
+        return false;
+    }
+
+    traffic.length = 0;
+    test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_TIMEGPS, payload, sizeof(payload), true);
+    test_feed(traffic.data, traffic.length);
+    ubx_core_clear_data();
+
+    if (ubx_core_get_gps_data_since(first + 10, &data) || ubx_core_peek_current_gps_data(&data)
+            || data.bad_packets != (chip->preserve_packet_counters_on_clear ? 1 : 0)) {
+        fprintf(stderr, "FAIL: %s: bad frame or clear published as a new solution\n", chip->name);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * The M10 driver keeps the packet counters over a clear, to tell whether the receiver talks after a wake-up
+ */
+static bool test_clear_data(const ubx_chip *chip)
+{
+    static test_traffic traffic;
+    uint8_t payload[16] = {0};
+    gps_data data;
+
+    test_init_chip(chip);
+    traffic.length = 0;
+    test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_STATUS, payload, sizeof(payload), false);
+    test_append_frame(&traffic, UBX_CLASS_NAV, UBX_NAV_STATUS, payload, sizeof(payload), true);
+    test_feed(traffic.data, traffic.length);
+
+    ubx_core_clear_data();
+    ubx_core_peek_current_gps_data(&data);
+
+    // NAV-STATUS is decoded by the G6010 only
+    uint16_t expected_ok = chip == &ubxg6010_chip ? 1 : 0;
+    bool kept = chip->preserve_packet_counters_on_clear;
+    if (data.updated || data.ok_packets != (kept ? expected_ok : 0) || data.bad_packets != (kept ? 1 : 0)) {
+        fprintf(stderr, "FAIL: %s: %u ok, %u bad packets after clearing the GPS data\n", chip->name,
+                data.ok_packets, data.bad_packets);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "S:")) != -1) {
+        switch (opt) {
+            case 'S':
+                seed = (unsigned int) atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-S seed]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    srand(seed);
+
+    static const struct {
+        const ubx_chip *chip;
+        bool (*traffic)();
+        uint8_t short_msg_id;
+        uint16_t short_min_length;
+    } chips[] = {
+            {&ubxg6010_chip, test_g6010_traffic, UBX_NAV_SOL, 52},
+            {&ubxm10050_chip, test_m10_traffic, UBX_NAV_PVT, 92},
+    };
+
+    bool success = true;
+
+    for (size_t i = 0; i < sizeof(chips) / sizeof(chips[0]); i++) {
+        const ubx_chip *chip = chips[i].chip;
+        bool ok = chips[i].traffic()
+                && test_rejected_frames(chip, chips[i].short_msg_id, chips[i].short_min_length)
+                && test_clear_data(chip)
+                && test_sequence(chip);
+
+        for (int reply = TEST_REPLY_ACK; ok && reply <= TEST_REPLY_STALE_ACK; reply++) {
+            for (int round = 0; ok && round < 20; round++) {
+                ok = test_ack(chip, (test_reply) reply);
+            }
+        }
+
+        printf("%-8s %u epochs, ACK wait %s: %s\n", chip->name, TEST_EPOCH_COUNT,
+                chip->ack_wait_drains_dma ? "drains DMA" : "delays", ok ? "OK" : "FAIL");
+        success &= ok;
+    }
+
+    return success ? 0 : 1;
+}
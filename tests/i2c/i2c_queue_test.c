@@ -0,0 +1,547 @@
+/**
+ * I2C request queue test: runs the queue against a mock I2C bus with register files for a few devices.
+ *
+ * The mock bus completes transfers like the I2C interrupt would, after a random number of 1 ms ticks, from
+ * inside i2c_transfer_start() or never at all. Each case checks that transfers start one at a time in submission
+ * order, that callbacks run from i2c_queue_poll() only after their transfer has ended and in the same order, that
+ * reads and writes reach the right registers, and that a device that never answers is aborted after the request
+ * timeout without holding up the requests queued behind it. Requests without a callback, which interrupt handlers
+ * submit, have to run to the end without the main loop polling the queue.
+ *
+ * Usage: i2c_queue_test [-S seed]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "stm32f1xx_hal.h"
+#include "drivers/hal/i2c_queue.h"
+
+#define TEST_REQUEST_COUNT 8
+#define TEST_ROUND_COUNT 500
+#define TEST_DEVICE_COUNT 3
+#define TEST_TIMEOUT_MS 20
+#define TEST_TICK_LIMIT 100000
+
+typedef enum _mock_mode {
+    // Completes after a random delay, as the I2C interrupt would
+    MOCK_MODE_INTERRUPT = 0,
+    // Completes before i2c_transfer_start() returns
+    MOCK_MODE_SYNCHRONOUS,
+    // Every transfer to the hanging device fails to complete
+    MOCK_MODE_HANG,
+    // Transfers to the failing device end with an error or fail to start
+    MOCK_MODE_ERROR,
+} mock_mode;
+
+struct _i2c_port {
+    uint8_t registers[TEST_DEVICE_COUNT][256];
+};
+
+i2c_port DEFAULT_I2C_PORT;
+static i2c_port expected_port;
+
+static uint32_t mock_tick;
+static mock_mode mock_bus_mode;
+static i2c_request *mock_active;
+static uint32_t mock_complete_tick;
+static int mock_complete_status;
+static uint32_t mock_abort_count;
+static uint32_t mock_start_count;
+static bool mock_failed;
+
+// Device address that never completes a transfer in MOCK_MODE_HANG or fails it in MOCK_MODE_ERROR
+#define MOCK_BAD_DEVICE 2
+
+typedef struct _test_request {
+    i2c_request request;
+    uint8_t buffer[16];
+    uint8_t expected[16];
+    int expected_status;
+    uint32_t submit_order;
+    uint32_t start_order;
+    uint32_t callback_order;
+    uint32_t start_tick;
+    uint32_t callback_tick;
+    bool started;
+    bool completed;
+    bool called_back;
+} test_request;
+
+static test_request test_requests[TEST_REQUEST_COUNT];
+static uint32_t test_start_counter;
+static uint32_t test_callback_counter;
+
+uint32_t HAL_GetTick(void)
+{
+    return mock_tick;
+}
+
+// The mock interrupt runs in line with the test, there is nothing to mask
+uint32_t sim_get_primask(void)
+{
+    return 0;
+}
+
+void sim_set_primask(uint32_t primask)
+{
+}
+
+static test_request *test_find(i2c_request *request)
+{
+    return (test_request *) request->context;
+}
+
+static void fail(const char *message, uint32_t index)
+{
+    if (!mock_failed) {
+        fprintf(stderr, "FAIL: %s (request %u, tick %u)\n", message, index, mock_tick);
+    }
+    mock_failed = true;
+}
+
+static void mock_transfer(i2c_request *request)
+{
+    uint8_t *registers = request->port->registers[request->address];
+    for (uint8_t i = 0; i < request->size; i++) {
+        uint8_t reg = (uint8_t) (request->reg + i);
+        if (request->write) {
+            registers[reg] = request->data[i];
+        } else {
+            request->data[i] = registers[reg];
+        }
+    }
+}
+
+int i2c_transfer_start(i2c_request *request)
+{
+    test_request *test = test_find(request);
+
+    if (mock_active != NULL) {
+        fail("transfer started while another one is active", test->submit_order);
+    }
+    if (test->started) {
+        fail("transfer started twice", test->submit_order);
+    }
+
+    test->started = true;
+    test->start_order = test_start_counter++;
+    test->start_tick = mock_tick;
+    mock_start_count++;
+
+    bool bad_device = request->address == MOCK_BAD_DEVICE;
+
+    if (mock_bus_mode == MOCK_MODE_ERROR && bad_device && (rand() & 1)) {
+        // Bus busy or NACK while addressing: nothing happens on the bus
+        test->completed = true;
+        return HAL_ERROR;
+    }
+
+    mock_active = request;
+
+    if (mock_bus_mode == MOCK_MODE_HANG && bad_device) {
+        mock_complete_tick = UINT32_MAX;
+        return HAL_OK;
+    }
+
+    mock_complete_status = (mock_bus_mode == MOCK_MODE_ERROR && bad_device) ? HAL_ERROR : HAL_OK;
+
+    if (mock_bus_mode == MOCK_MODE_SYNCHRONOUS) {
+        if (mock_complete_status == HAL_OK) {
+            mock_transfer(request);
+        }
+        mock_active = NULL;
+        test->completed = true;
+        i2c_queue_handle_transfer_complete(mock_complete_status);
+        return HAL_OK;
+    }
+
+    mock_complete_tick = mock_tick + (uint32_t) (rand() % 5);
+    return HAL_OK;
+}
+
+void i2c_transfer_abort()
+{
+    if (mock_active == NULL) {
+        fail("abort without an active transfer", 0);
+        return;
+    }
+    test_find(mock_active)->completed = true;
+    mock_active = NULL;
+    mock_abort_count++;
+}
+
+/**
+ * The I2C interrupt: ends the active transfer once its time has come.
+ */
+static void mock_interrupt()
+{
+    if (mock_active == NULL || mock_tick < mock_complete_tick) {
+        return;
+    }
+
+    i2c_request *request = mock_active;
+    if (mock_complete_status == HAL_OK) {
+        mock_transfer(request);
+    }
+    mock_active = NULL;
+    test_find(request)->completed = true;
+    i2c_queue_handle_transfer_complete(mock_complete_status);
+}
+
+static void test_callback(i2c_request *request)
+{
+    test_request *test = test_find(request);
+
+    if (!test->completed) {
+        fail("callback before the transfer has ended", test->submit_order);
+    }
+    if (test->called_back) {
+        fail("callback run twice", test->submit_order);
+    }
+    if (request->state != I2C_REQUEST_STATE_IDLE) {
+        fail("request not idle in callback", test->submit_order);
+    }
+    if (request->status != test->expected_status) {
+        fprintf(stderr, "request %u: status %d, expected %d\n", test->submit_order, request->status,
+                test->expected_status);
+        fail("unexpected status", test->submit_order);
+    }
+    if (request->status == HAL_OK && !request->write
+        && memcmp(request->data, test->expected, request->size) != 0) {
+        fail("read data mismatch", test->submit_order);
+    }
+
+    test->called_back = true;
+    test->callback_order = test_callback_counter++;
+    test->callback_tick = mock_tick;
+}
+
+static void test_prepare(uint32_t index, uint8_t *bad_device_count)
+{
+    test_request *test = &test_requests[index];
+    i2c_request *request = &test->request;
+
+    memset(test, 0, sizeof(test_request));
+
+    request->port = &DEFAULT_I2C_PORT;
+    request->address = (uint8_t) (rand() % TEST_DEVICE_COUNT);
+    request->reg = (uint8_t) (rand() & 0xFF);
+    request->size = (uint8_t) (1 + rand() % sizeof(test->buffer));
+    request->data = test->buffer;
+    request->write = (rand() & 1) != 0;
+    request->timeout_ms = TEST_TIMEOUT_MS;
+    request->callback = test_callback;
+    request->context = test;
+
+    test->submit_order = index;
+
+    bool bad_device = request->address == MOCK_BAD_DEVICE;
+    if (bad_device) {
+        (*bad_device_count)++;
+    }
+
+    if (mock_bus_mode == MOCK_MODE_HANG && bad_device) {
+        test->expected_status = HAL_TIMEOUT;
+    } else if (mock_bus_mode == MOCK_MODE_ERROR && bad_device) {
+        test->expected_status = HAL_ERROR;
+    } else {
+        test->expected_status = HAL_OK;
+    }
+
+    // Expected register contents after the transfers in submission order
+    uint8_t *expected_registers = expected_port.registers[request->address];
+    for (uint8_t i = 0; i < request->size; i++) {
+        uint8_t reg = (uint8_t) (request->reg + i);
+        if (request->write) {
+            test->buffer[i] = (uint8_t) rand();
+            if (test->expected_status == HAL_OK) {
+                expected_registers[reg] = test->buffer[i];
+            }
+        } else {
+            test->expected[i] = expected_registers[reg];
+        }
+    }
+}
+
+static bool test_round(mock_mode mode, uint32_t *max_latency_ms, uint32_t *timeout_count)
+{
+    uint8_t bad_device_count = 0;
+
+    mock_bus_mode = mode;
+    mock_active = NULL;
+    mock_abort_count = 0;
+    test_start_counter = 0;
+    test_callback_counter = 0;
+
+    for (int device = 0; device < TEST_DEVICE_COUNT; device++) {
+        for (int reg = 0; reg < 256; reg++) {
+            DEFAULT_I2C_PORT.registers[device][reg] = (uint8_t) rand();
+        }
+    }
+    memcpy(&expected_port, &DEFAULT_I2C_PORT, sizeof(i2c_port));
+
+    for (uint32_t i = 0; i < TEST_REQUEST_COUNT; i++) {
+        test_prepare(i, &bad_device_count);
+        if (!i2c_queue_submit(&test_requests[i].request)) {
+            fail("submit refused", i);
+            return false;
+        }
+        if (i2c_queue_submit(&test_requests[i].request)) {
+            fail("queued request submitted twice", i);
+            return false;
+        }
+        // Submissions interleave with polls of the main loop
+        if (rand() % 4 == 0) {
+            i2c_queue_poll();
+        }
+    }
+
+    uint32_t start_tick = mock_tick;
+    while (i2c_queue_busy()) {
+        if (mock_tick - start_tick > TEST_TICK_LIMIT) {
+            fail("queue never drained", 0);
+            return false;
+        }
+        mock_tick++;
+        mock_interrupt();
+        i2c_queue_poll();
+    }
+
+    for (uint32_t i = 0; i < TEST_REQUEST_COUNT; i++) {
+        test_request *test = &test_requests[i];
+        if (!test->called_back) {
+            fail("callback never ran", i);
+            continue;
+        }
+        if (test->start_order != i || test->callback_order != i) {
+            fail("requests out of submission order", i);
+        }
+        if (test->expected_status == HAL_TIMEOUT && test->callback_tick - test->start_tick < TEST_TIMEOUT_MS) {
+            fail("timed out early", i);
+        }
+        uint32_t latency_ms = test->callback_tick - test->start_tick;
+        if (test->expected_status == HAL_TIMEOUT) {
+            (*timeout_count)++;
+            if (latency_ms > TEST_TIMEOUT_MS + 1) {
+                fail("timed out late", i);
+            }
+        } else if (latency_ms > *max_latency_ms) {
+            *max_latency_ms = latency_ms;
+        }
+    }
+
+    if (mode == MOCK_MODE_HANG && mock_abort_count != bad_device_count) {
+        fail("abort count does not match the hanging transfers", 0);
+    }
+
+    if (memcmp(&DEFAULT_I2C_PORT, &expected_port, sizeof(i2c_port)) != 0) {
+        fail("register contents differ from the submission order", 0);
+    }
+
+    // A completion interrupt with nothing active, for example after an abort, must be ignored
+    i2c_queue_handle_transfer_complete(HAL_OK);
+    i2c_queue_poll();
+    if (i2c_queue_busy()) {
+        fail("stray completion left the queue busy", 0);
+    }
+
+    return !mock_failed;
+}
+
+static test_request chain_request;
+static uint32_t chain_remaining;
+
+static void test_chain_callback(i2c_request *request)
+{
+    if (chain_remaining > 0) {
+        chain_remaining--;
+        if (!i2c_queue_submit(request)) {
+            fail("resubmission from the callback refused", chain_remaining);
+        }
+    }
+}
+
+/**
+ * Sensor handlers submit the next read from the completion callback.
+ */
+static bool test_chain()
+{
+    mock_bus_mode = MOCK_MODE_INTERRUPT;
+    mock_active = NULL;
+    mock_start_count = 0;
+
+    memset(&chain_request, 0, sizeof(chain_request));
+    chain_request.request.port = &DEFAULT_I2C_PORT;
+    chain_request.request.address = 0;
+    chain_request.request.size = 2;
+    chain_request.request.data = chain_request.buffer;
+    chain_request.request.timeout_ms = TEST_TIMEOUT_MS;
+    chain_request.request.callback = test_chain_callback;
+    chain_request.request.context = &chain_request;
+    chain_remaining = 10;
+
+    i2c_queue_submit(&chain_request.request);
+
+    uint32_t start_tick = mock_tick;
+    while (i2c_queue_busy() && mock_tick - start_tick < TEST_TICK_LIMIT) {
+        mock_tick++;
+        // The mock checks every start against the previous one
+        chain_request.started = false;
+        mock_interrupt();
+        i2c_queue_poll();
+    }
+
+    if (mock_start_count != 11 || chain_remaining != 0) {
+        fail("chained requests did not all run", mock_start_count);
+    }
+
+    return !mock_failed;
+}
+
+static test_request interrupt_requests[2];
+
+/**
+ * Interrupt handlers submit writes without a callback: the queue starts them and returns them to idle on its own.
+ */
+static bool test_interrupt_submit()
+{
+    mock_bus_mode = MOCK_MODE_INTERRUPT;
+    mock_active = NULL;
+    mock_start_count = 0;
+
+    for (uint8_t i = 0; i < 2; i++) {
+        test_request *test = &interrupt_requests[i];
+        memset(test, 0, sizeof(test_request));
+        test->request.port = &DEFAULT_I2C_PORT;
+        test->request.address = i;
+        test->request.reg = 0x10;
+        test->request.size = 3;
+        test->request.data = test->buffer;
+        test->request.write = true;
+        test->request.timeout_ms = TEST_TIMEOUT_MS;
+        test->request.callback = NULL;
+        test->request.context = test;
+    }
+
+    uint32_t submit_count = 0;
+
+    // A blocking transfer holds back the queue
+    i2c_queue_suspend();
+    i2c_queue_submit(&interrupt_requests[0].request);
+    submit_count++;
+    if (mock_start_count != 0) {
+        fail("transfer started while the queue is suspended", 0);
+    }
+    i2c_queue_resume();
+    if (mock_start_count != 1) {
+        fail("queued transfer not started on resume", 0);
+    }
+
+    for (uint32_t tick = 0; tick < 1000; tick++) {
+        mock_tick++;
+        mock_interrupt();
+
+        // The timer interrupt: a request still in progress is skipped
+        test_request *test = &interrupt_requests[tick & 1];
+        if (test->request.state != I2C_REQUEST_STATE_IDLE) {
+            continue;
+        }
+        if (test->request.status != HAL_OK) {
+            fail("interrupt request failed", tick);
+        }
+        test->started = false;
+        test->completed = false;
+        memset(test->buffer, (uint8_t) tick, 3);
+        if (!i2c_queue_submit(&test->request)) {
+            fail("interrupt request refused", tick);
+        }
+        submit_count++;
+    }
+
+    uint32_t start_tick = mock_tick;
+    while (i2c_queue_busy() && mock_tick - start_tick < TEST_TICK_LIMIT) {
+        mock_tick++;
+        mock_interrupt();
+    }
+
+    if (i2c_queue_busy() || mock_start_count != submit_count) {
+        fail("interrupt requests did not all run", mock_start_count);
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        test_request *test = &interrupt_requests[i];
+        if (test->request.state != I2C_REQUEST_STATE_IDLE
+            || memcmp(&DEFAULT_I2C_PORT.registers[i][0x10], test->buffer, 3) != 0) {
+            fail("interrupt request did not complete", i);
+        }
+    }
+
+    return !mock_failed;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "S:")) != -1) {
+        switch (opt) {
+            case 'S':
+                seed = (unsigned int) atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-S seed]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    srand(seed);
+
+    static const struct {
+        const char *name;
+        mock_mode mode;
+    } cases[] = {
+            {"interrupt", MOCK_MODE_INTERRUPT},
+            {"synchronous", MOCK_MODE_SYNCHRONOUS},
+            {"hanging device", MOCK_MODE_HANG},
+            {"failing device", MOCK_MODE_ERROR},
+    };
+
+    bool success = true;
+
+    printf("%-16s %10s %10s %16s\n", "case", "requests", "timeouts", "max latency ms");
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint32_t max_latency_ms = 0;
+        uint32_t timeout_count = 0;
+
+        for (uint32_t round = 0; round < TEST_ROUND_COUNT; round++) {
+            if (!test_round(cases[i].mode, &max_latency_ms, &timeout_count)) {
+                fprintf(stderr, "FAIL: %s: round %u\n", cases[i].name, round);
+                success = false;
+                mock_failed = false;
+                break;
+            }
+        }
+
+        printf("%-16s %10u %10u %16u\n", cases[i].name, TEST_ROUND_COUNT * TEST_REQUEST_COUNT, timeout_count,
+                max_latency_ms);
+    }
+
+    if (!test_chain()) {
+        fprintf(stderr, "FAIL: chained requests\n");
+        success = false;
+    }
+
+    if (!test_interrupt_submit()) {
+        fprintf(stderr, "FAIL: requests submitted from interrupts\n");
+        success = false;
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+/**
+ * Symbol clock test: drift of the symbol edges against GPS time over a WSPR frame and Horus packets.
+ *
+ * The MCU oscillator runs with a random frequency error of up to +-30 ppm that drifts by up to +-0.05 ppm/s,
+ * like a warming crystal. The timepulse capture counts the 1 MHz timer ticks between GPS seconds, and the
+ * measurements are averaged into the clock error with symbol_clock_filter_clock_error() like clock_calibration.c
+ * does. After a minute of timepulses, a WSPR frame (162 symbols on the 10 kHz scheduler tick) and 1000-symbol Horus
+ * packets at 50, 100 and 300 baud (on the 1 MHz data timer) are timed with:
+ *
+ * - original: the previous symbol timing, the TIM6 counter from the 683 ms WSPR tone delay and the integer
+ *   1000000 / baud_rate TIM2 period, both on the uncorrected MCU clock
+ * - q16: the Q16 symbol clock on the uncorrected MCU clock
+ * - q16 gps: the Q16 symbol clock corrected by the measured clock error
+ *
+ * The worst end-of-frame drift and the worst error of any symbol edge over the runs are reported. The test fails
+ * unless the corrected symbol clock keeps every edge within 1 ms over the WSPR frame and within 1% of a symbol
+ * over the Horus packets.
+ *
+ * Usage: symbol_clock_test [-S seed]
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "symbol_clock.h"
+
+#define TEST_RUN_COUNT 50
+#define TEST_WARMUP_SECONDS 60.0
+
+#define TEST_CLOCK_ERROR_MAX_PPM 30.0
+#define TEST_CLOCK_DRIFT_MAX_PPM_PER_SECOND 0.05
+
+#define TEST_TIMEPULSE_TICKS_PER_SECOND 1000000.0
+
+typedef enum _test_variant {
+    TEST_VARIANT_ORIGINAL = 0,
+    TEST_VARIANT_Q16,
+    TEST_VARIANT_Q16_GPS,
+    TEST_VARIANT_COUNT,
+} test_variant;
+
+static const char *test_variant_names[] = {
+        "original",
+        "q16",
+        "q16 gps",
+};
+
+typedef struct _test_case {
+    const char *name;
+    uint32_t ticks_per_second;
+    uint32_t symbol_count;
+    // Exact symbol period in seconds
+    double symbol_period;
+    // Symbol rate for the symbol clock, 0 to use the symbol delay
+    uint32_t symbol_rate;
+    // Symbol delay in units of 10 us for the symbol clock
+    uint32_t symbol_delay_ms_100;
+    // Symbol period in ticks of the original symbol timing
+    uint32_t original_period;
+    // Largest edge error allowed with the corrected symbol clock, in seconds
+    double max_edge_error;
+} test_case;
+
+static test_case test_cases[] = {
+        {
+                .name = "wspr",
+                .ticks_per_second = 10000,
+                .symbol_count = 162,
+                .symbol_period = 8192.0 / 12000.0,
+                .symbol_delay_ms_100 = 68267,
+                // (uint32_t) (683 * 100 * 10000.0f / 100000.0f)
+                .original_period = 6830,
+                .max_edge_error = 0.001,
+        },
+        {
+                .name = "horus 50",
+                .ticks_per_second = 1000000,
+                .symbol_count = 1000,
+                .symbol_period = 1.0 / 50.0,
+                .symbol_rate = 50,
+                .original_period = 1000000 / 50,
+                .max_edge_error = 0.01 / 50.0,
+        },
+        {
+                .name = "horus 100",
+                .ticks_per_second = 1000000,
+                .symbol_count = 1000,
+                .symbol_period = 1.0 / 100.0,
+                .symbol_rate = 100,
+                .original_period = 1000000 / 100,
+                .max_edge_error = 0.01 / 100.0,
+        },
+        {
+                .name = "horus 300",
+                .ticks_per_second = 1000000,
+                .symbol_count = 1000,
+                .symbol_period = 1.0 / 300.0,
+                .symbol_rate = 300,
+                .original_period = 1000000 / 300,
+                .max_edge_error = 0.01 / 300.0,
+        },
+};
+
+typedef struct _test_oscillator {
+    // Frequency error at time 0 and its drift, relative
+    double error;
+    double drift_per_second;
+} test_oscillator;
+
+typedef struct _test_result {
+    double end_drift;
+    double max_edge_error;
+} test_result;
+
+static double test_random(double max)
+{
+    return ((double) rand() / (double) RAND_MAX * 2.0 - 1.0) * max;
+}
+
+/**
+ * Timer ticks counted from GPS time 0 to the given GPS time
+ */
+static double test_ticks_at(const test_oscillator *oscillator, double ticks_per_second, double time)
+{
+    return ticks_per_second * (time * (1.0 + oscillator->error) + 0.5 * oscillator->drift_per_second * time * time);
+}
+
+/**
+ * GPS time at which the timer has counted the given ticks
+ */
+static double test_time_at(const test_oscillator *oscillator, double ticks_per_second, double ticks)
+{
+    double time = ticks / ticks_per_second;
+
+    for (int i = 0; i < 4; i++) {
+        double rate = ticks_per_second * (1.0 + oscillator->error + oscillator->drift_per_second * time);
+        time -= (test_ticks_at(oscillator, ticks_per_second, time) - ticks) / rate;
+    }
+
+    return time;
+}
+
+/**
+ * Timepulse error of the given GPS second, the way TIM4 measures it: the difference of the captured counter values
+ * minus the expected ticks
+ */
+static int32_t test_timepulse_error_us(const test_oscillator *oscillator, uint32_t second)
+{
+    double previous = floor(test_ticks_at(oscillator, TEST_TIMEPULSE_TICKS_PER_SECOND, (double) (second - 1)));
+    double current = floor(test_ticks_at(oscillator, TEST_TIMEPULSE_TICKS_PER_SECOND, (double) second));
+
+    return (int32_t) (current - previous - TEST_TIMEPULSE_TICKS_PER_SECOND);
+}
+
+static void test_run(const test_case *test, const test_oscillator *oscillator, double start_offset,
+        test_variant variant, test_result *result)
+{
+    double ticks_per_second = test->ticks_per_second;
+
+    int32_t clock_error_ppb = 0;
+    uint32_t timepulse_second = 1;
+
+    // The frame starts on a timer tick after the warm-up
+    double start_ticks = ceil(test_ticks_at(oscillator, ticks_per_second, TEST_WARMUP_SECONDS + start_offset));
+    double start_time = test_time_at(oscillator, ticks_per_second, start_ticks);
+
+    symbol_clock clock;
+    if (test->symbol_rate > 0) {
+        symbol_clock_init_rate(&clock, test->ticks_per_second, test->symbol_rate);
+    } else {
+        symbol_clock_init_delay(&clock, test->ticks_per_second, test->symbol_delay_ms_100);
+    }
+
+    double ticks = start_ticks;
+    double time = start_time;
+
+    result->end_drift = 0;
+    result->max_edge_error = 0;
+
+    for (uint32_t symbol = 1; symbol <= test->symbol_count; symbol++) {
+        // Timepulses averaged up to the edge starting the symbol, where its period is set
+        while ((double) timepulse_second <= time) {
+            clock_error_ppb = symbol_clock_filter_clock_error(clock_error_ppb,
+                    test_timepulse_error_us(oscillator, timepulse_second));
+            timepulse_second++;
+        }
+
+        uint32_t period;
+        switch (variant) {
+            case TEST_VARIANT_ORIGINAL:
+                period = test->original_period;
+                break;
+            case TEST_VARIANT_Q16:
+                period = symbol_clock_next(&clock, 0);
+                break;
+            default:
+                period = symbol_clock_next(&clock, clock_error_ppb);
+                break;
+        }
+
+        ticks += period;
+        time = test_time_at(oscillator, ticks_per_second, ticks);
+
+        double edge_error = time - (start_time + symbol * test->symbol_period);
+        if (fabs(edge_error) > result->max_edge_error) {
+            result->max_edge_error = fabs(edge_error);
+        }
+        result->end_drift = edge_error;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "S:")) != -1) {
+        switch (opt) {
+            case 'S':
+                seed = (unsigned int) atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-S seed]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    srand(seed);
+
+    bool success = true;
+
+    printf("%-10s %-9s %10s %16s %16s\n", "case", "timing", "frame (s)", "end drift (us)", "max error (us)");
+
+    for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_case); i++) {
+        const test_case *test = &test_cases[i];
+        test_result worst[TEST_VARIANT_COUNT] = {0};
+
+        for (int run = 0; run < TEST_RUN_COUNT; run++) {
+            test_oscillator oscillator = {
+                    .error = test_random(TEST_CLOCK_ERROR_MAX_PPM) * 1e-6,
+                    .drift_per_second = test_random(TEST_CLOCK_DRIFT_MAX_PPM_PER_SECOND) * 1e-6,
+            };
+            // Same frame start for every variant
+            double start_offset = test_random(0.5);
+
+            for (int variant = 0; variant < TEST_VARIANT_COUNT; variant++) {
+                test_result result;
+                test_run(test, &oscillator, start_offset, (test_variant) variant, &result);
+
+                if (fabs(result.end_drift) > fabs(worst[variant].end_drift)) {
+                    worst[variant].end_drift = result.end_drift;
+                }
+                if (result.max_edge_error > worst[variant].max_edge_error) {
+                    worst[variant].max_edge_error = result.max_edge_error;
+                }
+            }
+        }
+
+        for (int variant = 0; variant < TEST_VARIANT_COUNT; variant++) {
+            printf("%-10s %-9s %10.1f %16.1f %16.1f\n", test->name, test_variant_names[variant],
+                    test->symbol_count * test->symbol_period, worst[variant].end_drift * 1e6,
+                    worst[variant].max_edge_error * 1e6);
+        }
+
+        if (worst[TEST_VARIANT_Q16_GPS].max_edge_error > test->max_edge_error) {
+            fprintf(stderr, "FAIL: %s: symbol edge off by %.1f us with the corrected symbol clock, limit %.1f us\n",
+                    test->name, worst[TEST_VARIANT_Q16_GPS].max_edge_error * 1e6, test->max_edge_error * 1e6);
+            success = false;
+        }
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+/**
+ * Time-synced transmit schedule test: radio_time_sync_find_ready_entry() against the original scan of every entry
+ * on every GPS solution, which is kept here as the reference.
+ *
+ * Both schedulers get their own copy of a transmit schedule and replay the same sequences of GPS time of week
+ * and leap seconds: 1 Hz solutions with jitter and outages, a week rollover, leap second changes in both
+ * directions, a time of week smaller than the leap second correction and entries enabled and disabled on the way
+ * (like landed mode does). The test fails unless exactly the same entries fire for the same solutions, or if an
+ * entry fires before the next slot window predicted by radio_time_sync_millis_until_next() on the solution before.
+ *
+ * Usage: time_sync_test [-S seed]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "radio_time_sync.h"
+
+#define TEST_WEEK_MILLIS (7UL * 24 * 3600 * 1000)
+
+typedef struct _test_sequence {
+    const char *name;
+    uint32_t start_millis;
+    uint32_t solution_count;
+    int8_t leap_seconds;
+    // Leap seconds after half of the solutions, the same value for no change
+    int8_t leap_seconds_changed;
+    // Percentage of solutions lost
+    uint8_t outage_percentage;
+    // Toggle the enabled state of an entry every this many solutions, 0 for never
+    uint32_t toggle_interval;
+} test_sequence;
+
+static test_sequence test_sequences[] = {
+        {
+                .name = "day",
+                .start_millis = 3UL * 24 * 3600 * 1000 + 123,
+                .solution_count = 24 * 3600,
+                .leap_seconds = 18,
+                .leap_seconds_changed = 18,
+        },
+        {
+                .name = "outages",
+                .start_millis = 1000,
+                .solution_count = 20000,
+                .leap_seconds = 18,
+                .leap_seconds_changed = 18,
+                .outage_percentage = 60,
+        },
+        {
+                .name = "week rollover",
+                .start_millis = TEST_WEEK_MILLIS - 3600UL * 1000,
+                .solution_count = 7200,
+                .leap_seconds = 18,
+                .leap_seconds_changed = 18,
+        },
+        {
+                .name = "leap second +",
+                .start_millis = 500000,
+                .solution_count = 7200,
+                .leap_seconds = 17,
+                .leap_seconds_changed = 18,
+        },
+        {
+                .name = "leap second -",
+                .start_millis = 500000,
+                .solution_count = 7200,
+                .leap_seconds = 18,
+                .leap_seconds_changed = 0,
+        },
+        {
+                .name = "leap default",
+                // The default leap seconds replaced by the receiver after the first solutions
+                .start_millis = TEST_WEEK_MILLIS - 600UL * 1000,
+                .solution_count = 7200,
+                .leap_seconds = 0,
+                .leap_seconds_changed = 18,
+        },
+        {
+                .name = "enable toggle",
+                .start_millis = 1000000,
+                .solution_count = 20000,
+                .leap_seconds = 18,
+                .leap_seconds_changed = 18,
+                .outage_percentage = 10,
+                .toggle_interval = 97,
+        },
+};
+
+// Periods and offsets of the time-synced entries, a period of 0 for an entry without time sync
+static const uint16_t test_schedule[][2] = {
+        {0, 0},
+        {60, 0},
+        {60, 20},
+        {30, 5},
+        {10, 0},
+        {0, 0},
+        {120, 59},
+        {3600, 1800},
+        {7, 3},
+};
+
+#define TEST_ENTRY_COUNT (sizeof(test_schedule) / sizeof(test_schedule[0]))
+
+static radio_transmit_entry test_entries[TEST_ENTRY_COUNT];
+static radio_transmit_entry reference_entries[TEST_ENTRY_COUNT];
+
+// Original scan of the whole schedule
+
+static radio_transmit_entry *reference_find_ready_entry(radio_transmit_entry *entries, uint8_t entry_count,
+        uint32_t time_millis)
+{
+    for (uint8_t i = 0; i < entry_count; i++) {
+        radio_transmit_entry *entry = &entries[i];
+        if (!entry->enabled || entry->time_sync_seconds == 0) continue;
+
+        uint32_t offset_millis = entry->time_sync_seconds_offset * 1000;
+        if (time_millis < offset_millis) continue;
+
+        uint32_t slot = (time_millis - offset_millis) / (entry->time_sync_seconds * 1000);
+        if (entry->last_tx_slot == slot) continue;
+
+        uint32_t time_sync_period_millis = (time_millis - offset_millis) % (entry->time_sync_seconds * 1000);
+        if (time_sync_period_millis >= RADIO_TIME_SYNC_THRESHOLD_MS) continue;
+
+        entry->last_tx_slot = slot;
+        return entry;
+    }
+
+    return NULL;
+}
+
+static void test_init_entries()
+{
+    memset(test_entries, 0, sizeof(test_entries));
+
+    for (size_t i = 0; i < TEST_ENTRY_COUNT; i++) {
+        test_entries[i].enabled = true;
+        test_entries[i].time_sync_seconds = test_schedule[i][0];
+        test_entries[i].time_sync_seconds_offset = test_schedule[i][1];
+        test_entries[i].last_tx_slot = UINT32_MAX;
+    }
+
+    memcpy(reference_entries, test_entries, sizeof(test_entries));
+    radio_time_sync_reset();
+}
+
+static bool test_run(test_sequence *sequence, uint32_t *fired_count, uint32_t *solution_count)
+{
+    test_init_entries();
+
+    uint32_t time_of_week_millis = sequence->start_millis;
+    int8_t leap_seconds = sequence->leap_seconds;
+    // Next slot window as predicted on the previous solution, for as long as the time of week moves forward
+    uint32_t previous_millis = 0;
+    uint32_t predicted_millis = UINT32_MAX;
+
+    for (uint32_t n = 0; n < sequence->solution_count; n++) {
+        // Solutions at 1 Hz, with up to 200 ms of jitter in the time the main loop sees them
+        time_of_week_millis = (time_of_week_millis + 1000) % TEST_WEEK_MILLIS;
+        uint32_t seen_millis = (time_of_week_millis + (uint32_t) (rand() % 200)) % TEST_WEEK_MILLIS;
+
+        if (n == sequence->solution_count / 2) {
+            leap_seconds = sequence->leap_seconds_changed;
+        }
+
+        if (sequence->toggle_interval > 0 && n % sequence->toggle_interval == 0) {
+            size_t index = (size_t) rand() % TEST_ENTRY_COUNT;
+            test_entries[index].enabled = !test_entries[index].enabled;
+            reference_entries[index].enabled = test_entries[index].enabled;
+        }
+
+        if ((uint32_t) (rand() % 100) < sequence->outage_percentage) {
+            continue;
+        }
+
+        (*solution_count)++;
+
+        uint32_t time_millis = seen_millis - (leap_seconds * 1000);
+
+        radio_transmit_entry *expected = reference_find_ready_entry(reference_entries, TEST_ENTRY_COUNT, time_millis);
+        radio_transmit_entry *actual = radio_time_sync_find_ready_entry(test_entries, TEST_ENTRY_COUNT, time_millis);
+
+        long expected_index = expected == NULL ? -1 : expected - reference_entries;
+        long actual_index = actual == NULL ? -1 : actual - test_entries;
+
+        if (expected_index != actual_index) {
+            fprintf(stderr, "FAIL: %s: solution %u at %u ms: entry %ld fired, expected %ld\n", sequence->name, n,
+                    time_millis, actual_index, expected_index);
+            return false;
+        }
+
+        // Sensor measurements are started ahead of the prediction, so it must never be later than the entry fires
+        if (actual != NULL && predicted_millis != UINT32_MAX && time_millis >= previous_millis
+            && time_millis < predicted_millis) {
+            fprintf(stderr, "FAIL: %s: solution %u at %u ms: entry %ld fired before the predicted %u ms\n",
+                    sequence->name, n, time_millis, actual_index, predicted_millis);
+            return false;
+        }
+
+        uint32_t until_next_millis = radio_time_sync_millis_until_next(time_millis);
+        predicted_millis = until_next_millis == UINT32_MAX ? UINT32_MAX : time_millis + until_next_millis;
+        previous_millis = time_millis;
+
+        if (actual != NULL) {
+            (*fired_count)++;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "S:")) != -1) {
+        switch (opt) {
+            case 'S':
+                seed = (unsigned int) atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-S seed]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    srand(seed);
+
+    bool success = true;
+
+    printf("%-16s %12s %12s\n", "sequence", "solutions", "fired");
+
+    for (size_t i = 0; i < sizeof(test_sequences) / sizeof(test_sequence); i++) {
+        uint32_t fired_count = 0;
+        uint32_t solution_count = 0;
+
+        if (!test_run(&test_sequences[i], &fired_count, &solution_count)) {
+            success = false;
+            continue;
+        }
+
+        printf("%-16s %12u %12u\n", test_sequences[i].name, solution_count, fired_count);
+
+        if (fired_count == 0) {
+            fprintf(stderr, "FAIL: %s: no entry fired\n", test_sequences[i].name);
+            success = false;
+        }
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,443 @@
+/**
+ * Si4063 SPI command test: runs the DFM17 Si4063 driver against a mock SPI bus and a minimal Si4063 command model.
+ *
+ * Every chip select frame is recorded as the bytes written to the chip, with ".." for a byte read from it. The
+ * frames of each driver call must match the ones recorded with the original driver, both when the chip reports
+ * clear-to-send (CTS) right away and when it stays busy for a few polls after each command. The command trace
+ * must count the commands and CTS polls, and a chip that never reports CTS must make the driver give up after
+ * a bounded number of polls.
+ *
+ * Usage: si4063_spi_test [-p]
+ * With -p, the recorded frames are printed instead of checked.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "stm32f1xx_hal.h"
+#include "drivers/hal/delay.h"
+#include "drivers/hal/spi.h"
+#include "drivers/si4063/si4063.h"
+
+#define TEST_TRACE_LENGTH 8192
+
+// Polls that never see CTS before the driver must give up
+#define TEST_CTS_POLL_LIMIT 200000
+
+GPIO_TypeDef sim_gpio_banks[4];
+TIM_HandleTypeDef htim15;
+
+static char test_trace[TEST_TRACE_LENGTH];
+static size_t test_trace_length;
+static bool test_trace_overflow;
+
+static bool mock_selected;
+static bool mock_frame_empty;
+static uint8_t mock_frame_command;
+static uint8_t mock_frame_length;
+
+// CTS polls answered with "busy" after each command, UINT32_MAX for a chip that never gets ready
+static uint32_t mock_busy_polls;
+static uint32_t mock_busy_polls_left;
+static uint32_t mock_cts_poll_count;
+
+static const uint8_t *mock_response;
+static size_t mock_response_length;
+static size_t mock_response_index;
+
+static void test_trace_append(const char *text)
+{
+    size_t length = strlen(text);
+    if (test_trace_length + length + 1 > sizeof(test_trace)) {
+        test_trace_overflow = true;
+        return;
+    }
+    memcpy(test_trace + test_trace_length, text, length + 1);
+    test_trace_length += length;
+}
+
+static void test_trace_reset()
+{
+    test_trace[0] = '\0';
+    test_trace_length = 0;
+    test_trace_overflow = false;
+}
+
+void spi_set_chip_select(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, bool select)
+{
+    (void) gpio_cs;
+    (void) pin_cs;
+
+    if (select == mock_selected) {
+        return;
+    }
+    mock_selected = select;
+
+    if (select) {
+        test_trace_append(test_trace_length > 0 ? " [" : "[");
+        mock_frame_empty = true;
+        mock_frame_length = 0;
+    } else {
+        test_trace_append("]");
+        // A command other than READ_CMD_BUFF keeps the chip busy for a while
+        if (!mock_frame_empty && mock_frame_command != 0x44) {
+            mock_busy_polls_left = mock_busy_polls;
+            mock_response_index = 0;
+        }
+    }
+}
+
+void spi_send(uint8_t data)
+{
+    char text[4];
+    snprintf(text, sizeof(text), mock_frame_empty ? "%02X" : " %02X", data);
+    test_trace_append(text);
+
+    if (mock_frame_empty) {
+        mock_frame_command = data;
+    }
+    mock_frame_empty = false;
+    mock_frame_length++;
+}
+
+uint8_t spi_read()
+{
+    test_trace_append(mock_frame_empty ? ".." : " ..");
+    mock_frame_empty = false;
+
+    uint8_t position = mock_frame_length++;
+
+    if (mock_frame_command != 0x44) {
+        return 0x00;
+    }
+
+    // The first byte read after READ_CMD_BUFF is CTS, the rest is the command response
+    if (position == 1) {
+        mock_cts_poll_count++;
+        if (mock_busy_polls_left > 0) {
+            if (mock_busy_polls_left != UINT32_MAX) {
+                mock_busy_polls_left--;
+            }
+            return 0x00;
+        }
+        return 0xFF;
+    }
+
+    if (mock_response_index < mock_response_length) {
+        return mock_response[mock_response_index++];
+    }
+
+    return 0x00;
+}
+
+void spi_transfer_segments(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, const spi_segment *segments, uint8_t count)
+{
+    if (gpio_cs != NULL) {
+        spi_set_chip_select(gpio_cs, pin_cs, true);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        for (uint16_t j = 0; j < segments[i].length; j++) {
+            if (segments[i].rx != NULL) {
+                segments[i].rx[j] = spi_read();
+            } else {
+                spi_send(segments[i].tx[j]);
+            }
+        }
+    }
+
+    if (gpio_cs != NULL) {
+        spi_set_chip_select(gpio_cs, pin_cs, false);
+    }
+}
+
+void spi_transfer(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, const uint8_t *tx, uint8_t *rx, uint16_t length)
+{
+    spi_segment segment = {
+            .tx = tx,
+            .rx = rx,
+            .length = length,
+    };
+
+    spi_transfer_segments(gpio_cs, pin_cs, &segment, 1);
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *gpio, GPIO_InitTypeDef *init)
+{
+    (void) gpio;
+    (void) init;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *gpio, uint16_t pin, GPIO_PinState state)
+{
+    (void) gpio;
+    (void) pin;
+    (void) state;
+}
+
+void delay_us(uint16_t us)
+{
+    (void) us;
+}
+
+void delay_ms(uint32_t ms)
+{
+    (void) ms;
+}
+
+typedef struct _test_case {
+    const char *name;
+    void (*call)();
+    const uint8_t *response;
+    size_t response_length;
+    const char *expected;
+    const char *expected_busy;
+} test_case;
+
+static const uint8_t test_part_info[] = {0x11, 0x40, 0x63, 0x00, 0x00, 0x00, 0x00, 0x00};
+static const uint8_t test_fifo_info[] = {0x00, 0x20};
+static const uint8_t test_device_state[] = {0x03};
+static const uint8_t test_adc_reading[] = {0x00, 0x00, 0x00, 0x00, 0x02, 0x9A};
+static const uint8_t test_int_status[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20};
+
+static uint8_t test_data[80];
+static int32_t test_temperature;
+static int test_status;
+
+static void test_call_init()
+{
+    test_status = si4063_init();
+}
+
+static void test_call_set_tx_frequency()
+{
+    si4063_set_tx_frequency(432560000UL);
+}
+
+static void test_call_set_frequency_deviation()
+{
+    si4063_set_frequency_deviation(2400);
+}
+
+static void test_call_set_data_rate()
+{
+    si4063_set_data_rate(1200);
+}
+
+static void test_call_set_tx_power()
+{
+    si4063_set_tx_power(0x7F);
+}
+
+static void test_call_set_frequency_offset()
+{
+    si4063_set_frequency_offset(0x1234);
+}
+
+static void test_call_set_modulation_type()
+{
+    si4063_set_modulation_type(SI4063_MODULATION_TYPE_CW);
+    si4063_set_modulation_type(SI4063_MODULATION_TYPE_OOK);
+    si4063_set_modulation_type(SI4063_MODULATION_TYPE_FSK);
+    si4063_set_modulation_type(SI4063_MODULATION_TYPE_FIFO_FSK);
+}
+
+static void test_call_set_crystal_capacitance()
+{
+    si4063_set_crystal_capacitance(0x3E);
+}
+
+static void test_call_state()
+{
+    si4063_enable_tx();
+    si4063_inhibit_tx();
+    si4063_disable_tx();
+}
+
+static void test_call_read_temperature()
+{
+    test_temperature = si4063_read_temperature_celsius_100();
+}
+
+static void test_call_fifo_underflow()
+{
+    test_status = si4063_fifo_underflow();
+}
+
+static void test_call_start_tx()
+{
+    test_status = si4063_start_tx(test_data, 70);
+}
+
+static void test_call_refill_buffer()
+{
+    test_status = si4063_refill_buffer(test_data, 40);
+}
+
+static void test_call_wait_for_tx_complete()
+{
+    test_status = si4063_wait_for_tx_complete(10);
+}
+
+#include "si4063_spi_test_frames.h"
+
+static test_case test_cases[] = {
+        {"init", test_call_init, test_part_info, sizeof(test_part_info),
+                TEST_FRAMES_INIT, TEST_FRAMES_INIT_BUSY},
+        {"set_tx_frequency", test_call_set_tx_frequency, NULL, 0,
+                TEST_FRAMES_SET_TX_FREQUENCY, TEST_FRAMES_SET_TX_FREQUENCY_BUSY},
+        {"set_frequency_deviation", test_call_set_frequency_deviation, NULL, 0,
+                TEST_FRAMES_SET_FREQUENCY_DEVIATION, TEST_FRAMES_SET_FREQUENCY_DEVIATION_BUSY},
+        {"set_data_rate", test_call_set_data_rate, NULL, 0,
+                TEST_FRAMES_SET_DATA_RATE, TEST_FRAMES_SET_DATA_RATE_BUSY},
+        {"set_tx_power", test_call_set_tx_power, NULL, 0,
+                TEST_FRAMES_SET_TX_POWER, TEST_FRAMES_SET_TX_POWER_BUSY},
+        {"set_frequency_offset", test_call_set_frequency_offset, NULL, 0,
+                TEST_FRAMES_SET_FREQUENCY_OFFSET, TEST_FRAMES_SET_FREQUENCY_OFFSET_BUSY},
+        {"set_modulation_type", test_call_set_modulation_type, NULL, 0,
+                TEST_FRAMES_SET_MODULATION_TYPE, TEST_FRAMES_SET_MODULATION_TYPE_BUSY},
+        {"set_crystal_capacitance", test_call_set_crystal_capacitance, NULL, 0,
+                TEST_FRAMES_SET_CRYSTAL_CAPACITANCE, TEST_FRAMES_SET_CRYSTAL_CAPACITANCE_BUSY},
+        {"state", test_call_state, NULL, 0,
+                TEST_FRAMES_STATE, TEST_FRAMES_STATE_BUSY},
+        {"read_temperature", test_call_read_temperature, test_adc_reading, sizeof(test_adc_reading),
+                TEST_FRAMES_READ_TEMPERATURE, TEST_FRAMES_READ_TEMPERATURE_BUSY},
+        {"fifo_underflow", test_call_fifo_underflow, test_int_status, sizeof(test_int_status),
+                TEST_FRAMES_FIFO_UNDERFLOW, TEST_FRAMES_FIFO_UNDERFLOW_BUSY},
+        {"start_tx", test_call_start_tx, test_int_status, sizeof(test_int_status),
+                TEST_FRAMES_START_TX, TEST_FRAMES_START_TX_BUSY},
+        {"refill_buffer", test_call_refill_buffer, test_fifo_info, sizeof(test_fifo_info),
+                TEST_FRAMES_REFILL_BUFFER, TEST_FRAMES_REFILL_BUFFER_BUSY},
+        {"wait_for_tx_complete", test_call_wait_for_tx_complete, test_device_state, sizeof(test_device_state),
+                TEST_FRAMES_WAIT_FOR_TX_COMPLETE, TEST_FRAMES_WAIT_FOR_TX_COMPLETE_BUSY},
+};
+
+static void test_run(test_case *test, uint32_t busy_polls)
+{
+    mock_busy_polls = busy_polls;
+    mock_busy_polls_left = 0;
+    mock_response = test->response;
+    mock_response_length = test->response_length;
+    mock_response_index = 0;
+    mock_cts_poll_count = 0;
+
+    test_trace_reset();
+    test->call();
+}
+
+static void test_print_frames(const char *name, bool busy)
+{
+    printf("#define TEST_FRAMES_");
+    for (const char *c = name; *c != '\0'; c++) {
+        putchar(*c >= 'a' && *c <= 'z' ? *c - 'a' + 'A' : *c);
+    }
+    printf("%s \\\n", busy ? "_BUSY" : "");
+
+    // Wrap the frames on frame boundaries
+    const char *start = test_trace;
+    while (*start != '\0') {
+        const char *end = start;
+        const char *last_break = NULL;
+        while (*end != '\0' && (end - start < 100 || last_break == NULL)) {
+            if (*end == ']') {
+                last_break = end + 1;
+            }
+            end++;
+        }
+        if (*end == '\0') {
+            last_break = end;
+        }
+        printf("        \"%.*s\"%s\n", (int) (last_break - start), start, *last_break == '\0' ? "" : " \\");
+        start = last_break;
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    bool print = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p")) != -1) {
+        switch (opt) {
+            case 'p':
+                print = true;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-p]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t) (i * 7 + 1);
+    }
+
+    bool success = true;
+
+    for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_case); i++) {
+        test_case *test = &test_cases[i];
+
+        for (int busy = 0; busy <= 1; busy++) {
+            test_run(test, busy ? 3 : 0);
+
+            if (print) {
+                test_print_frames(test->name, busy);
+                continue;
+            }
+
+            const char *expected = busy ? test->expected_busy : test->expected;
+            if (test_trace_overflow || strcmp(test_trace, expected) != 0) {
+                fprintf(stderr, "FAIL: %s%s: SPI frames differ\n  got:      %s\n  expected: %s\n", test->name,
+                        busy ? " (busy)" : "", test_trace, expected);
+                success = false;
+            }
+        }
+    }
+
+    if (print) {
+        return 0;
+    }
+
+    if (test_temperature != -14930) {
+        fprintf(stderr, "FAIL: temperature %d, expected -14930\n", test_temperature);
+        success = false;
+    }
+
+    // Command trace: three commands, the last two of them after three busy polls each
+    si4063_command_trace trace;
+    si4063_reset_command_trace();
+    test_run(&test_cases[1], 3);
+    si4063_get_command_trace(&trace);
+    if (trace.command_count != 3 || trace.cts_poll_count != 9 || trace.cts_poll_max != 4
+            || trace.cts_timeout_count != 0) {
+        fprintf(stderr, "FAIL: command trace: %u commands, %u polls, %u max, %u timeouts\n", trace.command_count,
+                trace.cts_poll_count, trace.cts_poll_max, trace.cts_timeout_count);
+        success = false;
+    }
+
+    // A chip that never reports CTS
+    test_run(&test_cases[0], UINT32_MAX);
+    if (test_status == HAL_OK) {
+        fprintf(stderr, "FAIL: init succeeded without CTS\n");
+        success = false;
+    }
+    if (mock_cts_poll_count > TEST_CTS_POLL_LIMIT) {
+        fprintf(stderr, "FAIL: %u CTS polls without CTS, limit is %d\n", mock_cts_poll_count, TEST_CTS_POLL_LIMIT);
+        success = false;
+    }
+    si4063_get_command_trace(&trace);
+    if (trace.cts_timeout_count == 0) {
+        fprintf(stderr, "FAIL: CTS timeouts missing from the command trace\n");
+        success = false;
+    }
+
+    printf("%s\n", success ? "OK" : "FAILED");
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+/**
+ * SPI frames of the Si4063 driver calls in si4063_spi_test.c, recorded with the original driver (si4063_spi_test -p)
+ */
+
+#define TEST_FRAMES_INIT \
+        "[44 ..] [44 ..] [44 ..] [02 01 01 01 86 A0 00] [44 ..] [44 ..] [01] [44 .. .. .. .. .. .. .. .. ..]" \
+        " [44 ..] [11 00 01 00 62] [44 ..] [11 00 01 01 48] [44 ..] [11 00 01 03 70] [44 ..] [11 01 01 00 00]" \
+        " [44 ..] [11 02 04 00 00 00 00 00] [44 ..] [11 10 01 00 00] [44 ..] [11 11 01 00 80] [44 ..]" \
+        " [11 22 01 02 00] [44 ..] [11 12 01 10 80] [44 ..] [13 00 00 07 04 00 0B 03] [44 ..]" \
+        " [11 22 01 01 00] [44 ..] [11 20 02 0D 00 00] [44 ..] [11 20 03 0A 00 00 00] [44 ..]" \
+        " [11 20 01 00 E8] [44 ..] [34 03]"
+
+#define TEST_FRAMES_INIT_BUSY \
+        "[44 ..] [44 ..] [44 ..] [02 01 01 01 86 A0 00] [44 ..] [44 ..] [44 ..] [44 ..] [44 ..] [01] [44 ..]" \
+        " [44 ..] [44 ..] [44 .. .. .. .. .. .. .. .. ..] [44 ..] [11 00 01 00 62] [44 ..] [44 ..] [44 ..]" \
+        " [44 ..] [11 00 01 01 48] [44 ..] [44 ..] [44 ..] [44 ..] [11 00 01 03 70] [44 ..] [44 ..] [44 ..]" \
+        " [44 ..] [11 01 01 00 00] [44 ..] [44 ..] [44 ..] [44 ..] [11 02 04 00 00 00 00 00] [44 ..] [44 ..]" \
+        " [44 ..] [44 ..] [11 10 01 00 00] [44 ..] [44 ..] [44 ..] [44 ..] [11 11 01 00 80] [44 ..] [44 ..]" \
+        " [44 ..] [44 ..] [11 22 01 02 00] [44 ..] [44 ..] [44 ..] [44 ..] [11 12 01 10 80] [44 ..] [44 ..]" \
+        " [44 ..] [44 ..] [13 00 00 07 04 00 0B 03] [44 ..] [44 ..] [44 ..] [44 ..] [11 22 01 01 00] [44 ..]" \
+        " [44 ..] [44 ..] [44 ..] [11 20 02 0D 00 00] [44 ..] [44 ..] [44 ..] [44 ..] [11 20 03 0A 00 00 00]" \
+        " [44 ..] [44 ..] [44 ..] [44 ..] [11 20 01 00 E8] [44 ..] [44 ..] [44 ..] [44 ..] [34 03]"
+
+#define TEST_FRAMES_SET_TX_FREQUENCY \
+        "[44 ..] [11 20 01 51 0A] [44 ..] [11 40 06 00 42 0C B3 34 00 02] [44 ..] [11 20 03 0A 00 00 00]"
+
+#define TEST_FRAMES_SET_TX_FREQUENCY_BUSY \
+        "[44 ..] [11 20 01 51 0A] [44 ..] [44 ..] [44 ..] [44 ..] [11 40 06 00 42 0C B3 34 00 02] [44 ..]" \
+        " [44 ..] [44 ..] [44 ..] [11 20 03 0A 00 00 00]"
+
+#define TEST_FRAMES_SET_FREQUENCY_DEVIATION \
+        "[44 ..] [11 20 03 0A 00 00 C4]"
+
+#define TEST_FRAMES_SET_FREQUENCY_DEVIATION_BUSY \
+        "[44 ..] [11 20 03 0A 00 00 C4]"
+
+#define TEST_FRAMES_SET_DATA_RATE \
+        "[44 ..] [11 20 07 03 00 2E E0 01 86 A0 00]"
+
+#define TEST_FRAMES_SET_DATA_RATE_BUSY \
+        "[44 ..] [11 20 07 03 00 2E E0 01 86 A0 00]"
+
+#define TEST_FRAMES_SET_TX_POWER \
+        "[44 ..] [11 22 01 01 7F]"
+
+#define TEST_FRAMES_SET_TX_POWER_BUSY \
+        "[44 ..] [11 22 01 01 7F]"
+
+#define TEST_FRAMES_SET_FREQUENCY_OFFSET \
+        "[44 ..] [11 20 02 0D 12 34]"
+
+#define TEST_FRAMES_SET_FREQUENCY_OFFSET_BUSY \
+        "[44 ..] [11 20 02 0D 12 34]"
+
+#define TEST_FRAMES_SET_MODULATION_TYPE \
+        "[44 ..] [11 20 01 00 E8] [44 ..] [11 20 01 00 E9] [44 ..] [11 20 01 00 EA] [44 ..] [11 20 01 00 02]"
+
+#define TEST_FRAMES_SET_MODULATION_TYPE_BUSY \
+        "[44 ..] [11 20 01 00 E8] [44 ..] [44 ..] [44 ..] [44 ..] [11 20 01 00 E9] [44 ..] [44 ..] [44 ..]" \
+        " [44 ..] [11 20 01 00 EA] [44 ..] [44 ..] [44 ..] [44 ..] [11 20 01 00 02]"
+
+#define TEST_FRAMES_SET_CRYSTAL_CAPACITANCE \
+        "[44 ..] [11 00 01 00 3E]"
+
+#define TEST_FRAMES_SET_CRYSTAL_CAPACITANCE_BUSY \
+        "[44 ..] [11 00 01 00 3E]"
+
+#define TEST_FRAMES_STATE \
+        "[44 ..] [34 07] [44 ..] [34 03] [44 ..] [34 01]"
+
+#define TEST_FRAMES_STATE_BUSY \
+        "[44 ..] [34 07] [44 ..] [44 ..] [44 ..] [44 ..] [34 03] [44 ..] [44 ..] [44 ..] [44 ..] [34 01]"
+
+#define TEST_FRAMES_READ_TEMPERATURE \
+        "[44 ..] [14 10 00] [44 .. .. .. .. .. .. ..]"
+
+#define TEST_FRAMES_READ_TEMPERATURE_BUSY \
+        "[44 ..] [14 10 00] [44 ..] [44 ..] [44 ..] [44 .. .. .. .. .. .. ..]"
+
+#define TEST_FRAMES_FIFO_UNDERFLOW \
+        "[44 ..] [20 FF FF DF] [44 .. .. .. .. .. .. .. ..]"
+
+#define TEST_FRAMES_FIFO_UNDERFLOW_BUSY \
+        "[44 ..] [20 FF FF DF] [44 ..] [44 ..] [44 ..] [44 .. .. .. .. .. .. .. ..]"
+
+#define TEST_FRAMES_START_TX \
+        "[44 ..] [20 FF FF DF] [44 .. .. .. .. .. .. .. ..] [44 ..] [15 01] [44 ..] [44 ..]" \
+        " [66 01 08 0F 16 1D 24 2B 32 39 40 47 4E 55 5C 63 6A 71 78 7F 86 8D 94 9B A2 A9 B0 B7 BE C5 CC D3 DA E1 E8 EF F6 FD 04 0B 12 19 20 27 2E 35 3C 43 4A 51 58 5F 66 6D 74 7B 82 89 90 97 9E A5 AC B3 BA]" \
+        " [44 ..] [31 00 10 00 46 00] [44 ..]"
+
+#define TEST_FRAMES_START_TX_BUSY \
+        "[44 ..] [20 FF FF DF] [44 ..] [44 ..] [44 ..] [44 .. .. .. .. .. .. .. ..] [44 ..] [15 01] [44 ..]" \
+        " [44 ..] [44 ..] [44 ..] [44 ..]" \
+        " [66 01 08 0F 16 1D 24 2B 32 39 40 47 4E 55 5C 63 6A 71 78 7F 86 8D 94 9B A2 A9 B0 B7 BE C5 CC D3 DA E1 E8 EF F6 FD 04 0B 12 19 20 27 2E 35 3C 43 4A 51 58 5F 66 6D 74 7B 82 89 90 97 9E A5 AC B3 BA]" \
+        " [44 ..] [44 ..] [44 ..] [44 ..] [31 00 10 00 46 00] [44 ..] [44 ..] [44 ..] [44 ..]"
+
+#define TEST_FRAMES_REFILL_BUFFER \
+        "[44 ..] [15] [44 .. .. ..] [44 ..]" \
+        " [66 01 08 0F 16 1D 24 2B 32 39 40 47 4E 55 5C 63 6A 71 78 7F 86 8D 94 9B A2 A9 B0 B7 BE C5 CC D3 DA]"
+
+#define TEST_FRAMES_REFILL_BUFFER_BUSY \
+        "[44 ..] [15] [44 ..] [44 ..] [44 ..] [44 .. .. ..] [44 ..]" \
+        " [66 01 08 0F 16 1D 24 2B 32 39 40 47 4E 55 5C 63 6A 71 78 7F 86 8D 94 9B A2 A9 B0 B7 BE C5 CC D3 DA]"
+
+#define TEST_FRAMES_WAIT_FOR_TX_COMPLETE \
+        "[44 ..] [33] [44 .. ..]"
+
+#define TEST_FRAMES_WAIT_FOR_TX_COMPLETE_BUSY \
+        "[44 ..] [33] [44 ..] [44 ..] [44 ..] [44 .. ..]"
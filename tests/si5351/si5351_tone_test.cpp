@@ -0,0 +1,244 @@
+/**
+ * Si5351 tone table test: Horus-style MFSK tone switching with si5351_set_tone() and si5351_queue_tone() against
+ * Si5351::set_freq() for every symbol, which is kept here as the reference.
+ *
+ * The handler and a reference driver instance each talk to their own mock Si5351 register file over a mock I2C
+ * bus. After the tone table is set up and after every symbol of a random tone sequence, both register files must
+ * be identical. Symbols alternate randomly between blocking and queued writes, and some queued writes fail: the
+ * registers then differ until the next symbol, which has to bring them back in line. The test also checks that
+ * setups the tone table cannot handle (an R divider boundary between tones, frequencies that need PLL changes)
+ * are refused, and reports the I2C bytes transferred per symbol.
+ *
+ * Usage: si5351_tone_test [-S seed]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "drivers/si5351/si5351.h"
+#include "drivers/hal/i2c_queue.h"
+#include "si5351_handler.h"
+
+#define TEST_SYMBOL_COUNT 2000
+// One in this many queued tone writes fails
+#define TEST_QUEUE_FAILURE_RATE 32
+
+struct _i2c_port {
+    uint8_t registers[256];
+    uint32_t transferred_bytes;
+};
+
+i2c_port DEFAULT_I2C_PORT;
+static i2c_port reference_port;
+
+typedef struct _test_case {
+    const char *name;
+    uint64_t frequency_hz_100;
+    uint32_t tone_spacing_hz_100;
+    uint8_t tone_count;
+    bool supported;
+} test_case;
+
+static test_case test_cases[] = {
+        {.name = "7 MHz", .frequency_hz_100 = 704010000ULL, .tone_spacing_hz_100 = 27000, .tone_count = 4,
+                .supported = true},
+        {.name = "14 MHz", .frequency_hz_100 = 1409510000ULL, .tone_spacing_hz_100 = 27000, .tone_count = 4,
+                .supported = true},
+        {.name = "28 MHz", .frequency_hz_100 = 2812345600ULL, .tone_spacing_hz_100 = 27000, .tone_count = 4,
+                .supported = true},
+        {.name = "50 MHz", .frequency_hz_100 = 5029400000ULL, .tone_spacing_hz_100 = 10000, .tone_count = 16,
+                .supported = true},
+        {.name = "475 kHz", .frequency_hz_100 = 47530000ULL, .tone_spacing_hz_100 = 1500, .tone_count = 4,
+                .supported = true},
+        {.name = "R div boundary", .frequency_hz_100 = 51190000ULL, .tone_spacing_hz_100 = 27000, .tone_count = 4,
+                .supported = false},
+        {.name = "144 MHz", .frequency_hz_100 = 14480000000ULL, .tone_spacing_hz_100 = 27000, .tone_count = 4,
+                .supported = false},
+};
+
+extern "C" {
+
+int i2c_read_bytes(struct _i2c_port *port, uint8_t address, uint8_t reg, uint8_t size, uint8_t *data)
+{
+    (void) address;
+    for (uint8_t i = 0; i < size; i++) {
+        data[i] = port->registers[(uint8_t) (reg + i)];
+    }
+    port->transferred_bytes += 2 + size;
+    return HAL_OK;
+}
+
+int i2c_read_byte(struct _i2c_port *port, uint8_t address, uint8_t reg, uint8_t *data)
+{
+    return i2c_read_bytes(port, address, reg, 1, data);
+}
+
+int i2c_write_bytes(struct _i2c_port *port, uint8_t address, uint8_t reg, uint8_t size, uint8_t *data)
+{
+    (void) address;
+    for (uint8_t i = 0; i < size; i++) {
+        port->registers[(uint8_t) (reg + i)] = data[i];
+    }
+    port->transferred_bytes += 2 + size;
+    return HAL_OK;
+}
+
+int i2c_write_byte(struct _i2c_port *port, uint8_t address, uint8_t reg, uint8_t data)
+{
+    return i2c_write_bytes(port, address, reg, 1, &data);
+}
+
+static bool mock_queue_failure = false;
+
+/**
+ * Queued transfers complete at once, or fail to start without touching the registers
+ */
+int i2c_transfer_start(i2c_request *request)
+{
+    if (mock_queue_failure) {
+        return HAL_ERROR;
+    }
+    i2c_write_bytes(request->port, request->address, request->reg, request->size, request->data);
+    i2c_queue_handle_transfer_complete(HAL_OK);
+    return HAL_OK;
+}
+
+void i2c_transfer_abort()
+{
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return 0;
+}
+
+uint32_t sim_get_primask(void)
+{
+    return 0;
+}
+
+void sim_set_primask(uint32_t primask)
+{
+}
+
+}
+
+static bool test_compare_registers(const char *name, const char *step)
+{
+    for (int i = 0; i < 256; i++) {
+        if (DEFAULT_I2C_PORT.registers[i] != reference_port.registers[i]) {
+            fprintf(stderr, "FAIL: %s: %s: register %d is 0x%02X, expected 0x%02X\n", name, step, i,
+                    DEFAULT_I2C_PORT.registers[i], reference_port.registers[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool test_run(test_case *test, Si5351 *reference, double *bytes_per_symbol, double *reference_bytes_per_symbol)
+{
+    memset(&DEFAULT_I2C_PORT, 0, sizeof(DEFAULT_I2C_PORT));
+    memset(&reference_port, 0, sizeof(reference_port));
+
+    if (!si5351_handler_init() || !reference->init(SI5351_CRYSTAL_LOAD_8PF, 0, 0)) {
+        fprintf(stderr, "FAIL: %s: init failed\n", test->name);
+        return false;
+    }
+
+    bool tone_table = si5351_set_tone_table(SI5351_CLOCK_CLK0, test->frequency_hz_100, test->tone_spacing_hz_100,
+            test->tone_count);
+    if (tone_table != test->supported) {
+        fprintf(stderr, "FAIL: %s: tone table %s\n", test->name, tone_table ? "accepted" : "refused");
+        return false;
+    }
+    if (!tone_table) {
+        return true;
+    }
+
+    reference->set_freq(test->frequency_hz_100, SI5351_CLK0);
+    if (!test_compare_registers(test->name, "setup")) {
+        return false;
+    }
+
+    DEFAULT_I2C_PORT.transferred_bytes = 0;
+    reference_port.transferred_bytes = 0;
+
+    for (uint32_t n = 0; n < TEST_SYMBOL_COUNT; n++) {
+        uint8_t tone_index = (uint8_t) (rand() % test->tone_count);
+        bool queued = (rand() & 1) != 0;
+
+        mock_queue_failure = queued && rand() % TEST_QUEUE_FAILURE_RATE == 0;
+
+        bool success = queued ? si5351_queue_tone(tone_index) : si5351_set_tone(tone_index);
+        reference->set_freq(test->frequency_hz_100 + (uint64_t) tone_index * test->tone_spacing_hz_100, SI5351_CLK0);
+
+        if (!success) {
+            fprintf(stderr, "FAIL: %s: symbol %u: %s tone switch refused\n", test->name, n,
+                    queued ? "queued" : "blocking");
+            return false;
+        }
+        if (mock_queue_failure) {
+            continue;
+        }
+
+        char step[32];
+        snprintf(step, sizeof(step), "symbol %u", n);
+        if (!test_compare_registers(test->name, step)) {
+            return false;
+        }
+    }
+
+    *bytes_per_symbol = (double) DEFAULT_I2C_PORT.transferred_bytes / TEST_SYMBOL_COUNT;
+    *reference_bytes_per_symbol = (double) reference_port.transferred_bytes / TEST_SYMBOL_COUNT;
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "S:")) != -1) {
+        switch (opt) {
+            case 'S':
+                seed = (unsigned int) atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-S seed]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    srand(seed);
+
+    Si5351 reference(&reference_port);
+    bool success = true;
+
+    printf("%-16s %18s %18s\n", "case", "I2C bytes/symbol", "set_freq bytes");
+
+    for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_case); i++) {
+        double bytes_per_symbol = 0;
+        double reference_bytes_per_symbol = 0;
+
+        if (!test_run(&test_cases[i], &reference, &bytes_per_symbol, &reference_bytes_per_symbol)) {
+            success = false;
+            continue;
+        }
+
+        if (!test_cases[i].supported) {
+            printf("%-16s %18s %18s\n", test_cases[i].name, "refused", "-");
+            continue;
+        }
+
+        printf("%-16s %18.2f %18.2f\n", test_cases[i].name, bytes_per_symbol, reference_bytes_per_symbol);
+    }
+
+    return success ? 0 : 1;
+}
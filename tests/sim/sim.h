@@ -0,0 +1,146 @@
+#ifndef __SIM_H
+#define __SIM_H
+
+/**
+ * Host-side hardware-in-the-loop simulator for RS41ng.
+ *
+ * The real radio scheduler (radio.c), the payload encoders, telemetry.c and the radio chip / GPS drivers
+ * are linked against a simulated drivers/hal layer. Time is virtual: TIM6 (scheduler tick), TIM2 (data timer),
+ * SPI transfers, delays and the GPS UART all advance a single nanosecond clock, and interrupt handlers
+ * are dispatched from that clock the same way the NVIC would.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// SPI clock: RS41 runs SPI2 at 24 MHz / 256, DFM17 runs SPI1 at 24 MHz / 32
+#ifdef DFM17
+#define SIM_SPI_CLOCK_HZ (24000000UL / 32)
+#else
+#define SIM_SPI_CLOCK_HZ (24000000UL / 256)
+#endif
+
+#define SIM_SPI_BYTE_NS (8ULL * 1000000000ULL / SIM_SPI_CLOCK_HZ)
+
+// Busy loops only make progress if polling costs time: a GPS DMA ring drain (once per main loop iteration)
+// and a tick counter read are charged with a rough cycle count at 24 MHz
+#define SIM_USART_GPS_DRAIN_NS 2000ULL
+#define SIM_USART_GPS_DRAIN_BYTE_NS 1000ULL
+#define SIM_GET_TICK_NS 250ULL
+
+typedef enum _sim_irq {
+    SIM_IRQ_TIM6 = 0,
+    SIM_IRQ_TIM2,
+    SIM_IRQ_DMA_PWM,
+    SIM_IRQ_I2C,
+    SIM_IRQ_COUNT
+} sim_irq;
+
+typedef struct _sim_irq_stats {
+    const char *name;
+    uint64_t period_ns;
+    uint64_t count;
+    uint64_t overruns;
+    uint64_t latency_ns_total;
+    uint64_t latency_ns_max;
+    uint64_t busy_ns_total;
+    uint64_t busy_ns_max;
+    uint64_t host_ns_total;
+    uint64_t host_ns_max;
+} sim_irq_stats;
+
+typedef struct _sim_symbol_stats {
+    uint64_t nominal_ns;
+    uint64_t count;
+    uint64_t intervals;
+    int64_t error_ns_total;
+    int64_t error_ns_min;
+    int64_t error_ns_max;
+    double error_ns_square_total;
+} sim_symbol_stats;
+
+typedef struct _sim_transmit_stats {
+    uint32_t count;
+    uint64_t latency_ns_total;
+    uint64_t latency_ns_max;
+    uint64_t airtime_ns_total;
+    uint64_t last_tx_off_ns;
+} sim_transmit_stats;
+
+extern uint64_t sim_time_ns;
+extern uint64_t sim_time_limit_ns;
+extern sim_irq_stats sim_irq_statistics[SIM_IRQ_COUNT];
+extern sim_symbol_stats sim_symbol_statistics;
+extern sim_transmit_stats sim_transmit_statistics;
+// DMA channels claimed by two drivers at once
+extern uint32_t sim_dma_conflicts;
+// Blocking I2C transfers started from interrupt context
+extern uint32_t sim_i2c_interrupt_transfers;
+
+/**
+ * Virtual clock
+ */
+void sim_advance(uint64_t ns);
+void sim_advance_to(uint64_t time_ns);
+void sim_idle_until_event(uint64_t limit_ns);
+
+/**
+ * Called from the main context once the virtual clock passes sim_time_limit_ns. Does not return.
+ */
+void sim_finish() __attribute__((noreturn));
+
+/**
+ * Interrupt sources. Periodic sources are dispatched by sim_advance() when their deadline passes.
+ */
+void sim_irq_set_handler(sim_irq irq, void (*handler)());
+void sim_irq_start(sim_irq irq, uint64_t period_ns);
+void sim_irq_set_period(sim_irq irq, uint64_t period_ns);
+uint64_t sim_irq_elapsed(sim_irq irq);
+void sim_irq_stop(sim_irq irq);
+bool sim_irq_running(sim_irq irq);
+// True while an interrupt handler runs
+bool sim_irq_active();
+void sim_irq_mask(bool masked);
+bool sim_irq_masked();
+
+/**
+ * Trace output: one line per event, "<time_us> <source> <event> [details]"
+ */
+void sim_trace_open(const char *path);
+void sim_trace_close();
+void sim_trace(const char *source, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * Radio observation hooks, called by the chip models
+ */
+void sim_radio_tx_on();
+void sim_radio_tx_off();
+void sim_radio_symbol(const char *source, uint32_t value);
+
+/**
+ * Provided by the firmware glue: nominal symbol rate of the current transmission and the virtual time
+ * at which the current transmission became eligible to start (slot boundary or end of post-transmit delay).
+ */
+extern uint32_t (*sim_radio_symbol_rate)();
+extern uint64_t (*sim_radio_eligible_time_ns)();
+
+/**
+ * SPI bus: the HAL forwards chip select edges and bytes to the attached chip model
+ */
+void sim_chip_select(bool selected);
+uint8_t sim_chip_transfer(uint8_t data);
+void sim_chip_gpio_write(uint16_t pin, bool high);
+void sim_si4032_init();
+
+/**
+ * GPS receiver model feeding the USART RX DMA ring
+ */
+void sim_gps_init(const char *replay_path, bool fix);
+void sim_gps_set_baud_rate(uint32_t baud_rate);
+void sim_gps_poll();
+void sim_gps_handle_command(uint8_t data);
+uint32_t sim_gps_time_of_week_ms(uint64_t time_ns);
+void sim_usart_gps_push(uint8_t data);
+
+#endif
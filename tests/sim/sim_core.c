@@ -0,0 +1,341 @@
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim.h"
+
+typedef struct _sim_irq_source {
+    void (*handler)();
+    bool running;
+    uint64_t period_ns;
+    uint64_t deadline_ns;
+} sim_irq_source;
+
+uint64_t sim_time_ns = 0;
+uint64_t sim_time_limit_ns = UINT64_MAX;
+
+sim_irq_stats sim_irq_statistics[SIM_IRQ_COUNT] = {
+        {.name = "TIM6"},
+        {.name = "TIM2"},
+        {.name = "DMA2"},
+        {.name = "I2C2"},
+};
+sim_symbol_stats sim_symbol_statistics;
+sim_transmit_stats sim_transmit_statistics;
+
+uint32_t (*sim_radio_symbol_rate)() = NULL;
+uint64_t (*sim_radio_eligible_time_ns)() = NULL;
+
+static sim_irq_source sim_irq_sources[SIM_IRQ_COUNT];
+static bool sim_in_isr = false;
+static bool sim_irq_mask_state = false;
+
+static FILE *sim_trace_file = NULL;
+
+static bool sim_tx_active = false;
+static uint64_t sim_tx_start_ns = 0;
+static uint64_t sim_last_symbol_ns = 0;
+static bool sim_last_symbol_valid = false;
+
+static uint64_t sim_host_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static sim_irq sim_next_irq(uint64_t *deadline_ns)
+{
+    sim_irq next = SIM_IRQ_COUNT;
+
+    for (int i = 0; i < SIM_IRQ_COUNT; i++) {
+        sim_irq_source *source = &sim_irq_sources[i];
+        if (!source->running) {
+            continue;
+        }
+        if (next == SIM_IRQ_COUNT || source->deadline_ns < *deadline_ns) {
+            next = (sim_irq) i;
+            *deadline_ns = source->deadline_ns;
+        }
+    }
+
+    return next;
+}
+
+static void sim_dispatch(sim_irq irq)
+{
+    sim_irq_source *source = &sim_irq_sources[irq];
+    sim_irq_stats *stats = &sim_irq_statistics[irq];
+
+    uint64_t latency_ns = sim_time_ns - source->deadline_ns;
+    stats->count++;
+    stats->latency_ns_total += latency_ns;
+    if (latency_ns > stats->latency_ns_max) {
+        stats->latency_ns_max = latency_ns;
+    }
+
+    // A periodic timer keeps its phase: missed periods are counted as overruns, not replayed
+    source->deadline_ns += source->period_ns;
+    if (source->deadline_ns <= sim_time_ns) {
+        uint64_t missed = (sim_time_ns - source->deadline_ns) / source->period_ns + 1;
+        stats->overruns += missed;
+        source->deadline_ns += missed * source->period_ns;
+    }
+
+    uint64_t start_ns = sim_time_ns;
+    uint64_t host_start_ns = sim_host_time_ns();
+
+    sim_in_isr = true;
+    source->handler();
+    sim_in_isr = false;
+
+    uint64_t host_ns = sim_host_time_ns() - host_start_ns;
+    uint64_t busy_ns = sim_time_ns - start_ns;
+
+    stats->busy_ns_total += busy_ns;
+    if (busy_ns > stats->busy_ns_max) {
+        stats->busy_ns_max = busy_ns;
+    }
+    stats->host_ns_total += host_ns;
+    if (host_ns > stats->host_ns_max) {
+        stats->host_ns_max = host_ns;
+    }
+}
+
+void sim_advance_to(uint64_t time_ns)
+{
+    // Interrupt handlers do not nest: time spent inside a handler (e.g. on SPI) only delays pending interrupts
+    if (sim_in_isr || sim_irq_mask_state) {
+        if (time_ns > sim_time_ns) {
+            sim_time_ns = time_ns;
+        }
+        sim_gps_poll();
+        return;
+    }
+
+    while (true) {
+        uint64_t deadline_ns = 0;
+        sim_irq irq = sim_next_irq(&deadline_ns);
+        if (irq == SIM_IRQ_COUNT || deadline_ns > time_ns) {
+            break;
+        }
+        if (deadline_ns > sim_time_ns) {
+            sim_time_ns = deadline_ns;
+        }
+        sim_gps_poll();
+        sim_dispatch(irq);
+    }
+
+    if (time_ns > sim_time_ns) {
+        sim_time_ns = time_ns;
+    }
+    sim_gps_poll();
+
+    if (sim_time_ns >= sim_time_limit_ns) {
+        sim_finish();
+    }
+}
+
+void sim_advance(uint64_t ns)
+{
+    sim_advance_to(sim_time_ns + ns);
+}
+
+void sim_idle_until_event(uint64_t limit_ns)
+{
+    uint64_t deadline_ns = 0;
+    sim_irq irq = sim_next_irq(&deadline_ns);
+
+    if (irq != SIM_IRQ_COUNT && deadline_ns < limit_ns) {
+        limit_ns = deadline_ns;
+    }
+
+    sim_advance_to(limit_ns);
+}
+
+void sim_irq_set_handler(sim_irq irq, void (*handler)())
+{
+    sim_irq_sources[irq].handler = handler;
+}
+
+void sim_irq_start(sim_irq irq, uint64_t period_ns)
+{
+    sim_irq_source *source = &sim_irq_sources[irq];
+
+    source->period_ns = period_ns;
+    source->deadline_ns = sim_time_ns + period_ns;
+    source->running = source->handler != NULL;
+
+    sim_irq_statistics[irq].period_ns = period_ns;
+
+    sim_trace(sim_irq_statistics[irq].name, "start period_ns=%llu", (unsigned long long) period_ns);
+}
+
+/**
+ * Changes the period of a running timer from its handler, starting with the period that began with this interrupt,
+ * like writing an unbuffered auto-reload register
+ */
+void sim_irq_set_period(sim_irq irq, uint64_t period_ns)
+{
+    sim_irq_source *source = &sim_irq_sources[irq];
+
+    source->deadline_ns = source->deadline_ns - source->period_ns + period_ns;
+    source->period_ns = period_ns;
+}
+
+/**
+ * Time since the current period of a running timer began, longer than the period while its interrupt is pending
+ */
+uint64_t sim_irq_elapsed(sim_irq irq)
+{
+    sim_irq_source *source = &sim_irq_sources[irq];
+
+    if (!source->running) {
+        return 0;
+    }
+
+    return sim_time_ns + source->period_ns - source->deadline_ns;
+}
+
+void sim_irq_stop(sim_irq irq)
+{
+    if (!sim_irq_sources[irq].running) {
+        return;
+    }
+    sim_irq_sources[irq].running = false;
+
+    sim_trace(sim_irq_statistics[irq].name, "stop");
+}
+
+bool sim_irq_running(sim_irq irq)
+{
+    return sim_irq_sources[irq].running;
+}
+
+bool sim_irq_active()
+{
+    return sim_in_isr;
+}
+
+void sim_irq_mask(bool masked)
+{
+    sim_irq_mask_state = masked;
+    if (!masked) {
+        // Pending interrupts fire as soon as they are unmasked
+        sim_advance(0);
+    }
+}
+
+bool sim_irq_masked()
+{
+    return sim_irq_mask_state;
+}
+
+void sim_trace_open(const char *path)
+{
+    sim_trace_file = fopen(path, "w");
+    if (sim_trace_file == NULL) {
+        perror(path);
+    }
+}
+
+void sim_trace_close()
+{
+    if (sim_trace_file != NULL) {
+        fclose(sim_trace_file);
+        sim_trace_file = NULL;
+    }
+}
+
+void sim_trace(const char *source, const char *format, ...)
+{
+    if (sim_trace_file == NULL) {
+        return;
+    }
+
+    fprintf(sim_trace_file, "%llu.%03llu %s ",
+            (unsigned long long) (sim_time_ns / 1000), (unsigned long long) (sim_time_ns % 1000), source);
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(sim_trace_file, format, args);
+    va_end(args);
+
+    fputc('\n', sim_trace_file);
+}
+
+void sim_radio_tx_on()
+{
+    if (sim_tx_active) {
+        return;
+    }
+
+    sim_tx_active = true;
+    sim_tx_start_ns = sim_time_ns;
+    sim_last_symbol_valid = false;
+
+    uint64_t latency_ns = 0;
+    if (sim_radio_eligible_time_ns != NULL) {
+        uint64_t eligible_ns = sim_radio_eligible_time_ns();
+        if (eligible_ns <= sim_time_ns) {
+            latency_ns = sim_time_ns - eligible_ns;
+        }
+    }
+
+    sim_transmit_statistics.count++;
+    sim_transmit_statistics.latency_ns_total += latency_ns;
+    if (latency_ns > sim_transmit_statistics.latency_ns_max) {
+        sim_transmit_statistics.latency_ns_max = latency_ns;
+    }
+
+    sim_trace("radio", "tx_on schedule_latency_us=%llu", (unsigned long long) (latency_ns / 1000));
+}
+
+void sim_radio_tx_off()
+{
+    if (!sim_tx_active) {
+        return;
+    }
+
+    sim_tx_active = false;
+    sim_transmit_statistics.airtime_ns_total += sim_time_ns - sim_tx_start_ns;
+    sim_transmit_statistics.last_tx_off_ns = sim_time_ns;
+
+    sim_trace("radio", "tx_off airtime_us=%llu", (unsigned long long) ((sim_time_ns - sim_tx_start_ns) / 1000));
+}
+
+void sim_radio_symbol(const char *source, uint32_t value)
+{
+    sim_trace(source, "symbol %lu", (unsigned long) value);
+
+    if (!sim_tx_active) {
+        return;
+    }
+
+    sim_symbol_stats *stats = &sim_symbol_statistics;
+    stats->count++;
+
+    uint32_t symbol_rate = sim_radio_symbol_rate != NULL ? sim_radio_symbol_rate() : 0;
+    if (symbol_rate == 0) {
+        sim_last_symbol_valid = false;
+        return;
+    }
+    stats->nominal_ns = 1000000000ULL / symbol_rate;
+
+    if (sim_last_symbol_valid) {
+        int64_t error_ns = (int64_t) (sim_time_ns - sim_last_symbol_ns) - (int64_t) stats->nominal_ns;
+
+        if (stats->intervals == 0 || error_ns < stats->error_ns_min) {
+            stats->error_ns_min = error_ns;
+        }
+        if (stats->intervals == 0 || error_ns > stats->error_ns_max) {
+            stats->error_ns_max = error_ns;
+        }
+        stats->intervals++;
+        stats->error_ns_total += error_ns;
+        stats->error_ns_square_total += (double) error_ns * (double) error_ns;
+    }
+
+    sim_last_symbol_ns = sim_time_ns;
+    sim_last_symbol_valid = true;
+}
@@ -0,0 +1,394 @@
+/**
+ * u-blox GPS receiver model feeding the simulated USART RX DMA ring.
+ *
+ * The model understands the UBX commands the RS41 GPS driver sends: it acknowledges CFG messages, follows
+ * baud rate changes from CFG-PRT, honors message rates from CFG-MSG and answers NAV-TIMEGPS polls.
+ * Once per second it outputs the enabled NAV messages for a synthetic ascending balloon. Bytes are delivered
+ * at the receiver's baud rate, and nothing gets through while the USART and the receiver disagree on it.
+ *
+ * Alternatively, a raw capture of the receiver output can be replayed byte by byte at the line rate.
+ */
+
+#include <string.h>
+
+#include "config.h"
+#include "sim.h"
+
+#define GPS_DEFAULT_BAUD_RATE 9600
+
+#define GPS_TX_QUEUE_SIZE 4096
+#define GPS_COMMAND_BUFFER_SIZE 128
+
+// GPS week 2330 starts on 2024-09-08, the epoch below is Sunday 00:00:00 GPS time
+#define GPS_START_WEEK 2330
+#define GPS_START_TIME_OF_WEEK_MS 43200000UL
+#define GPS_START_YEAR 2024
+#define GPS_START_MONTH 9
+#define GPS_START_DAY 8
+
+#define GPS_START_LATITUDE_DEGREES_10000000 601700000L
+#define GPS_START_LONGITUDE_DEGREES_10000000 249400000L
+#define GPS_START_ALTITUDE_MM 100000L
+#define GPS_CLIMB_MM_PER_SECOND 5000L
+
+typedef enum _gps_message {
+    GPS_MESSAGE_NAV_POSLLH = 0,
+    GPS_MESSAGE_NAV_STATUS,
+    GPS_MESSAGE_NAV_SOL,
+    GPS_MESSAGE_NAV_VELNED,
+    GPS_MESSAGE_NAV_TIMEUTC,
+    GPS_MESSAGE_COUNT
+} gps_message;
+
+static const uint8_t gps_message_ids[GPS_MESSAGE_COUNT] = {0x02, 0x03, 0x06, 0x12, 0x21};
+
+static uint8_t gps_message_rates[GPS_MESSAGE_COUNT];
+
+static bool gps_fix = true;
+static bool gps_sleeping = false;
+
+static uint32_t gps_usart_baud_rate = 0;
+static uint32_t gps_receiver_baud_rate = GPS_DEFAULT_BAUD_RATE;
+
+static uint8_t gps_tx_queue[GPS_TX_QUEUE_SIZE];
+static uint16_t gps_tx_queue_head = 0;
+static uint16_t gps_tx_queue_tail = 0;
+static uint64_t gps_tx_next_byte_ns = 0;
+
+static uint8_t gps_command_buffer[GPS_COMMAND_BUFFER_SIZE];
+static uint16_t gps_command_length = 0;
+
+static uint64_t gps_next_epoch_ns = 1000000000ULL;
+static uint32_t gps_epoch_count = 0;
+
+static FILE *gps_replay_file = NULL;
+
+static uint64_t gps_byte_time_ns()
+{
+    return 10ULL * 1000000000ULL / gps_receiver_baud_rate;
+}
+
+static bool gps_baud_rate_matches()
+{
+    return gps_usart_baud_rate == gps_receiver_baud_rate;
+}
+
+uint32_t sim_gps_time_of_week_ms(uint64_t time_ns)
+{
+    return (uint32_t) ((GPS_START_TIME_OF_WEEK_MS + time_ns / 1000000ULL) % (7UL * 24 * 3600 * 1000));
+}
+
+static void gps_queue_byte(uint8_t data)
+{
+    uint16_t next = (gps_tx_queue_head + 1) % GPS_TX_QUEUE_SIZE;
+    if (next == gps_tx_queue_tail) {
+        sim_trace("gps", "tx queue overflow");
+        return;
+    }
+
+    if (gps_tx_queue_head == gps_tx_queue_tail && gps_tx_next_byte_ns < sim_time_ns) {
+        gps_tx_next_byte_ns = sim_time_ns;
+    }
+
+    gps_tx_queue[gps_tx_queue_head] = data;
+    gps_tx_queue_head = next;
+}
+
+static void gps_queue_packet(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t payload_size)
+{
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+    uint8_t header[4] = {msg_class, msg_id, (uint8_t) (payload_size & 0xFFU), (uint8_t) (payload_size >> 8U)};
+
+    gps_queue_byte(0xB5);
+    gps_queue_byte(0x62);
+
+    for (int i = 0; i < 4; i++) {
+        gps_queue_byte(header[i]);
+        ck_a += header[i];
+        ck_b += ck_a;
+    }
+    for (uint16_t i = 0; i < payload_size; i++) {
+        gps_queue_byte(payload[i]);
+        ck_a += payload[i];
+        ck_b += ck_a;
+    }
+
+    gps_queue_byte(ck_a);
+    gps_queue_byte(ck_b);
+
+    sim_trace("gps", "tx class=0x%02X id=0x%02X len=%u", msg_class, msg_id, payload_size);
+}
+
+static void gps_put_u8(uint8_t *buffer, int offset, uint8_t value)
+{
+    buffer[offset] = value;
+}
+
+static void gps_put_u16(uint8_t *buffer, int offset, uint16_t value)
+{
+    buffer[offset] = (uint8_t) value;
+    buffer[offset + 1] = (uint8_t) (value >> 8U);
+}
+
+static void gps_put_u32(uint8_t *buffer, int offset, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        buffer[offset + i] = (uint8_t) (value >> (8U * i));
+    }
+}
+
+static void gps_queue_ack(uint8_t msg_class, uint8_t msg_id, bool ack)
+{
+    uint8_t payload[2] = {msg_class, msg_id};
+    gps_queue_packet(0x05, ack ? 0x01 : 0x00, payload, sizeof(payload));
+}
+
+static void gps_queue_nav_message(gps_message message, uint64_t epoch_ns)
+{
+    uint8_t payload[52];
+    memset(payload, 0, sizeof(payload));
+
+    uint32_t itow = sim_gps_time_of_week_ms(epoch_ns);
+    uint32_t seconds = (uint32_t) (epoch_ns / 1000000000ULL);
+    int32_t altitude_mm = gps_fix ? GPS_START_ALTITUDE_MM + (int32_t) seconds * GPS_CLIMB_MM_PER_SECOND : 0;
+
+    switch (message) {
+        case GPS_MESSAGE_NAV_POSLLH:
+            gps_put_u32(payload, 0, itow);
+            gps_put_u32(payload, 4, gps_fix ? GPS_START_LONGITUDE_DEGREES_10000000 : 0);
+            gps_put_u32(payload, 8, gps_fix ? GPS_START_LATITUDE_DEGREES_10000000 : 0);
+            gps_put_u32(payload, 12, altitude_mm);
+            gps_put_u32(payload, 16, altitude_mm);
+            gps_put_u32(payload, 20, 5000);
+            gps_put_u32(payload, 24, 8000);
+            gps_queue_packet(0x01, 0x02, payload, 28);
+            break;
+        case GPS_MESSAGE_NAV_STATUS:
+            gps_put_u32(payload, 0, itow);
+            gps_put_u8(payload, 4, gps_fix ? 3 : 0);
+            gps_put_u8(payload, 5, gps_fix ? 0x0D : 0x00);
+            gps_put_u8(payload, 7, 0x01);
+            gps_put_u32(payload, 8, 30000);
+            gps_put_u32(payload, 12, (uint32_t) (epoch_ns / 1000000ULL));
+            gps_queue_packet(0x01, 0x03, payload, 16);
+            break;
+        case GPS_MESSAGE_NAV_SOL:
+            gps_put_u32(payload, 0, itow);
+            gps_put_u16(payload, 8, GPS_START_WEEK);
+            gps_put_u8(payload, 10, gps_fix ? 3 : 0);
+            gps_put_u8(payload, 11, gps_fix ? 0x0D : 0x00);
+            gps_put_u16(payload, 44, 150);
+            gps_put_u8(payload, 47, gps_fix ? 9 : 0);
+            gps_queue_packet(0x01, 0x06, payload, 52);
+            break;
+        case GPS_MESSAGE_NAV_VELNED:
+            gps_put_u32(payload, 0, itow);
+            gps_put_u32(payload, 4, 300);
+            gps_put_u32(payload, 8, 400);
+            gps_put_u32(payload, 12, (uint32_t) (-GPS_CLIMB_MM_PER_SECOND / 10));
+            gps_put_u32(payload, 16, 640);
+            gps_put_u32(payload, 20, 500);
+            gps_put_u32(payload, 24, 5313010);
+            gps_queue_packet(0x01, 0x12, payload, 36);
+            break;
+        case GPS_MESSAGE_NAV_TIMEUTC: {
+            uint32_t utc_seconds = (itow / 1000 + 24 * 3600 - GPS_TIME_LEAP_SECONDS) % (24 * 3600);
+            gps_put_u32(payload, 0, itow);
+            gps_put_u32(payload, 4, 50);
+            gps_put_u16(payload, 12, GPS_START_YEAR);
+            gps_put_u8(payload, 14, GPS_START_MONTH);
+            gps_put_u8(payload, 15, GPS_START_DAY);
+            gps_put_u8(payload, 16, utc_seconds / 3600);
+            gps_put_u8(payload, 17, (utc_seconds / 60) % 60);
+            gps_put_u8(payload, 18, utc_seconds % 60);
+            gps_put_u8(payload, 19, gps_fix ? 0x07 : 0x00);
+            gps_queue_packet(0x01, 0x21, payload, 20);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static void gps_queue_nav_timegps(uint64_t epoch_ns)
+{
+    uint8_t payload[16];
+    memset(payload, 0, sizeof(payload));
+
+    gps_put_u32(payload, 0, sim_gps_time_of_week_ms(epoch_ns));
+    gps_put_u16(payload, 8, GPS_START_WEEK);
+    gps_put_u8(payload, 10, GPS_TIME_LEAP_SECONDS);
+    gps_put_u8(payload, 11, gps_fix ? 0x07 : 0x00);
+    gps_put_u32(payload, 12, 50);
+
+    gps_queue_packet(0x01, 0x20, payload, sizeof(payload));
+}
+
+static void gps_handle_command_packet(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t size)
+{
+    sim_trace("gps", "rx class=0x%02X id=0x%02X len=%u", msg_class, msg_id, size);
+
+    if (msg_class == 0x06) {
+        switch (msg_id) {
+            case 0x00:
+                // CFG-PRT: the acknowledgement still goes out at the old baud rate
+                gps_queue_ack(msg_class, msg_id, true);
+                if (size >= 12) {
+                    gps_receiver_baud_rate = payload[8] | (payload[9] << 8U) | ((uint32_t) payload[10] << 16U)
+                            | ((uint32_t) payload[11] << 24U);
+                    sim_trace("gps", "baud_rate %lu", (unsigned long) gps_receiver_baud_rate);
+                }
+                return;
+            case 0x01:
+                if (size >= 3 && payload[0] == 0x01) {
+                    for (int i = 0; i < GPS_MESSAGE_COUNT; i++) {
+                        if (gps_message_ids[i] == payload[1]) {
+                            gps_message_rates[i] = payload[2];
+                        }
+                    }
+                }
+                break;
+            case 0x04:
+                // CFG-RST: controlled software reset reverts to the default port configuration, no acknowledgement
+                gps_receiver_baud_rate = GPS_DEFAULT_BAUD_RATE;
+                memset(gps_message_rates, 0, sizeof(gps_message_rates));
+                gps_tx_queue_tail = gps_tx_queue_head;
+                gps_sleeping = false;
+                sim_trace("gps", "reset");
+                return;
+            default:
+                break;
+        }
+        gps_queue_ack(msg_class, msg_id, true);
+    } else if (msg_class == 0x02 && msg_id == 0x41) {
+        gps_sleeping = true;
+        sim_trace("gps", "sleep");
+    } else if (msg_class == 0x01 && msg_id == 0x20 && size == 0) {
+        gps_queue_nav_timegps(sim_time_ns);
+    }
+}
+
+void sim_gps_handle_command(uint8_t data)
+{
+    if (!gps_baud_rate_matches()) {
+        // Framing errors on the receiver side: the byte is lost
+        gps_command_length = 0;
+        return;
+    }
+
+    if (gps_command_length == 0 && data != 0xB5) {
+        return;
+    }
+    if (gps_command_length == 1 && data != 0x62) {
+        gps_command_length = 0;
+        return;
+    }
+
+    gps_command_buffer[gps_command_length++] = data;
+
+    if (gps_command_length < 6) {
+        return;
+    }
+
+    uint16_t payload_size = gps_command_buffer[4] | (gps_command_buffer[5] << 8U);
+    if (payload_size + 8 > GPS_COMMAND_BUFFER_SIZE) {
+        gps_command_length = 0;
+        return;
+    }
+    if (gps_command_length < payload_size + 8) {
+        return;
+    }
+
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+    for (uint16_t i = 2; i < payload_size + 6; i++) {
+        ck_a += gps_command_buffer[i];
+        ck_b += ck_a;
+    }
+
+    if (ck_a == gps_command_buffer[payload_size + 6] && ck_b == gps_command_buffer[payload_size + 7]) {
+        gps_handle_command_packet(gps_command_buffer[2], gps_command_buffer[3], &gps_command_buffer[6], payload_size);
+    } else {
+        sim_trace("gps", "rx checksum error");
+    }
+
+    gps_command_length = 0;
+}
+
+static void gps_handle_epoch(uint64_t epoch_ns)
+{
+    if (gps_sleeping || gps_replay_file != NULL) {
+        return;
+    }
+
+    gps_epoch_count++;
+
+    for (int i = 0; i < GPS_MESSAGE_COUNT; i++) {
+        if (gps_message_rates[i] > 0 && (gps_epoch_count % gps_message_rates[i]) == 0) {
+            gps_queue_nav_message((gps_message) i, epoch_ns);
+        }
+    }
+}
+
+static void gps_queue_replay_bytes()
+{
+    // Keep the line busy: refill from the capture whenever the queue runs dry, wrapping around at the end
+    while (gps_tx_queue_head == gps_tx_queue_tail) {
+        int c = fgetc(gps_replay_file);
+        if (c == EOF) {
+            rewind(gps_replay_file);
+            c = fgetc(gps_replay_file);
+            if (c == EOF) {
+                return;
+            }
+        }
+        gps_queue_byte((uint8_t) c);
+    }
+}
+
+void sim_gps_poll()
+{
+    while (sim_time_ns >= gps_next_epoch_ns) {
+        gps_handle_epoch(gps_next_epoch_ns);
+        gps_next_epoch_ns += 1000000000ULL;
+    }
+
+    if (gps_replay_file != NULL && !gps_sleeping) {
+        gps_queue_replay_bytes();
+    }
+
+    while (gps_tx_queue_head != gps_tx_queue_tail && gps_tx_next_byte_ns + gps_byte_time_ns() <= sim_time_ns) {
+        uint8_t data = gps_tx_queue[gps_tx_queue_tail];
+        gps_tx_queue_tail = (gps_tx_queue_tail + 1) % GPS_TX_QUEUE_SIZE;
+        gps_tx_next_byte_ns += gps_byte_time_ns();
+
+        if (gps_baud_rate_matches()) {
+            sim_usart_gps_push(data);
+        }
+
+        if (gps_replay_file != NULL && !gps_sleeping) {
+            gps_queue_replay_bytes();
+        }
+    }
+}
+
+void sim_gps_set_baud_rate(uint32_t baud_rate)
+{
+    gps_usart_baud_rate = baud_rate;
+    sim_trace("usart_gps", "baud_rate %lu", (unsigned long) baud_rate);
+}
+
+void sim_gps_init(const char *replay_path, bool fix)
+{
+    gps_fix = fix;
+
+    if (replay_path != NULL) {
+        gps_replay_file = fopen(replay_path, "rb");
+        if (gps_replay_file == NULL) {
+            perror(replay_path);
+        }
+        // A recorded receiver is already configured
+        gps_receiver_baud_rate = GPS_SERIAL_PORT_BAUD_RATE;
+    }
+}
@@ -0,0 +1,754 @@
+/**
+ * Simulated drivers/hal layer: system, delay, data timer, PWM timer, SPI, I2C and GPS USART
+ * implemented on top of the simulator's virtual clock.
+ */
+
+#include <string.h>
+
+#include "config.h"
+#include "gpio.h"
+#include "drivers/hal/system.h"
+#include "drivers/hal/delay.h"
+#include "drivers/hal/datatimer.h"
+#include "drivers/hal/pwm.h"
+#include "drivers/hal/spi.h"
+#include "drivers/hal/i2c.h"
+#include "drivers/hal/i2c_queue.h"
+#include "drivers/hal/timers.h"
+#include "drivers/hal/usart_gps.h"
+
+#include "drivers/hal/clock_calibration.h"
+#include "symbol_clock.h"
+
+#include "sim.h"
+
+#define GPS_DMA_BUF_SIZE 256
+
+GPIO_TypeDef sim_gpio_banks[4] = {
+        {.name = 'A'},
+        {.name = 'B'},
+        {.name = 'C'},
+        {.name = 'D'},
+};
+
+static TIM_TypeDef sim_tim1;
+static TIM_TypeDef sim_tim2;
+static TIM_TypeDef sim_tim6;
+static TIM_TypeDef sim_tim15;
+
+TIM_HandleTypeDef htim1 = {.Instance = &sim_tim1};
+TIM_HandleTypeDef htim2 = {.Instance = &sim_tim2};
+TIM_HandleTypeDef htim6 = {.Instance = &sim_tim6};
+TIM_HandleTypeDef htim15 = {.Instance = &sim_tim15};
+
+void (*system_handle_timer_tick)() = NULL;
+void (*system_handle_data_timer_tick)() = NULL;
+static uint16_t sim_tick_step = 1;
+// Ticks of a timer period cut short by a step change, covered by the next interrupt
+static uint16_t sim_tick_carry = 0;
+// Ticks covered by the running TIM6 interrupt
+static uint16_t sim_interrupt_ticks = 1;
+void (*usart_gps_handle_incoming_data)(const uint8_t *ring, uint16_t ring_size, uint16_t start, uint16_t end,
+        uint8_t reset) = NULL;
+
+volatile uint32_t gps_ints = 0;
+volatile uint32_t drain_interrupted = 0;
+volatile uint32_t drain_not_enabled = 0;
+volatile uint32_t drain_null_instance = 0;
+volatile uint32_t drain_dma_not_running = 0;
+volatile uint32_t drain_byte_calls = 0;
+
+static uint8_t dma_rx_buf[GPS_DMA_BUF_SIZE];
+static volatile uint16_t dma_rd_pos = 0;
+static volatile uint16_t dma_wr_pos = 0;
+static volatile bool dma_drain_enabled = true;
+static bool usart_gps_enabled = false;
+static uint32_t usart_gps_overruns = 0;
+
+static bool pwm_timer_enabled = false;
+
+#define SIM_DMA_CHANNEL_COUNT 7
+
+// Driver that configured each DMA1 channel, by channel number
+static const char *sim_dma_channel_owners[SIM_DMA_CHANNEL_COUNT + 1];
+uint32_t sim_dma_conflicts = 0;
+
+/**
+ * Called where the driver configures its DMA channel (DMA_CHANNEL_* of config_internal.h). A channel configured
+ * by another driver that has not released it is a conflict, which fails the simulation.
+ */
+static void sim_dma_claim(uint8_t channel, const char *owner)
+{
+    const char *current = sim_dma_channel_owners[channel];
+
+    if (current != NULL && strcmp(current, owner) != 0) {
+        fprintf(stderr, "FAIL: DMA1 channel %u claimed by %s while owned by %s\n", channel, owner, current);
+        sim_trace("dma", "conflict channel %u %s %s", channel, owner, current);
+        sim_dma_conflicts++;
+        return;
+    }
+
+    sim_dma_channel_owners[channel] = owner;
+}
+
+static void sim_dma_release(uint8_t channel, const char *owner)
+{
+    if (sim_dma_channel_owners[channel] != NULL && strcmp(sim_dma_channel_owners[channel], owner) == 0) {
+        sim_dma_channel_owners[channel] = NULL;
+    }
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *gpio, GPIO_InitTypeDef *init)
+{
+    (void) gpio;
+    (void) init;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *gpio, uint16_t pin, GPIO_PinState state)
+{
+    if (state == GPIO_PIN_SET) {
+        gpio->odr |= pin;
+    } else {
+        gpio->odr &= ~pin;
+    }
+
+    if (gpio == BANK_NSEL && pin == PIN_NSEL) {
+        // Chip select is active low
+        sim_chip_select(state == GPIO_PIN_RESET);
+        return;
+    }
+
+    sim_chip_gpio_write(pin, state == GPIO_PIN_SET);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *gpio, uint16_t pin)
+{
+    return (gpio->odr & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    sim_advance(SIM_GET_TICK_NS);
+    return (uint32_t) (sim_time_ns / 1000000ULL);
+}
+
+void sim_wait_for_interrupt(void)
+{
+    sim_idle_until_event(UINT64_MAX);
+}
+
+uint32_t sim_get_primask(void)
+{
+    return sim_irq_masked() ? 1 : 0;
+}
+
+void sim_set_primask(uint32_t primask)
+{
+    sim_irq_mask(primask != 0);
+}
+
+static void sim_handle_tim6()
+{
+    User_TIM6_IRQHandler(&htim6);
+}
+
+static void sim_handle_tim2()
+{
+    User_TIM2_IRQHandler(&htim2);
+}
+
+void system_init()
+{
+    sim_dma_claim(DMA_CHANNEL_ADC, "adc");
+    sim_irq_set_handler(SIM_IRQ_TIM6, sim_handle_tim6);
+    sim_irq_set_handler(SIM_IRQ_TIM2, sim_handle_tim2);
+    sim_irq_start(SIM_IRQ_TIM6, 1000000000ULL / SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND * sim_tick_step);
+}
+
+void system_shutdown()
+{
+    sim_trace("system", "shutdown");
+}
+
+void system_disable_tick()
+{
+    sim_irq_stop(SIM_IRQ_TIM6);
+}
+
+void system_enable_tick()
+{
+    if (!sim_irq_running(SIM_IRQ_TIM6)) {
+        sim_irq_start(SIM_IRQ_TIM6, 1000000000ULL / SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND * sim_tick_step);
+    }
+}
+
+void system_set_tick_step(uint16_t step)
+{
+    if (step == 0 || step == sim_tick_step) {
+        return;
+    }
+
+    sim_tick_step = step;
+    if (sim_irq_running(SIM_IRQ_TIM6)) {
+        // Reloading the auto-reload register and the counter restarts the period,
+        // the next interrupt covers the ticks that have passed in the current one
+        sim_tick_carry += sim_irq_elapsed(SIM_IRQ_TIM6) / (1000000000ULL / SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND);
+        sim_irq_start(SIM_IRQ_TIM6, 1000000000ULL / SYSTEM_SCHEDULER_TIMER_TICKS_PER_SECOND * sim_tick_step);
+    }
+}
+
+uint16_t system_get_tick_step()
+{
+    return sim_interrupt_ticks;
+}
+
+void system_idle_sleep(uint16_t ticks)
+{
+    system_set_tick_step(ticks);
+    // HAL_GetTick() follows the virtual clock, so there is no SysTick to suspend and correct
+    sim_wait_for_interrupt();
+}
+
+void system_disable_irq()
+{
+    sim_irq_mask(true);
+}
+
+void system_enable_irq()
+{
+    sim_irq_mask(false);
+}
+
+void system_set_green_led(bool enabled)
+{
+    sim_trace("led", "green %d", enabled);
+}
+
+void system_set_red_led(bool enabled)
+{
+    sim_trace("led", "red %d", enabled);
+}
+
+#ifdef DFM17
+void system_set_yellow_led(bool enabled)
+{
+    sim_trace("led", "yellow %d", enabled);
+}
+
+void system_switch_to_hse_bypass()
+{
+}
+
+uint16_t system_get_current_milliamps()
+{
+    return 100;
+}
+
+int clock_calibration_get_cap_trim_offset()
+{
+    return 0;
+}
+
+int32_t clock_calibration_get_us_error()
+{
+    return 0;
+}
+
+uint8_t clock_calibration_get_po_state()
+{
+    return 3;
+}
+
+int32_t clock_calibration_get_clock_error_ppb()
+{
+    return 0;
+}
+#endif
+
+uint16_t system_get_battery_voltage_millivolts()
+{
+    return 3000;
+}
+
+uint16_t system_get_button_adc_value()
+{
+    return 0;
+}
+
+void system_handle_button()
+{
+}
+
+void User_TIM6_IRQHandler(TIM_HandleTypeDef *htim)
+{
+    (void) htim;
+    sim_interrupt_ticks = sim_tick_step + sim_tick_carry;
+    sim_tick_carry = 0;
+
+    if (system_handle_timer_tick != NULL) {
+        system_handle_timer_tick();
+    }
+}
+
+void DMA1_Channel1_IRQHandler(void)
+{
+}
+
+void SysTick_Handler(void)
+{
+}
+
+void delay_init()
+{
+}
+
+void delay_us(uint16_t us)
+{
+    sim_advance((uint64_t) us * 1000ULL);
+}
+
+void delay_us_loop(uint16_t us)
+{
+    sim_advance((uint64_t) us * 1000ULL);
+}
+
+void delay_ms(uint32_t ms)
+{
+    sim_advance((uint64_t) ms * 1000000ULL);
+}
+
+void User_TIM1_IRQHandler(TIM_HandleTypeDef *htim)
+{
+    (void) htim;
+}
+
+static symbol_clock sim_data_timer_symbol_clock;
+
+void data_timer_init(uint32_t baud_rate)
+{
+    // Same periods as the real TIM2 setup: 1 MHz timer clock, ARR set from the symbol clock for every cycle
+    symbol_clock_init_rate(&sim_data_timer_symbol_clock, 1000000, baud_rate);
+    uint16_t period = (uint16_t) (symbol_clock_next(&sim_data_timer_symbol_clock,
+            clock_calibration_get_clock_error_ppb()) - 1);
+    htim2.Instance->ARR = period;
+    sim_irq_start(SIM_IRQ_TIM2, ((uint64_t) period + 1) * 1000ULL);
+}
+
+void data_timer_uninit()
+{
+    sim_irq_stop(SIM_IRQ_TIM2);
+}
+
+void User_TIM2_IRQHandler(TIM_HandleTypeDef *htim)
+{
+    (void) htim;
+    uint16_t period = (uint16_t) (symbol_clock_next(&sim_data_timer_symbol_clock,
+            clock_calibration_get_clock_error_ppb()) - 1);
+    htim2.Instance->ARR = period;
+    sim_irq_set_period(SIM_IRQ_TIM2, ((uint64_t) period + 1) * 1000ULL);
+    if (system_handle_data_timer_tick != NULL) {
+        system_handle_data_timer_tick();
+    }
+}
+
+void pwm_timer_init(uint32_t frequency_hz_100)
+{
+    htim15.Instance->ARR = pwm_calculate_period(frequency_hz_100);
+    sim_trace("pwm", "init period=%lu", (unsigned long) htim15.Instance->ARR);
+}
+
+void pwm_timer_pwm_enable(bool enabled)
+{
+    if (enabled != pwm_timer_enabled) {
+        sim_trace("pwm", "enable %d", enabled);
+    }
+    pwm_timer_enabled = enabled;
+}
+
+void pwm_timer_use(bool use)
+{
+    sim_trace("pwm", "use %d", use);
+}
+
+void pwm_timer_uninit()
+{
+    pwm_timer_enabled = false;
+    sim_trace("pwm", "uninit");
+}
+
+uint16_t pwm_calculate_period(uint32_t frequency_hz_100)
+{
+    return (uint16_t) (((100.0f * 1000000.0f) / (frequency_hz_100 * 2.0f))) - 1;
+}
+
+void pwm_timer_set_frequency(uint32_t pwm_period)
+{
+    htim15.Instance->ARR = pwm_period;
+    sim_radio_symbol("pwm", pwm_period);
+}
+
+#if PWM_TIMER_DMA_ENABLE
+uint16_t pwm_timer_dma_buffer[PWM_TIMER_DMA_BUFFER_SIZE];
+
+uint16_t (*pwm_handle_dma_transfer_half)(uint16_t buffer_size, uint16_t *buffer) = NULL;
+uint16_t (*pwm_handle_dma_transfer_full)(uint16_t buffer_size, uint16_t *buffer) = NULL;
+
+static bool pwm_dma_second_half = false;
+
+/**
+ * The DMA transfers are paced by the PWM output: a buffer half takes the sum of its half cycle periods to play.
+ */
+static uint64_t pwm_dma_half_duration_ns(bool second_half)
+{
+    uint16_t length = PWM_TIMER_DMA_BUFFER_SIZE / 2;
+    uint16_t *periods = pwm_timer_dma_buffer + (second_half ? length : 0);
+    uint64_t ticks = 0;
+
+    for (uint16_t i = 0; i < length; i++) {
+        ticks += (uint64_t) periods[i] + 1;
+    }
+
+    return ticks * (1000000000ULL / PWM_TIMER_CLOCK_HZ);
+}
+
+static void sim_handle_dma_pwm()
+{
+    bool second_half = pwm_dma_second_half;
+
+    // The other half is played while the completed one is refilled
+    pwm_dma_second_half = !pwm_dma_second_half;
+    sim_irq_start(SIM_IRQ_DMA_PWM, pwm_dma_half_duration_ns(pwm_dma_second_half));
+
+    sim_trace("pwm", "dma %s", second_half ? "full" : "half");
+
+    if (second_half) {
+        if (pwm_handle_dma_transfer_full != NULL) {
+            pwm_handle_dma_transfer_full(PWM_TIMER_DMA_BUFFER_SIZE, pwm_timer_dma_buffer);
+        }
+    } else {
+        if (pwm_handle_dma_transfer_half != NULL) {
+            pwm_handle_dma_transfer_half(PWM_TIMER_DMA_BUFFER_SIZE, pwm_timer_dma_buffer);
+        }
+    }
+}
+
+void pwm_dma_init()
+{
+    sim_dma_claim(DMA_CHANNEL_PWM_TIMER, "pwm");
+    sim_irq_set_handler(SIM_IRQ_DMA_PWM, sim_handle_dma_pwm);
+}
+
+void pwm_dma_start()
+{
+    pwm_dma_second_half = false;
+    sim_irq_start(SIM_IRQ_DMA_PWM, pwm_dma_half_duration_ns(false));
+}
+
+void pwm_dma_stop()
+{
+    sim_irq_stop(SIM_IRQ_DMA_PWM);
+}
+#endif
+
+void spi_init()
+{
+#if SPI_DMA_ENABLE
+    sim_dma_claim(DMA_CHANNEL_SPI_TX, "spi");
+#endif
+}
+
+void spi_uninit()
+{
+#if SPI_DMA_ENABLE
+    sim_dma_release(DMA_CHANNEL_SPI_TX, "spi");
+#endif
+}
+
+void spi_send(uint8_t data)
+{
+    sim_chip_transfer(data);
+}
+
+uint8_t spi_receive()
+{
+    return sim_chip_transfer(0xFF);
+}
+
+uint8_t spi_read()
+{
+    return sim_chip_transfer(0xFF);
+}
+
+void spi_set_chip_select(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, bool select)
+{
+    HAL_GPIO_WritePin(gpio_cs, pin_cs, select ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+uint8_t spi_send_and_receive(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, uint16_t data)
+{
+    HAL_GPIO_WritePin(gpio_cs, pin_cs, GPIO_PIN_RESET);
+    sim_chip_transfer((uint8_t) (data >> 8));
+    uint8_t rx = sim_chip_transfer((uint8_t) (data & 0xFF));
+    HAL_GPIO_WritePin(gpio_cs, pin_cs, GPIO_PIN_SET);
+
+    return rx;
+}
+
+void spi_transfer_segments(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, const spi_segment *segments, uint8_t count)
+{
+    if (gpio_cs != NULL) {
+        HAL_GPIO_WritePin(gpio_cs, pin_cs, GPIO_PIN_RESET);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        for (uint16_t j = 0; j < segments[i].length; j++) {
+            uint8_t rx = sim_chip_transfer(segments[i].tx != NULL ? segments[i].tx[j] : 0xFF);
+            if (segments[i].rx != NULL) {
+                segments[i].rx[j] = rx;
+            }
+        }
+    }
+
+    if (gpio_cs != NULL) {
+        HAL_GPIO_WritePin(gpio_cs, pin_cs, GPIO_PIN_SET);
+    }
+}
+
+void spi_transfer(GPIO_TypeDef *gpio_cs, uint16_t pin_cs, const uint8_t *tx, uint8_t *rx, uint16_t length)
+{
+    spi_segment segment = {
+            .tx = tx,
+            .rx = rx,
+            .length = length,
+    };
+
+    spi_transfer_segments(gpio_cs, pin_cs, &segment, 1);
+}
+
+struct _i2c_port {
+    uint8_t index;
+};
+
+uint32_t sim_i2c_interrupt_transfers = 0;
+
+i2c_port DEFAULT_I2C_PORT = {
+        .index = 2,
+};
+
+/**
+ * Recording I2C bus: no devices answer reads (all zeros), but every transaction is traced and takes
+ * as long as it would on the wire: start, address, register and data bytes, 9 clocks each.
+ */
+static uint64_t i2c_transaction_ns(uint8_t size, bool read)
+{
+    uint32_t bytes = 2 + size + (read ? 1 : 0);
+    return (uint64_t) bytes * 9ULL * 1000000000ULL / I2C_BUS_CLOCK_SPEED;
+}
+
+static void i2c_trace_transaction(const char *type, uint8_t address, uint8_t reg, uint8_t size, const uint8_t *data)
+{
+    char hex[3 * 32 + 1];
+    int pos = 0;
+    for (uint8_t i = 0; data != NULL && i < size && i < 32; i++) {
+        pos += snprintf(hex + pos, sizeof(hex) - pos, " %02X", data[i]);
+    }
+    hex[pos] = '\0';
+
+    sim_trace("i2c", "%s addr=0x%02X reg=0x%02X len=%u%s", type, address, reg, size, hex);
+}
+
+// Queued transfer in progress, completed by the I2C2 interrupt once its bus time has passed
+static i2c_request *sim_i2c_active = NULL;
+
+/**
+ * Like the firmware, a blocking transfer keeps the queue from starting transfers and waits for the one in progress.
+ */
+static void i2c_transaction(const char *type, uint8_t address, uint8_t reg, uint8_t size, const uint8_t *data)
+{
+    i2c_queue_suspend();
+    while (sim_i2c_active != NULL) {
+        sim_idle_until_event(UINT64_MAX);
+    }
+
+    sim_advance(i2c_transaction_ns(size, data == NULL));
+    i2c_trace_transaction(type, address, reg, size, data);
+
+    i2c_queue_resume();
+}
+
+/**
+ * The firmware rejects blocking transfers from interrupt context, and so does the simulator, failing the simulation.
+ */
+static bool i2c_check_thread_mode(const char *type, uint8_t address, uint8_t reg)
+{
+    if (!sim_irq_active()) {
+        return true;
+    }
+
+    fprintf(stderr, "FAIL: blocking I2C %s addr=0x%02X reg=0x%02X from interrupt context\n", type, address, reg);
+    sim_trace("i2c", "%s from interrupt addr=0x%02X reg=0x%02X", type, address, reg);
+    sim_i2c_interrupt_transfers++;
+    return false;
+}
+
+static void sim_handle_i2c()
+{
+    i2c_request *request = sim_i2c_active;
+
+    sim_irq_stop(SIM_IRQ_I2C);
+    sim_i2c_active = NULL;
+    if (request == NULL) {
+        return;
+    }
+
+    if (request->write) {
+        i2c_trace_transaction("queued write", request->address, request->reg, request->size, request->data);
+    } else {
+        memset(request->data, 0, request->size);
+        i2c_trace_transaction("queued read", request->address, request->reg, request->size, NULL);
+    }
+
+    i2c_queue_handle_transfer_complete(HAL_OK);
+}
+
+void i2c_init()
+{
+    sim_irq_set_handler(SIM_IRQ_I2C, sim_handle_i2c);
+}
+
+void i2c_uninit()
+{
+}
+
+int i2c_read_bytes(i2c_port *port, uint8_t address, uint8_t reg, uint8_t size, uint8_t *data)
+{
+    (void) port;
+    if (!i2c_check_thread_mode("read", address, reg)) {
+        return HAL_ERROR;
+    }
+    memset(data, 0, size);
+    i2c_transaction("read", address, reg, size, NULL);
+    return HAL_OK;
+}
+
+int i2c_read_byte(i2c_port *port, uint8_t address, uint8_t reg, uint8_t *data)
+{
+    return i2c_read_bytes(port, address, reg, 1, data);
+}
+
+int i2c_write_bytes(i2c_port *port, uint8_t address, uint8_t reg, uint8_t size, uint8_t *data)
+{
+    (void) port;
+    if (!i2c_check_thread_mode("write", address, reg)) {
+        return HAL_ERROR;
+    }
+    i2c_transaction("write", address, reg, size, data);
+    return HAL_OK;
+}
+
+int i2c_write_byte(i2c_port *port, uint8_t address, uint8_t reg, uint8_t data)
+{
+    return i2c_write_bytes(port, address, reg, 1, &data);
+}
+
+/**
+ * Queued transfers run in the background and complete from the I2C2 interrupt, also when started from
+ * another interrupt handler.
+ */
+int i2c_transfer_start(i2c_request *request)
+{
+    if (sim_i2c_active != NULL) {
+        return HAL_ERROR;
+    }
+
+    sim_i2c_active = request;
+    sim_irq_start(SIM_IRQ_I2C, i2c_transaction_ns(request->size, !request->write));
+    return HAL_OK;
+}
+
+void i2c_transfer_abort()
+{
+    sim_irq_stop(SIM_IRQ_I2C);
+    sim_i2c_active = NULL;
+}
+
+void usart_gps_init(uint32_t baud_rate, bool enable_irq)
+{
+    (void) enable_irq;
+    sim_dma_claim(DMA_CHANNEL_GPS_USART_RX, "usart_gps");
+    dma_rd_pos = 0;
+    dma_wr_pos = 0;
+    usart_gps_enabled = true;
+    sim_gps_set_baud_rate(baud_rate);
+}
+
+void usart_gps_set_baud_rate(uint32_t baud_rate)
+{
+    dma_rd_pos = dma_wr_pos;
+    sim_gps_set_baud_rate(baud_rate);
+}
+
+void usart_gps_uninit()
+{
+    sim_dma_release(DMA_CHANNEL_GPS_USART_RX, "usart_gps");
+    usart_gps_enabled = false;
+}
+
+void usart_gps_enable(bool enabled)
+{
+    usart_gps_enabled = enabled;
+}
+
+void usart_gps_send_byte(uint8_t data)
+{
+    sim_advance(1000000000ULL * 10 / 9600);
+    sim_gps_handle_command(data);
+}
+
+void usart_gps_send_break(void)
+{
+}
+
+void sim_usart_gps_push(uint8_t data)
+{
+    if (!usart_gps_enabled) {
+        return;
+    }
+
+    // Circular DMA keeps writing: a reader that falls a full buffer behind silently loses data
+    dma_rx_buf[dma_wr_pos] = data;
+    dma_wr_pos = (dma_wr_pos + 1) % GPS_DMA_BUF_SIZE;
+    if (dma_wr_pos == dma_rd_pos) {
+        usart_gps_overruns++;
+        sim_trace("usart_gps", "overrun %lu", (unsigned long) usart_gps_overruns);
+    }
+}
+
+void usart_gps_drain_dma(void)
+{
+    static volatile bool draining = false;
+    if (draining) {
+        drain_interrupted++;
+        return;
+    }
+    if (!dma_drain_enabled) {
+        drain_not_enabled++;
+        return;
+    }
+
+    draining = true;
+
+    sim_advance(SIM_USART_GPS_DRAIN_NS);
+
+    uint16_t wr_pos = dma_wr_pos;
+
+    if (usart_gps_handle_incoming_data && dma_rd_pos != wr_pos) {
+        uint16_t count = (uint16_t) ((wr_pos + GPS_DMA_BUF_SIZE - dma_rd_pos) % GPS_DMA_BUF_SIZE);
+        drain_byte_calls += count;
+        usart_gps_handle_incoming_data(dma_rx_buf, GPS_DMA_BUF_SIZE, dma_rd_pos, wr_pos, 0);
+        sim_advance(SIM_USART_GPS_DRAIN_BYTE_NS * count);
+    }
+    dma_rd_pos = wr_pos;
+
+    draining = false;
+}
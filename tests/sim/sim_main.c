@@ -0,0 +1,156 @@
+/**
+ * Runs the unmodified firmware main() (compiled as rs41ng_main) on the simulated hardware for a fixed amount
+ * of virtual time and prints a timing report: interrupt latency and CPU budget per tick, transmission
+ * schedule latency and symbol timing jitter.
+ *
+ * Usage: rs41ng_sim [-d seconds] [-t trace_file] [-r gps_capture_file] [-n]
+ *   -d  virtual time to simulate in seconds (default: 120)
+ *   -t  write a timestamped trace of every symbol, register write and bus transaction
+ *   -r  replay a raw capture of GPS receiver output instead of the synthetic receiver
+ *   -n  synthetic receiver without a GPS fix
+ */
+
+#include <math.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "radio_internal.h"
+#include "sim.h"
+
+int rs41ng_main(void);
+
+static jmp_buf sim_finish_jump;
+
+void sim_finish()
+{
+    longjmp(sim_finish_jump, 1);
+}
+
+static uint32_t sim_firmware_symbol_rate()
+{
+    return radio_shared_state.radio_current_symbol_rate;
+}
+
+/**
+ * A time-synced entry becomes eligible at its slot boundary, anything else when the post-transmit delay
+ * after the previous transmission expires.
+ */
+static uint64_t sim_firmware_eligible_time_ns()
+{
+    radio_transmit_entry *entry = radio_current_transmit_entry;
+
+    if (entry != NULL && entry->time_sync_seconds > 0 && entry->current_transmit_index == 0) {
+        uint64_t time_millis = sim_gps_time_of_week_ms(sim_time_ns) - (GPS_TIME_LEAP_SECONDS * 1000);
+        uint64_t offset_millis = entry->time_sync_seconds_offset * 1000ULL;
+        uint64_t period_millis = entry->time_sync_seconds * 1000ULL;
+        uint64_t since_slot_millis = (time_millis - offset_millis) % period_millis;
+        uint64_t since_slot_ns = since_slot_millis * 1000000ULL + sim_time_ns % 1000000ULL;
+
+        return since_slot_ns <= sim_time_ns ? sim_time_ns - since_slot_ns : 0;
+    }
+
+    if (sim_transmit_statistics.last_tx_off_ns == 0) {
+        // Nothing to measure against before the first transmission
+        return sim_time_ns;
+    }
+
+    return sim_transmit_statistics.last_tx_off_ns + RADIO_POST_TRANSMIT_DELAY_MS * 1000000ULL;
+}
+
+static double sim_us(uint64_t ns)
+{
+    return (double) ns / 1000.0;
+}
+
+static void sim_print_report()
+{
+    double seconds = (double) sim_time_ns / 1e9;
+
+    printf("Simulated time: %.3f s\n\n", seconds);
+
+    printf("%-6s %10s %9s %12s %12s %12s %12s %8s %12s\n", "IRQ", "count", "overruns", "lat avg us",
+            "lat max us", "busy avg us", "busy max us", "cpu %", "host max us");
+    for (int i = 0; i < SIM_IRQ_COUNT; i++) {
+        sim_irq_stats *stats = &sim_irq_statistics[i];
+        uint64_t count = stats->count > 0 ? stats->count : 1;
+        printf("%-6s %10llu %9llu %12.3f %12.3f %12.3f %12.3f %8.3f %12.3f\n", stats->name,
+                (unsigned long long) stats->count, (unsigned long long) stats->overruns,
+                sim_us(stats->latency_ns_total / count), sim_us(stats->latency_ns_max),
+                sim_us(stats->busy_ns_total / count), sim_us(stats->busy_ns_max),
+                100.0 * (double) stats->busy_ns_total / (double) (sim_time_ns > 0 ? sim_time_ns : 1),
+                sim_us(stats->host_ns_max));
+    }
+
+    sim_transmit_stats *tx = &sim_transmit_statistics;
+    printf("\nTransmissions: %lu, airtime %.3f s (%.1f %%)\n", (unsigned long) tx->count,
+            (double) tx->airtime_ns_total / 1e9, 100.0 * (double) tx->airtime_ns_total / (double) (sim_time_ns + 1));
+    if (tx->count > 0) {
+        printf("Schedule latency: avg %.3f ms, max %.3f ms\n",
+                (double) tx->latency_ns_total / tx->count / 1e6, (double) tx->latency_ns_max / 1e6);
+    }
+
+    sim_symbol_stats *symbols = &sim_symbol_statistics;
+    printf("\nSymbols: %llu, nominal period %.3f us\n", (unsigned long long) symbols->count,
+            sim_us(symbols->nominal_ns));
+    if (symbols->intervals > 0) {
+        double mean = (double) symbols->error_ns_total / (double) symbols->intervals;
+        double rms = sqrt(symbols->error_ns_square_total / (double) symbols->intervals);
+        printf("Symbol timing error: mean %.3f us, rms %.3f us, min %.3f us, max %.3f us\n",
+                mean / 1000.0, rms / 1000.0, (double) symbols->error_ns_min / 1000.0,
+                (double) symbols->error_ns_max / 1000.0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    double duration_seconds = 120;
+    const char *trace_path = NULL;
+    const char *replay_path = NULL;
+    bool fix = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:t:r:n")) != -1) {
+        switch (opt) {
+            case 'd':
+                duration_seconds = atof(optarg);
+                break;
+            case 't':
+                trace_path = optarg;
+                break;
+            case 'r':
+                replay_path = optarg;
+                break;
+            case 'n':
+                fix = false;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-d seconds] [-t trace_file] [-r gps_capture_file] [-n]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (trace_path != NULL) {
+        sim_trace_open(trace_path);
+    }
+
+    sim_radio_symbol_rate = sim_firmware_symbol_rate;
+    sim_radio_eligible_time_ns = sim_firmware_eligible_time_ns;
+    sim_time_limit_ns = (uint64_t) (duration_seconds * 1e9);
+
+    sim_si4032_init();
+    sim_gps_init(replay_path, fix);
+
+    if (setjmp(sim_finish_jump) == 0) {
+        rs41ng_main();
+    }
+
+    sim_trace_close();
+    sim_print_report();
+
+    // The configured schedule must produce at least one transmission, without two drivers on one DMA channel
+    // and without blocking I2C transfers in interrupt handlers
+    return sim_transmit_statistics.count > 0 && sim_dma_conflicts == 0
+            && sim_i2c_interrupt_transfers == 0 ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+#ifndef __SIM_PGMSPACE_H
+#define __SIM_PGMSPACE_H
+
+// Force-included into C++ sources: JTEncode reads its tables through the AVR program memory accessor
+// on every architecture other than ARM
+#include <stdint.h>
+
+#define pgm_read_byte(addr) (*(const uint8_t *) (addr))
+
+#endif
@@ -0,0 +1,255 @@
+/**
+ * Si4032 register model attached to the simulated SPI bus.
+ *
+ * Every register write is traced. The transmitter state (register 07h), the frequency offset used for
+ * FSK symbols (register 73h), the TX FIFO (register 7Fh) and the interrupt status (register 03h) are modeled
+ * closely enough for the RS41 radio backend to run unmodified.
+ */
+
+#include <string.h>
+
+#include "gpio.h"
+#include "sim.h"
+
+#define SI4032_REG_DEVICE_VERSION 0x01
+#define SI4032_REG_INTERRUPT_STATUS_1 0x03
+#define SI4032_REG_OPERATING_MODE_1 0x07
+#define SI4032_REG_OPERATING_MODE_2 0x08
+#define SI4032_REG_ADC_VALUE 0x11
+#define SI4032_REG_PACKET_LENGTH 0x3E
+#define SI4032_REG_TX_DATA_RATE_1 0x6E
+#define SI4032_REG_TX_DATA_RATE_0 0x6F
+#define SI4032_REG_MODULATION_MODE_CONTROL_2 0x71
+#define SI4032_REG_FREQUENCY_OFFSET_1 0x73
+#define SI4032_REG_TX_FIFO_CONTROL_2 0x7D
+#define SI4032_REG_FIFO_ACCESS 0x7F
+
+#define SI4032_OPERATING_MODE_TXON 0x08
+#define SI4032_OPERATING_MODE_2_FFCLRTX 0x01
+#define SI4032_INTERRUPT_IFFERR 0x80
+#define SI4032_INTERRUPT_IPKSENT 0x04
+#define SI4032_INTERRUPT_ITXFFAEM 0x20
+#define SI4032_MODULATION_DTMOD_MASK 0x30
+#define SI4032_MODULATION_DTMOD_FIFO 0x20
+
+#define SI4032_FIFO_SIZE 64
+
+// Raw ADC reading for +20 C with the -64 ... 64 C range selected by the driver
+#define SI4032_ADC_TEMPERATURE_RAW ((20 + 64) * 2)
+
+static uint8_t si4032_registers[128];
+
+static bool si4032_selected = false;
+static uint8_t si4032_byte_index = 0;
+static uint8_t si4032_address = 0;
+static bool si4032_write_access = false;
+
+static bool si4032_tx_on = false;
+static bool si4032_fifo_mode = false;
+
+static uint16_t si4032_fifo_level = 0;
+static uint16_t si4032_packet_bytes_sent = 0;
+static uint64_t si4032_fifo_last_update_ns = 0;
+static uint64_t si4032_fifo_byte_remainder_ns = 0;
+
+static void si4032_reset_registers()
+{
+    memset(si4032_registers, 0, sizeof(si4032_registers));
+    si4032_registers[SI4032_REG_DEVICE_VERSION] = 0x06;
+    si4032_registers[SI4032_REG_ADC_VALUE] = SI4032_ADC_TEMPERATURE_RAW;
+    si4032_fifo_level = 0;
+}
+
+static uint64_t si4032_byte_time_ns()
+{
+    uint32_t txdr = ((uint32_t) si4032_registers[SI4032_REG_TX_DATA_RATE_1] << 8U)
+            | si4032_registers[SI4032_REG_TX_DATA_RATE_0];
+    if (txdr == 0) {
+        txdr = 1;
+    }
+
+    // Inverse of si4032_set_data_rate(): txdr = bps * 2^21 * 30 / 1e6 / 26 with txdtrtscale set
+    uint64_t bits_per_second_1000 = (uint64_t) txdr * 1000000ULL * 26ULL * 1000ULL / (30ULL << 21U);
+    if (bits_per_second_1000 == 0) {
+        bits_per_second_1000 = 1;
+    }
+
+    return 8ULL * 1000000000ULL * 1000ULL / bits_per_second_1000;
+}
+
+static void si4032_set_tx(bool tx_on)
+{
+    if (tx_on == si4032_tx_on) {
+        return;
+    }
+
+    si4032_tx_on = tx_on;
+
+    if (tx_on) {
+        si4032_fifo_mode = (si4032_registers[SI4032_REG_MODULATION_MODE_CONTROL_2] & SI4032_MODULATION_DTMOD_MASK)
+                == SI4032_MODULATION_DTMOD_FIFO;
+        si4032_packet_bytes_sent = 0;
+        si4032_fifo_last_update_ns = sim_time_ns;
+        si4032_fifo_byte_remainder_ns = 0;
+        sim_radio_tx_on();
+    } else {
+        sim_radio_tx_off();
+    }
+}
+
+/**
+ * The FIFO is drained at the configured data rate while the transmitter is on. The state is brought up to date
+ * lazily whenever the firmware touches the chip, which is the only time the firmware can observe it.
+ */
+static void si4032_update_fifo()
+{
+    if (!si4032_tx_on || !si4032_fifo_mode) {
+        return;
+    }
+
+    uint64_t byte_ns = si4032_byte_time_ns();
+    uint64_t elapsed_ns = sim_time_ns - si4032_fifo_last_update_ns + si4032_fifo_byte_remainder_ns;
+    uint64_t bytes = elapsed_ns / byte_ns;
+
+    si4032_fifo_last_update_ns = sim_time_ns;
+    si4032_fifo_byte_remainder_ns = elapsed_ns % byte_ns;
+
+    uint8_t packet_length = si4032_registers[SI4032_REG_PACKET_LENGTH];
+
+    while (bytes > 0 && si4032_tx_on) {
+        if (si4032_fifo_level == 0) {
+            sim_trace("si4032", "fifo underrun sent=%u", si4032_packet_bytes_sent);
+            si4032_registers[SI4032_REG_INTERRUPT_STATUS_1] |= SI4032_INTERRUPT_IFFERR;
+            si4032_fifo_byte_remainder_ns = 0;
+            break;
+        }
+
+        si4032_fifo_level--;
+        si4032_packet_bytes_sent++;
+        bytes--;
+
+        sim_radio_symbol("si4032_fifo", si4032_packet_bytes_sent);
+
+        if (si4032_packet_bytes_sent >= packet_length) {
+            si4032_registers[SI4032_REG_INTERRUPT_STATUS_1] |= SI4032_INTERRUPT_IPKSENT;
+            si4032_registers[SI4032_REG_OPERATING_MODE_1] &= ~SI4032_OPERATING_MODE_TXON;
+            si4032_fifo_level = 0;
+            si4032_set_tx(false);
+        }
+    }
+
+    if (si4032_fifo_level <= si4032_registers[SI4032_REG_TX_FIFO_CONTROL_2]) {
+        si4032_registers[SI4032_REG_INTERRUPT_STATUS_1] |= SI4032_INTERRUPT_ITXFFAEM;
+    }
+}
+
+static uint8_t si4032_read_register(uint8_t address)
+{
+    uint8_t value = si4032_registers[address];
+
+    switch (address) {
+        case SI4032_REG_INTERRUPT_STATUS_1:
+            // Interrupt status is cleared on read
+            si4032_registers[address] = 0;
+            break;
+        default:
+            break;
+    }
+
+    sim_trace("si4032", "read reg=0x%02X value=0x%02X", address, value);
+
+    return value;
+}
+
+static void si4032_write_register(uint8_t address, uint8_t value)
+{
+    sim_trace("si4032", "write reg=0x%02X value=0x%02X", address, value);
+
+    switch (address) {
+        case SI4032_REG_OPERATING_MODE_1:
+            if (value & 0x80) {
+                // Software reset
+                si4032_reset_registers();
+                si4032_set_tx(false);
+                return;
+            }
+            si4032_registers[address] = value;
+            si4032_set_tx((value & SI4032_OPERATING_MODE_TXON) != 0);
+            return;
+        case SI4032_REG_OPERATING_MODE_2:
+            if (value & SI4032_OPERATING_MODE_2_FFCLRTX) {
+                si4032_fifo_level = 0;
+            }
+            break;
+        case SI4032_REG_FREQUENCY_OFFSET_1:
+            if (si4032_tx_on) {
+                sim_radio_symbol("si4032", value);
+            }
+            break;
+        case SI4032_REG_FIFO_ACCESS:
+            if (si4032_fifo_level >= SI4032_FIFO_SIZE) {
+                sim_trace("si4032", "fifo overflow");
+            } else {
+                si4032_fifo_level++;
+            }
+            if (si4032_fifo_level > si4032_registers[SI4032_REG_TX_FIFO_CONTROL_2]) {
+                si4032_registers[SI4032_REG_INTERRUPT_STATUS_1] &= ~SI4032_INTERRUPT_ITXFFAEM;
+            }
+            return;
+        default:
+            break;
+    }
+
+    si4032_registers[address] = value;
+}
+
+void sim_chip_select(bool selected)
+{
+    si4032_selected = selected;
+    si4032_byte_index = 0;
+}
+
+uint8_t sim_chip_transfer(uint8_t data)
+{
+    sim_advance(SIM_SPI_BYTE_NS);
+
+    if (!si4032_selected) {
+        return 0xFF;
+    }
+
+    si4032_update_fifo();
+
+    uint8_t result = 0xFF;
+
+    if (si4032_byte_index == 0) {
+        si4032_write_access = (data & 0x80) != 0;
+        si4032_address = data & 0x7F;
+    } else {
+        if (si4032_write_access) {
+            si4032_write_register(si4032_address, data);
+        } else {
+            result = si4032_read_register(si4032_address);
+        }
+        // Burst access auto-increments the address, except for the FIFO
+        if (si4032_address != SI4032_REG_FIFO_ACCESS) {
+            si4032_address = (si4032_address + 1) & 0x7F;
+        }
+    }
+
+    si4032_byte_index++;
+
+    return result;
+}
+
+void sim_chip_gpio_write(uint16_t pin, bool high)
+{
+    if (pin == PIN_MOSI) {
+        // SDI pin driven directly: OOK/FSK data in direct mode, used for CW and bit-banged AFSK
+        sim_radio_symbol("si4032_sdi", high);
+    }
+}
+
+void sim_si4032_init()
+{
+    si4032_reset_registers();
+}
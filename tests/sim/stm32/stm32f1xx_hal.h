@@ -0,0 +1,124 @@
+#ifndef __SIM_STM32F1XX_HAL_H
+#define __SIM_STM32F1XX_HAL_H
+
+/**
+ * Minimal host-side stand-in for the STM32 HAL used by the hardware-in-the-loop simulator.
+ *
+ * Only the types, constants and calls that the radio scheduler, the radio chip drivers
+ * and the GPS driver touch are provided here. GPIO writes are forwarded to the simulator
+ * so that they show up in the trace.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+    char name;
+    uint16_t odr;
+} GPIO_TypeDef;
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+typedef struct {
+    uint32_t SR;
+    uint32_t DIER;
+    uint32_t ARR;
+    uint32_t CNT;
+} TIM_TypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+extern GPIO_TypeDef sim_gpio_banks[4];
+
+#define GPIOA (&sim_gpio_banks[0])
+#define GPIOB (&sim_gpio_banks[1])
+#define GPIOC (&sim_gpio_banks[2])
+#define GPIOD (&sim_gpio_banks[3])
+
+#define GPIO_PIN_0  ((uint16_t) 0x0001)
+#define GPIO_PIN_1  ((uint16_t) 0x0002)
+#define GPIO_PIN_2  ((uint16_t) 0x0004)
+#define GPIO_PIN_3  ((uint16_t) 0x0008)
+#define GPIO_PIN_4  ((uint16_t) 0x0010)
+#define GPIO_PIN_5  ((uint16_t) 0x0020)
+#define GPIO_PIN_6  ((uint16_t) 0x0040)
+#define GPIO_PIN_7  ((uint16_t) 0x0080)
+#define GPIO_PIN_8  ((uint16_t) 0x0100)
+#define GPIO_PIN_9  ((uint16_t) 0x0200)
+#define GPIO_PIN_10 ((uint16_t) 0x0400)
+#define GPIO_PIN_11 ((uint16_t) 0x0800)
+#define GPIO_PIN_12 ((uint16_t) 0x1000)
+#define GPIO_PIN_13 ((uint16_t) 0x2000)
+#define GPIO_PIN_14 ((uint16_t) 0x4000)
+#define GPIO_PIN_15 ((uint16_t) 0x8000)
+
+#define GPIO_MODE_INPUT     0x00U
+#define GPIO_MODE_OUTPUT_PP 0x01U
+#define GPIO_MODE_OUTPUT_OD 0x11U
+#define GPIO_MODE_AF_PP     0x02U
+#define GPIO_MODE_AF_OD     0x12U
+#define GPIO_MODE_ANALOG    0x03U
+
+#define GPIO_NOPULL   0x00U
+#define GPIO_PULLUP   0x01U
+#define GPIO_PULLDOWN 0x02U
+
+#define GPIO_SPEED_FREQ_LOW    0x02U
+#define GPIO_SPEED_FREQ_MEDIUM 0x01U
+#define GPIO_SPEED_FREQ_HIGH   0x03U
+
+#define GPIO_AF14_TIM15 0x0EU
+
+#define TIM_FLAG_UPDATE 0x0001U
+#define TIM_IT_UPDATE   0x0001U
+
+#define __HAL_TIM_GET_FLAG(handle, flag) (((handle)->Instance->SR & (flag)) == (flag))
+#define __HAL_TIM_GET_IT_SOURCE(handle, it) ((((handle)->Instance->DIER & (it)) == (it)) ? 1U : 0U)
+#define __HAL_TIM_CLEAR_IT(handle, it) ((handle)->Instance->SR = ~(it))
+
+#define __NOP() do { } while (0)
+#define __WFI() sim_wait_for_interrupt()
+#define __get_PRIMASK() sim_get_primask()
+#define __set_PRIMASK(primask) sim_set_primask(primask)
+#define __disable_irq() sim_set_primask(1)
+#define __enable_irq() sim_set_primask(0)
+
+void HAL_GPIO_Init(GPIO_TypeDef *gpio, GPIO_InitTypeDef *init);
+void HAL_GPIO_WritePin(GPIO_TypeDef *gpio, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *gpio, uint16_t pin);
+uint32_t HAL_GetTick(void);
+
+void sim_wait_for_interrupt(void);
+uint32_t sim_get_primask(void);
+void sim_set_primask(uint32_t primask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif